@@ -0,0 +1,277 @@
+#include "adversary.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <random>
+#include <thread>
+
+namespace Adversary {
+
+namespace {
+
+using Random = std::mt19937;
+
+size_t below(Random &random, size_t bound)
+{
+    return bound ? std::uniform_int_distribution<size_t>(0, bound - 1)(random) : 0;
+}
+
+// A random stretch of at most an eighth of the input.
+std::pair<size_t, size_t> segment(Random &random, size_t size)
+{
+    const size_t length = 1 + below(random, std::max<size_t>(size / 8, 1));
+    const size_t begin = below(random, size - std::min(length, size) + 1);
+    return { begin, std::min(begin + length, size) };
+}
+
+// Each one keeps the values in 1..size; the last lets repeats in, or out.
+void mutate(std::vector<int32_t> &input, Random &random)
+{
+    const size_t size = input.size();
+    const auto [begin, end] = segment(random, size);
+    switch (below(random, 4)) {
+    case 0:
+        std::swap(input[below(random, size)], input[below(random, size)]);
+        break;
+    case 1:
+        std::reverse(input.begin() + ptrdiff_t(begin), input.begin() + ptrdiff_t(end));
+        break;
+    case 2:
+        if (end > begin)
+            std::rotate(input.begin() + ptrdiff_t(begin), input.begin() + ptrdiff_t(begin + 1),
+                        input.begin() + ptrdiff_t(end));
+        break;
+    default:
+        input[below(random, size)] = input[below(random, size)];
+        break;
+    }
+}
+
+// Two-point: a stretch of b in a's place.
+std::vector<int32_t> crossover(const std::vector<int32_t> &a, const std::vector<int32_t> &b, Random &random)
+{
+    std::vector<int32_t> child = a;
+    const auto [begin, end] = segment(random, a.size());
+    std::copy(b.begin() + ptrdiff_t(begin), b.begin() + ptrdiff_t(end), child.begin() + ptrdiff_t(begin));
+    return child;
+}
+
+double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+} // namespace
+
+// Values carry key * size + identity, so the adversary can tell which
+// element is at a position however far the sort has moved it. Gas is the
+// key size, above every frozen one; freezing hands out 0, 1, 2, ... so the
+// element frozen first ends up smallest.
+std::vector<int32_t> antiSort(const Sorts::Algorithm &algorithm, size_t size)
+{
+    size = std::min(size, MaxAntiSortSize);
+    const int32_t stride = int32_t(std::max<size_t>(size, 1));
+    const int32_t gas = stride;
+    std::vector<int32_t> keys(size, gas);
+    std::vector<int32_t> values(size);
+    for (size_t i = 0; i < size; ++i)
+        values[i] = gas * stride + int32_t(i);
+
+    int32_t nextKey = 0;
+    int32_t candidate = -1;
+    const auto freeze = [&](size_t position) {
+        const int32_t item = values[position] % stride;
+        keys[size_t(item)] = nextKey++;
+        values[position] = keys[size_t(item)] * stride + item;
+    };
+    Stepper stepper = algorithm.run(values);
+    while (stepper.next()) {
+        const VisualEvent &event = stepper.event();
+        if (event.kind != VisualEvent::Compare || event.a >= size || event.b >= size)
+            continue;
+        const int32_t x = values[event.a] % stride;
+        const int32_t y = values[event.b] % stride;
+        if (keys[size_t(x)] == gas && keys[size_t(y)] == gas)
+            freeze(x == candidate ? event.a : event.b);
+        if (keys[size_t(x)] == gas)
+            candidate = x;
+        else if (keys[size_t(y)] == gas)
+            candidate = y;
+    }
+
+    // Gas never decided a compare, so any order of it will do.
+    std::vector<int32_t> input(size);
+    for (size_t item = 0; item < size; ++item) {
+        if (keys[item] == gas)
+            keys[item] = nextKey++;
+        input[item] = keys[item] + 1;
+    }
+    return input;
+}
+
+double score(const Sorts::Algorithm &algorithm, std::span<const int32_t> input, Objective objective)
+{
+    std::vector<int32_t> values(input.begin(), input.end());
+    if (objective == Objective::Time && algorithm.native) {
+        double best = HUGE_VAL;
+        for (int run = 0; run < 3; ++run) {
+            std::copy(input.begin(), input.end(), values.begin());
+            const auto started = std::chrono::steady_clock::now();
+            algorithm.native(values);
+            best = std::min(best, elapsedMs(started));
+        }
+        return best;
+    }
+    const auto started = std::chrono::steady_clock::now();
+    uint64_t operations = 0;
+    Stepper stepper = algorithm.run(values);
+    while (stepper.next())
+        operations += stepper.event().kind != VisualEvent::Mark;
+    return objective == Objective::Time ? elapsedMs(started) : double(operations);
+}
+
+SearchResult search(const Sorts::Algorithm &algorithm, const SearchOptions &options,
+                    const std::function<bool(int generation, double best)> &progress)
+{
+    struct Candidate
+    {
+        std::vector<int32_t> input;
+        double score = 0;
+    };
+    const size_t size = std::max<size_t>(options.size, 2);
+    const size_t population = size_t(std::max(options.population, 4));
+    // The best two go through unchanged, so the best score never drops.
+    constexpr size_t Elite = 2;
+    Random random(options.seed);
+
+    std::vector<Candidate> candidates(population);
+    for (size_t i = 0; i < population; ++i)
+        candidates[i].input = Sorts::makeInput(Sorts::Shape(i % Sorts::ShapeCount), size, options.seed + uint32_t(i));
+    const auto evaluate = [&](size_t first) {
+        const auto one = [&](size_t i) { candidates[i].score = score(algorithm, candidates[i].input, options.objective); };
+        // Timings taken side by side would only measure each other.
+        if (options.objective == Objective::Time) {
+            for (size_t i = first; i < population; ++i)
+                one(i);
+            return;
+        }
+        Parallel::forRange(first, population, 1, [&](size_t begin, size_t end) {
+            for (size_t i = begin; i < end; ++i)
+                one(i);
+        });
+    };
+    const auto byScore = [](const Candidate &a, const Candidate &b) { return a.score > b.score; };
+    evaluate(0);
+    std::sort(candidates.begin(), candidates.end(), byScore);
+
+    SearchResult result { candidates.front().input, candidates.front().score, 0 };
+    for (int generation = 1; generation <= options.generations; ++generation) {
+        const auto tournament = [&]() -> const Candidate & {
+            const Candidate *best = &candidates[below(random, population)];
+            for (int k = 0; k < 2; ++k) {
+                const Candidate &other = candidates[below(random, population)];
+                if (other.score > best->score)
+                    best = &other;
+            }
+            return *best;
+        };
+        std::vector<Candidate> next(candidates.begin(), candidates.begin() + ptrdiff_t(Elite));
+        while (next.size() < population) {
+            Candidate child { crossover(tournament().input, tournament().input, random) };
+            for (size_t k = 1 + below(random, 3); k > 0; --k)
+                mutate(child.input, random);
+            next.push_back(std::move(child));
+        }
+        candidates = std::move(next);
+        evaluate(Elite);
+        std::sort(candidates.begin(), candidates.end(), byScore);
+
+        if (candidates.front().score > result.score)
+            result = { candidates.front().input, candidates.front().score, generation };
+        if (progress && !progress(generation, result.score))
+            break;
+    }
+    return result;
+}
+
+struct BackgroundSearch::Shared
+{
+    std::mutex mutex;
+    SearchResult result;
+    std::atomic<int> generation { 0 };
+    std::atomic<double> best { 0 };
+    std::atomic<bool> cancelled { false };
+    std::atomic<bool> done { false };
+};
+
+BackgroundSearch::~BackgroundSearch()
+{
+    cancel();
+}
+
+void BackgroundSearch::start(const Sorts::Algorithm *algorithm, Method method, const SearchOptions &options)
+{
+    cancel();
+    m_algorithm = algorithm;
+    m_method = method;
+    m_shared = std::make_shared<Shared>();
+    std::thread([shared = m_shared, algorithm, method, options] {
+        SearchResult result;
+        if (method == Method::AntiSort) {
+            result.input = antiSort(*algorithm, options.size);
+            result.score = score(*algorithm, result.input, options.objective);
+        } else {
+            result = search(*algorithm, options, [&](int generation, double best) {
+                shared->generation.store(generation, std::memory_order_relaxed);
+                shared->best.store(best, std::memory_order_relaxed);
+                return !shared->cancelled.load(std::memory_order_relaxed);
+            });
+        }
+        if (!result.input.empty() && !shared->cancelled.load(std::memory_order_relaxed)) {
+            const std::vector<int32_t> random = Sorts::makeInput(Sorts::Shape::Random, result.input.size(), 1);
+            result.typical = score(*algorithm, random, options.objective);
+        }
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->result = std::move(result);
+        }
+        shared->done.store(true, std::memory_order_release);
+    }).detach();
+}
+
+void BackgroundSearch::cancel()
+{
+    if (m_shared)
+        m_shared->cancelled.store(true, std::memory_order_relaxed);
+    m_shared.reset();
+}
+
+bool BackgroundSearch::running() const
+{
+    return m_shared && !m_shared->done.load(std::memory_order_acquire);
+}
+
+int BackgroundSearch::generation() const
+{
+    return m_shared ? m_shared->generation.load(std::memory_order_relaxed) : 0;
+}
+
+double BackgroundSearch::best() const
+{
+    return m_shared ? m_shared->best.load(std::memory_order_relaxed) : 0;
+}
+
+SearchResult BackgroundSearch::result() const
+{
+    if (!m_shared || !m_shared->done.load(std::memory_order_acquire))
+        return {};
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    return m_shared->result;
+}
+
+} // namespace Adversary
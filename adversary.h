@@ -0,0 +1,105 @@
+#ifndef ADVERSARY_H
+#define ADVERSARY_H
+
+#include "sorts.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Searches for inputs that make a sort as slow as it can be, so a latency
+// budget can be checked against the worst case rather than the shapes that
+// happened to be tried.
+//
+//  - antiSort() is McIlroy's "killer adversary for quicksort": values
+//    start undecided ("gas") and are fixed ("frozen") only when a compare
+//    needs them, always against the sort's likely pivot. It drives any
+//    comparison sort towards its worst case in one run, since the stepper
+//    announces each compare before making it.
+//  - search() is a genetic search for everything else: radix and the like,
+//    or a second opinion on a comparison sort. A population of inputs,
+//    seeded with the catalog shapes, is bred by crossover and mutation and
+//    scored on the Parallel pool.
+//
+// Results hold the values 1..size, possibly with repeats, like makeInput().
+namespace Adversary {
+
+// Gas and frozen values share an int32 with the element's identity.
+constexpr size_t MaxAntiSortSize = 46340;
+
+// Clamped to MaxAntiSortSize. Comparisons that name no array element, as
+// against a scratch buffer, are left to play out.
+std::vector<int32_t> antiSort(const Sorts::Algorithm &algorithm, size_t size);
+
+enum class Objective
+{
+    Operations, // compares, swaps and writes, from the stepper; deterministic
+    Time,       // the native version's best of three, scored one at a time
+};
+
+double score(const Sorts::Algorithm &algorithm, std::span<const int32_t> input, Objective objective);
+
+struct SearchOptions
+{
+    size_t size = 1024;
+    int population = 32;
+    int generations = 100;
+    Objective objective = Objective::Operations;
+    uint32_t seed = 1;
+};
+
+struct SearchResult
+{
+    std::vector<int32_t> input;
+    double score = 0;
+    int generation = 0; // when it was found
+    // BackgroundSearch only: the same objective on a random input of the
+    // same size, to show the worst case against.
+    double typical = 0;
+};
+
+// progress sees the best score after each generation and returns false to
+// stop early.
+SearchResult search(const Sorts::Algorithm &algorithm, const SearchOptions &options,
+                    const std::function<bool(int generation, double best)> &progress = {});
+
+// search() or antiSort() on a worker thread for the GUI to poll, followed
+// by the scores of what was found and of a random input, all of them
+// stepping runs that can take seconds each. A search is cancelled between
+// generations, the rest only once it is done; like SampledSort, the worker
+// may outlive the object.
+class BackgroundSearch
+{
+public:
+    enum class Method { AntiSort, Genetic };
+
+    BackgroundSearch() = default;
+    BackgroundSearch(const BackgroundSearch &) = delete;
+    BackgroundSearch &operator=(const BackgroundSearch &) = delete;
+    ~BackgroundSearch();
+
+    // AntiSort only looks at options.size and options.objective.
+    void start(const Sorts::Algorithm *algorithm, Method method, const SearchOptions &options);
+    void cancel();
+
+    const Sorts::Algorithm *algorithm() const { return m_algorithm; }
+    Method method() const { return m_method; }
+    bool running() const;
+    int generation() const;
+    double best() const;
+    // Empty until finished.
+    SearchResult result() const;
+
+private:
+    struct Shared;
+
+    const Sorts::Algorithm *m_algorithm = nullptr;
+    Method m_method = Method::Genetic;
+    std::shared_ptr<Shared> m_shared;
+};
+
+} // namespace Adversary
+
+#endif // ADVERSARY_H
@@ -0,0 +1,1770 @@
+#include "adversary.h"
+#include "codec.h"
+#include "complexity.h"
+#include "distsort.h"
+#include "entropy.h"
+#include "imageconvert.h"
+#include "imagepipeline.h"
+#include "labeling.h"
+#include "lifeboard.h"
+#include "machine.h"
+#include "memoryusage.h"
+#include "mergepath.h"
+#include "parallel.h"
+#include "roofline.h"
+#include "sorts.h"
+#include "statistics.h"
+#include "traceanalysis.h"
+#include "traceplayer.h"
+#include "tuning.h"
+
+#include <QCommandLineParser>
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QHash>
+#include <QImageReader>
+#include <QJsonArray>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QJsonParseError>
+#include <QTextStream>
+
+#include <algorithm>
+#include <atomic>
+#include <cmath>
+#include <cstring>
+#include <functional>
+#include <iterator>
+#include <limits>
+#include <memory>
+#include <mutex>
+#include <numeric>
+#include <random>
+#include <string>
+#include <thread>
+
+namespace {
+
+QTextStream &out()
+{
+    static QTextStream stream(stdout);
+    return stream;
+}
+
+QTextStream &err()
+{
+    static QTextStream stream(stderr);
+    return stream;
+}
+
+// Smooth blobs with a little noise, roughly what a scan or satellite image
+// looks like. As a mask it is thresholded, so labeling is not dominated by
+// 1-pixel specks; as a gray image it keeps the gradients.
+Mask syntheticImage(int width, int height, bool binary)
+{
+    Mask image(width, height);
+    Parallel::forRange(0, size_t(height), 64, [&](size_t first, size_t last) {
+        for (size_t y = first; y < last; ++y) {
+            uint32_t noise = uint32_t(y) * 2654435761u + 1;
+            for (int x = 0; x < width; ++x) {
+                noise ^= noise << 13;
+                noise ^= noise >> 17;
+                noise ^= noise << 5;
+                const double field = std::sin(x * 0.013 + std::sin(y * 0.007) * 3.0)
+                        + std::cos(y * 0.011 + x * 0.002) * 0.8 + (noise % 100) / 300.0;
+                image.at(x, int(y)) = binary ? field > 0.3 : uint8_t(std::clamp(128 + field * 60, 0.0, 255.0));
+            }
+        }
+    });
+    return image;
+}
+
+bool parseSize(const QCommandLineParser &parser, int &width, int &height)
+{
+    const QStringList size = parser.value(QStringLiteral("size")).split(QLatin1Char('x'));
+    width = size.value(0).toInt();
+    height = size.value(1, size.value(0)).toInt();
+    if (width <= 0 || height <= 0) {
+        err() << "Invalid --size" << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+bool readImage(const QString &path, QImage &image)
+{
+    QImageReader reader(path);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    reader.setAllocationLimit(0);
+#endif
+    image = reader.read();
+    if (image.isNull()) {
+        err() << "Cannot read " << path << ": " << reader.errorString() << Qt::endl;
+        return false;
+    }
+    return true;
+}
+
+// Log-like text: a small vocabulary with a skewed word distribution and
+// numbers, so both the match finders and the entropy coders have work.
+std::vector<uint8_t> syntheticText(size_t size)
+{
+    static const char *const words[] = { "compare", "swap", "pivot", "merge", "run", "index", "value",
+                                         "left", "right", "partition", "step", "done", "error", "thread" };
+    std::vector<uint8_t> text;
+    text.reserve(size + 32);
+    uint32_t noise = 2463534242u;
+    while (text.size() < size) {
+        noise ^= noise << 13;
+        noise ^= noise >> 17;
+        noise ^= noise << 5;
+        const char *word = words[(noise % 16) * (noise % 16) / 19];
+        text.insert(text.end(), word, word + std::char_traits<char>::length(word));
+        text.push_back(' ');
+        if (noise % 5 == 0) {
+            const std::string number = std::to_string(noise % 100000);
+            text.insert(text.end(), number.begin(), number.end());
+            text.push_back(noise % 3 ? ' ' : '\n');
+        }
+    }
+    text.resize(size);
+    return text;
+}
+
+template <typename Function>
+std::vector<double> samplesMs(int repeat, Function &&function)
+{
+    std::vector<double> samples;
+    for (int i = 0; i < repeat; ++i) {
+        QElapsedTimer timer;
+        timer.start();
+        function();
+        samples.push_back(timer.nsecsElapsed() / 1e6);
+    }
+    return samples;
+}
+
+template <typename Function>
+double bestOfMs(int repeat, Function &&function)
+{
+    const std::vector<double> samples = samplesMs(repeat, std::forward<Function>(function));
+    return samples.empty() ? HUGE_VAL : *std::min_element(samples.begin(), samples.end());
+}
+
+// Where the timed threads run, and what might have disturbed them.
+struct Environment
+{
+    std::vector<int> cpus; // empty when not pinned
+    Machine::Info machine;
+    QStringList warnings;
+};
+
+// Pins the pool one thread per chosen CPU, unless --threads says otherwise,
+// before anything is timed. main() calls it for the timing modes only.
+bool setUpEnvironment(const QCommandLineParser &parser, Environment &environment)
+{
+    const QString choice = parser.value(QStringLiteral("cpus"));
+    std::vector<int> cpus;
+    if (choice == QLatin1String("auto")) {
+        cpus = Machine::allowedCpus();
+    } else if (choice == QLatin1String("isolated")) {
+        cpus = Machine::describe({}).isolated;
+        if (cpus.empty()) {
+            err() << "No isolated CPUs; boot with isolcpus= to set some aside" << Qt::endl;
+            return false;
+        }
+    } else if (choice != QLatin1String("none")) {
+        cpus = Machine::parseCpuList(choice);
+        if (cpus.empty()) {
+            err() << "Invalid --cpus " << choice << Qt::endl;
+            return false;
+        }
+    }
+
+    if (!cpus.empty()) {
+        if (!Parallel::pinThreads(cpus)) {
+            err() << "Cannot pin threads to CPUs " << choice << Qt::endl;
+            return false;
+        }
+        if (!parser.isSet(QStringLiteral("threads")))
+            Parallel::setThreadCount(int(cpus.size()));
+    }
+    environment.cpus = cpus;
+    environment.machine = Machine::describe(cpus);
+    environment.warnings = Machine::warnings(environment.machine, cpus);
+    if (choice == QLatin1String("none"))
+        environment.warnings << QStringLiteral("threads are not pinned and may migrate between CPUs");
+    if (!cpus.empty() && Parallel::threadCount() > int(cpus.size()))
+        environment.warnings << QStringLiteral("more threads than pinned CPUs");
+    for (const QString &warning : environment.warnings)
+        err() << "warning: " << warning << Qt::endl;
+    return true;
+}
+
+int runLabel(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    Mask mask;
+    if (!inputs.isEmpty()) {
+        QImage image;
+        if (!readImage(inputs.first(), image))
+            return 1;
+        mask = ImageConvert::toMask(image, parser.value(QStringLiteral("threshold")).toInt());
+    } else {
+        int width = 0;
+        int height = 0;
+        if (!parseSize(parser, width, height))
+            return 1;
+        mask = syntheticImage(width, height, true);
+    }
+
+    const int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+    const double megapixels = mask.pixels.size() / 1e6;
+    out() << "image " << mask.width << "x" << mask.height << " (" << megapixels << " MP), "
+          << Parallel::threadCount() << " threads" << Qt::endl;
+
+    std::vector<uint32_t> labels;
+    uint32_t components = 0;
+    const double twoPassMs = bestOfMs(repeat, [&] { components = labelTwoPass(mask, labels); });
+    out() << "two-pass  " << twoPassMs << " ms, " << components << " components" << Qt::endl;
+    const double parallelMs = bestOfMs(repeat, [&] { components = labelParallel(mask, labels); });
+    out() << "parallel  " << parallelMs << " ms, " << components << " components" << Qt::endl;
+
+    Mask fillMask = mask;
+    size_t filled = 0;
+    const double fillMs = bestOfMs(1, [&] {
+        for (int y = 0; y < fillMask.height; ++y) {
+            for (int x = 0; x < fillMask.width; ++x) {
+                if (fillMask.at(x, y) == 1) {
+                    ScanlineFill fill(fillMask, x, y, 2);
+                    while (fill.step(SIZE_MAX)) {
+                    }
+                    filled += fill.filledPixels();
+                }
+            }
+        }
+    });
+    out() << "flood fill all components " << fillMs << " ms, " << filled << " pixels" << Qt::endl;
+    return 0;
+}
+
+// Runs the stage list through every variant on one image; the Tiled variant
+// is timed at one thread and at --threads so fusion and parallelism show up
+// separately. Each result is checked against the naive one.
+int runPipeline(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    Mask gray;
+    if (!inputs.isEmpty()) {
+        QImage image;
+        if (!readImage(inputs.first(), image))
+            return 1;
+        gray = ImageConvert::toGray(image);
+    } else {
+        int width = 0;
+        int height = 0;
+        if (!parseSize(parser, width, height))
+            return 1;
+        gray = syntheticImage(width, height, false);
+    }
+
+    std::vector<ImagePipeline::Stage> stages;
+    for (const QString &name : parser.value(QStringLiteral("stages")).split(QLatin1Char(','))) {
+        ImagePipeline::Stage stage;
+        if (!ImagePipeline::stageFromName(name.trimmed().toStdString(), stage)) {
+            err() << "Unknown stage " << name << Qt::endl;
+            return 1;
+        }
+        stages.push_back(stage);
+    }
+
+    ImagePipeline::Options options;
+    options.blurRadius = parser.value(QStringLiteral("radius")).toInt();
+    const int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+    const int threads = Parallel::threadCount();
+    out() << "image " << gray.width << "x" << gray.height << " (" << gray.pixels.size() / 1e6 << " MP), "
+          << parser.value(QStringLiteral("stages")) << ", AVX2 "
+          << (ImagePipeline::hasVectorKernel() ? "yes" : "no") << Qt::endl;
+
+    Mask reference;
+    double naiveMs = 0;
+    const ImagePipeline::Variant variants[] = { ImagePipeline::Variant::Naive, ImagePipeline::Variant::Separable,
+                                                ImagePipeline::Variant::Vector, ImagePipeline::Variant::Tiled,
+                                                ImagePipeline::Variant::Tiled };
+    for (size_t i = 0; i < std::size(variants); ++i) {
+        const bool serial = i + 1 < std::size(variants);
+        Parallel::setThreadCount(serial ? 1 : threads);
+        Mask result;
+        // The naive loops are slow enough that one run is plenty.
+        const double ms = bestOfMs(i == 0 ? 1 : repeat, [&] {
+            result = ImagePipeline::run(gray, stages, variants[i], options);
+        });
+        if (i == 0) {
+            reference = std::move(result);
+            naiveMs = ms;
+        }
+        out() << QString::fromLatin1(ImagePipeline::variantName(variants[i])).leftJustified(10)
+              << QString::number(ms, 'f', 1).rightJustified(9) << " ms  "
+              << QString::number(naiveMs / ms, 'f', 1).rightJustified(6) << "x  "
+              << Parallel::threadCount() << (Parallel::threadCount() == 1 ? " thread" : " threads")
+              << (i == 0 || result.pixels == reference.pixels ? "" : "  MISMATCH") << Qt::endl;
+    }
+    Parallel::setThreadCount(threads);
+    return 0;
+}
+
+// Times each stage of the codec on its own and then the whole thing. The
+// match finders are timed without entropy coding and the entropy coders on
+// the raw input; every decode is checked against the input.
+int runCompress(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    std::vector<uint8_t> data;
+    if (!inputs.isEmpty()) {
+        QFile file(inputs.first());
+        if (!file.open(QIODevice::ReadOnly)) {
+            err() << "Cannot read " << inputs.first() << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        const QByteArray bytes = file.readAll();
+        data.assign(bytes.begin(), bytes.end());
+    } else {
+        data = syntheticText(size_t(std::max(1, parser.value(QStringLiteral("megabytes")).toInt())) << 20);
+    }
+
+    const int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+    const double megabytes = data.size() / 1e6;
+    const auto report = [&](const QString &name, double ms, size_t compressed, bool ok) {
+        out() << name.leftJustified(22) << QString::number(megabytes / (ms / 1e3), 'f', 1).rightJustified(9)
+              << " MB/s";
+        if (compressed)
+            out() << "  ratio " << QString::number(double(compressed) / std::max<size_t>(data.size(), 1), 'f', 3);
+        out() << (ok ? "" : "  MISMATCH") << Qt::endl;
+    };
+    out() << "input " << data.size() << " bytes, " << Parallel::threadCount() << " threads" << Qt::endl;
+
+    Codec::Options options;
+    options.depth = parser.value(QStringLiteral("depth")).toInt();
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> restored;
+    const Codec::Finder finders[] = { Codec::Finder::HashChain, Codec::Finder::BinaryTree };
+    for (Codec::Finder finder : finders) {
+        const QString name = finder == Codec::Finder::HashChain ? QStringLiteral("hash chain")
+                                                                : QStringLiteral("binary tree");
+        options.finder = finder;
+        options.entropy = Codec::Entropy::None;
+        double ms = bestOfMs(repeat, [&] { compressed = Codec::compress(data.data(), data.size(), options); });
+        report(name + QStringLiteral(" lz"), ms, compressed.size(), true);
+
+        options.entropy = Codec::Entropy::Rans;
+        ms = bestOfMs(repeat, [&] { compressed = Codec::compress(data.data(), data.size(), options); });
+        report(name + QStringLiteral(" + rans"), ms, compressed.size(), true);
+        ms = bestOfMs(repeat, [&] {
+            restored.clear();
+            Codec::decompress(compressed.data(), compressed.size(), restored);
+        });
+        report(QStringLiteral("  decompress"), ms, 0, restored == data);
+    }
+
+    restored.resize(data.size());
+    double ms = bestOfMs(repeat, [&] {
+        compressed.clear();
+        Huffman::encode(data.data(), data.size(), compressed);
+    });
+    report(QStringLiteral("huffman encode"), ms, compressed.size(), true);
+    bool ok = false;
+    ms = bestOfMs(repeat, [&] { ok = Huffman::decode(compressed.data(), compressed.size(), data.size(), restored.data()); });
+    report(QStringLiteral("huffman decode"), ms, 0, ok && restored == data);
+
+    ms = bestOfMs(repeat, [&] {
+        compressed.clear();
+        Rans::encode(data.data(), data.size(), compressed);
+    });
+    report(QStringLiteral("rans encode"), ms, compressed.size(), true);
+    ms = bestOfMs(repeat, [&] { ok = Rans::decode(compressed.data(), compressed.size(), data.size(), restored.data()); });
+    report(QStringLiteral("rans decode"), ms, 0, ok && restored == data);
+    return 0;
+}
+
+// Heap high-water mark of one call, over what was allocated before it.
+template <typename Function>
+size_t peakBytes(Function &&function)
+{
+    MemoryUsage::resetPeak();
+    const size_t before = MemoryUsage::current();
+    function();
+    return MemoryUsage::peak() - before;
+}
+
+// The quadratic sorts take too long past this, and bogo at any size.
+bool sitsOut(const Sorts::Algorithm &algorithm, size_t count)
+{
+    const std::string_view name = algorithm.name;
+    return algorithm.unbounded || (count > (1 << 16) && (name == "bubble" || name == "insertion" || name == "selection"));
+}
+
+QString kilobytes(size_t bytes)
+{
+    return QString::number((bytes + 1023) / 1024) + QStringLiteral(" KB");
+}
+
+QJsonObject sortResult(const char *name, const char *variant, size_t count, Sorts::Shape shape,
+                       const std::vector<double> &samples)
+{
+    QJsonArray times;
+    for (double ms : samples)
+        times.append(ms);
+    return QJsonObject {
+        { QStringLiteral("name"), QString::fromLatin1(name) },
+        { QStringLiteral("variant"), QString::fromLatin1(variant) },
+        { QStringLiteral("count"), double(count) },
+        { QStringLiteral("shape"), QString::fromLatin1(Sorts::shapeName(shape)) },
+        { QStringLiteral("samplesMs"), times },
+    };
+}
+
+double bestOf(const std::vector<double> &samples)
+{
+    return *std::min_element(samples.begin(), samples.end());
+}
+
+void sortCount(Sorts::Shape shape, size_t count, int repeat, QJsonArray &results)
+{
+    const std::vector<int32_t> input = Sorts::makeInput(shape, count, 1);
+    std::vector<int32_t> expected = input;
+    std::vector<int32_t> values = input;
+    out() << count << " elements, " << Sorts::shapeName(shape) << Qt::endl;
+
+    const std::vector<double> nativeSamples = samplesMs(repeat, [&] {
+        expected = input;
+        std::sort(expected.begin(), expected.end());
+    });
+    const double nativeMs = bestOf(nativeSamples);
+    results.append(sortResult("std::sort", "reference", count, shape, nativeSamples));
+    out() << QStringLiteral("std::sort").leftJustified(12) << QString::number(nativeMs, 'f', 2).rightJustified(10)
+          << " ms" << Qt::endl;
+
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (sitsOut(algorithm, count))
+            continue;
+        uint64_t events = 0;
+        uint64_t compares = 0;
+        std::vector<double> samples;
+        const size_t peak = peakBytes([&] {
+            samples = samplesMs(repeat, [&] {
+                values = input;
+                events = 0;
+                compares = 0;
+                Stepper stepper = algorithm.run(values);
+                while (stepper.next()) {
+                    ++events;
+                    compares += stepper.event().kind == VisualEvent::Compare;
+                }
+            });
+        });
+        const double ms = bestOf(samples);
+        results.append(sortResult(algorithm.name, "stepping", count, shape, samples));
+        out() << QString::fromLatin1(algorithm.name).leftJustified(12) << QString::number(ms, 'f', 2).rightJustified(10)
+              << " ms  " << QString::number(ms / nativeMs, 'f', 1).rightJustified(6) << "x  "
+              << events << " events, " << compares << " compares, "
+              << QString::number(events / (ms * 1e3), 'f', 1) << " M events/s, " << kilobytes(peak)
+              << (values == expected ? "" : "  MISMATCH") << Qt::endl;
+        if (!algorithm.native)
+            continue;
+        std::vector<double> plainSamples;
+        const size_t plainPeak = peakBytes([&] {
+            plainSamples = samplesMs(repeat, [&] {
+                values = input;
+                algorithm.native(values);
+            });
+        });
+        const double plainMs = bestOf(plainSamples);
+        results.append(sortResult(algorithm.name, "native", count, shape, plainSamples));
+        out() << QStringLiteral("  native").leftJustified(12) << QString::number(plainMs, 'f', 2).rightJustified(10)
+              << " ms  " << QString::number(plainMs / nativeMs, 'f', 1).rightJustified(6) << "x  "
+              << kilobytes(plainPeak) << (values == expected ? "" : "  MISMATCH") << Qt::endl;
+    }
+}
+
+// The fewest repetitions on each side for compare to call a change: the
+// normal approximation Statistics::mannWhitney uses is only good from about
+// eight values per sample.
+constexpr size_t MinCompareSamples = 8;
+
+// Drains each algorithm's coroutine as fast as it goes, which is the cost of
+// the stepping machinery plus the sort itself; std::sort on the same input
+// is the native reference, and algorithms with a plain version also get a
+// line for that. The quadratic sorts sit out large inputs. Each line ends
+// with the most heap the run had in use beyond the input array. With --json
+// every repetition's time is saved too, for compare, and there are at least
+// MinCompareSamples of them.
+int runSort(const QCommandLineParser &parser, const Environment &environment)
+{
+    Sorts::Shape shape;
+    if (!Sorts::shapeFromName(parser.value(QStringLiteral("shape")).toStdString(), shape)) {
+        err() << "Unknown shape " << parser.value(QStringLiteral("shape")) << Qt::endl;
+        return 1;
+    }
+    std::vector<size_t> counts;
+    for (const QString &count : parser.value(QStringLiteral("count")).split(QLatin1Char(','))) {
+        counts.push_back(count.toULongLong());
+        if (counts.back() == 0) {
+            err() << "Invalid --count" << Qt::endl;
+            return 1;
+        }
+    }
+    const QString path = parser.value(QStringLiteral("json"));
+    int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+    if (!path.isEmpty() && repeat < int(MinCompareSamples)) {
+        if (parser.isSet(QStringLiteral("repeat"))) {
+            err() << "Taking " << MinCompareSamples << " repetitions rather than " << repeat
+                  << ", the fewest compare can judge" << Qt::endl;
+        }
+        repeat = int(MinCompareSamples);
+    }
+
+    QJsonArray results;
+    for (size_t count : counts)
+        sortCount(shape, count, repeat, results);
+
+    if (path.isEmpty())
+        return 0;
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)) {
+        err() << "Cannot write " << path << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+    QJsonArray cpus;
+    for (int cpu : environment.cpus)
+        cpus.append(cpu);
+    const QJsonObject report {
+        { QStringLiteral("mode"), QStringLiteral("sort") },
+        { QStringLiteral("threads"), Parallel::threadCount() },
+        { QStringLiteral("repeat"), repeat },
+        { QStringLiteral("cpus"), cpus },
+        { QStringLiteral("machine"), Machine::toJson(environment.machine) },
+        { QStringLiteral("warnings"), QJsonArray::fromStringList(environment.warnings) },
+        { QStringLiteral("results"), results },
+    };
+    const QByteArray json = QJsonDocument(report).toJson();
+    if (file.write(json) != json.size() || !file.flush()) {
+        err() << "Cannot write " << path << ": " << file.errorString() << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
+
+QString fitLine(const char *what, const std::vector<Complexity::Point> &points)
+{
+    const Complexity::Fit fit = Complexity::fit(points);
+    if (!fit.model)
+        return QString();
+    return QStringLiteral("  %1 ~ %2 n^%3, closest %4 (±%5%)\n")
+            .arg(QString::fromLatin1(what).leftJustified(8))
+            .arg(fit.constant, 0, 'g', 3)
+            .arg(fit.exponent, 0, 'f', 2)
+            .arg(QString::fromLatin1(fit.model->name))
+            .arg(fit.modelError * 100, 0, 'f', 0);
+}
+
+// Sweeps n from 256 up to --count by doublings for every algorithm and
+// names the growth of its time, compares and moves. A size that takes
+// longer than --budget ms is an algorithm's last, so quadratic cases end
+// early instead of running for hours.
+int runScaling(const QCommandLineParser &parser)
+{
+    Sorts::Shape shape;
+    if (!Sorts::shapeFromName(parser.value(QStringLiteral("shape")).toStdString(), shape)) {
+        err() << "Unknown shape " << parser.value(QStringLiteral("shape")) << Qt::endl;
+        return 1;
+    }
+    const size_t largest = parser.value(QStringLiteral("count")).toULongLong();
+    const double budgetMs = parser.value(QStringLiteral("budget")).toDouble();
+    out() << "n = 256 .. " << largest << ", " << Sorts::shapeName(shape) << Qt::endl;
+
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (algorithm.unbounded)
+            continue;
+        out() << algorithm.name << Qt::endl;
+        std::vector<Complexity::Point> times;
+        std::vector<Complexity::Point> compares;
+        std::vector<Complexity::Point> moves;
+        Complexity::sweep(algorithm, shape, 256, largest, budgetMs, [&](const Complexity::Measurement &measurement) {
+            const double n = double(measurement.n);
+            times.push_back({ n, measurement.ms });
+            compares.push_back({ n, double(measurement.compares) });
+            moves.push_back({ n, double(measurement.moves) });
+            out() << QString::number(measurement.n).rightJustified(12)
+                  << QString::number(measurement.ms, 'f', 3).rightJustified(12) << " ms"
+                  << QString::number(measurement.compares).rightJustified(16) << " compares"
+                  << QString::number(measurement.moves).rightJustified(16) << " moves" << Qt::endl;
+            return true;
+        });
+        out() << fitLine("time", times) << fitLine("compares", compares) << fitLine("moves", moves) << Qt::flush;
+    }
+    return 0;
+}
+
+bool readReport(const QString &path, QJsonObject &report)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        err() << "Cannot read " << path << ": " << file.errorString() << Qt::endl;
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject() || !document.object().value(QStringLiteral("results")).isArray()) {
+        err() << path << " is not a bench --json report: " << parseError.errorString() << Qt::endl;
+        return false;
+    }
+    report = document.object();
+    return true;
+}
+
+// Timings from different machines, or from one that was throttling, are
+// not comparable however significant the test says they differ.
+void noteEnvironments(const QJsonObject &baseline, const QJsonObject &candidate)
+{
+    const QJsonObject machines[] = { baseline.value(QStringLiteral("machine")).toObject(),
+                                     candidate.value(QStringLiteral("machine")).toObject() };
+    const QString models[] = { machines[0].value(QStringLiteral("cpuModel")).toString(),
+                               machines[1].value(QStringLiteral("cpuModel")).toString() };
+    if (models[0] != models[1])
+        err() << "note: baseline ran on " << models[0] << ", candidate on " << models[1] << Qt::endl;
+    const char *names[] = { "baseline", "candidate" };
+    for (int i = 0; i < 2; ++i) {
+        for (const QJsonValue &warning : (i ? candidate : baseline).value(QStringLiteral("warnings")).toArray())
+            err() << "note: " << names[i] << " " << warning.toString() << Qt::endl;
+    }
+}
+
+QString resultKey(const QJsonObject &result)
+{
+    return result.value(QStringLiteral("name")).toString() + QLatin1Char('/')
+            + result.value(QStringLiteral("variant")).toString() + QLatin1Char('/')
+            + result.value(QStringLiteral("shape")).toString() + QLatin1Char('/')
+            + QString::number(result.value(QStringLiteral("count")).toDouble(), 'f', 0);
+}
+
+std::vector<double> resultSamples(const QJsonObject &result)
+{
+    std::vector<double> samples;
+    for (const QJsonValue &ms : result.value(QStringLiteral("samplesMs")).toArray())
+        samples.push_back(ms.toDouble());
+    return samples;
+}
+
+// Lines up two sort --json reports and tests each measurement for a shift
+// with Mann-Whitney, which does not mind the long right tail that timings
+// have. A change counts only if it is both significant at --alpha and
+// larger than --min-change percent, so a real but negligible drift does
+// not fail a build. Exits with 2 if anything got slower, for gating, and
+// otherwise with 3 if some measurements could not be judged.
+int runCompare(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    if (inputs.size() != 2) {
+        err() << "compare takes two sort --json reports: baseline and candidate" << Qt::endl;
+        return 1;
+    }
+    QJsonObject baselineReport;
+    QJsonObject candidateReport;
+    if (!readReport(inputs[0], baselineReport) || !readReport(inputs[1], candidateReport))
+        return 1;
+    noteEnvironments(baselineReport, candidateReport);
+    const QJsonArray baseline = baselineReport.value(QStringLiteral("results")).toArray();
+    const QJsonArray candidate = candidateReport.value(QStringLiteral("results")).toArray();
+    const double alpha = parser.value(QStringLiteral("alpha")).toDouble();
+    const double minChange = parser.value(QStringLiteral("min-change")).toDouble();
+
+    QHash<QString, QJsonObject> baselineByKey;
+    for (const QJsonValue &result : baseline)
+        baselineByKey.insert(resultKey(result.toObject()), result.toObject());
+
+    int slower = 0;
+    int faster = 0;
+    int unjudged = 0;
+    for (const QJsonValue &value : candidate) {
+        const QJsonObject result = value.toObject();
+        const auto match = baselineByKey.constFind(resultKey(result));
+        if (match == baselineByKey.constEnd())
+            continue;
+        const std::vector<double> before = resultSamples(*match);
+        const std::vector<double> after = resultSamples(result);
+        if (before.empty() || after.empty())
+            continue;
+        const double beforeMs = Statistics::median(before);
+        const double afterMs = Statistics::median(after);
+        const double change = (afterMs / beforeMs - 1) * 100;
+        const Statistics::RankTest test = Statistics::mannWhitney(after, before);
+
+        QString verdict;
+        if (before.size() < MinCompareSamples || after.size() < MinCompareSamples) {
+            verdict = QStringLiteral("too few samples");
+            ++unjudged;
+        } else if (test.p >= alpha || std::abs(change) < minChange) {
+            verdict = QStringLiteral("same");
+        } else if (change > 0) {
+            verdict = QStringLiteral("SLOWER");
+            ++slower;
+        } else {
+            verdict = QStringLiteral("faster");
+            ++faster;
+        }
+        const QString label = result.value(QStringLiteral("name")).toString()
+                + (result.value(QStringLiteral("variant")).toString() == QLatin1String("native")
+                       ? QStringLiteral(" native") : QString());
+        out() << label.leftJustified(20) << QString::number(result.value(QStringLiteral("count")).toDouble(), 'f', 0)
+                                                    .rightJustified(10)
+              << QString::number(beforeMs, 'f', 2).rightJustified(10) << " ->"
+              << QString::number(afterMs, 'f', 2).rightJustified(10) << " ms"
+              << ((change >= 0 ? QStringLiteral("+") : QString()) + QString::number(change, 'f', 1) + QLatin1Char('%'))
+                         .rightJustified(9)
+              << "  p " << QString::number(test.p, 'g', 2).leftJustified(9) << verdict << Qt::endl;
+    }
+    out() << slower << " slower, " << faster << " faster at alpha " << alpha << Qt::endl;
+    if (unjudged) {
+        err() << "warning: " << unjudged << " measurements have fewer than " << MinCompareSamples
+              << " repetitions on a side and could not be judged; rerun sort --json with --repeat "
+              << MinCompareSamples << " or more" << Qt::endl;
+    }
+    return slower ? 2 : unjudged ? 3 : 0;
+}
+
+// Tries each candidate for one setting, keeps the fastest and prints the
+// lot. The incumbent stays unless a candidate beats it by more than 3%, so
+// noise does not flip settings between runs.
+template <typename T>
+T pickFastest(const char *name, T &setting, std::initializer_list<T> candidates, int repeat,
+              const std::function<void()> &measured)
+{
+    const T incumbent = setting;
+    const double incumbentMs = bestOfMs(repeat, measured);
+    T best = incumbent;
+    double bestMs = incumbentMs;
+    out() << name << Qt::endl;
+    for (const T candidate : candidates) {
+        setting = candidate;
+        const double ms = candidate == incumbent ? incumbentMs : bestOfMs(repeat, measured);
+        out() << QString::number(qint64(candidate)).rightJustified(10) << QString::number(ms, 'f', 2).rightJustified(10)
+              << " ms" << Qt::endl;
+        if (ms < bestMs && (best != incumbent || ms < incumbentMs * 0.97)) {
+            best = candidate;
+            bestMs = ms;
+        }
+    }
+    setting = best;
+    out() << "  -> " << qint64(best) << Qt::endl;
+    return best;
+}
+
+// Searches each setting of the Tuning profile in turn, the others held at
+// their current values, on --count random values for the sorts and a
+// synthetic image (--size if given, else 2048x2048) for the pipeline, and
+// writes the result to --profile.
+int runTune(const QCommandLineParser &parser)
+{
+    const size_t count = parser.value(QStringLiteral("count")).toULongLong();
+    const std::vector<int32_t> input = Sorts::makeInput(Sorts::Shape::Random, count, 1);
+    std::vector<int32_t> values;
+    int width = 2048;
+    int height = 2048;
+    if (parser.isSet(QStringLiteral("size")) && !parseSize(parser, width, height))
+        return 1;
+    const Mask gray = syntheticImage(width, height, false);
+    const int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+    out() << count << " values, " << width << "x" << height << " image, " << Parallel::threadCount() << " threads"
+          << Qt::endl;
+
+    Tuning::Profile profile = Tuning::current();
+    const auto sortWith = [&](const char *name) {
+        const Sorts::Algorithm *algorithm = Sorts::findAlgorithm(name);
+        return [&values, &input, algorithm] {
+            values = input;
+            algorithm->native(values);
+        };
+    };
+    const auto applied = [&](const std::function<void()> &measured) {
+        return [&profile, measured] {
+            Tuning::setCurrent(profile);
+            measured();
+        };
+    };
+    const auto pipeline = [&](std::vector<ImagePipeline::Stage> stages) {
+        return [&gray, stages] { ImagePipeline::run(gray, stages, ImagePipeline::Variant::Tiled); };
+    };
+    const auto merge = sortWith("merge");
+    const auto quick = sortWith("quick");
+
+    pickFastest<size_t>("insertion cutoff", profile.insertionCutoff, { 1, 4, 8, 12, 16, 24, 32, 48, 64 }, repeat,
+                        applied([&] {
+                            merge();
+                            quick();
+                        }));
+    pickFastest<int>("radix bits", profile.radixBits, { 4, 6, 8, 10, 11, 12, 16 }, repeat,
+                     applied(sortWith("radix")));
+    pickFastest<size_t>("merge piece", profile.mergePiece, { 1 << 10, 1 << 12, 1 << 14, 1 << 16, 1 << 18 }, repeat,
+                        applied(sortWith("merge-path")));
+    const auto fused = pipeline({ ImagePipeline::Stage::Blur, ImagePipeline::Stage::Sobel });
+    pickFastest<int>("tile width", profile.tileWidth, { 128, 256, 512, 1024, 2048 }, repeat, applied(fused));
+    pickFastest<int>("tile height", profile.tileHeight, { 16, 32, 64, 128, 256 }, repeat, applied(fused));
+    pickFastest<size_t>("row grain", profile.rowGrain, { 8, 16, 32, 64, 128, 256 }, repeat,
+                        applied(pipeline({ ImagePipeline::Stage::Equalize })));
+
+    Tuning::setCurrent(profile);
+    const QString path = parser.value(QStringLiteral("profile"));
+    QString error;
+    if (!Tuning::save(path, profile, &error)) {
+        err() << error << Qt::endl;
+        return 1;
+    }
+    out() << "Wrote " << path << Qt::endl;
+    return 0;
+}
+
+// A parallel engine as the threads mode runs it. prepare() builds an input
+// of the given size and returns the call to time; bytes() is the least
+// memory traffic that call needs at that many threads, so the GB/s column
+// is a floor on the bandwidth actually used.
+struct ParallelWorkload
+{
+    const char *name;
+    const char *unit;
+    size_t size; // strong scaling size; weak scaling gives each thread size / max threads
+    std::function<std::function<void()>(size_t size)> prepare;
+    std::function<double(size_t size, int threads)> bytes;
+};
+
+// Images are ImageWidth wide, as tall as the size asks.
+constexpr int ImageWidth = 4096;
+
+int imageHeight(size_t pixels)
+{
+    return int(std::max<size_t>(pixels / ImageWidth, 1));
+}
+
+std::vector<ParallelWorkload> parallelWorkloads()
+{
+    return {
+        { "life", "cells", size_t(1) << 26,
+          [](size_t cells) {
+              auto board = std::make_shared<LifeBoard>(ImageWidth, imageHeight(cells));
+              board->randomize(1);
+              return [board] { board->step(); };
+          },
+          // One bit per cell read and written.
+          [](size_t cells, int) { return cells / 4.0; } },
+        { "label", "pixels", size_t(1) << 24,
+          [](size_t pixels) {
+              auto mask = std::make_shared<Mask>(syntheticImage(ImageWidth, imageHeight(pixels), true));
+              auto labels = std::make_shared<std::vector<uint32_t>>();
+              return [mask, labels] { labelParallel(*mask, *labels); };
+          },
+          // The mask read, and 32-bit labels written then relabelled in place.
+          [](size_t pixels, int) { return pixels * 13.0; } },
+        { "pipeline", "pixels", size_t(1) << 24,
+          [](size_t pixels) {
+              auto gray = std::make_shared<Mask>(syntheticImage(ImageWidth, imageHeight(pixels), false));
+              return [gray] {
+                  ImagePipeline::run(*gray, { ImagePipeline::Stage::Blur, ImagePipeline::Stage::Sobel },
+                                     ImagePipeline::Variant::Tiled);
+              };
+          },
+          // Fused, so one read and one write per pixel.
+          [](size_t pixels, int) { return pixels * 2.0; } },
+        { "merge-path", "elements", size_t(1) << 24,
+          [](size_t count) {
+              auto input = std::make_shared<std::vector<int32_t>>(Sorts::makeInput(Sorts::Shape::Random, count, 1));
+              auto values = std::make_shared<std::vector<int32_t>>();
+              return [input, values] {
+                  *values = *input;
+                  MergePath::sort(*values);
+              };
+          },
+          // The copy, the block sorts, then a read and a write per merge round.
+          [](size_t count, int threads) {
+              const double rounds = threads > 1 ? std::ceil(std::log2(threads)) + 1 : 0;
+              return count * 8.0 * (2 + rounds);
+          } },
+        { "compress", "bytes", size_t(1) << 26,
+          [](size_t size) {
+              auto data = std::make_shared<std::vector<uint8_t>>(syntheticText(size));
+              return [data] { Codec::compress(data->data(), data->size()); };
+          },
+          [](size_t size, int) { return size * 1.0; } },
+    };
+}
+
+// 1, 2, 4, ... up to the most threads, which is always included.
+std::vector<int> threadSteps(int most)
+{
+    std::vector<int> steps;
+    for (int threads = 1; threads < most; threads *= 2)
+        steps.push_back(threads);
+    steps.push_back(most);
+    return steps;
+}
+
+QString bar(double fraction, int width)
+{
+    return QString(std::clamp(int(std::lround(fraction * width)), 0, width), QLatin1Char('#'));
+}
+
+// Times one workload at each thread count, strong (the same size for all)
+// or weak (the size growing with the threads), and charts the efficiency.
+void scaleWorkload(const ParallelWorkload &workload, bool weak, const std::vector<int> &steps, int repeat)
+{
+    const int most = steps.back();
+    const size_t perThread = std::max<size_t>(workload.size / size_t(most), 1);
+    if (weak)
+        out() << workload.name << ", weak: " << perThread << " " << workload.unit << " per thread" << Qt::endl;
+    else
+        out() << workload.name << ", strong: " << workload.size << " " << workload.unit << Qt::endl;
+    out() << "threads" << QStringLiteral("ms").rightJustified(12) << QStringLiteral("speedup").rightJustified(10)
+          << QStringLiteral("efficiency").rightJustified(12) << QStringLiteral("GB/s").rightJustified(9) << Qt::endl;
+
+    double singleMs = 0;
+    int fallsOffAt = 0;
+    for (int threads : steps) {
+        const size_t size = weak ? perThread * size_t(threads) : workload.size;
+        Parallel::setThreadCount(threads);
+        const std::function<void()> run = workload.prepare(size);
+        run(); // first touch of the output, and of the pool
+        const double ms = bestOfMs(repeat, run);
+        if (threads == 1)
+            singleMs = ms;
+        // Weak scaling's speedup is how much more work got done in the time.
+        const double speedup = singleMs / ms * (weak ? threads : 1);
+        const double efficiency = speedup / threads;
+        if (!fallsOffAt && efficiency < 0.5)
+            fallsOffAt = threads;
+        out() << QString::number(threads).rightJustified(7) << QString::number(ms, 'f', 2).rightJustified(12)
+              << (QString::number(speedup, 'f', 2) + QLatin1Char('x')).rightJustified(10)
+              << (QString::number(efficiency * 100, 'f', 0) + QLatin1Char('%')).rightJustified(12)
+              << QString::number(workload.bytes(size, threads) / (ms * 1e6), 'f', 2).rightJustified(9) << "  "
+              << bar(efficiency, 40) << Qt::endl;
+    }
+    if (fallsOffAt)
+        out() << "  efficiency below 50% from " << fallsOffAt << " threads" << Qt::endl;
+    Parallel::setThreadCount(most);
+}
+
+// Strong and weak scaling of the engines that use the Parallel pool, at
+// 1, 2, 4, ... threads up to the current count (all cores, --threads or
+// the pinned CPUs). The workloads to run may be named as inputs.
+int runThreads(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    const int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+    const std::vector<int> steps = threadSteps(Parallel::threadCount());
+    bool ran = false;
+    for (const ParallelWorkload &workload : parallelWorkloads()) {
+        if (!inputs.isEmpty() && !inputs.contains(QLatin1String(workload.name)))
+            continue;
+        scaleWorkload(workload, false, steps, repeat);
+        scaleWorkload(workload, true, steps, repeat);
+        ran = true;
+    }
+    if (!ran) {
+        err() << "No such workload; try life, label, pipeline, merge-path or compress" << Qt::endl;
+        return 1;
+    }
+    return 0;
+}
+
+// What a stepping run tells about memory traffic: a compare reads two
+// elements, a swap reads and writes two, and a write stores one whose
+// value was read from somewhere first.
+struct TraceTraffic
+{
+    double ops = 0; // compares and moves
+    double bytes = 0;
+};
+
+TraceTraffic traceTraffic(const Sorts::Algorithm &algorithm, std::vector<int32_t> values)
+{
+    TraceTraffic traffic;
+    Stepper stepper = algorithm.run(values);
+    while (stepper.next()) {
+        switch (stepper.event().kind) {
+        case VisualEvent::Compare:
+            traffic.ops += 1;
+            traffic.bytes += 2 * sizeof(int32_t);
+            break;
+        case VisualEvent::Swap:
+            traffic.ops += 1;
+            traffic.bytes += 4 * sizeof(int32_t);
+            break;
+        case VisualEvent::Write:
+            traffic.ops += 1;
+            traffic.bytes += 2 * sizeof(int32_t);
+            break;
+        case VisualEvent::Mark:
+            break;
+        }
+    }
+    return traffic;
+}
+
+// Log-log: intensity from 1/64 to 64 ops per byte across, Gop/s from
+// 1/10000 of the peak to twice it up. Each run is a letter.
+void printRooflineChart(double peak, double bandwidth, const std::vector<Roofline::Placement> &placements)
+{
+    constexpr int Columns = 64;
+    constexpr int Rows = 16;
+    const double minLog = std::log10(peak / 1e4);
+    const double maxLog = std::log10(peak * 2);
+    const auto column = [&](double intensity) {
+        return std::clamp(int(std::lround((std::log2(intensity) + 6) / 12 * Columns)), 0, Columns);
+    };
+    const auto row = [&](double gops) {
+        const double position = (std::log10(std::max(gops, 1e-12)) - minLog) / (maxLog - minLog);
+        return std::clamp(Rows - int(std::lround(position * Rows)), 0, Rows);
+    };
+
+    std::vector<QString> grid(Rows + 1, QString(Columns + 1, QLatin1Char(' ')));
+    for (int x = 0; x <= Columns; ++x) {
+        const double intensity = std::exp2(double(x) / Columns * 12 - 6);
+        const bool memoryBound = intensity * bandwidth < peak;
+        grid[size_t(row(std::min(peak, intensity * bandwidth)))][x] = memoryBound ? QLatin1Char('/') : QLatin1Char('-');
+    }
+    for (size_t i = 0; i < placements.size(); ++i)
+        grid[size_t(row(placements[i].achieved))][column(placements[i].intensity)] = QLatin1Char(char('a' + i % 26));
+    out() << "Gop/s" << Qt::endl;
+    for (int y = 0; y <= Rows; ++y) {
+        const double gops = std::pow(10.0, maxLog - (maxLog - minLog) * y / Rows);
+        out() << (y % 4 == 0 ? QString::number(gops, 'g', 2) : QString()).rightJustified(8) << " |" << grid[size_t(y)]
+              << Qt::endl;
+    }
+    out() << QString(10, QLatin1Char(' ')) << QStringLiteral("1/64").leftJustified(Columns / 2)
+          << QStringLiteral("1").leftJustified(Columns / 2 - 2) << "64 ops/byte" << Qt::endl;
+}
+
+// A STREAM-like bandwidth probe over three --megabytes arrays and a vector
+// integer peak, on one thread and on all, then every algorithm placed on
+// the one-thread roofline. The sorts run with the pool capped at one
+// thread, merge-path included, since that is the roof they are placed
+// against and the miss counter only sees the calling thread. Bytes come
+// from that counter, in the fastest repetition, where perf events work,
+// and from the event trace where they do not, which counts cache hits too
+// and so places runs further left than memory really sees them. A run
+// with no misses at all has no intensity to place it at and is left off
+// the chart.
+int runRoofline(const QCommandLineParser &parser)
+{
+    Sorts::Shape shape;
+    if (!Sorts::shapeFromName(parser.value(QStringLiteral("shape")).toStdString(), shape)) {
+        err() << "Unknown shape " << parser.value(QStringLiteral("shape")) << Qt::endl;
+        return 1;
+    }
+    const size_t count = parser.value(QStringLiteral("count")).toULongLong();
+    const size_t arrayBytes = parser.value(QStringLiteral("megabytes")).toULongLong() << 20;
+    const int repeat = std::max(1, parser.value(QStringLiteral("repeat")).toInt());
+
+    const int threads = Parallel::threadCount();
+    Parallel::setThreadCount(1);
+    const Roofline::Bandwidth single = Roofline::measureBandwidth(arrayBytes, repeat);
+    const double singlePeak = Roofline::measurePeakOps(repeat);
+    Parallel::setThreadCount(threads);
+    const Roofline::Bandwidth all = Roofline::measureBandwidth(arrayBytes, repeat);
+    const double allPeak = Roofline::measurePeakOps(repeat);
+    const auto printRoof = [](int threads, const Roofline::Bandwidth &bandwidth, double peak) {
+        out() << threads << (threads == 1 ? " thread:  " : " threads: ") << "copy "
+              << QString::number(bandwidth.copy, 'f', 1) << " GB/s, triad " << QString::number(bandwidth.triad, 'f', 1)
+              << " GB/s, peak " << QString::number(peak, 'f', 1) << " Gop/s, ridge at "
+              << QString::number(peak / bandwidth.triad, 'f', 2) << " ops/byte" << Qt::endl;
+    };
+    printRoof(1, single, singlePeak);
+    printRoof(threads, all, allPeak);
+
+    Roofline::MissCounter counter;
+    out() << count << " elements, " << Sorts::shapeName(shape) << ", bytes from "
+          << (counter.available() ? "last-level cache misses" : "the event trace (no perf counters here)") << Qt::endl;
+
+    const std::vector<int32_t> input = Sorts::makeInput(shape, count, 1);
+    std::vector<int32_t> values;
+    std::vector<Roofline::Placement> placements;
+    QStringList legend;
+    Parallel::setThreadCount(1);
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (sitsOut(algorithm, count))
+            continue;
+        const TraceTraffic traffic = traceTraffic(algorithm, input);
+        std::vector<uint64_t> missBytes;
+        const std::vector<double> samples = samplesMs(repeat, [&] {
+            values = input;
+            counter.start();
+            if (algorithm.native) {
+                algorithm.native(values);
+            } else {
+                Stepper stepper = algorithm.run(values);
+                while (stepper.next()) {
+                }
+            }
+            missBytes.push_back(counter.stop());
+        });
+        const size_t fastest = size_t(std::min_element(samples.begin(), samples.end()) - samples.begin());
+        const double ms = samples[fastest];
+        const double bytes = counter.available() ? double(missBytes[fastest]) : traffic.bytes;
+        if (bytes <= 0) {
+            out() << "  " << QString::fromLatin1(algorithm.name).leftJustified(12)
+                  << " no memory traffic measured, left off the chart" << Qt::endl;
+            continue;
+        }
+        const Roofline::Placement placement = Roofline::place(traffic.ops, bytes, ms / 1e3, singlePeak, single.triad);
+        const QChar letter = QLatin1Char(char('a' + placements.size() % 26));
+        placements.push_back(placement);
+        legend << QString(letter) + QLatin1Char(' ') + QString::fromLatin1(algorithm.name);
+        out() << letter << " " << QString::fromLatin1(algorithm.name).leftJustified(12)
+              << QString::number(placement.intensity, 'f', 3).rightJustified(8) << " ops/byte"
+              << QString::number(placement.achieved, 'f', 3).rightJustified(10) << " Gop/s, "
+              << QString::number(100 * placement.achieved / placement.roof, 'f', 1).rightJustified(5) << "% of a "
+              << (placement.memoryBound ? "memory" : "compute") << " roof" << (algorithm.native ? "" : " (stepping)")
+              << Qt::endl;
+    }
+    Parallel::setThreadCount(threads);
+    printRooflineChart(singlePeak, single.triad, placements);
+    out() << legend.join(QStringLiteral(", ")) << Qt::endl;
+    return 0;
+}
+
+// Scores each named algorithm (all but bogo when none are named) on a
+// random input, on McIlroy's adversary and on the best of a genetic
+// search, and with --output writes the worst input found for each to
+// <dir>/<name>.worst.txt, which the GUI opens as a dataset. --count
+// defaults to 2048 here; the adversary stops at 46340.
+int runAdversary(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    Adversary::SearchOptions options;
+    options.size = parser.isSet(QStringLiteral("count")) ? parser.value(QStringLiteral("count")).toULongLong() : 2048;
+    options.generations = std::max(0, parser.value(QStringLiteral("generations")).toInt());
+    const QString objective = parser.value(QStringLiteral("objective"));
+    if (objective == QLatin1String("time")) {
+        options.objective = Adversary::Objective::Time;
+    } else if (objective != QLatin1String("operations")) {
+        err() << "Unknown objective " << objective << "; use operations or time" << Qt::endl;
+        return 1;
+    }
+    const QString unit = options.objective == Adversary::Objective::Time ? QStringLiteral(" ms")
+                                                                         : QStringLiteral(" ops");
+    const QString directory = parser.value(QStringLiteral("output"));
+
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (inputs.isEmpty() ? algorithm.unbounded : !inputs.contains(QLatin1String(algorithm.name)))
+            continue;
+        const auto score = [&](const std::vector<int32_t> &input) {
+            return Adversary::score(algorithm, input, options.objective);
+        };
+        const std::vector<int32_t> random = Sorts::makeInput(Sorts::Shape::Random, options.size, 1);
+        const double randomScore = score(random);
+        out() << QString::fromLatin1(algorithm.name).leftJustified(12) << "random "
+              << QString::number(randomScore, 'f', 0) << unit << Qt::endl;
+
+        std::vector<int32_t> worst = random;
+        double worstScore = randomScore;
+        const std::vector<int32_t> killer = Adversary::antiSort(algorithm, options.size);
+        if (killer.size() == options.size) {
+            const double killerScore = score(killer);
+            out() << "  adversary  " << QString::number(killerScore, 'f', 0) << unit << "  "
+                  << QString::number(killerScore / randomScore, 'f', 2) << "x random" << Qt::endl;
+            if (killerScore > worstScore) {
+                worst = killer;
+                worstScore = killerScore;
+            }
+        }
+        const Adversary::SearchResult found = Adversary::search(algorithm, options);
+        out() << "  genetic    " << QString::number(found.score, 'f', 0) << unit << "  "
+              << QString::number(found.score / randomScore, 'f', 2) << "x random, generation " << found.generation
+              << Qt::endl;
+        if (found.score > worstScore) {
+            worst = found.input;
+            worstScore = found.score;
+        }
+
+        if (directory.isEmpty())
+            continue;
+        const QString path = directory + QLatin1Char('/') + QLatin1String(algorithm.name) + QLatin1String(".worst.txt");
+        QFile file(path);
+        if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate | QIODevice::Text)) {
+            err() << "Cannot write " << path << ": " << file.errorString() << Qt::endl;
+            return 1;
+        }
+        QTextStream text(&file);
+        text << "# " << algorithm.name << ", " << QString::number(worstScore, 'f', 0) << unit << Qt::endl;
+        for (int32_t value : worst)
+            text << value << '\n';
+    }
+    return 0;
+}
+
+// Analyzes the whole trace of each named algorithm (by default all that
+// do not sit out at --count) on --shape in one pass: event rate, memory
+// the pass held, swap distances by power of two, and the inversions and
+// working set at nine points through the run.
+int runTrace(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    Sorts::Shape shape;
+    if (!Sorts::shapeFromName(parser.value(QStringLiteral("shape")).toStdString(), shape)) {
+        err() << "Unknown shape " << parser.value(QStringLiteral("shape")) << Qt::endl;
+        return 1;
+    }
+    const size_t count = parser.value(QStringLiteral("count")).toULongLong();
+    const double pairs = std::max(double(count) * double(count - 1) / 2, 1.0);
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (inputs.isEmpty() ? sitsOut(algorithm, count) : !inputs.contains(QLatin1String(algorithm.name)))
+            continue;
+        QElapsedTimer timer;
+        timer.start();
+        const TraceAnalysis::Result stats = TraceAnalysis::analyze(algorithm, Sorts::makeInput(shape, count, 1));
+        const double seconds = std::max(timer.nsecsElapsed() / 1e9, 1e-9);
+        out() << QString::fromLatin1(algorithm.name).leftJustified(12) << stats.events << " events in "
+              << QString::number(seconds, 'f', 2) << " s, " << QString::number(stats.events / seconds / 1e6, 'f', 1)
+              << " M/s, " << kilobytes(stats.memoryBytes) << Qt::endl;
+
+        QString distances;
+        for (int k = 0; k < TraceAnalysis::DistanceBuckets; ++k) {
+            if (stats.distances[k])
+                distances += QStringLiteral(" 2^%1:%2").arg(k).arg(stats.distances[k]);
+        }
+        if (!distances.isEmpty())
+            out() << "  swap distances" << distances << Qt::endl;
+
+        const auto before = [](const TraceAnalysis::Sample &sample, uint64_t position) {
+            return sample.position < position;
+        };
+        QString inversions;
+        QString workingSet;
+        for (int step = 0; step <= 8; ++step) {
+            const uint64_t position = stats.events * uint64_t(step) / 8;
+            const auto sample = std::lower_bound(stats.samples.begin(), stats.samples.end(), position, before);
+            inversions += QString::number(100 * sample->inversions / pairs, 'f', 1).rightJustified(7);
+            workingSet += QString::number(sample->workingSet).rightJustified(7);
+        }
+        out() << "  inversions %" << inversions << Qt::endl << "  working set  " << workingSet << " lines"
+              << Qt::endl;
+    }
+    return 0;
+}
+
+// The sorts only take int32, so fuzz varies what the values look like
+// instead of their type: the catalog shapes over 1..n, the whole int32
+// range with both extremes thrown in (radix has to flip the sign bit),
+// and two values repeated throughout, where an unstable sort shows.
+// Sizes 0 to 3 come up often, since that is where off-by-ones live.
+std::vector<int32_t> fuzzInput(uint64_t seed, size_t most, QString &description)
+{
+    std::mt19937_64 random(seed);
+    const size_t size = random() % 4 == 0 ? random() % 4 : random() % (most + 1);
+    std::vector<int32_t> values(size);
+    switch (random() % 3) {
+    case 0: {
+        const auto shape = Sorts::Shape(random() % Sorts::ShapeCount);
+        description = QLatin1String(Sorts::shapeName(shape));
+        return Sorts::makeInput(shape, size, uint32_t(random()));
+    }
+    case 1: {
+        constexpr int32_t Extremes[] = { std::numeric_limits<int32_t>::min(), std::numeric_limits<int32_t>::max(),
+                                         0, -1 };
+        for (int32_t &value : values)
+            value = random() % 8 == 0 ? Extremes[random() % std::size(Extremes)] : int32_t(uint32_t(random()));
+        description = QStringLiteral("wide");
+        break;
+    }
+    default:
+        for (int32_t &value : values)
+            value = int32_t(random() % 2) - 1;
+        description = QStringLiteral("binary");
+        break;
+    }
+    return values;
+}
+
+// Runs the stepping version to the end and checks it sorted like
+// std::stable_sort, then that its trace holds up on its own: every index
+// in range, every write naming the value it really replaced, replaying it
+// on the input giving the result and undoing it from the result giving
+// the input back. For a stable algorithm it then checks that equal values
+// kept their order: a trace of swaps only is followed with each value's
+// original position. Writes don't say which of several equal values they
+// copy, so a sort that writes is run again on the input's ranks tagged
+// with their positions, rank * size + position, which makes every value
+// distinct but leaves the order of unequal ones alone. Its trace has to
+// be the same one, so the tags were never looked at, and its result then
+// shows where each value came from. Radix sorts by digits, which the tags
+// change, so only the sorts that report comparisons get that check.
+// Returns what went wrong, or an empty string.
+QString checkStepping(const Sorts::Algorithm &algorithm, const std::vector<int32_t> &input,
+                      const std::vector<int32_t> &expected, bool &stabilityChecked)
+{
+    std::vector<int32_t> values = input;
+    std::vector<VisualEvent> events;
+    Stepper stepper = algorithm.run(values);
+    while (stepper.next())
+        events.push_back(stepper.event());
+    if (values != expected)
+        return QStringLiteral("stepping result is not sorted");
+
+    const size_t size = input.size();
+    std::vector<int32_t> replay = input;
+    bool swapsOnly = true;
+    for (size_t i = 0; i < events.size(); ++i) {
+        const VisualEvent &event = events[i];
+        if (event.kind == VisualEvent::Mark) {
+            if (event.a > event.b || event.b > size)
+                return QStringLiteral("event %1 marks [%2, %3)").arg(i).arg(event.a).arg(event.b);
+            continue;
+        }
+        if (event.a >= size || event.b >= size)
+            return QStringLiteral("event %1 touches %2 and %3").arg(i).arg(event.a).arg(event.b);
+        if (event.kind == VisualEvent::Write) {
+            swapsOnly = false;
+            if (replay[event.a] != event.previous) {
+                return QStringLiteral("event %1 says it replaced %2 at %3, but %4 was there")
+                    .arg(i).arg(event.previous).arg(event.a).arg(replay[event.a]);
+            }
+        }
+        event.apply(replay);
+    }
+    if (replay != values)
+        return QStringLiteral("replaying the trace does not give the result");
+    for (auto event = events.rbegin(); event != events.rend(); ++event)
+        event->undo(replay);
+    if (replay != input)
+        return QStringLiteral("undoing the trace does not give the input back");
+
+    if (!algorithm.stable)
+        return {};
+    std::vector<uint32_t> origin(size);
+    std::iota(origin.begin(), origin.end(), 0);
+    if (swapsOnly) {
+        for (const VisualEvent &event : events) {
+            if (event.kind == VisualEvent::Swap)
+                std::swap(origin[event.a], origin[event.b]);
+        }
+    } else {
+        // The tags have to fit in an int32_t.
+        constexpr size_t MostTagged = 46340;
+        const bool compares = std::any_of(events.begin(), events.end(), [](const VisualEvent &event) {
+            return event.kind == VisualEvent::Compare;
+        });
+        if (!compares || size > MostTagged)
+            return {};
+        std::vector<int32_t> ranks = expected;
+        ranks.erase(std::unique(ranks.begin(), ranks.end()), ranks.end());
+        const auto rank = [&](int32_t value) {
+            return int32_t(std::lower_bound(ranks.begin(), ranks.end(), value) - ranks.begin());
+        };
+        std::vector<int32_t> tagged(size);
+        for (size_t i = 0; i < size; ++i)
+            tagged[i] = rank(input[i]) * int32_t(size) + int32_t(i);
+        Stepper twin = algorithm.run(tagged);
+        size_t i = 0;
+        for (; twin.next(); ++i) {
+            const VisualEvent &event = twin.event();
+            const bool same = i < events.size() && event.kind == events[i].kind && event.a == events[i].a
+                && event.b == events[i].b
+                && (event.kind != VisualEvent::Write || event.value / int32_t(size) == rank(events[i].value));
+            if (!same)
+                return QStringLiteral("event %1 changes once equal values are told apart by position").arg(i);
+        }
+        if (i != events.size())
+            return QStringLiteral("the trace ends at event %1 once equal values are told apart by position").arg(i);
+        for (size_t j = 0; j < size; ++j)
+            origin[j] = uint32_t(tagged[j]) % uint32_t(size);
+    }
+    stabilityChecked = true;
+    for (size_t i = 1; i < size; ++i) {
+        if (values[i] == values[i - 1] && origin[i] < origin[i - 1])
+            return QStringLiteral("equal values from %1 and %2 changed order").arg(origin[i - 1]).arg(origin[i]);
+    }
+    return {};
+}
+
+// Seeks a TracePlayer around the trace with a deadline that has always
+// passed, so every call stops at its first look at the clock, including
+// the re-derives after jumps back past the ring, and checks the array and
+// the last event at each stop against the trace itself. The checkpoint
+// spacing varies with the seed so that re-derives end on a clock check
+// too. Returns what went wrong, or an empty string.
+QString checkPlayer(const Sorts::Algorithm &algorithm, const std::vector<int32_t> &input, uint64_t seed)
+{
+    std::vector<VisualEvent> events;
+    {
+        std::vector<int32_t> values = input;
+        Stepper stepper = algorithm.run(values);
+        while (stepper.next())
+            events.push_back(stepper.event());
+    }
+
+    TracePlayer::Options options;
+    options.lookahead = 64;
+    options.history = 64;
+    options.checkpointInterval = uint64_t(256) << (seed % 5);
+    TracePlayer player;
+    player.start(&algorithm, input, options);
+    std::vector<int32_t> expected = input;
+    uint64_t expectedAt = 0;
+    const auto past = std::chrono::steady_clock::now();
+    std::mt19937_64 random(seed);
+    constexpr int Seeks = 12;
+    constexpr int MostCalls = 1 << 20;
+    for (int s = 0; s < Seeks; ++s) {
+        const uint64_t target = random() % (events.size() + 1);
+        int calls = 0;
+        while (!player.seek(target, past)) {
+            if (++calls == MostCalls)
+                return QStringLiteral("seek %1 to %2 never arrives").arg(s).arg(target);
+        }
+        for (; expectedAt < target; ++expectedAt)
+            events[expectedAt].apply(expected);
+        for (; expectedAt > target; --expectedAt)
+            events[expectedAt - 1].undo(expected);
+        if (player.position() != target || player.rederiving())
+            return QStringLiteral("seek %1 to %2 stopped at %3").arg(s).arg(target).arg(player.position());
+        if (!std::equal(expected.begin(), expected.end(), player.values().begin(), player.values().end()))
+            return QStringLiteral("seek %1 to %2 shows the wrong array").arg(s).arg(target);
+        VisualEvent last;
+        if (player.lastEvent(last)) {
+            const VisualEvent &real = events[target - 1];
+            if (last.kind != real.kind || last.a != real.a || last.b != real.b || last.value != real.value
+                || last.previous != real.previous)
+                return QStringLiteral("seek %1 to %2 shows the wrong last event").arg(s).arg(target);
+        }
+    }
+    return {};
+}
+
+struct FuzzFailure
+{
+    const char *algorithm;
+    uint64_t seed;
+    size_t size;
+    QString input;
+    QString problem;
+};
+
+// Fuzzes the named algorithms (all of them when none are named) against
+// std::stable_sort, and exits 1 on any failure. --cases inputs of up to
+// --count values (512 unless given) are spread over the pool, each run
+// through the stepping version with its trace checked as above and through
+// the native version, and every eighth also played back by checkPlayer();
+// bogo only gets those of up to 6 values. Then, on this thread so that
+// they can use the pool themselves, the native versions take a few inputs
+// big enough to reach their parallel and tuned paths. Input i comes from
+// seed --seed + i, so --seed s --cases 1 repeats a failure.
+int runFuzz(const QCommandLineParser &parser, const QStringList &inputs)
+{
+    const size_t most = parser.isSet(QStringLiteral("count")) ? parser.value(QStringLiteral("count")).toULongLong()
+                                                              : 512;
+    const uint64_t cases = parser.value(QStringLiteral("cases")).toULongLong();
+    const uint64_t firstSeed = parser.value(QStringLiteral("seed")).toULongLong();
+    std::vector<const Sorts::Algorithm *> algorithms;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (inputs.isEmpty() || inputs.contains(QLatin1String(algorithm.name)))
+            algorithms.push_back(&algorithm);
+    }
+    if (algorithms.empty()) {
+        err() << "No algorithm called " << inputs.join(QStringLiteral(", ")) << Qt::endl;
+        return 1;
+    }
+
+    std::mutex mutex;
+    std::vector<FuzzFailure> failures;
+    std::atomic<uint64_t> runs { 0 };
+    std::atomic<uint64_t> stabilityRuns { 0 };
+    const auto fail = [&](const Sorts::Algorithm &algorithm, uint64_t seed, size_t size, const QString &input,
+                          const QString &problem) {
+        std::lock_guard lock(mutex);
+        failures.push_back({ algorithm.name, seed, size, input, problem });
+    };
+
+    // The player check runs the whole trace once more and seeks about it.
+    constexpr uint64_t PlayerEvery = 8;
+    QElapsedTimer timer;
+    timer.start();
+    Parallel::forRange(0, cases, 1, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i) {
+            const uint64_t seed = firstSeed + i;
+            QString description;
+            const std::vector<int32_t> input = fuzzInput(seed, most, description);
+            std::vector<int32_t> expected = input;
+            std::stable_sort(expected.begin(), expected.end());
+            for (const Sorts::Algorithm *algorithm : algorithms) {
+                if (algorithm->unbounded && input.size() > 6)
+                    continue;
+                bool stabilityChecked = false;
+                const QString problem = checkStepping(*algorithm, input, expected, stabilityChecked);
+                if (!problem.isEmpty())
+                    fail(*algorithm, seed, input.size(), description, problem);
+                if (stabilityChecked)
+                    ++stabilityRuns;
+                if (seed % PlayerEvery == 0) {
+                    const QString playerProblem = checkPlayer(*algorithm, input, seed);
+                    if (!playerProblem.isEmpty())
+                        fail(*algorithm, seed, input.size(), description, QStringLiteral("player: ") + playerProblem);
+                }
+                if (algorithm->native) {
+                    std::vector<int32_t> values = input;
+                    algorithm->native(values);
+                    if (values != expected)
+                        fail(*algorithm, seed, input.size(), description, QStringLiteral("native result is not sorted"));
+                }
+                ++runs;
+            }
+        }
+    });
+
+    constexpr size_t LargeCases = 8;
+    for (size_t i = 0; i < LargeCases; ++i) {
+        const uint64_t seed = firstSeed + cases + i;
+        QString description;
+        const std::vector<int32_t> input = fuzzInput(seed, size_t(1) << 20, description);
+        std::vector<int32_t> expected = input;
+        std::sort(expected.begin(), expected.end());
+        for (const Sorts::Algorithm *algorithm : algorithms) {
+            if (!algorithm->native)
+                continue;
+            std::vector<int32_t> values = input;
+            algorithm->native(values);
+            if (values != expected)
+                fail(*algorithm, seed, input.size(), description, QStringLiteral("native result is not sorted"));
+            ++runs;
+        }
+    }
+
+    std::sort(failures.begin(), failures.end(), [](const FuzzFailure &a, const FuzzFailure &b) {
+        return a.seed < b.seed;
+    });
+    constexpr size_t MostShown = 20;
+    for (size_t i = 0; i < std::min(failures.size(), MostShown); ++i) {
+        const FuzzFailure &failure = failures[i];
+        err() << QString::fromLatin1(failure.algorithm).leftJustified(12) << "seed " << failure.seed << ", "
+              << failure.size << " values, " << failure.input << ": " << failure.problem << Qt::endl;
+    }
+    out() << runs.load() << " runs over " << cases + LargeCases << " inputs in "
+          << QString::number(timer.elapsed() / 1000.0, 'f', 1) << " s, " << stabilityRuns.load()
+          << " of them also checked for stability, " << failures.size() << " failed" << Qt::endl;
+    return failures.empty() ? 0 : 1;
+}
+
+// One stepping and one native run per algorithm with the running thread
+// profiled, and the pool workers its parallel sorts use, as JSON on stdout:
+// peak bytes, allocation count and the bytes in use over time, as
+// [nanoseconds, bytes] pairs.
+int runMemory(const QCommandLineParser &parser)
+{
+    Sorts::Shape shape;
+    if (!Sorts::shapeFromName(parser.value(QStringLiteral("shape")).toStdString(), shape)) {
+        err() << "Unknown shape " << parser.value(QStringLiteral("shape")) << Qt::endl;
+        return 1;
+    }
+    const size_t count = parser.value(QStringLiteral("count")).toULongLong();
+    const std::vector<int32_t> input = Sorts::makeInput(shape, count, 1);
+    std::vector<int32_t> values = input;
+    MemoryUsage::Profile profile;
+
+    const auto measure = [&](const Sorts::Algorithm &algorithm, bool stepping) {
+        values = input;
+        QElapsedTimer timer;
+        timer.start();
+        profile.attach();
+        if (stepping) {
+            Stepper stepper = algorithm.run(values);
+            while (stepper.next()) {
+            }
+        } else {
+            algorithm.native(values);
+        }
+        profile.detach();
+        const double ms = timer.nsecsElapsed() / 1e6;
+
+        QJsonArray timeline;
+        for (const MemoryUsage::Profile::Sample &sample : profile.timeline())
+            timeline.append(QJsonArray { qint64(sample.nanoseconds), qint64(sample.bytes) });
+        return QJsonObject {
+            { QStringLiteral("algorithm"), QString::fromLatin1(algorithm.name) },
+            { QStringLiteral("stepping"), stepping },
+            { QStringLiteral("ms"), ms },
+            { QStringLiteral("peakBytes"), qint64(profile.peakBytes()) },
+            { QStringLiteral("allocations"), qint64(profile.allocations()) },
+            { QStringLiteral("frees"), qint64(profile.frees()) },
+            { QStringLiteral("allocatedBytes"), qint64(profile.allocatedBytes()) },
+            { QStringLiteral("timeline"), timeline },
+        };
+    };
+
+    QJsonArray runs;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (sitsOut(algorithm, count))
+            continue;
+        runs.append(measure(algorithm, true));
+        if (algorithm.native)
+            runs.append(measure(algorithm, false));
+    }
+    const QJsonObject result {
+        { QStringLiteral("count"), qint64(count) },
+        { QStringLiteral("shape"), QString::fromLatin1(Sorts::shapeName(shape)) },
+        { QStringLiteral("runs"), runs },
+    };
+    out() << QJsonDocument(result).toJson();
+    return 0;
+}
+
+// Sample sort over --nodes local processes, at full speed: wall time from
+// the first fork to the last exit, how much crossed a socket, and how
+// unevenly the final partitions came out.
+int runDistSort(const QCommandLineParser &parser)
+{
+    Sorts::Shape shape;
+    if (!Sorts::shapeFromName(parser.value(QStringLiteral("shape")).toStdString(), shape)) {
+        err() << "Unknown shape " << parser.value(QStringLiteral("shape")) << Qt::endl;
+        return 1;
+    }
+    const size_t count = parser.value(QStringLiteral("count")).toULongLong();
+    const std::vector<int32_t> input = Sorts::makeInput(shape, count, 1);
+    std::vector<int32_t> expected = input;
+    std::sort(expected.begin(), expected.end());
+
+    DistributedSort::Options options;
+    options.nodes = parser.value(QStringLiteral("nodes")).toInt();
+    DistributedSort sort;
+    QString error;
+    if (!sort.start(QCoreApplication::applicationFilePath(), input, options, &error)) {
+        err() << error << Qt::endl;
+        return 1;
+    }
+    while (sort.poll())
+        std::this_thread::sleep_for(std::chrono::microseconds(200));
+
+    std::vector<int32_t> result;
+    out() << count << " elements, " << Sorts::shapeName(shape) << ", " << sort.nodes() << " nodes" << Qt::endl;
+    for (int i = 0; i < sort.nodes(); ++i) {
+        const std::span<const int32_t> partition = sort.incoming(i);
+        result.insert(result.end(), partition.begin(), partition.end());
+        out() << "  node " << i << ": " << partition.size() << " values" << Qt::endl;
+    }
+    out() << QString::number(sort.seconds() * 1e3, 'f', 2) << " ms, " << sort.networkValues()
+          << " values over sockets (" << QString::number(100.0 * sort.networkValues() / std::max<size_t>(count, 1), 'f', 1)
+          << "%), skew " << QString::number(sort.skew(), 'f', 2)
+          << (sort.failed() ? "  FAILED" : result == expected ? "" : "  MISMATCH") << Qt::endl;
+    return sort.failed() || result != expected;
+}
+
+} // namespace
+
+int main(int argc, char *argv[])
+{
+    if (argc > 1 && std::strcmp(argv[1], DistributedSort::NodeFlag) == 0)
+        return DistributedSort::runNode(argc, argv);
+    QCoreApplication app(argc, argv);
+    QCoreApplication::setApplicationName(QStringLiteral("animated_algorithms_bench"));
+
+    QCommandLineParser parser;
+    parser.setApplicationDescription(QStringLiteral("Headless benchmarks for the algorithm engines."));
+    parser.addHelpOption();
+    parser.addPositionalArgument(QStringLiteral("mode"),
+                                 QStringLiteral("Benchmark to run: label, pipeline, compress, sort, compare, "
+                                                "scaling, threads, roofline, adversary, fuzz, trace, "
+                                                "memory, tune, distsort."));
+    parser.addPositionalArgument(QStringLiteral("inputs"), QStringLiteral("Mode specific input files."),
+                                 QStringLiteral("[inputs...]"));
+    parser.addOptions({
+        { QStringLiteral("threads"), QStringLiteral("Worker threads (default: all cores)."), QStringLiteral("n") },
+        { QStringLiteral("repeat"), QStringLiteral("Repetitions per measurement."), QStringLiteral("n"), QStringLiteral("3") },
+        { QStringLiteral("size"), QStringLiteral("Synthetic image size when no image is given."),
+          QStringLiteral("WxH"), QStringLiteral("10000x10000") },
+        { QStringLiteral("threshold"), QStringLiteral("Gray level below which pixels are foreground."),
+          QStringLiteral("level"), QStringLiteral("128") },
+        { QStringLiteral("stages"), QStringLiteral("Comma separated pipeline stages: blur, sobel, median, equalize."),
+          QStringLiteral("list"), QStringLiteral("blur,sobel,median,equalize") },
+        { QStringLiteral("radius"), QStringLiteral("Blur radius."), QStringLiteral("pixels"), QStringLiteral("3") },
+        { QStringLiteral("megabytes"), QStringLiteral("Synthetic input size when no file is given; for roofline, "
+                                                      "the size of each bandwidth probe array."),
+          QStringLiteral("n"), QStringLiteral("64") },
+        { QStringLiteral("depth"), QStringLiteral("Match finder search depth."), QStringLiteral("n"),
+          QStringLiteral("16") },
+        { QStringLiteral("count"), QStringLiteral("Elements to sort; sort takes a comma separated list, scaling "
+                                                  "goes up to it."),
+          QStringLiteral("n"), QStringLiteral("1000000") },
+        { QStringLiteral("shape"), QStringLiteral("Sort input: random, sorted, reversed, nearly-sorted, few-unique, "
+                                                  "sawtooth, organ-pipe, rotated."),
+          QStringLiteral("name"), QStringLiteral("random") },
+        { QStringLiteral("budget"), QStringLiteral("Longest size scaling measures for one algorithm."),
+          QStringLiteral("ms"), QStringLiteral("1000") },
+        { QStringLiteral("generations"), QStringLiteral("Generations of the adversary's genetic search."),
+          QStringLiteral("n"), QStringLiteral("100") },
+        { QStringLiteral("objective"), QStringLiteral("What adversary maximizes: operations or time."),
+          QStringLiteral("name"), QStringLiteral("operations") },
+        { QStringLiteral("cases"), QStringLiteral("Random inputs fuzz runs every algorithm on."),
+          QStringLiteral("n"), QStringLiteral("2000") },
+        { QStringLiteral("seed"), QStringLiteral("Seed of fuzz's first input."), QStringLiteral("n"),
+          QStringLiteral("1") },
+        { QStringLiteral("output"), QStringLiteral("Directory adversary writes the worst inputs to."),
+          QStringLiteral("dir") },
+        { QStringLiteral("nodes"), QStringLiteral("Node processes for distsort."), QStringLiteral("n"),
+          QStringLiteral("4") },
+        { QStringLiteral("profile"), QStringLiteral("Tuning profile to load, and for tune to write."),
+          QStringLiteral("path"), Tuning::profilePath() },
+        { QStringLiteral("cpus"), QStringLiteral("CPUs the timing modes pin threads to: auto (those allowed), "
+                                                 "isolated, none, or a list such as 2-5,8."),
+          QStringLiteral("list"), QStringLiteral("auto") },
+        { QStringLiteral("json"), QStringLiteral("Also write every repetition's time here, for compare."),
+          QStringLiteral("path") },
+        { QStringLiteral("alpha"), QStringLiteral("Significance level for compare."), QStringLiteral("p"),
+          QStringLiteral("0.01") },
+        { QStringLiteral("min-change"), QStringLiteral("Smallest change compare reports, in percent."),
+          QStringLiteral("percent"), QStringLiteral("2") },
+    });
+    parser.process(app);
+
+    QString error;
+    if (!Tuning::loadCurrent(parser.value(QStringLiteral("profile")), &error))
+        err() << error << ", using defaults" << Qt::endl;
+
+    if (parser.isSet(QStringLiteral("threads")))
+        Parallel::setThreadCount(parser.value(QStringLiteral("threads")).toInt());
+    QStringList arguments = parser.positionalArguments();
+    if (arguments.isEmpty())
+        parser.showHelp(1);
+    const QString mode = arguments.takeFirst();
+
+    // Only the modes that time things pin. Affinity is inherited across
+    // fork and exec, so a pinned distsort would put every node on one CPU.
+    static const QStringList PinnedModes = { QStringLiteral("label"), QStringLiteral("pipeline"),
+                                             QStringLiteral("compress"), QStringLiteral("sort"),
+                                             QStringLiteral("scaling"), QStringLiteral("threads"),
+                                             QStringLiteral("roofline"), QStringLiteral("adversary"),
+                                             QStringLiteral("tune") };
+    Environment environment;
+    if (PinnedModes.contains(mode) && !setUpEnvironment(parser, environment))
+        return 1;
+
+    if (mode == QLatin1String("label"))
+        return runLabel(parser, arguments);
+    if (mode == QLatin1String("pipeline"))
+        return runPipeline(parser, arguments);
+    if (mode == QLatin1String("compress"))
+        return runCompress(parser, arguments);
+    if (mode == QLatin1String("sort"))
+        return runSort(parser, environment);
+    if (mode == QLatin1String("scaling"))
+        return runScaling(parser);
+    if (mode == QLatin1String("threads"))
+        return runThreads(parser, arguments);
+    if (mode == QLatin1String("roofline"))
+        return runRoofline(parser);
+    if (mode == QLatin1String("adversary"))
+        return runAdversary(parser, arguments);
+    if (mode == QLatin1String("fuzz"))
+        return runFuzz(parser, arguments);
+    if (mode == QLatin1String("trace"))
+        return runTrace(parser, arguments);
+    if (mode == QLatin1String("compare"))
+        return runCompare(parser, arguments);
+    if (mode == QLatin1String("tune"))
+        return runTune(parser);
+    if (mode == QLatin1String("memory"))
+        return runMemory(parser);
+    if (mode == QLatin1String("distsort"))
+        return runDistSort(parser);
+
+    err() << "Unknown mode " << mode << Qt::endl;
+    return 1;
+}
@@ -0,0 +1,69 @@
+#include "canvaswidget.h"
+
+#include <QMouseEvent>
+#include <QPainter>
+
+CanvasWidget::CanvasWidget(QWidget *parent)
+    : QWidget(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+    // Room for at least one panel of bars under its label.
+    setMinimumSize(160, 90);
+}
+
+void CanvasWidget::setImage(const QImage &image)
+{
+    m_image = image;
+    update();
+}
+
+QSize CanvasWidget::pixelSize() const
+{
+    const qreal ratio = devicePixelRatioF();
+    return QSize(qRound(width() * ratio), qRound(height() * ratio));
+}
+
+QRect CanvasWidget::imageRect() const
+{
+    if (m_image.isNull())
+        return QRect();
+    const QSize logical = (QSizeF(m_image.size()) / m_image.devicePixelRatio()).toSize();
+    const QSize scaled = logical.scaled(size(), Qt::KeepAspectRatio);
+    return QRect(QPoint((width() - scaled.width()) / 2, (height() - scaled.height()) / 2), scaled);
+}
+
+// Under fractional scaling the widget's logical size rounds, so an image
+// made for the screen is placed at its top left rather than fitted to
+// imageRect(), which would scale it by a fraction of a pixel.
+void CanvasWidget::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), Qt::black);
+    if (m_image.isNull())
+        return;
+    if (m_image.size() == pixelSize() && qFuzzyCompare(m_image.devicePixelRatio(), devicePixelRatioF()))
+        painter.drawImage(QPoint(0, 0), m_image);
+    else
+        painter.drawImage(imageRect(), m_image);
+}
+
+QPoint CanvasWidget::mapToImage(const QPoint &position) const
+{
+    const QRect target = imageRect();
+    if (!target.contains(position))
+        return QPoint(-1, -1);
+    return QPoint(int(qint64(position.x() - target.x()) * m_image.width() / target.width()),
+                  int(qint64(position.y() - target.y()) * m_image.height() / target.height()));
+}
+
+void CanvasWidget::mousePressEvent(QMouseEvent *event)
+{
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    const QPoint pixel = mapToImage(event->position().toPoint());
+#else
+    const QPoint pixel = mapToImage(event->pos());
+#endif
+    if (event->button() == Qt::LeftButton && pixel.x() >= 0)
+        emit imageClicked(pixel);
+    QWidget::mousePressEvent(event);
+}
@@ -0,0 +1,41 @@
+#ifndef CANVASWIDGET_H
+#define CANVASWIDGET_H
+
+#include <QImage>
+#include <QWidget>
+
+// Central widget that shows a QImage scaled to fit, keeping its aspect
+// ratio and using nearest-neighbour scaling so individual cells stay sharp.
+// An image rendered at pixelSize() with the widget's device pixel ratio is
+// drawn as it is, with no scaling at all.
+class CanvasWidget : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit CanvasWidget(QWidget *parent = nullptr);
+
+    const QImage &image() const { return m_image; }
+    // For in-place edits of large images without a detach; call update()
+    // afterwards. Keep no other copies of the image or every edit copies it.
+    QImage &image() { return m_image; }
+    void setImage(const QImage &image);
+    // The widget's size in device pixels.
+    QSize pixelSize() const;
+
+    QRect imageRect() const;
+    // Maps a widget position to image pixel coordinates, or (-1, -1).
+    QPoint mapToImage(const QPoint &position) const;
+
+signals:
+    void imageClicked(const QPoint &pixel);
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+    void mousePressEvent(QMouseEvent *event) override;
+
+private:
+    QImage m_image;
+};
+
+#endif // CANVASWIDGET_H
@@ -0,0 +1,352 @@
+#include "codec.h"
+
+#include "entropy.h"
+#include "lzmatch.h"
+#include "parallel.h"
+
+#include <algorithm>
+#include <atomic>
+#include <cstring>
+
+namespace Codec {
+
+namespace {
+
+// Stream layout, all integers little-endian:
+//   "AAZ1", u64 raw size, u32 block size, u32 block count,
+//   u32 compressed size per block, then the blocks.
+// A block is two streams, literals then commands, each stored as
+//   u8 method, u32 decoded size, u32 payload size, payload.
+// Commands are LZ4-style sequences: a token with the literal run in the
+// high nibble and the match length - MinMatch in the low one (15 means more
+// follows in 255-saturated bytes), then the distance as a varint. The last
+// sequence of a block has literals only.
+constexpr char Magic[4] = { 'A', 'A', 'Z', '1' };
+constexpr size_t HeaderSize = 20;
+constexpr size_t StreamHeaderSize = 9;
+
+enum Method : uint8_t { Stored, HuffmanCoded, RansCoded };
+
+void put32(std::vector<uint8_t> &out, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        out.push_back(uint8_t(value >> (8 * i)));
+}
+
+uint32_t get32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+void putLength(std::vector<uint8_t> &out, size_t extra)
+{
+    for (; extra >= 255; extra -= 255)
+        out.push_back(255);
+    out.push_back(uint8_t(extra));
+}
+
+void emitSequence(std::vector<uint8_t> &commands, std::vector<uint8_t> &literals,
+                  const uint8_t *data, size_t literalStart, size_t literalEnd, const LzMatch::Match &match)
+{
+    const size_t literalCount = literalEnd - literalStart;
+    const size_t matchCode = match.length ? match.length - LzMatch::MinMatch : 0;
+    commands.push_back(uint8_t(std::min<size_t>(literalCount, 15) << 4 | std::min<size_t>(matchCode, 15)));
+    if (literalCount >= 15)
+        putLength(commands, literalCount - 15);
+    literals.insert(literals.end(), data + literalStart, data + literalEnd);
+    if (!match.length)
+        return;
+    if (matchCode >= 15)
+        putLength(commands, matchCode - 15);
+    for (uint32_t d = match.distance; ; d >>= 7) {
+        if (d < 128) {
+            commands.push_back(uint8_t(d));
+            break;
+        }
+        commands.push_back(uint8_t(d | 128));
+    }
+}
+
+// Greedy parse: take the longest match at each position, else a literal.
+template <typename Finder>
+void parse(const uint8_t *data, size_t size, int depth,
+           std::vector<uint8_t> &commands, std::vector<uint8_t> &literals)
+{
+    Finder finder(data, size, depth);
+    size_t literalStart = 0;
+    size_t pos = 0;
+    while (pos + LzMatch::MinMatch <= size) {
+        const LzMatch::Match match = finder.find(pos);
+        if (!match.length) {
+            ++pos;
+            continue;
+        }
+        emitSequence(commands, literals, data, literalStart, pos, match);
+        for (size_t end = pos + match.length; ++pos < end;)
+            finder.skip(pos);
+        literalStart = pos;
+    }
+    if (literalStart < size)
+        emitSequence(commands, literals, data, literalStart, size, LzMatch::Match());
+}
+
+void putStream(std::vector<uint8_t> &out, const std::vector<uint8_t> &stream, Entropy entropy)
+{
+    const size_t start = out.size();
+    out.resize(start + StreamHeaderSize);
+    Method method = Stored;
+    if (entropy != Entropy::None && !stream.empty()) {
+        method = entropy == Entropy::Huffman ? HuffmanCoded : RansCoded;
+        if (method == HuffmanCoded)
+            Huffman::encode(stream.data(), stream.size(), out);
+        else
+            Rans::encode(stream.data(), stream.size(), out);
+        if (out.size() - start - StreamHeaderSize >= stream.size()) {
+            out.resize(start + StreamHeaderSize);
+            method = Stored;
+        }
+    }
+    if (method == Stored)
+        out.insert(out.end(), stream.begin(), stream.end());
+
+    const uint32_t payload = uint32_t(out.size() - start - StreamHeaderSize);
+    out[start] = method;
+    for (int i = 0; i < 4; ++i) {
+        out[start + 1 + size_t(i)] = uint8_t(stream.size() >> (8 * i));
+        out[start + 5 + size_t(i)] = uint8_t(payload >> (8 * i));
+    }
+}
+
+// maxSize is the most the block can use, so that a header cannot make it
+// allocate more than that.
+bool getStream(const uint8_t *&in, const uint8_t *end, size_t maxSize, std::vector<uint8_t> &stream)
+{
+    if (size_t(end - in) < StreamHeaderSize)
+        return false;
+    const uint8_t method = in[0];
+    const uint32_t size = get32(in + 1);
+    const uint32_t payload = get32(in + 5);
+    in += StreamHeaderSize;
+    if (size_t(end - in) < payload || size > maxSize)
+        return false;
+
+    stream.resize(size);
+    bool ok = false;
+    switch (method) {
+    case Stored:
+        ok = payload == size;
+        if (ok)
+            std::memcpy(stream.data(), in, size);
+        break;
+    case HuffmanCoded:
+        ok = Huffman::decode(in, payload, size, stream.data());
+        break;
+    case RansCoded:
+        ok = Rans::decode(in, payload, size, stream.data());
+        break;
+    }
+    in += payload;
+    return ok;
+}
+
+std::vector<uint8_t> compressBlock(const uint8_t *data, size_t size, const Options &options)
+{
+    std::vector<uint8_t> commands;
+    std::vector<uint8_t> literals;
+    if (options.finder == Finder::BinaryTree)
+        parse<LzMatch::BinaryTree>(data, size, options.depth, commands, literals);
+    else
+        parse<LzMatch::HashChain>(data, size, options.depth, commands, literals);
+
+    std::vector<uint8_t> block;
+    putStream(block, literals, options.entropy);
+    putStream(block, commands, options.entropy);
+    return block;
+}
+
+// The most a stream's payload can decode to. A Huffman code is at least a
+// bit, but rANS spends less than a bit on a common byte, and nothing at
+// all on the only one, so for rANS only the header's u32 limits it.
+uint64_t maxStreamSize(uint8_t method, uint32_t payload)
+{
+    switch (method) {
+    case Stored:
+        return payload;
+    case HuffmanCoded:
+        return uint64_t(payload) * 8;
+    case RansCoded:
+        return UINT32_MAX;
+    }
+    return 0;
+}
+
+// The most a block can decode to, from its stream headers alone: every
+// literal once, plus at most 255 bytes of match per command byte, as a
+// length byte adds 255 and a token and its distance byte 15 + MinMatch
+// between them. False if the streams do not fill the block exactly. Only
+// a quick rejection: with rANS streams the bound says little.
+bool blockBound(const uint8_t *in, const uint8_t *end, uint64_t &bound)
+{
+    static_assert(15 + LzMatch::MinMatch <= 2 * 255);
+    uint64_t sizes[2];
+    for (uint64_t &streamSize : sizes) {
+        if (size_t(end - in) < StreamHeaderSize)
+            return false;
+        const uint8_t method = in[0];
+        const uint32_t size = get32(in + 1);
+        const uint32_t payload = get32(in + 5);
+        in += StreamHeaderSize;
+        if (size_t(end - in) < payload)
+            return false;
+        in += payload;
+        streamSize = std::min<uint64_t>(size, maxStreamSize(method, payload));
+    }
+    bound = sizes[0] + 255 * sizes[1];
+    return in == end;
+}
+
+bool readLength(const uint8_t *&in, const uint8_t *end, size_t &length)
+{
+    for (;;) {
+        if (in == end)
+            return false;
+        const uint8_t byte = *in++;
+        length += byte;
+        if (byte != 255)
+            return true;
+    }
+}
+
+bool decompressBlock(const uint8_t *in, const uint8_t *end, uint8_t *out, size_t size)
+{
+    // Every literal is used once. A sequence with a match adds at least
+    // MinMatch bytes for its token and at most five distance bytes, the last
+    // one adds a literal for its token, and a length byte never adds less
+    // than one, so a block cannot use three command bytes per output byte.
+    std::vector<uint8_t> literals;
+    std::vector<uint8_t> commands;
+    if (!getStream(in, end, size, literals) || !getStream(in, end, 3 * size, commands) || in != end)
+        return false;
+
+    const uint8_t *literal = literals.data();
+    const uint8_t *literalEnd = literal + literals.size();
+    const uint8_t *command = commands.data();
+    const uint8_t *commandEnd = command + commands.size();
+    size_t produced = 0;
+    while (produced < size) {
+        if (command == commandEnd)
+            return false;
+        const uint8_t token = *command++;
+        size_t literalCount = token >> 4;
+        if (literalCount == 15 && !readLength(command, commandEnd, literalCount))
+            return false;
+        if (literalCount > size_t(literalEnd - literal) || literalCount > size - produced)
+            return false;
+        std::memcpy(out + produced, literal, literalCount);
+        literal += literalCount;
+        produced += literalCount;
+        if (produced == size)
+            break;
+
+        size_t length = token & 15;
+        if (length == 15 && !readLength(command, commandEnd, length))
+            return false;
+        length += LzMatch::MinMatch;
+        size_t distance = 0;
+        for (int shift = 0;; shift += 7) {
+            if (command == commandEnd || shift > 28)
+                return false;
+            const uint8_t byte = *command++;
+            distance |= size_t(byte & 127) << shift;
+            if (!(byte & 128))
+                break;
+        }
+        if (distance == 0 || distance > produced || length > size - produced)
+            return false;
+        const uint8_t *from = out + produced - distance;
+        uint8_t *to = out + produced;
+        if (distance >= length) {
+            std::memcpy(to, from, length);
+        } else {
+            for (size_t i = 0; i < length; ++i)
+                to[i] = from[i];
+        }
+        produced += length;
+    }
+    return literal == literalEnd && command == commandEnd;
+}
+
+} // namespace
+
+std::vector<uint8_t> compress(const uint8_t *data, size_t size, const Options &options)
+{
+    const size_t blockSize = std::clamp<uint32_t>(options.blockSize, 1024, MaxBlockSize);
+    const size_t blocks = (size + blockSize - 1) / blockSize;
+    std::vector<std::vector<uint8_t>> compressed(blocks);
+    Parallel::forRange(0, blocks, 1, [&](size_t first, size_t last) {
+        for (size_t b = first; b < last; ++b) {
+            const size_t offset = b * blockSize;
+            compressed[b] = compressBlock(data + offset, std::min(blockSize, size - offset), options);
+        }
+    });
+
+    std::vector<uint8_t> out(Magic, Magic + 4);
+    put32(out, uint32_t(uint64_t(size)));
+    put32(out, uint32_t(uint64_t(size) >> 32));
+    put32(out, uint32_t(blockSize));
+    put32(out, uint32_t(blocks));
+    for (const std::vector<uint8_t> &block : compressed)
+        put32(out, uint32_t(block.size()));
+    for (const std::vector<uint8_t> &block : compressed)
+        out.insert(out.end(), block.begin(), block.end());
+    return out;
+}
+
+bool decompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    if (size < HeaderSize || std::memcmp(data, Magic, 4) != 0)
+        return false;
+    const uint64_t rawSize = get32(data + 4) | uint64_t(get32(data + 8)) << 32;
+    const size_t blockSize = get32(data + 12);
+    const size_t blocks = get32(data + 16);
+    if (blockSize == 0 || blockSize > MaxBlockSize || blocks != (rawSize + blockSize - 1) / blockSize
+        || (size - HeaderSize) / 4 < blocks)
+        return false;
+
+    std::vector<size_t> offsets(blocks + 1);
+    offsets[0] = HeaderSize + blocks * 4;
+    for (size_t b = 0; b < blocks; ++b)
+        offsets[b + 1] = offsets[b] + get32(data + HeaderSize + b * 4);
+    if (offsets[blocks] != size)
+        return false;
+    for (size_t b = 0; b < blocks; ++b) {
+        uint64_t bound = 0;
+        if (!blockBound(data + offsets[b], data + offsets[b + 1], bound)
+            || std::min<uint64_t>(blockSize, rawSize - b * blockSize) > bound)
+            return false;
+    }
+
+    // A batch of blocks per pass, one for each thread, with out grown only
+    // to the end of the batch: a raw size the blocks do not really decode
+    // to is caught after at most a batch's worth of memory.
+    const size_t start = out.size();
+    const size_t batch = size_t(Parallel::threadCount());
+    std::atomic<bool> ok { true };
+    for (size_t first = 0; first < blocks && ok; first += batch) {
+        const size_t last = std::min(blocks, first + batch);
+        out.resize(start + std::min<uint64_t>(rawSize, uint64_t(last) * blockSize));
+        Parallel::forRange(first, last, 1, [&](size_t begin, size_t end) {
+            for (size_t b = begin; b < end && ok.load(std::memory_order_relaxed); ++b) {
+                const size_t offset = b * blockSize;
+                if (!decompressBlock(data + offsets[b], data + offsets[b + 1], out.data() + start + offset,
+                                     std::min<size_t>(blockSize, rawSize - offset)))
+                    ok = false;
+            }
+        });
+    }
+    if (!ok)
+        out.resize(start);
+    return ok;
+}
+
+} // namespace Codec
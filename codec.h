@@ -0,0 +1,38 @@
+#ifndef CODEC_H
+#define CODEC_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// General purpose byte compressor: LZ77 with a choice of match finder,
+// followed by an order-0 entropy coder over the literal and command
+// streams. The input is cut into independent blocks, which are compressed
+// and decompressed in parallel and can later be decoded on their own.
+namespace Codec {
+
+enum class Finder { HashChain, BinaryTree };
+enum class Entropy { None, Huffman, Rans };
+
+// The largest block compress() writes and decompress() accepts.
+constexpr uint32_t MaxBlockSize = uint32_t(1) << 26;
+
+struct Options
+{
+    Finder finder = Finder::HashChain;
+    Entropy entropy = Entropy::Rans;
+    int depth = 16; // candidates per match search
+    uint32_t blockSize = 1 << 20; // clamped to [1024, MaxBlockSize]
+};
+
+std::vector<uint8_t> compress(const uint8_t *data, size_t size, const Options &options = Options());
+
+// Appends the decompressed bytes to out. Returns false, leaving out as it
+// was, if data is not a complete stream. out grows a few blocks at a time
+// as they decode, so a header claiming more than the blocks hold costs at
+// most that much memory before it is caught.
+bool decompress(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+
+} // namespace Codec
+
+#endif // CODEC_H
@@ -0,0 +1,204 @@
+#include "complexity.h"
+
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+namespace Complexity {
+
+namespace {
+
+constexpr Model Models[] = {
+    { "1", [](double) { return 1.0; } },
+    { "log n", [](double n) { return std::log2(n); } },
+    { "n", [](double n) { return n; } },
+    { "n log n", [](double n) { return n * std::log2(n); } },
+    { "n^2", [](double n) { return n * n; } },
+    { "n^2 log n", [](double n) { return n * n * std::log2(n); } },
+    { "n^3", [](double n) { return n * n * n; } },
+};
+
+// Shorter runs are repeated until they add up to this.
+constexpr double MinTotalMs = 5;
+constexpr int MaxRuns = 1000;
+
+double elapsedMs(std::chrono::steady_clock::time_point since)
+{
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - since).count();
+}
+
+template <typename Function>
+double bestMs(Function &&function)
+{
+    double best = HUGE_VAL;
+    double total = 0;
+    for (int run = 0; run < MaxRuns && total < MinTotalMs; ++run) {
+        const auto started = std::chrono::steady_clock::now();
+        function();
+        const double ms = elapsedMs(started);
+        best = std::min(best, ms);
+        total += ms;
+    }
+    return best;
+}
+
+} // namespace
+
+std::span<const Model> models()
+{
+    return Models;
+}
+
+// Fitting a constant to log(value) - log(model(n)) is an average, and the
+// scatter left around it says how well the model's shape matches.
+Fit fit(std::span<const Point> points)
+{
+    Fit result;
+    std::vector<Point> usable;
+    for (const Point &point : points) {
+        if (point.n > 1 && point.value > 0)
+            usable.push_back(point);
+    }
+    if (usable.size() < 2)
+        return result;
+
+    double meanX = 0;
+    double meanY = 0;
+    for (const Point &point : usable) {
+        meanX += std::log(point.n);
+        meanY += std::log(point.value);
+    }
+    meanX /= double(usable.size());
+    meanY /= double(usable.size());
+    double sxy = 0;
+    double sxx = 0;
+    for (const Point &point : usable) {
+        const double dx = std::log(point.n) - meanX;
+        sxy += dx * (std::log(point.value) - meanY);
+        sxx += dx * dx;
+    }
+    if (sxx == 0)
+        return result;
+    result.exponent = sxy / sxx;
+    result.constant = std::exp(meanY - result.exponent * meanX);
+
+    result.modelError = HUGE_VAL;
+    for (const Model &model : Models) {
+        double meanLog = 0;
+        for (const Point &point : usable)
+            meanLog += std::log(point.value / model.f(point.n));
+        meanLog /= double(usable.size());
+        double squares = 0;
+        for (const Point &point : usable) {
+            const double residual = std::log(point.value / model.f(point.n)) - meanLog;
+            squares += residual * residual;
+        }
+        const double error = std::sqrt(squares / double(usable.size()));
+        if (error < result.modelError) {
+            result.model = &model;
+            result.modelConstant = std::exp(meanLog);
+            result.modelError = error;
+        }
+    }
+    return result;
+}
+
+Measurement measure(const Sorts::Algorithm &algorithm, Sorts::Shape shape, size_t n)
+{
+    const std::vector<int32_t> input = Sorts::makeInput(shape, n, 1);
+    std::vector<int32_t> values = input;
+    Measurement measurement;
+    measurement.n = n;
+
+    const auto started = std::chrono::steady_clock::now();
+    Stepper stepper = algorithm.run(values);
+    while (stepper.next()) {
+        const VisualEvent::Kind kind = stepper.event().kind;
+        measurement.compares += kind == VisualEvent::Compare;
+        measurement.moves += kind == VisualEvent::Swap || kind == VisualEvent::Write;
+    }
+    const double steppingMs = elapsedMs(started);
+
+    if (algorithm.native) {
+        measurement.ms = bestMs([&] {
+            values = input;
+            algorithm.native(values);
+        });
+    } else if (steppingMs >= MinTotalMs) {
+        measurement.ms = steppingMs;
+    } else {
+        measurement.ms = std::min(steppingMs, bestMs([&] {
+            values = input;
+            Stepper again = algorithm.run(values);
+            while (again.next()) {
+            }
+        }));
+    }
+    return measurement;
+}
+
+void sweep(const Sorts::Algorithm &algorithm, Sorts::Shape shape, size_t first, size_t last, double budgetMs,
+           const std::function<bool(const Measurement &)> &onMeasured)
+{
+    for (size_t n = std::max<size_t>(first, 2); n <= last; n *= 2) {
+        const auto started = std::chrono::steady_clock::now();
+        const Measurement measurement = measure(algorithm, shape, n);
+        if (!onMeasured(measurement) || elapsedMs(started) > budgetMs)
+            return;
+    }
+}
+
+struct Sweep::Shared
+{
+    std::mutex mutex;
+    std::vector<Measurement> measurements;
+    std::atomic<bool> cancelled { false };
+    std::atomic<bool> done { false };
+};
+
+Sweep::~Sweep()
+{
+    cancel();
+}
+
+void Sweep::start(const Sorts::Algorithm *algorithm, Sorts::Shape shape, size_t first, size_t last,
+                  double budgetMs)
+{
+    cancel();
+    m_algorithm = algorithm;
+    m_shape = shape;
+    m_shared = std::make_shared<Shared>();
+    std::thread([shared = m_shared, algorithm, shape, first, last, budgetMs] {
+        sweep(*algorithm, shape, first, last, budgetMs, [&](const Measurement &measurement) {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->measurements.push_back(measurement);
+            return !shared->cancelled.load(std::memory_order_relaxed);
+        });
+        shared->done.store(true, std::memory_order_release);
+    }).detach();
+}
+
+void Sweep::cancel()
+{
+    if (m_shared)
+        m_shared->cancelled.store(true, std::memory_order_relaxed);
+    m_shared.reset();
+}
+
+bool Sweep::running() const
+{
+    return m_shared && !m_shared->done.load(std::memory_order_acquire);
+}
+
+std::vector<Measurement> Sweep::measurements() const
+{
+    if (!m_shared)
+        return {};
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    return m_shared->measurements;
+}
+
+} // namespace Complexity
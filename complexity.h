@@ -0,0 +1,95 @@
+#ifndef COMPLEXITY_H
+#define COMPLEXITY_H
+
+#include "sorts.h"
+
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Measures how a sort's time and operation counts grow with n, and names
+// the growth. An algorithm that is n log n on random input can go
+// quadratic on a particular shape (quick sort on few unique values is the
+// classic), which a single-size benchmark does not show.
+namespace Complexity {
+
+struct Point
+{
+    double n = 0;
+    double value = 0;
+};
+
+struct Model
+{
+    const char *name;
+    double (*f)(double n);
+};
+
+// 1, log n, n, n log n, n^2, n^2 log n, n^3.
+std::span<const Model> models();
+
+struct Fit
+{
+    // value ~ constant * n^exponent, least squares on log-log axes.
+    double exponent = 0;
+    double constant = 0;
+    // The named model that fits best, and its constant.
+    const Model *model = nullptr;
+    double modelConstant = 0;
+    // Root mean square of log(value / model): 0.05 is about 5% off.
+    double modelError = 0;
+};
+
+// Needs two points with distinct n and positive values; others are skipped.
+Fit fit(std::span<const Point> points);
+
+struct Measurement
+{
+    size_t n = 0;
+    double ms = 0; // the native version where there is one
+    uint64_t compares = 0;
+    uint64_t moves = 0; // swaps and writes
+};
+
+// Best of enough runs to fill a few milliseconds, so small n are not just
+// timer noise; the counts come from one stepping run.
+Measurement measure(const Sorts::Algorithm &algorithm, Sorts::Shape shape, size_t n);
+
+// Measures n = first, 2 first, 4 first, ... up to last, stopping early
+// once a size takes longer than budgetMs, as the next would take at least
+// twice that. onMeasured sees each result and returns false to stop.
+void sweep(const Sorts::Algorithm &algorithm, Sorts::Shape shape, size_t first, size_t last, double budgetMs,
+           const std::function<bool(const Measurement &)> &onMeasured);
+
+// sweep() on a worker thread, for the GUI to poll. Cancelling takes effect
+// between sizes; like SampledSort, the worker may outlive the object.
+class Sweep
+{
+public:
+    Sweep() = default;
+    Sweep(const Sweep &) = delete;
+    Sweep &operator=(const Sweep &) = delete;
+    ~Sweep();
+
+    void start(const Sorts::Algorithm *algorithm, Sorts::Shape shape, size_t first, size_t last,
+               double budgetMs);
+    void cancel();
+
+    const Sorts::Algorithm *algorithm() const { return m_algorithm; }
+    Sorts::Shape shape() const { return m_shape; }
+    bool running() const;
+    std::vector<Measurement> measurements() const;
+
+private:
+    struct Shared;
+
+    const Sorts::Algorithm *m_algorithm = nullptr;
+    Sorts::Shape m_shape = Sorts::Shape::Random;
+    std::shared_ptr<Shared> m_shared;
+};
+
+} // namespace Complexity
+
+#endif // COMPLEXITY_H
@@ -0,0 +1,383 @@
+#include "compressionview.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+constexpr int Columns = 64;
+constexpr int HeaderHeight = 36;
+
+QString byteLabel(uint8_t byte)
+{
+    return byte >= 32 && byte < 127 ? QString(QLatin1Char(char(byte))) : QStringLiteral("·");
+}
+
+int treeHeight(const std::vector<Huffman::Merge> &merges, int node, std::vector<int> &heights)
+{
+    if (node < 256)
+        return 0;
+    int &height = heights[size_t(node - 256)];
+    if (height < 0) {
+        const Huffman::Merge &merge = merges[size_t(node - 256)];
+        height = 1 + std::max(treeHeight(merges, merge.left, heights), treeHeight(merges, merge.right, heights));
+    }
+    return height;
+}
+
+} // namespace
+
+void CompressionView::start(const uint8_t *data, size_t size, Mode mode)
+{
+    m_mode = mode;
+    m_sample.assign(data, data + std::min(size, SampleSize));
+    m_step = 0;
+    m_frame = 0;
+    m_probesShown = 0;
+    m_lzSteps.clear();
+    m_merges.clear();
+    m_ransSteps.clear();
+
+    switch (mode) {
+    case Mode::HashChain:
+    case Mode::BinaryTree: {
+        // The same greedy parse the codec does, keeping what each search saw.
+        LzMatch::HashChain chain(m_sample.data(), m_sample.size(), 16);
+        LzMatch::BinaryTree tree(m_sample.data(), m_sample.size(), 16);
+        for (size_t pos = 0; pos + LzMatch::MinMatch <= m_sample.size();) {
+            LzStep step { uint32_t(pos), {}, {} };
+            step.match = mode == Mode::HashChain ? chain.find(pos, &step.probes) : tree.find(pos, &step.probes);
+            const size_t end = pos + std::max<size_t>(step.match.length, 1);
+            m_lzSteps.push_back(std::move(step));
+            while (++pos < end) {
+                if (mode == Mode::HashChain)
+                    chain.skip(pos);
+                else
+                    tree.skip(pos);
+            }
+        }
+        m_stepCount = m_lzSteps.size();
+        break;
+    }
+    case Mode::Huffman:
+        std::fill(std::begin(m_counts), std::end(m_counts), 0);
+        for (uint8_t byte : m_sample)
+            ++m_counts[byte];
+        m_merges = Huffman::buildTree(m_counts);
+        Huffman::codeLengths(m_counts, m_lengths);
+        m_stepCount = m_merges.size();
+        break;
+    case Mode::Rans: {
+        std::vector<uint8_t> payload;
+        Rans::encode(m_sample.data(), m_sample.size(), payload, &m_ransSteps);
+        std::fill(std::begin(m_counts), std::end(m_counts), 0);
+        for (uint8_t byte : m_sample)
+            ++m_counts[byte];
+        Rans::normalize(m_counts, m_frequencies);
+        m_stepCount = m_ransSteps.size();
+        break;
+    }
+    }
+}
+
+bool CompressionView::advance()
+{
+    if (m_step >= m_stepCount)
+        return false;
+    // Tree merges are few and worth following one by one; the per-byte
+    // modes would take minutes at that pace.
+    ++m_frame;
+    switch (m_mode) {
+    case Mode::HashChain:
+    case Mode::BinaryTree:
+        m_probesShown += m_lzSteps[m_step].probes.size();
+        ++m_step;
+        break;
+    case Mode::Huffman:
+        if (m_frame % 6 == 0)
+            ++m_step;
+        break;
+    case Mode::Rans:
+        m_step = std::min(m_stepCount, m_step + 8);
+        break;
+    }
+    return m_step < m_stepCount;
+}
+
+QString CompressionView::progress() const
+{
+    switch (m_mode) {
+    case Mode::HashChain:
+    case Mode::BinaryTree: {
+        const size_t position = m_step < m_stepCount ? m_lzSteps[m_step].position : m_sample.size();
+        return QStringLiteral("byte %1 of %2, %3 searches, %4 candidates compared (%5 per search)")
+                .arg(position).arg(m_sample.size()).arg(m_step).arg(m_probesShown)
+                .arg(m_step ? double(m_probesShown) / m_step : 0.0, 0, 'f', 2);
+    }
+    case Mode::Huffman:
+        return QStringLiteral("merge %1 of %2").arg(m_step).arg(m_stepCount);
+    case Mode::Rans:
+        return QStringLiteral("symbol %1 of %2").arg(m_step).arg(m_stepCount);
+    }
+    return QString();
+}
+
+void CompressionView::render(QImage &image) const
+{
+    // A device pixel ratio left by RaceView would scale the painting.
+    if (image.size() != QSize(1280, 800) || image.format() != QImage::Format_RGB32 || image.devicePixelRatio() != 1)
+        image = QImage(1280, 800, QImage::Format_RGB32);
+    image.fill(QColor(24, 24, 28));
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    QFont font = painter.font();
+    font.setPixelSize(13);
+    painter.setFont(font);
+    const QRect area = image.rect().adjusted(16, HeaderHeight, -16, -16);
+    switch (m_mode) {
+    case Mode::HashChain:
+    case Mode::BinaryTree:
+        renderMatches(painter, area);
+        break;
+    case Mode::Huffman:
+        renderTree(painter, area);
+        break;
+    case Mode::Rans:
+        renderStates(painter, area);
+        break;
+    }
+}
+
+// The sample as a grid of bytes: coded bytes in blue (literals) or green
+// (copied by a match), the position being searched in yellow, and every
+// candidate the finder compared outlined in orange, with its matched prefix
+// shaded. The winning candidate's source bytes are drawn in cyan.
+void CompressionView::renderMatches(QPainter &painter, const QRect &area) const
+{
+    const int cellWidth = area.width() / Columns;
+    const int rows = int((m_sample.size() + Columns - 1) / Columns);
+    const int cellHeight = std::min(24, area.height() / std::max(rows, 1));
+    const auto cell = [&](size_t index) {
+        return QRect(area.left() + int(index % Columns) * cellWidth, area.top() + int(index / Columns) * cellHeight,
+                     cellWidth - 1, cellHeight - 1);
+    };
+
+    std::vector<QColor> colours(m_sample.size(), QColor(48, 48, 56));
+    for (size_t i = 0; i < m_step; ++i) {
+        const LzStep &step = m_lzSteps[i];
+        if (!step.match.length) {
+            colours[step.position] = QColor(40, 70, 130);
+            continue;
+        }
+        for (uint32_t k = 0; k < step.match.length; ++k)
+            colours[step.position + k] = QColor(40, 120, 60);
+    }
+
+    const LzStep *current = m_step < m_stepCount ? &m_lzSteps[m_step] : nullptr;
+    if (current) {
+        for (const LzMatch::Probe &probe : current->probes) {
+            for (uint32_t k = 0; k < probe.length; ++k)
+                colours[probe.position + k] = QColor(150, 90, 30);
+        }
+        if (current->match.length) {
+            const size_t source = current->position - current->match.distance;
+            for (uint32_t k = 0; k < current->match.length; ++k)
+                colours[source + k] = QColor(30, 150, 170);
+        }
+        colours[current->position] = QColor(200, 180, 40);
+    }
+
+    for (size_t i = 0; i < m_sample.size(); ++i) {
+        painter.fillRect(cell(i), colours[i]);
+        painter.setPen(QColor(220, 220, 220));
+        painter.drawText(cell(i), Qt::AlignCenter, byteLabel(m_sample[i]));
+    }
+    if (current) {
+        painter.setBrush(Qt::NoBrush);
+        painter.setPen(QPen(QColor(255, 160, 40), 2));
+        for (const LzMatch::Probe &probe : current->probes)
+            painter.drawRect(cell(probe.position));
+    }
+
+    painter.setPen(QColor(230, 230, 230));
+    const QString name = m_mode == Mode::HashChain ? QStringLiteral("Hash chain") : QStringLiteral("Binary tree");
+    QString detail;
+    if (current) {
+        detail = QStringLiteral("  position %1: %2 candidates, ").arg(current->position).arg(current->probes.size());
+        detail += current->match.length
+                ? QStringLiteral("match of %1 bytes at distance %2").arg(current->match.length).arg(current->match.distance)
+                : QStringLiteral("literal");
+    }
+    painter.drawText(QRect(16, 0, area.width(), HeaderHeight), Qt::AlignVCenter | Qt::AlignLeft, name + detail);
+}
+
+// Bytes that occur are leaves along the bottom, in the order the finished
+// tree puts them; each merge hangs a parent over its two children at a
+// height one above the taller. The newest merge is drawn in red, and once
+// the tree is complete every leaf is labelled with its length-limited code
+// length.
+void CompressionView::renderTree(QPainter &painter, const QRect &area) const
+{
+    const int nodes = 256 + int(m_merges.size());
+    std::vector<int> heights(m_merges.size(), -1);
+    const int root = m_merges.empty() ? -1 : nodes - 1;
+    const int rootHeight = root < 0 ? 0 : treeHeight(m_merges, root, heights);
+
+    // In-order leaf positions from the finished tree.
+    std::vector<double> x(size_t(nodes), 0.0);
+    std::vector<int> leaves;
+    std::vector<int> stack;
+    if (root >= 0)
+        stack.push_back(root);
+    while (!stack.empty()) {
+        const int node = stack.back();
+        stack.pop_back();
+        if (node < 256) {
+            leaves.push_back(node);
+            continue;
+        }
+        const Huffman::Merge &merge = m_merges[size_t(node - 256)];
+        stack.push_back(merge.right);
+        stack.push_back(merge.left);
+    }
+    if (leaves.empty()) {
+        for (int s = 0; s < 256; ++s) {
+            if (m_counts[s])
+                leaves.push_back(s);
+        }
+    }
+    const double spacing = area.width() / double(std::max<size_t>(leaves.size(), 1));
+    for (size_t i = 0; i < leaves.size(); ++i)
+        x[size_t(leaves[i])] = area.left() + spacing * (i + 0.5);
+    for (size_t i = 0; i < m_merges.size(); ++i)
+        x[256 + i] = (x[size_t(m_merges[i].left)] + x[size_t(m_merges[i].right)]) / 2;
+
+    const double bottom = area.bottom() - 40;
+    const double level = (bottom - area.top()) / std::max(rootHeight, 1);
+    const auto point = [&](int node) {
+        const int height = node < 256 ? 0 : heights[size_t(node - 256)];
+        return QPointF(x[size_t(node)], bottom - height * level);
+    };
+
+    for (size_t i = 0; i < m_step; ++i) {
+        const Huffman::Merge &merge = m_merges[i];
+        painter.setPen(QPen(i + 1 == m_step ? QColor(230, 70, 60) : QColor(140, 140, 150), 1.5));
+        const QPointF parent = point(int(256 + i));
+        painter.drawLine(parent, point(merge.left));
+        painter.drawLine(parent, point(merge.right));
+    }
+
+    // Roots of the forest so far are bright, nodes already merged are dim.
+    std::vector<bool> merged(size_t(nodes), false);
+    for (size_t i = 0; i < m_step; ++i) {
+        merged[size_t(m_merges[i].left)] = true;
+        merged[size_t(m_merges[i].right)] = true;
+    }
+    painter.setPen(Qt::NoPen);
+    for (int leaf : leaves) {
+        painter.setBrush(merged[size_t(leaf)] ? QColor(70, 110, 160) : QColor(120, 180, 255));
+        painter.drawEllipse(point(leaf), 4, 4);
+    }
+    for (size_t i = 0; i < m_step; ++i) {
+        painter.setBrush(merged[256 + i] ? QColor(110, 110, 120) : QColor(240, 200, 80));
+        painter.drawEllipse(point(int(256 + i)), 4, 4);
+    }
+
+    if (spacing >= 9) {
+        painter.setPen(QColor(220, 220, 220));
+        for (int leaf : leaves) {
+            const QPointF at = point(leaf);
+            painter.drawText(QRectF(at.x() - spacing / 2, at.y() + 6, spacing, 16), Qt::AlignCenter,
+                             byteLabel(uint8_t(leaf)));
+            if (m_step == m_stepCount)
+                painter.drawText(QRectF(at.x() - spacing / 2, at.y() + 22, spacing, 16), Qt::AlignCenter,
+                                 QString::number(m_lengths[leaf]));
+        }
+    }
+
+    painter.setPen(QColor(230, 230, 230));
+    QString header = QStringLiteral("Huffman tree: %1 distinct bytes").arg(leaves.size());
+    if (m_step > 0) {
+        const auto weight = [&](int node) {
+            return node < 256 ? m_counts[node] : m_merges[size_t(node - 256)].weight;
+        };
+        const Huffman::Merge &merge = m_merges[m_step - 1];
+        header += QStringLiteral(", merged weights %1 + %2 = %3")
+                .arg(weight(merge.left)).arg(weight(merge.right)).arg(merge.weight);
+    }
+    if (m_step == m_stepCount && !leaves.empty()) {
+        uint64_t bits = 0;
+        for (int s = 0; s < 256; ++s)
+            bits += m_counts[s] * m_lengths[s];
+        header += QStringLiteral(", %1 bits per byte").arg(double(bits) / m_sample.size(), 0, 'f', 3);
+    }
+    painter.drawText(QRect(16, 0, area.width(), HeaderHeight), Qt::AlignVCenter | Qt::AlignLeft, header);
+}
+
+// Top: log2 of both interleaved states against the symbols encoded so far
+// (the encoder runs back to front), with a tick wherever renormalisation
+// pushed bytes out. Bottom: the scaled frequency table, the symbol just
+// encoded highlighted.
+void CompressionView::renderStates(QPainter &painter, const QRect &area) const
+{
+    const QRect plot(area.left(), area.top(), area.width(), area.height() * 2 / 3 - 16);
+    const QRect table(area.left(), plot.bottom() + 32, area.width(), area.bottom() - plot.bottom() - 32);
+    const double low = std::log2(double(Rans::LowerBound));
+    const double high = 32;
+    const double dx = plot.width() / double(std::max<size_t>(m_stepCount, 1));
+    const auto y = [&](uint32_t state) {
+        return plot.bottom() - (std::log2(double(state)) - low) / (high - low) * plot.height();
+    };
+
+    painter.setPen(QColor(70, 70, 80));
+    painter.drawRect(plot);
+    for (int bits = int(low) + 1; bits < int(high); ++bits) {
+        const double at = plot.bottom() - (bits - low) / (high - low) * plot.height();
+        painter.drawLine(QPointF(plot.left(), at), QPointF(plot.right(), at));
+        painter.drawText(QRectF(plot.left() + 4, at - 16, 60, 16), Qt::AlignLeft, QStringLiteral("2^%1").arg(bits));
+    }
+
+    const QColor colours[2] = { QColor(90, 200, 255), QColor(255, 150, 80) };
+    QPointF previous[2];
+    bool started[2] = { false, false };
+    size_t bytesOut = 0;
+    for (size_t i = 0; i < m_step; ++i) {
+        const Rans::Step &step = m_ransSteps[i];
+        const int lane = int(step.index & 1);
+        const QPointF at(plot.left() + dx * (i + 1), y(step.stateAfter));
+        painter.setPen(QPen(colours[lane], 1.2));
+        painter.drawLine(started[lane] ? previous[lane] : QPointF(plot.left(), y(step.stateBefore)), at);
+        if (step.bytesOut) {
+            painter.setPen(QColor(230, 230, 230));
+            painter.drawLine(QPointF(at.x(), plot.bottom()), QPointF(at.x(), plot.bottom() - 6 * step.bytesOut));
+        }
+        previous[lane] = at;
+        started[lane] = true;
+        bytesOut += size_t(step.bytesOut);
+    }
+
+    const int current = m_step ? m_ransSteps[m_step - 1].symbol : -1;
+    const double barWidth = table.width() / 256.0;
+    const uint32_t largest = *std::max_element(std::begin(m_frequencies), std::end(m_frequencies));
+    for (int s = 0; s < 256; ++s) {
+        if (!m_frequencies[s])
+            continue;
+        const double height = table.height() * double(m_frequencies[s]) / std::max<uint32_t>(largest, 1);
+        painter.fillRect(QRectF(table.left() + s * barWidth, table.bottom() - height, std::max(barWidth - 1, 1.0), height),
+                         s == current ? QColor(240, 200, 80) : QColor(90, 120, 170));
+    }
+
+    painter.setPen(QColor(230, 230, 230));
+    QString header = QStringLiteral("rANS, %1-bit frequencies, two interleaved states").arg(Rans::ScaleBits);
+    if (m_step) {
+        const Rans::Step &step = m_ransSteps[m_step - 1];
+        header += QStringLiteral(": '%1' (%2/%3)  0x%4 -> 0x%5,  %6 bytes out, %7 bits per symbol")
+                .arg(byteLabel(step.symbol)).arg(m_frequencies[step.symbol]).arg(1 << Rans::ScaleBits)
+                .arg(step.stateBefore, 8, 16, QLatin1Char('0')).arg(step.stateAfter, 8, 16, QLatin1Char('0'))
+                .arg(bytesOut).arg((bytesOut * 8.0 + 64) / m_step, 0, 'f', 3);
+    }
+    painter.drawText(QRect(16, 0, area.width(), HeaderHeight), Qt::AlignVCenter | Qt::AlignLeft, header);
+}
@@ -0,0 +1,61 @@
+#ifndef COMPRESSIONVIEW_H
+#define COMPRESSIONVIEW_H
+
+#include "entropy.h"
+#include "lzmatch.h"
+
+#include <QImage>
+#include <QString>
+
+#include <vector>
+
+class QPainter;
+class QRect;
+
+// Step-by-step pictures of the compression engines over a small sample:
+// the candidates a match finder compares at each position, the merges that
+// build a Huffman tree, and the two rANS states as symbols are pushed in.
+class CompressionView
+{
+public:
+    enum class Mode { HashChain, BinaryTree, Huffman, Rans };
+
+    // At most this many bytes of the input are animated.
+    static constexpr size_t SampleSize = 2048;
+
+    void start(const uint8_t *data, size_t size, Mode mode);
+    // Moves on by one frame's worth of steps; false once everything is shown.
+    bool advance();
+    void render(QImage &image) const;
+    QString progress() const;
+
+private:
+    struct LzStep
+    {
+        uint32_t position;
+        LzMatch::Match match;
+        std::vector<LzMatch::Probe> probes;
+    };
+
+    void renderMatches(QPainter &painter, const QRect &area) const;
+    void renderTree(QPainter &painter, const QRect &area) const;
+    void renderStates(QPainter &painter, const QRect &area) const;
+
+    Mode m_mode = Mode::HashChain;
+    std::vector<uint8_t> m_sample;
+    size_t m_step = 0;
+    size_t m_stepCount = 0;
+    int m_frame = 0;
+
+    std::vector<LzStep> m_lzSteps;
+    size_t m_probesShown = 0;
+
+    std::vector<Huffman::Merge> m_merges;
+    uint64_t m_counts[256] = {};
+    uint8_t m_lengths[256] = {};
+
+    std::vector<Rans::Step> m_ransSteps;
+    uint32_t m_frequencies[256] = {};
+};
+
+#endif // COMPRESSIONVIEW_H
@@ -0,0 +1,42 @@
+#ifndef CSRGRAPH_H
+#define CSRGRAPH_H
+
+#include <algorithm>
+#include <cstdint>
+#include <utility>
+#include <vector>
+
+// Compressed sparse row adjacency: the neighbours of vertex v are
+// targets[offsets[v] .. offsets[v + 1]).
+struct CsrGraph
+{
+    std::vector<uint32_t> offsets;
+    std::vector<uint32_t> targets;
+
+    size_t vertexCount() const { return offsets.empty() ? 0 : offsets.size() - 1; }
+    size_t edgeCount() const { return targets.size(); }
+
+    static CsrGraph fromEdges(std::vector<std::pair<uint32_t, uint32_t>> edges);
+};
+
+inline CsrGraph CsrGraph::fromEdges(std::vector<std::pair<uint32_t, uint32_t>> edges)
+{
+    CsrGraph graph;
+    uint32_t vertices = 0;
+    for (const auto &edge : edges)
+        vertices = std::max(vertices, std::max(edge.first, edge.second) + 1);
+
+    graph.offsets.assign(size_t(vertices) + 1, 0);
+    for (const auto &edge : edges)
+        ++graph.offsets[edge.first + 1];
+    for (size_t v = 0; v < vertices; ++v)
+        graph.offsets[v + 1] += graph.offsets[v];
+
+    graph.targets.resize(edges.size());
+    std::vector<uint32_t> cursor(graph.offsets.begin(), graph.offsets.end() - 1);
+    for (const auto &edge : edges)
+        graph.targets[cursor[edge.first]++] = edge.second;
+    return graph;
+}
+
+#endif // CSRGRAPH_H
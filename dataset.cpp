@@ -0,0 +1,117 @@
+#include "dataset.h"
+
+#include <QFile>
+#include <QFileInfo>
+
+namespace {
+
+bool isSpace(char c)
+{
+    return c == ' ' || c == '\t' || c == '\r' || c == '\n' || c == ',' || c == ';';
+}
+
+// Parses the next integer starting at *pos, skipping separators. Returns
+// false at end of input or on a malformed token.
+bool nextInteger(const char *&pos, const char *end, int64_t &value)
+{
+    while (pos < end && isSpace(*pos))
+        ++pos;
+    if (pos == end)
+        return false;
+
+    bool negative = false;
+    if (*pos == '-' || *pos == '+') {
+        negative = *pos == '-';
+        ++pos;
+    }
+    if (pos == end || *pos < '0' || *pos > '9')
+        return false;
+
+    int64_t result = 0;
+    while (pos < end && *pos >= '0' && *pos <= '9')
+        result = result * 10 + (*pos++ - '0');
+    value = negative ? -result : result;
+    return true;
+}
+
+void skipComment(const char *&pos, const char *end)
+{
+    while (pos < end && isSpace(*pos))
+        ++pos;
+    while (pos < end && (*pos == '#' || *pos == '%')) {
+        while (pos < end && *pos != '\n')
+            ++pos;
+        while (pos < end && isSpace(*pos))
+            ++pos;
+    }
+}
+
+} // namespace
+
+Dataset Dataset::fromValues(std::vector<int32_t> values)
+{
+    Dataset dataset;
+    dataset.m_kind = Kind::Array;
+    dataset.m_ownedValues = std::move(values);
+    dataset.m_values = dataset.m_ownedValues.data();
+    dataset.m_valueCount = dataset.m_ownedValues.size();
+    return dataset;
+}
+
+Dataset Dataset::fromGraph(CsrGraph graph)
+{
+    Dataset dataset;
+    dataset.m_kind = Kind::Graph;
+    dataset.m_ownedGraph = std::move(graph);
+    dataset.m_offsets = dataset.m_ownedGraph.offsets.data();
+    dataset.m_targets = dataset.m_ownedGraph.targets.data();
+    dataset.m_vertexCount = dataset.m_ownedGraph.vertexCount();
+    dataset.m_edgeCount = dataset.m_ownedGraph.edgeCount();
+    return dataset;
+}
+
+// Arrays are whitespace or comma separated integers; files with an .edges or
+// .el suffix are edge lists with one "source target" pair per line. Lines
+// starting with '#' or '%' are comments in both.
+Dataset Dataset::importText(const QString &path, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        if (error)
+            *error = file.errorString();
+        return {};
+    }
+    const QByteArray text = file.readAll();
+    const char *pos = text.constData();
+    const char *end = pos + text.size();
+
+    const QString suffix = QFileInfo(path).suffix().toLower();
+    if (suffix == QLatin1String("edges") || suffix == QLatin1String("el")) {
+        std::vector<std::pair<uint32_t, uint32_t>> edges;
+        int64_t source = 0;
+        int64_t target = 0;
+        for (skipComment(pos, end); pos < end; skipComment(pos, end)) {
+            if (!nextInteger(pos, end, source) || !nextInteger(pos, end, target)
+                || source < 0 || target < 0 || source > UINT32_MAX - 1 || target > UINT32_MAX - 1) {
+                if (error)
+                    *error = QStringLiteral("Malformed edge near byte %1").arg(pos - text.constData());
+                return {};
+            }
+            edges.emplace_back(uint32_t(source), uint32_t(target));
+        }
+        return fromGraph(CsrGraph::fromEdges(std::move(edges)));
+    }
+
+    std::vector<int32_t> values;
+    values.reserve(size_t(text.size() / 4));
+    int64_t value = 0;
+    for (skipComment(pos, end); pos < end; skipComment(pos, end)) {
+        if (!nextInteger(pos, end, value) || value < INT32_MIN || value > INT32_MAX) {
+            if (error)
+                *error = QStringLiteral("Malformed value near byte %1").arg(pos - text.constData());
+            return {};
+        }
+        values.push_back(int32_t(value));
+    }
+    return fromValues(std::move(values));
+}
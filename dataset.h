@@ -0,0 +1,60 @@
+#ifndef DATASET_H
+#define DATASET_H
+
+#include "csrgraph.h"
+
+#include <QString>
+
+#include <cstdint>
+#include <memory>
+#include <vector>
+
+class QFile;
+
+// An array or CSR graph that MainWindow operates on. The storage is either
+// owned (freshly imported) or a read-only view into a memory-mapped snapshot;
+// callers only ever see the raw pointers, so both cases look the same.
+class Dataset
+{
+public:
+    enum class Kind { Empty, Array, Graph };
+
+    Dataset() = default;
+    Dataset(Dataset &&) = default;
+    Dataset &operator=(Dataset &&) = default;
+    Dataset(const Dataset &) = delete;
+    Dataset &operator=(const Dataset &) = delete;
+
+    static Dataset fromValues(std::vector<int32_t> values);
+    static Dataset fromGraph(CsrGraph graph);
+    static Dataset importText(const QString &path, QString *error = nullptr);
+
+    Kind kind() const { return m_kind; }
+    bool isEmpty() const { return m_kind == Kind::Empty; }
+    bool isMapped() const { return bool(m_mapping); }
+
+    const int32_t *values() const { return m_values; }
+    size_t valueCount() const { return m_valueCount; }
+
+    const uint32_t *offsets() const { return m_offsets; }
+    const uint32_t *targets() const { return m_targets; }
+    size_t vertexCount() const { return m_vertexCount; }
+    size_t edgeCount() const { return m_edgeCount; }
+
+private:
+    friend class SnapshotCache;
+
+    Kind m_kind = Kind::Empty;
+    std::vector<int32_t> m_ownedValues;
+    CsrGraph m_ownedGraph;
+    std::shared_ptr<QFile> m_mapping;
+
+    const int32_t *m_values = nullptr;
+    size_t m_valueCount = 0;
+    const uint32_t *m_offsets = nullptr;
+    const uint32_t *m_targets = nullptr;
+    size_t m_vertexCount = 0;
+    size_t m_edgeCount = 0;
+};
+
+#endif // DATASET_H
@@ -0,0 +1,660 @@
+#include "distsort.h"
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <atomic>
+#include <cerrno>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+#include <utility>
+
+#ifdef Q_OS_UNIX
+#include <fcntl.h>
+#include <poll.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/socket.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+
+struct DistributedSort::Node
+{
+    std::atomic<uint32_t> phase;
+    std::atomic<uint64_t> localCount;
+    std::atomic<uint64_t> incomingCount;
+    std::atomic<uint64_t> planned[MaxNodes];
+    std::atomic<uint64_t> sent[MaxNodes];
+};
+
+// Start of the shared memory. The lanes follow: every node's local chunk,
+// then every node's incoming area.
+struct DistributedSort::Header
+{
+    static constexpr uint32_t Magic = 0x44534f52; // "DSOR"
+
+    uint32_t magic;
+    uint32_t nodes;
+    uint32_t oversampling;
+    uint64_t chunkValues;
+    uint64_t exchangeMicroseconds;
+    uint64_t pauseMicroseconds;
+    uint64_t total;
+    uint64_t localCapacity;
+    uint64_t incomingCapacity;
+    std::atomic<uint32_t> splitterCount;
+    int32_t splitters[MaxNodes - 1];
+    Node node[MaxNodes];
+
+    static size_t bytes(size_t nodes, size_t localCapacity, size_t incomingCapacity)
+    {
+        return sizeof(Header) + nodes * (localCapacity + incomingCapacity) * sizeof(int32_t);
+    }
+    const int32_t *local(int index) const
+    {
+        return reinterpret_cast<const int32_t *>(this + 1) + size_t(index) * localCapacity;
+    }
+    const int32_t *incoming(int index) const
+    {
+        return local(int(nodes)) + size_t(index) * incomingCapacity;
+    }
+    int32_t *local(int index) { return const_cast<int32_t *>(std::as_const(*this).local(index)); }
+    int32_t *incoming(int index) { return const_cast<int32_t *>(std::as_const(*this).incoming(index)); }
+};
+
+namespace {
+
+// Descriptors in a node: the shared memory, then one socket per peer at
+// FirstSocketFd + peer (its own slot unused).
+constexpr int SharedFd = 3;
+constexpr int FirstSocketFd = 4;
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+#ifdef Q_OS_UNIX
+
+QString systemError(const char *what)
+{
+    return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(std::strerror(errno)));
+}
+
+// One peer's side of an all-to-all round: bytes to send it and room for
+// the bytes it sends us, both sizes agreed on beforehand.
+struct Transfer
+{
+    int fd = -1;
+    const char *out = nullptr;
+    size_t outLeft = 0;
+    char *in = nullptr;
+    size_t inLeft = 0;
+    // Counted in values, for the data round only.
+    std::atomic<uint64_t> *sent = nullptr;
+    size_t sentBytes = 0;
+};
+
+// Sends and receives on all sockets at once, so no pair of nodes can block
+// each other on full socket buffers. pace is slept after every chunk sent.
+bool exchange(std::vector<Transfer> &transfers, size_t chunkBytes, std::chrono::microseconds pace)
+{
+    std::vector<pollfd> fds;
+    std::vector<Transfer *> owners;
+    for (;;) {
+        fds.clear();
+        owners.clear();
+        for (Transfer &transfer : transfers) {
+            const short events = short((transfer.outLeft ? POLLOUT : 0) | (transfer.inLeft ? POLLIN : 0));
+            if (events) {
+                fds.push_back({ transfer.fd, events, 0 });
+                owners.push_back(&transfer);
+            }
+        }
+        if (fds.empty())
+            return true;
+        if (poll(fds.data(), nfds_t(fds.size()), -1) < 0) {
+            if (errno == EINTR)
+                continue;
+            return false;
+        }
+        for (size_t i = 0; i < fds.size(); ++i) {
+            Transfer &transfer = *owners[i];
+            if (fds[i].revents & POLLIN) {
+                const ssize_t got = recv(transfer.fd, transfer.in, transfer.inLeft, 0);
+                if (got <= 0 && !(got < 0 && (errno == EAGAIN || errno == EINTR)))
+                    return false;
+                if (got > 0) {
+                    transfer.in += got;
+                    transfer.inLeft -= size_t(got);
+                }
+            } else if (fds[i].revents & (POLLERR | POLLHUP | POLLNVAL)) {
+                return false;
+            }
+            if ((fds[i].revents & POLLOUT) && transfer.outLeft) {
+                const ssize_t put = send(transfer.fd, transfer.out, std::min(transfer.outLeft, chunkBytes), 0);
+                if (put < 0 && errno != EAGAIN && errno != EINTR)
+                    return false;
+                if (put > 0) {
+                    transfer.out += put;
+                    transfer.outLeft -= size_t(put);
+                    transfer.sentBytes += size_t(put);
+                    if (transfer.sent)
+                        transfer.sent->store(transfer.sentBytes / sizeof(int32_t), std::memory_order_relaxed);
+                    if (pace.count() > 0)
+                        std::this_thread::sleep_for(pace);
+                }
+            }
+        }
+    }
+}
+
+// A round where this node sends out[peer] to, and receives in[peer] from,
+// each peer; empty spans skip that direction.
+bool allToAll(int self, int nodes, const std::vector<std::span<const char>> &out,
+              const std::vector<std::span<char>> &in, size_t chunkBytes = size_t(1) << 16,
+              std::chrono::microseconds pace = {}, std::atomic<uint64_t> *sent = nullptr)
+{
+    std::vector<Transfer> transfers;
+    for (int peer = 0; peer < nodes; ++peer) {
+        if (peer == self)
+            continue;
+        Transfer transfer;
+        transfer.fd = FirstSocketFd + peer;
+        transfer.out = out[peer].data();
+        transfer.outLeft = out[peer].size();
+        transfer.in = in[peer].data();
+        transfer.inLeft = in[peer].size();
+        transfer.sent = sent ? &sent[peer] : nullptr;
+        transfers.push_back(transfer);
+    }
+    return exchange(transfers, chunkBytes, pace);
+}
+
+template<typename T>
+std::span<const char> bytesOf(std::span<const T> values)
+{
+    return { reinterpret_cast<const char *>(values.data()), values.size_bytes() };
+}
+
+template<typename T>
+std::span<char> bytesOf(std::span<T> values)
+{
+    return { reinterpret_cast<char *>(values.data()), values.size_bytes() };
+}
+
+#endif
+
+} // namespace
+
+const char *DistributedSort::phaseName(Phase phase)
+{
+    static const char *const names[] = { "starting", "local sort", "sampling", "splitters", "counts",
+                                         "exchange", "merge", "done", "failed" };
+    return names[int(phase)];
+}
+
+#ifdef Q_OS_UNIX
+
+int DistributedSort::runNode(int argc, char **argv)
+{
+    if (argc != 3)
+        return 2;
+    const int self = std::atoi(argv[2]);
+    // A peer that died shows up as a failed send, not as a signal.
+    signal(SIGPIPE, SIG_IGN);
+    struct stat info;
+    if (fstat(SharedFd, &info) != 0 || size_t(info.st_size) < sizeof(Header))
+        return 3;
+    void *mapped = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, SharedFd, 0);
+    close(SharedFd);
+    if (mapped == MAP_FAILED)
+        return 3;
+    Header &header = *static_cast<Header *>(mapped);
+    const int nodes = int(header.nodes);
+    if (header.magic != Header::Magic || self < 0 || self >= nodes
+        || Header::bytes(nodes, header.localCapacity, header.incomingCapacity) > size_t(info.st_size)) {
+        return 3;
+    }
+    for (int peer = 0; peer < nodes; ++peer) {
+        if (peer != self)
+            fcntl(FirstSocketFd + peer, F_SETFL, fcntl(FirstSocketFd + peer, F_GETFL) | O_NONBLOCK);
+    }
+
+    Node &state = header.node[self];
+    const auto enter = [&](Phase phase) {
+        state.phase.store(uint32_t(phase), std::memory_order_release);
+    };
+    const auto fail = [&] {
+        enter(Phase::Failed);
+        return 1;
+    };
+    const auto pause = [&] {
+        std::this_thread::sleep_for(std::chrono::microseconds(header.pauseMicroseconds));
+    };
+    using OutSpans = std::vector<std::span<const char>>;
+    using InSpans = std::vector<std::span<char>>;
+
+    enter(Phase::LocalSort);
+    const std::span<int32_t> local(header.local(self), size_t(state.localCount.load()));
+    std::sort(local.begin(), local.end());
+    pause();
+
+    // Evenly spaced samples, all sent to node 0.
+    enter(Phase::Sampling);
+    const size_t perNode = std::max<uint32_t>(header.oversampling, 1);
+    std::vector<int32_t> samples(perNode);
+    for (size_t i = 0; i < perNode; ++i)
+        samples[i] = local.empty() ? 0 : local[(i + 1) * local.size() / (perNode + 1)];
+    std::vector<int32_t> allSamples(self == 0 ? perNode * size_t(nodes) : 0);
+    {
+        OutSpans out(nodes);
+        InSpans in(nodes);
+        if (self != 0)
+            out[0] = bytesOf(std::span<const int32_t>(samples));
+        else
+            for (int peer = 1; peer < nodes; ++peer)
+                in[peer] = bytesOf(std::span<int32_t>(allSamples).subspan(size_t(peer) * perNode, perNode));
+        if (!allToAll(self, nodes, out, in))
+            return fail();
+        if (self == 0)
+            std::copy(samples.begin(), samples.end(), allSamples.begin());
+    }
+    pause();
+
+    // Node 0 picks the splitters at regular positions among all samples.
+    enter(Phase::Splitters);
+    std::vector<int32_t> splitters(size_t(nodes) - 1);
+    {
+        OutSpans out(nodes);
+        InSpans in(nodes);
+        if (self == 0) {
+            std::sort(allSamples.begin(), allSamples.end());
+            for (size_t i = 0; i < splitters.size(); ++i)
+                splitters[i] = allSamples[(i + 1) * perNode];
+            std::copy(splitters.begin(), splitters.end(), header.splitters);
+            header.splitterCount.store(uint32_t(splitters.size()), std::memory_order_release);
+            for (int peer = 1; peer < nodes; ++peer)
+                out[peer] = bytesOf(std::span<const int32_t>(splitters));
+        } else {
+            in[0] = bytesOf(std::span<int32_t>(splitters));
+        }
+        if (!allToAll(self, nodes, out, in))
+            return fail();
+    }
+    pause();
+
+    // Bucket j gets the values in (splitters[j - 1], splitters[j]].
+    enter(Phase::Counts);
+    std::vector<size_t> bucketStart(size_t(nodes) + 1, 0);
+    for (int j = 0; j + 1 < nodes; ++j)
+        bucketStart[j + 1] = size_t(std::upper_bound(local.begin(), local.end(), splitters[j]) - local.begin());
+    bucketStart[nodes] = local.size();
+    std::vector<uint64_t> outgoing(nodes);
+    std::vector<uint64_t> incoming(nodes);
+    for (int j = 0; j < nodes; ++j) {
+        outgoing[j] = bucketStart[j + 1] - bucketStart[j];
+        state.planned[j].store(outgoing[j], std::memory_order_relaxed);
+    }
+    {
+        OutSpans out(nodes);
+        InSpans in(nodes);
+        for (int peer = 0; peer < nodes; ++peer) {
+            out[peer] = bytesOf(std::span<const uint64_t>(&outgoing[peer], 1));
+            in[peer] = bytesOf(std::span<uint64_t>(&incoming[peer], 1));
+        }
+        if (!allToAll(self, nodes, out, in))
+            return fail();
+        incoming[self] = outgoing[self];
+    }
+    std::vector<size_t> runStart(size_t(nodes) + 1, 0);
+    for (int j = 0; j < nodes; ++j)
+        runStart[j + 1] = runStart[j] + incoming[j];
+    if (runStart[nodes] > header.incomingCapacity)
+        return fail();
+    state.incomingCount.store(runStart[nodes], std::memory_order_release);
+    pause();
+
+    enter(Phase::Exchange);
+    int32_t *arrived = header.incoming(self);
+    std::copy(local.begin() + bucketStart[self], local.begin() + bucketStart[self + 1], arrived + runStart[self]);
+    state.sent[self].store(outgoing[self], std::memory_order_relaxed);
+    {
+        OutSpans out(nodes);
+        InSpans in(nodes);
+        size_t chunks = 0;
+        const size_t chunkValues = std::max<uint64_t>(header.chunkValues, 1);
+        for (int peer = 0; peer < nodes; ++peer) {
+            if (peer == self)
+                continue;
+            out[peer] = bytesOf(std::span<const int32_t>(local.subspan(bucketStart[peer], outgoing[peer])));
+            in[peer] = bytesOf(std::span<int32_t>(arrived + runStart[peer], incoming[peer]));
+            chunks += (outgoing[peer] + chunkValues - 1) / chunkValues;
+        }
+        const auto pace = std::chrono::microseconds(header.exchangeMicroseconds / std::max<size_t>(chunks, 1));
+        if (!allToAll(self, nodes, out, in, chunkValues * sizeof(int32_t), pace, state.sent))
+            return fail();
+    }
+    pause();
+
+    enter(Phase::Merge);
+    for (int j = 1; j < nodes; ++j)
+        std::inplace_merge(arrived, arrived + runStart[j], arrived + runStart[j + 1]);
+    enter(Phase::Done);
+    return 0;
+}
+
+bool DistributedSort::start(const QString &program, std::span<const int32_t> values, const Options &options,
+                            QString *error)
+{
+    stop();
+    unmap();
+    if (values.empty()) {
+        setError(error, QStringLiteral("Nothing to sort"));
+        return false;
+    }
+    const int nodes = int(std::min<size_t>(size_t(std::clamp(options.nodes, 1, MaxNodes)), values.size()));
+    const size_t localCapacity = (values.size() + size_t(nodes) - 1) / size_t(nodes);
+    // Skew can send everything to one node, so each incoming area takes it all.
+    const size_t incomingCapacity = values.size();
+    m_mappedBytes = Header::bytes(size_t(nodes), localCapacity, incomingCapacity);
+
+    const std::string name = "/animated_algorithms-dsort-" + std::to_string(getpid()) + "-"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        setError(error, systemError("Cannot create shared memory"));
+        return false;
+    }
+    shm_unlink(name.c_str());
+    void *writable = MAP_FAILED;
+    if (ftruncate(fd, off_t(m_mappedBytes)) == 0)
+        writable = mmap(nullptr, m_mappedBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    if (writable == MAP_FAILED) {
+        setError(error, systemError("Cannot set up shared memory"));
+        close(fd);
+        return false;
+    }
+
+    Header *header = new (writable) Header();
+    header->magic = Header::Magic;
+    header->nodes = uint32_t(nodes);
+    header->oversampling = uint32_t(std::max(options.oversampling, 1));
+    header->chunkValues = std::max<size_t>(options.chunkValues, 1);
+    header->exchangeMicroseconds = uint64_t(std::chrono::microseconds(options.exchangeDuration).count());
+    header->pauseMicroseconds = uint64_t(std::chrono::microseconds(options.phasePause).count());
+    header->total = values.size();
+    header->localCapacity = localCapacity;
+    header->incomingCapacity = incomingCapacity;
+    for (int i = 0; i < nodes; ++i) {
+        const size_t first = size_t(i) * values.size() / size_t(nodes);
+        const size_t last = size_t(i + 1) * values.size() / size_t(nodes);
+        std::copy(values.begin() + first, values.begin() + last, header->local(i));
+        header->node[i].localCount.store(last - first, std::memory_order_relaxed);
+    }
+    munmap(writable, m_mappedBytes);
+    const void *readable = mmap(nullptr, m_mappedBytes, PROT_READ, MAP_SHARED, fd, 0);
+    if (readable == MAP_FAILED) {
+        setError(error, systemError("Cannot map shared memory"));
+        close(fd);
+        return false;
+    }
+    m_header = static_cast<const Header *>(readable);
+    m_nodes = nodes;
+
+    // A full mesh of socket pairs; sockets[i][j] is node i's end towards j.
+    std::vector<std::vector<int>> sockets(size_t(m_nodes), std::vector<int>(size_t(m_nodes), -1));
+    bool ok = true;
+    for (int i = 0; i < m_nodes && ok; ++i) {
+        for (int j = i + 1; j < m_nodes && ok; ++j) {
+            int pair[2];
+            ok = socketpair(AF_UNIX, SOCK_STREAM, 0, pair) == 0;
+            if (ok) {
+                fcntl(pair[0], F_SETFD, FD_CLOEXEC);
+                fcntl(pair[1], F_SETFD, FD_CLOEXEC);
+                sockets[i][j] = pair[0];
+                sockets[j][i] = pair[1];
+            }
+        }
+    }
+    if (!ok)
+        setError(error, systemError("Cannot create sockets"));
+
+    const QByteArray programPath = program.toLocal8Bit();
+    m_pids.clear();
+    m_failed = false;
+    m_started = std::chrono::steady_clock::now();
+    for (int i = 0; i < m_nodes && ok; ++i) {
+        // Prepared before fork(), which is followed by async-signal-safe calls only.
+        const std::string index = std::to_string(i);
+        char *argv[] = { const_cast<char *>(programPath.constData()), const_cast<char *>(NodeFlag),
+                         const_cast<char *>(index.c_str()), nullptr };
+        int sources[MaxNodes + 1];
+        int targets[MaxNodes + 1];
+        int count = 0;
+        sources[count] = fd;
+        targets[count++] = SharedFd;
+        for (int j = 0; j < m_nodes; ++j) {
+            if (j != i) {
+                sources[count] = sockets[i][j];
+                targets[count++] = FirstSocketFd + j;
+            }
+        }
+        const pid_t pid = fork();
+        if (pid == 0) {
+            // Move every source above the target range first, so placing
+            // one cannot overwrite another.
+            for (int k = 0; k < count; ++k)
+                sources[k] = fcntl(sources[k], F_DUPFD_CLOEXEC, FirstSocketFd + MaxNodes);
+            for (int k = 0; k < count; ++k) {
+                if (sources[k] < 0 || dup2(sources[k], targets[k]) < 0)
+                    _exit(3);
+            }
+            execv(argv[0], argv);
+            _exit(127);
+        }
+        if (pid < 0) {
+            setError(error, systemError("Cannot start node process"));
+            ok = false;
+        } else {
+            m_pids.push_back(pid);
+        }
+    }
+    close(fd);
+    for (const std::vector<int> &row : sockets) {
+        for (int socket : row) {
+            if (socket >= 0)
+                close(socket);
+        }
+    }
+    m_running = !m_pids.empty();
+    if (!ok) {
+        stop();
+        return false;
+    }
+    return true;
+}
+
+bool DistributedSort::poll()
+{
+    if (!m_running)
+        return false;
+    bool anyLeft = false;
+    for (int &pid : m_pids) {
+        if (pid <= 0)
+            continue;
+        int status = 0;
+        if (waitpid(pid, &status, WNOHANG) == pid) {
+            pid = -1;
+            if (!WIFEXITED(status) || WEXITSTATUS(status) != 0)
+                m_failed = true;
+        } else {
+            anyLeft = true;
+        }
+    }
+    // A node that died leaves its peers waiting on sockets that may never
+    // close while it is half set up; end them all.
+    if (m_failed && anyLeft) {
+        stop();
+        return false;
+    }
+    if (!anyLeft) {
+        m_running = false;
+        m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+    }
+    return m_running;
+}
+
+void DistributedSort::stop()
+{
+    for (int pid : m_pids) {
+        if (pid > 0)
+            kill(pid, SIGKILL);
+    }
+    for (int pid : m_pids) {
+        if (pid > 0)
+            waitpid(pid, nullptr, 0);
+    }
+    if (m_running) {
+        m_seconds = std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+        m_failed = m_failed || !done();
+    }
+    m_pids.clear();
+    m_running = false;
+}
+
+void DistributedSort::unmap()
+{
+    if (m_header)
+        munmap(const_cast<Header *>(m_header), m_mappedBytes);
+    m_header = nullptr;
+    m_nodes = 0;
+}
+
+#else
+
+int DistributedSort::runNode(int, char **)
+{
+    return 2;
+}
+
+bool DistributedSort::start(const QString &, std::span<const int32_t>, const Options &, QString *error)
+{
+    setError(error, QStringLiteral("The distributed sort needs a POSIX system"));
+    return false;
+}
+
+bool DistributedSort::poll()
+{
+    return false;
+}
+
+void DistributedSort::stop()
+{
+}
+
+void DistributedSort::unmap()
+{
+}
+
+#endif
+
+DistributedSort::~DistributedSort()
+{
+    stop();
+    unmap();
+}
+
+const DistributedSort::Node &DistributedSort::node(int index) const
+{
+    return m_header->node[index];
+}
+
+bool DistributedSort::failed() const
+{
+    if (m_failed)
+        return true;
+    for (int i = 0; i < m_nodes; ++i) {
+        if (phase(i) == Phase::Failed)
+            return true;
+    }
+    return false;
+}
+
+bool DistributedSort::done() const
+{
+    for (int i = 0; i < m_nodes; ++i) {
+        if (phase(i) != Phase::Done)
+            return false;
+    }
+    return m_nodes > 0;
+}
+
+double DistributedSort::seconds() const
+{
+    if (m_running)
+        return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_started).count();
+    return m_seconds;
+}
+
+DistributedSort::Phase DistributedSort::phase(int index) const
+{
+    return Phase(node(index).phase.load(std::memory_order_acquire));
+}
+
+std::span<const int32_t> DistributedSort::local(int index) const
+{
+    return { m_header->local(index), size_t(node(index).localCount.load(std::memory_order_relaxed)) };
+}
+
+std::span<const int32_t> DistributedSort::incoming(int index) const
+{
+    return { m_header->incoming(index), size_t(node(index).incomingCount.load(std::memory_order_acquire)) };
+}
+
+uint64_t DistributedSort::sent(int from, int to) const
+{
+    return node(from).sent[to].load(std::memory_order_relaxed);
+}
+
+uint64_t DistributedSort::planned(int from, int to) const
+{
+    return node(from).planned[to].load(std::memory_order_relaxed);
+}
+
+std::vector<int32_t> DistributedSort::splitters() const
+{
+    if (!m_header)
+        return {};
+    const uint32_t count = m_header->splitterCount.load(std::memory_order_acquire);
+    return std::vector<int32_t>(m_header->splitters, m_header->splitters + count);
+}
+
+uint64_t DistributedSort::networkValues() const
+{
+    uint64_t total = 0;
+    for (int from = 0; from < m_nodes; ++from) {
+        for (int to = 0; to < m_nodes; ++to) {
+            if (from != to)
+                total += sent(from, to);
+        }
+    }
+    return total;
+}
+
+double DistributedSort::skew() const
+{
+    if (!m_header || m_nodes == 0)
+        return 0;
+    uint64_t largest = 0;
+    for (int i = 0; i < m_nodes; ++i)
+        largest = std::max<uint64_t>(largest, node(i).incomingCount.load(std::memory_order_relaxed));
+    return double(largest) * m_nodes / double(m_header->total);
+}
@@ -0,0 +1,102 @@
+#ifndef DISTSORT_H
+#define DISTSORT_H
+
+#include <QString>
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Sample sort across local worker processes that stand in for cluster
+// nodes. Every pair of nodes shares a Unix socket, and nothing moves
+// between them except through those sockets:
+//
+//  1. each node sorts its chunk and sends evenly spaced samples to node 0;
+//  2. node 0 sorts the samples and sends everyone the nodes - 1 splitters;
+//  3. the nodes exchange how many values they have for each other, then
+//     the values themselves, all to all;
+//  4. each node merges the sorted runs it received.
+//
+// The coordinator (this class) and anyone it shows them to read the
+// nodes' arrays and counters from shared memory, mapped read-only here,
+// as the rounds happen. Like Sandbox, a node is this executable started
+// again with NodeFlag, which main() passes to runNode(). POSIX only.
+class DistributedSort
+{
+public:
+    static constexpr int MaxNodes = 16;
+    static constexpr const char *NodeFlag = "--sort-node";
+    static int runNode(int argc, char **argv);
+
+    enum class Phase : uint32_t { Starting, LocalSort, Sampling, Splitters, Counts, Exchange, Merge, Done, Failed };
+    static const char *phaseName(Phase phase);
+
+    struct Options
+    {
+        int nodes = 4;
+        // Samples per node; more gives splitters closer to the true quantiles.
+        int oversampling = 32;
+        // Values per socket write during the exchange.
+        size_t chunkValues = 4096;
+        // Stretch the value exchange to about this long, and rest this long
+        // after every other phase, so the rounds can be watched. Zero runs
+        // at full speed.
+        std::chrono::milliseconds exchangeDuration { 0 };
+        std::chrono::milliseconds phasePause { 0 };
+    };
+
+    DistributedSort() = default;
+    DistributedSort(const DistributedSort &) = delete;
+    DistributedSort &operator=(const DistributedSort &) = delete;
+    ~DistributedSort();
+
+    // The values are dealt out to the nodes in contiguous chunks.
+    bool start(const QString &program, std::span<const int32_t> values, const Options &options,
+               QString *error = nullptr);
+    // Reaps nodes that have exited; false once none is left running.
+    bool poll();
+    void stop();
+
+    int nodes() const { return m_nodes; }
+    bool running() const { return m_running; }
+    bool failed() const;
+    bool done() const;
+    double seconds() const;
+
+    Phase phase(int node) const;
+    // The node's own chunk, sorted once past LocalSort.
+    std::span<const int32_t> local(int node) const;
+    // Where the node's incoming values land, one run per sender in node
+    // order; sized once the counts are known, filled as values arrive,
+    // and merged into the node's final partition at the end.
+    std::span<const int32_t> incoming(int node) const;
+    // Values node from has sent to node to, and planned to send in total.
+    uint64_t sent(int from, int to) const;
+    uint64_t planned(int from, int to) const;
+    std::vector<int32_t> splitters() const;
+
+    // Values that crossed a socket, and the largest final partition over
+    // the mean one.
+    uint64_t networkValues() const;
+    double skew() const;
+
+private:
+    struct Header;
+    struct Node;
+
+    const Node &node(int index) const;
+    void unmap();
+
+    int m_nodes = 0;
+    std::vector<int> m_pids;
+    bool m_running = false;
+    bool m_failed = false;
+    std::chrono::steady_clock::time_point m_started;
+    double m_seconds = 0;
+
+    const Header *m_header = nullptr;
+    size_t m_mappedBytes = 0;
+};
+
+#endif // DISTSORT_H
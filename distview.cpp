@@ -0,0 +1,141 @@
+#include "distview.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <limits>
+
+namespace DistView {
+
+namespace {
+
+constexpr int Width = 1280;
+constexpr int Height = 720;
+constexpr int LabelHeight = 16;
+constexpr int LocalRight = 560;
+constexpr int IncomingLeft = 720;
+
+QColor nodeColour(int node, int nodes, bool bright = true)
+{
+    return QColor::fromHsv(node * 360 / std::max(nodes, 1), bright ? 170 : 90, bright ? 230 : 90);
+}
+
+// Column x shows the element at x * n / width, as a bar scaled between
+// lowest and highest; colour gives each element's colour, or 0 to skip it.
+template<typename Colour>
+void drawBars(QImage &image, const QRect &area, size_t n, int64_t lowest, int64_t highest,
+              const int32_t *values, Colour colour)
+{
+    if (n == 0 || area.width() <= 0 || area.height() <= 0)
+        return;
+    const double scale = area.height() / double(std::max<int64_t>(highest - lowest, 1));
+    for (int x = 0; x < area.width(); ++x) {
+        const size_t index = size_t(x) * n / size_t(area.width());
+        const QRgb rgb = colour(index);
+        if (!rgb)
+            continue;
+        const int height = std::min(area.height(), 1 + int((int64_t(values[index]) - lowest) * scale));
+        for (int y = area.bottom() + 1 - height; y <= area.bottom(); ++y)
+            reinterpret_cast<QRgb *>(image.scanLine(y))[area.left() + x] = rgb;
+    }
+}
+
+} // namespace
+
+void render(const DistributedSort &sort, QImage &image)
+{
+    // A device pixel ratio left by RaceView would scale the painting.
+    if (image.size() != QSize(Width, Height) || image.format() != QImage::Format_RGB32 || image.devicePixelRatio() != 1)
+        image = QImage(Width, Height, QImage::Format_RGB32);
+    image.fill(qRgb(16, 16, 20));
+    const int nodes = sort.nodes();
+    if (nodes == 0)
+        return;
+
+    int64_t lowest = std::numeric_limits<int32_t>::max();
+    int64_t highest = std::numeric_limits<int32_t>::min();
+    for (int i = 0; i < nodes; ++i) {
+        for (int32_t value : sort.local(i)) {
+            lowest = std::min<int64_t>(lowest, value);
+            highest = std::max<int64_t>(highest, value);
+        }
+    }
+    const std::vector<int32_t> splitters = sort.splitters();
+    const int rowHeight = Height / nodes;
+    const auto row = [&](int node) { return QRect(0, node * rowHeight, Width, rowHeight); };
+
+    for (int i = 0; i < nodes; ++i) {
+        const QRect cell = row(i);
+        const bool known = sort.phase(i) >= DistributedSort::Phase::Counts;
+        const bool merged = sort.phase(i) >= DistributedSort::Phase::Merge;
+
+        // Bucket j of this node's sorted chunk starts after the values planned
+        // for the nodes before it.
+        std::vector<size_t> bucketStart(size_t(nodes) + 1, 0);
+        std::vector<size_t> runStart(size_t(nodes) + 1, 0);
+        for (int j = 0; j < nodes; ++j) {
+            bucketStart[j + 1] = bucketStart[j] + sort.planned(i, j);
+            runStart[j + 1] = runStart[j] + sort.planned(j, i);
+        }
+
+        const std::span<const int32_t> local = sort.local(i);
+        const QRect localArea(cell.left() + 4, cell.top() + LabelHeight, LocalRight - 8, cell.height() - LabelHeight - 3);
+        drawBars(image, localArea, local.size(), lowest, highest, local.data(), [&](size_t index) {
+            if (splitters.empty() || !known)
+                return qRgb(120, 120, 130);
+            const int bucket = int(std::upper_bound(bucketStart.begin() + 1, bucketStart.end(), index) - bucketStart.begin()) - 1;
+            const bool gone = bucket != i && index - bucketStart[bucket] < sort.sent(i, bucket);
+            return nodeColour(bucket, nodes, !gone).rgb();
+        });
+
+        const std::span<const int32_t> incoming = sort.incoming(i);
+        const QRect incomingArea(IncomingLeft + 4, cell.top() + LabelHeight, Width - IncomingLeft - 8,
+                                 cell.height() - LabelHeight - 3);
+        drawBars(image, incomingArea, incoming.size(), lowest, highest, incoming.data(), [&](size_t index) -> QRgb {
+            if (merged)
+                return nodeColour(i, nodes).rgb();
+            const int source = int(std::upper_bound(runStart.begin() + 1, runStart.end(), index) - runStart.begin()) - 1;
+            if (index - runStart[source] >= sort.sent(source, i))
+                return 0;
+            return nodeColour(source, nodes).rgb();
+        });
+    }
+
+    QPainter painter(&image);
+    painter.setRenderHint(QPainter::Antialiasing);
+    uint64_t largest = 1;
+    for (int from = 0; from < nodes; ++from) {
+        for (int to = 0; to < nodes; ++to)
+            largest = std::max(largest, from == to ? 0 : sort.planned(from, to));
+    }
+    for (int from = 0; from < nodes; ++from) {
+        for (int to = 0; to < nodes; ++to) {
+            const uint64_t planned = sort.planned(from, to);
+            if (from == to || planned == 0)
+                continue;
+            const uint64_t sent = sort.sent(from, to);
+            QColor colour = nodeColour(to, nodes);
+            colour.setAlpha(sent > 0 && sent < planned ? 230 : 50);
+            painter.setPen(QPen(colour, 1.0 + 5.0 * double(planned) / double(largest)));
+            painter.drawLine(QPointF(LocalRight, row(from).center().y()), QPointF(IncomingLeft, row(to).center().y()));
+        }
+    }
+
+    QFont font = painter.font();
+    font.setPixelSize(11);
+    painter.setFont(font);
+    for (int i = 0; i < nodes; ++i) {
+        const QRect cell = row(i);
+        painter.setPen(QColor(45, 45, 55));
+        painter.drawLine(cell.left(), cell.bottom(), cell.right(), cell.bottom());
+        painter.setPen(nodeColour(i, nodes));
+        painter.drawText(QRect(cell.left() + 4, cell.top(), LocalRight, LabelHeight), Qt::AlignLeft | Qt::AlignVCenter,
+                         QStringLiteral("node %1: %2, %3 values").arg(i)
+                         .arg(QLatin1String(DistributedSort::phaseName(sort.phase(i)))).arg(sort.local(i).size()));
+        painter.drawText(QRect(IncomingLeft + 4, cell.top(), Width - IncomingLeft - 8, LabelHeight),
+                         Qt::AlignLeft | Qt::AlignVCenter,
+                         QStringLiteral("receives %1").arg(sort.incoming(i).size()));
+    }
+}
+
+} // namespace DistView
@@ -0,0 +1,18 @@
+#ifndef DISTVIEW_H
+#define DISTVIEW_H
+
+#include "distsort.h"
+
+#include <QImage>
+
+// Draws a DistributedSort as one row per node: on the left its own chunk,
+// coloured by the node each value is bound for and dimmed once sent; on
+// the right the runs arriving from each sender; and between them a line
+// per pair of nodes, as thick as the partition and bright while it moves.
+namespace DistView {
+
+void render(const DistributedSort &sort, QImage &image);
+
+} // namespace DistView
+
+#endif // DISTVIEW_H
@@ -0,0 +1,376 @@
+#include "entropy.h"
+
+#include <algorithm>
+#include <cstring>
+#include <queue>
+
+namespace {
+
+void put32(uint8_t *p, uint32_t value)
+{
+    for (int i = 0; i < 4; ++i)
+        p[i] = uint8_t(value >> (8 * i));
+}
+
+uint32_t get32(const uint8_t *p)
+{
+    return uint32_t(p[0]) | uint32_t(p[1]) << 8 | uint32_t(p[2]) << 16 | uint32_t(p[3]) << 24;
+}
+
+void countBytes(const uint8_t *data, size_t size, uint64_t counts[256])
+{
+    std::fill(counts, counts + 256, 0);
+    for (size_t i = 0; i < size; ++i)
+        ++counts[data[i]];
+}
+
+} // namespace
+
+namespace Huffman {
+
+namespace {
+
+constexpr size_t LengthTableBytes = 128;
+
+// Decoding reads MaxCodeLength bits at a time, LSB first, so codes are
+// stored bit-reversed and every table slot ending in a code maps to it.
+struct TableEntry
+{
+    uint8_t symbol;
+    uint8_t length;
+};
+
+void canonicalCodes(const uint8_t lengths[256], uint16_t codes[256])
+{
+    int lengthCount[MaxCodeLength + 1] = {};
+    for (int s = 0; s < 256; ++s)
+        ++lengthCount[lengths[s]];
+    lengthCount[0] = 0;
+    int next[MaxCodeLength + 2] = {};
+    for (int length = 1, code = 0; length <= MaxCodeLength; ++length) {
+        code = (code + lengthCount[length - 1]) << 1;
+        next[length] = code;
+    }
+    for (int s = 0; s < 256; ++s) {
+        const int length = lengths[s];
+        if (!length)
+            continue;
+        const int code = next[length]++;
+        int reversed = 0;
+        for (int bit = 0; bit < length; ++bit)
+            reversed |= ((code >> bit) & 1) << (length - 1 - bit);
+        codes[s] = uint16_t(reversed);
+    }
+}
+
+} // namespace
+
+std::vector<Merge> buildTree(const uint64_t counts[256])
+{
+    using Item = std::pair<uint64_t, int>;
+    std::priority_queue<Item, std::vector<Item>, std::greater<Item>> heap;
+    for (int s = 0; s < 256; ++s) {
+        if (counts[s])
+            heap.push({ counts[s], s });
+    }
+    std::vector<Merge> merges;
+    while (heap.size() > 1) {
+        const Item a = heap.top();
+        heap.pop();
+        const Item b = heap.top();
+        heap.pop();
+        merges.push_back({ a.second, b.second, a.first + b.first });
+        heap.push({ a.first + b.first, 255 + int(merges.size()) });
+    }
+    return merges;
+}
+
+void codeLengths(const uint64_t counts[256], uint8_t lengths[256])
+{
+    std::fill(lengths, lengths + 256, 0);
+    const std::vector<Merge> merges = buildTree(counts);
+    if (merges.empty()) {
+        for (int s = 0; s < 256; ++s) {
+            if (counts[s])
+                lengths[s] = 1;
+        }
+        return;
+    }
+
+    // Depths from the root down: the last merge is the root.
+    std::vector<int> depth(256 + merges.size(), 0);
+    for (size_t i = merges.size(); i-- > 0;) {
+        const int node = 256 + int(i);
+        depth[size_t(merges[i].left)] = depth[size_t(node)] + 1;
+        depth[size_t(merges[i].right)] = depth[size_t(node)] + 1;
+    }
+
+    // Clamp to the limit, then lengthen the rarest of the longest remaining
+    // codes until the Kraft sum fits again.
+    uint32_t kraft = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (!counts[s])
+            continue;
+        lengths[s] = uint8_t(std::min(depth[size_t(s)], MaxCodeLength));
+        kraft += 1u << (MaxCodeLength - lengths[s]);
+    }
+    while (kraft > (1u << MaxCodeLength)) {
+        int pick = -1;
+        for (int s = 0; s < 256; ++s) {
+            if (!counts[s] || lengths[s] >= MaxCodeLength)
+                continue;
+            if (pick < 0 || lengths[s] > lengths[pick]
+                || (lengths[s] == lengths[pick] && counts[s] < counts[pick]))
+                pick = s;
+        }
+        ++lengths[pick];
+        kraft -= 1u << (MaxCodeLength - lengths[pick]);
+    }
+}
+
+void encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out)
+{
+    uint64_t counts[256];
+    countBytes(data, size, counts);
+    uint8_t lengths[256];
+    codeLengths(counts, lengths);
+    uint16_t codes[256] = {};
+    canonicalCodes(lengths, codes);
+
+    const size_t start = out.size();
+    out.resize(start + LengthTableBytes);
+    for (int s = 0; s < 256; s += 2)
+        out[start + size_t(s / 2)] = uint8_t(lengths[s] | lengths[s + 1] << 4);
+
+    uint64_t bits = 0;
+    int pending = 0;
+    for (size_t i = 0; i < size; ++i) {
+        bits |= uint64_t(codes[data[i]]) << pending;
+        pending += lengths[data[i]];
+        if (pending >= 32) {
+            const size_t at = out.size();
+            out.resize(at + 4);
+            put32(out.data() + at, uint32_t(bits));
+            bits >>= 32;
+            pending -= 32;
+        }
+    }
+    for (; pending > 0; pending -= 8, bits >>= 8)
+        out.push_back(uint8_t(bits));
+}
+
+bool decode(const uint8_t *payload, size_t payloadSize, size_t size, uint8_t *out)
+{
+    if (size == 0)
+        return true;
+    if (payloadSize < LengthTableBytes)
+        return false;
+
+    uint8_t lengths[256];
+    uint32_t kraft = 0;
+    for (int s = 0; s < 256; ++s) {
+        lengths[s] = (payload[s / 2] >> (4 * (s & 1))) & 15;
+        if (lengths[s] > MaxCodeLength)
+            return false;
+        if (lengths[s])
+            kraft += 1u << (MaxCodeLength - lengths[s]);
+    }
+    if (kraft == 0 || kraft > (1u << MaxCodeLength))
+        return false;
+
+    uint16_t codes[256] = {};
+    canonicalCodes(lengths, codes);
+    std::vector<TableEntry> table(size_t(1) << MaxCodeLength, TableEntry { 0, 0 });
+    for (int s = 0; s < 256; ++s) {
+        for (uint32_t slot = codes[s]; lengths[s] && slot < table.size(); slot += 1u << lengths[s])
+            table[slot] = { uint8_t(s), lengths[s] };
+    }
+
+    const uint8_t *in = payload + LengthTableBytes;
+    const uint8_t *end = payload + payloadSize;
+    uint64_t bits = 0;
+    int available = 0;
+    uint64_t consumed = 0;
+    constexpr uint32_t Mask = (1u << MaxCodeLength) - 1;
+    for (size_t i = 0; i < size; ++i) {
+        if (available < MaxCodeLength) {
+            if (end - in >= 8) {
+                uint64_t word = 0;
+                for (int b = 0; b < 8; ++b)
+                    word |= uint64_t(in[b]) << (8 * b);
+                bits |= word << available;
+                in += (63 - available) >> 3;
+                available |= 56;
+            } else {
+                while (available <= 56) {
+                    bits |= uint64_t(in < end ? *in++ : 0) << available;
+                    available += 8;
+                }
+            }
+        }
+        const TableEntry entry = table[bits & Mask];
+        if (!entry.length)
+            return false;
+        out[i] = entry.symbol;
+        bits >>= entry.length;
+        available -= entry.length;
+        consumed += entry.length;
+    }
+    return consumed <= uint64_t(payloadSize - LengthTableBytes) * 8;
+}
+
+} // namespace Huffman
+
+namespace Rans {
+
+namespace {
+
+constexpr uint32_t Total = 1u << ScaleBits;
+constexpr size_t PresenceBytes = 32;
+
+} // namespace
+
+void normalize(const uint64_t counts[256], uint32_t frequencies[256])
+{
+    uint64_t total = 0;
+    for (int s = 0; s < 256; ++s)
+        total += counts[s];
+    std::fill(frequencies, frequencies + 256, 0);
+    if (!total)
+        return;
+
+    // Floor the exact shares, then hand the remainder to the symbols that
+    // lost the most to rounding.
+    int64_t assigned = 0;
+    uint64_t remainders[256] = {};
+    for (int s = 0; s < 256; ++s) {
+        if (!counts[s])
+            continue;
+        const uint64_t scaled = counts[s] * Total;
+        frequencies[s] = std::max<uint32_t>(1, uint32_t(scaled / total));
+        remainders[s] = uint64_t(scaled % total);
+        assigned += frequencies[s];
+    }
+    int order[256];
+    for (int s = 0; s < 256; ++s)
+        order[s] = s;
+    if (assigned < int64_t(Total)) {
+        std::stable_sort(order, order + 256, [&](int a, int b) { return remainders[a] > remainders[b]; });
+        for (int i = 0; assigned < int64_t(Total); i = (i + 1) % 256) {
+            if (counts[order[i]]) {
+                ++frequencies[order[i]];
+                ++assigned;
+            }
+        }
+    } else {
+        std::stable_sort(order, order + 256, [&](int a, int b) { return frequencies[a] > frequencies[b]; });
+        for (int i = 0; assigned > int64_t(Total); i = (i + 1) % 256) {
+            if (frequencies[order[i]] > 1) {
+                --frequencies[order[i]];
+                --assigned;
+            }
+        }
+    }
+}
+
+void encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out, std::vector<Step> *steps)
+{
+    uint64_t counts[256];
+    countBytes(data, size, counts);
+    uint32_t frequencies[256];
+    normalize(counts, frequencies);
+    uint32_t starts[256];
+    for (uint32_t s = 0, start = 0; s < 256; start += frequencies[s++])
+        starts[s] = start;
+
+    // A symbol costs at most ScaleBits bits, plus the two flushed states.
+    std::vector<uint8_t> buffer(size * 2 + 8);
+    uint8_t *end = buffer.data() + buffer.size();
+    uint8_t *p = end;
+    uint32_t states[2] = { LowerBound, LowerBound };
+    for (size_t i = size; i-- > 0;) {
+        const uint8_t symbol = data[i];
+        const uint32_t frequency = frequencies[symbol];
+        uint32_t x = states[i & 1];
+        const uint32_t before = x;
+        const uint32_t limit = ((LowerBound >> ScaleBits) << 8) * frequency;
+        int bytes = 0;
+        while (x >= limit) {
+            *--p = uint8_t(x);
+            x >>= 8;
+            ++bytes;
+        }
+        x = ((x / frequency) << ScaleBits) + (x % frequency) + starts[symbol];
+        states[i & 1] = x;
+        if (steps)
+            steps->push_back({ i, symbol, before, x, bytes });
+    }
+    p -= 4;
+    put32(p, states[1]);
+    p -= 4;
+    put32(p, states[0]);
+
+    uint8_t model[PresenceBytes] = {};
+    for (int s = 0; s < 256; ++s) {
+        if (frequencies[s])
+            model[s / 8] |= uint8_t(1 << (s % 8));
+    }
+    out.insert(out.end(), model, model + PresenceBytes);
+    for (int s = 0; s < 256; ++s) {
+        if (frequencies[s]) {
+            out.push_back(uint8_t(frequencies[s] - 1));
+            out.push_back(uint8_t((frequencies[s] - 1) >> 8));
+        }
+    }
+    out.insert(out.end(), p, end);
+}
+
+bool decode(const uint8_t *payload, size_t payloadSize, size_t size, uint8_t *out)
+{
+    if (size == 0)
+        return true;
+    if (payloadSize < PresenceBytes)
+        return false;
+
+    const uint8_t *in = payload + PresenceBytes;
+    const uint8_t *end = payload + payloadSize;
+    uint32_t frequencies[256] = {};
+    uint32_t starts[256] = {};
+    uint8_t symbols[Total];
+    uint32_t total = 0;
+    for (int s = 0; s < 256; ++s) {
+        if (!(payload[s / 8] & (1 << (s % 8))))
+            continue;
+        if (end - in < 2)
+            return false;
+        frequencies[s] = uint32_t(in[0] | in[1] << 8) + 1;
+        in += 2;
+        if (frequencies[s] > Total - total)
+            return false;
+        starts[s] = total;
+        std::memset(symbols + total, s, frequencies[s]);
+        total += frequencies[s];
+    }
+    if (total != Total || end - in < 8)
+        return false;
+
+    uint32_t states[2] = { get32(in), get32(in + 4) };
+    in += 8;
+    for (size_t i = 0; i < size; ++i) {
+        uint32_t x = states[i & 1];
+        const uint32_t slot = x & (Total - 1);
+        const uint8_t symbol = symbols[slot];
+        x = frequencies[symbol] * (x >> ScaleBits) + slot - starts[symbol];
+        while (x < LowerBound) {
+            if (in == end)
+                return false;
+            x = x << 8 | *in++;
+        }
+        states[i & 1] = x;
+        out[i] = symbol;
+    }
+    // The encoder started from LowerBound in both lanes and used every byte.
+    return in == end && states[0] == LowerBound && states[1] == LowerBound;
+}
+
+} // namespace Rans
@@ -0,0 +1,63 @@
+#ifndef ENTROPY_H
+#define ENTROPY_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Order-0 entropy coders for byte streams. Encoders append a self-contained
+// payload (model plus data) to out; decoders return false on malformed
+// input instead of reading past it.
+
+namespace Huffman {
+
+// Code lengths are capped so decoding is a single table lookup.
+constexpr int MaxCodeLength = 12;
+
+// One step of building the tree: nodes 0..255 are the byte leaves, merge i
+// creates node 256 + i.
+struct Merge
+{
+    int left;
+    int right;
+    uint64_t weight;
+};
+
+// The merges of the classic two-smallest-first construction, in order.
+std::vector<Merge> buildTree(const uint64_t counts[256]);
+// Length-limited code lengths; zero for bytes that never occur.
+void codeLengths(const uint64_t counts[256], uint8_t lengths[256]);
+
+void encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out);
+bool decode(const uint8_t *payload, size_t payloadSize, size_t size, uint8_t *out);
+
+} // namespace Huffman
+
+// rANS with 12-bit frequencies, byte-wise renormalisation and two
+// interleaved states, after Giesen's rans_byte.
+namespace Rans {
+
+constexpr int ScaleBits = 12;
+constexpr uint32_t LowerBound = 1u << 23;
+
+// Frequencies scaled to sum to 1 << ScaleBits, every present byte at least 1.
+void normalize(const uint64_t counts[256], uint32_t frequencies[256]);
+
+// What encoding one symbol did to the state, for the visualiser. Symbols
+// are encoded last to first, so steps come out in reverse input order.
+struct Step
+{
+    size_t index;
+    uint8_t symbol;
+    uint32_t stateBefore;
+    uint32_t stateAfter;
+    int bytesOut;
+};
+
+void encode(const uint8_t *data, size_t size, std::vector<uint8_t> &out,
+            std::vector<Step> *steps = nullptr);
+bool decode(const uint8_t *payload, size_t payloadSize, size_t size, uint8_t *out);
+
+} // namespace Rans
+
+#endif // ENTROPY_H
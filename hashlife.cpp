@@ -0,0 +1,276 @@
+#include "hashlife.h"
+
+#include "lifeboard.h"
+
+#include <algorithm>
+
+namespace {
+
+size_t mixPointer(const void *pointer, uint64_t seed)
+{
+    uint64_t h = uint64_t(reinterpret_cast<uintptr_t>(pointer)) * 0x9e3779b97f4a7c15ULL + seed;
+    h ^= h >> 31;
+    h *= 0xbf58476d1ce4e5b9ULL;
+    return size_t(h ^ (h >> 29));
+}
+
+} // namespace
+
+size_t HashLife::QuadHash::operator()(const QuadKey &key) const
+{
+    return mixPointer(key.nw, 1) ^ mixPointer(key.ne, 2) ^ mixPointer(key.sw, 3) ^ mixPointer(key.se, 4);
+}
+
+size_t HashLife::StepHash::operator()(const std::pair<const Node *, int> &key) const
+{
+    return mixPointer(key.first, uint64_t(key.second));
+}
+
+HashLife::HashLife()
+{
+    m_nodes.push_back({ nullptr, nullptr, nullptr, nullptr, 0, 0, nullptr });
+    m_dead = &m_nodes.back();
+    m_nodes.push_back({ nullptr, nullptr, nullptr, nullptr, 1, 0, nullptr });
+    m_alive = &m_nodes.back();
+    m_empty.push_back(m_dead);
+    m_root = empty(3);
+}
+
+const HashLife::Node *HashLife::join(const Node *nw, const Node *ne, const Node *sw, const Node *se)
+{
+    const QuadKey key { nw, ne, sw, se };
+    const auto found = m_index.find(key);
+    if (found != m_index.end())
+        return found->second;
+
+    m_nodes.push_back({ nw, ne, sw, se,
+                        nw->population + ne->population + sw->population + se->population,
+                        nw->level + 1, nullptr });
+    const Node *node = &m_nodes.back();
+    m_index.emplace(key, node);
+    return node;
+}
+
+const HashLife::Node *HashLife::empty(int level)
+{
+    while (int(m_empty.size()) <= level) {
+        const Node *e = m_empty.back();
+        m_empty.push_back(join(e, e, e, e));
+    }
+    return m_empty[size_t(level)];
+}
+
+// Embeds node in the middle of an empty node one level up.
+const HashLife::Node *HashLife::expand(const Node *node)
+{
+    const Node *e = empty(node->level - 1);
+    return join(join(e, e, e, node->nw), join(e, e, node->ne, e),
+                join(e, node->sw, e, e), join(node->se, e, e, e));
+}
+
+const HashLife::Node *HashLife::centre(const Node *node)
+{
+    return join(node->nw->se, node->ne->sw, node->sw->ne, node->se->nw);
+}
+
+// Base case: the 2x2 centre of a 4x4 node one generation later.
+const HashLife::Node *HashLife::lifeFourByFour(const Node *node)
+{
+    auto alive = [node](int x, int y) {
+        const Node *quadrant = y < 2 ? (x < 2 ? node->nw : node->ne) : (x < 2 ? node->sw : node->se);
+        const Node *leaf = (y & 1) ? ((x & 1) ? quadrant->se : quadrant->sw)
+                                   : ((x & 1) ? quadrant->ne : quadrant->nw);
+        return leaf->population != 0;
+    };
+    auto next = [&](int x, int y) {
+        int neighbours = 0;
+        for (int dy = -1; dy <= 1; ++dy) {
+            for (int dx = -1; dx <= 1; ++dx) {
+                if (dx || dy)
+                    neighbours += alive(x + dx, y + dy);
+            }
+        }
+        const bool live = neighbours == 3 || (neighbours == 2 && alive(x, y));
+        return live ? m_alive : m_dead;
+    };
+    return join(next(1, 1), next(2, 1), next(1, 2), next(2, 2));
+}
+
+// The centre half of node advanced by 2^j generations (j <= level - 2).
+const HashLife::Node *HashLife::successor(const Node *node, int j)
+{
+    if (node->population == 0)
+        return node->nw;
+    j = std::min(j, node->level - 2);
+
+    const bool fullStep = j == node->level - 2;
+    if (fullStep && node->next)
+        return node->next;
+    if (!fullStep) {
+        const auto cached = m_steps.find({ node, j });
+        if (cached != m_steps.end())
+            return cached->second;
+    }
+
+    const Node *result;
+    if (node->level == 2) {
+        result = lifeFourByFour(node);
+    } else {
+        const Node *nw = node->nw;
+        const Node *ne = node->ne;
+        const Node *sw = node->sw;
+        const Node *se = node->se;
+        const Node *c1 = successor(nw, j);
+        const Node *c2 = successor(join(nw->ne, ne->nw, nw->se, ne->sw), j);
+        const Node *c3 = successor(ne, j);
+        const Node *c4 = successor(join(nw->sw, nw->se, sw->nw, sw->ne), j);
+        const Node *c5 = successor(join(nw->se, ne->sw, sw->ne, se->nw), j);
+        const Node *c6 = successor(join(ne->sw, ne->se, se->nw, se->ne), j);
+        const Node *c7 = successor(sw, j);
+        const Node *c8 = successor(join(sw->ne, se->nw, sw->se, se->sw), j);
+        const Node *c9 = successor(se, j);
+
+        if (fullStep) {
+            result = join(successor(join(c1, c2, c4, c5), j), successor(join(c2, c3, c5, c6), j),
+                          successor(join(c4, c5, c7, c8), j), successor(join(c5, c6, c8, c9), j));
+        } else {
+            result = join(join(c1->se, c2->sw, c4->ne, c5->nw), join(c2->se, c3->sw, c5->ne, c6->nw),
+                          join(c4->se, c5->sw, c7->ne, c8->nw), join(c5->se, c6->sw, c8->ne, c9->nw));
+        }
+    }
+
+    if (fullStep)
+        node->next = result;
+    else
+        m_steps.emplace(std::make_pair(node, j), result);
+    return result;
+}
+
+const HashLife::Node *HashLife::build(const LifeBoard &board, int x, int y, int level)
+{
+    if (x >= board.width() || y >= board.height())
+        return empty(level);
+    if (level == 0)
+        return board.cell(x, y) ? m_alive : m_dead;
+
+    const int size = 1 << level;
+    if (level >= 6) {
+        const int lastRow = std::min(board.height(), y + size);
+        const int firstWord = x / 64;
+        const int lastWord = std::min(board.wordsPerRow(), (x + size) / 64);
+        bool occupied = false;
+        for (int row = y; row < lastRow && !occupied; ++row) {
+            const uint64_t *cells = board.row(row);
+            occupied = std::any_of(cells + firstWord, cells + lastWord, [](uint64_t w) { return w != 0; });
+        }
+        if (!occupied)
+            return empty(level);
+    }
+
+    const int half = size / 2;
+    return join(build(board, x, y, level - 1), build(board, x + half, y, level - 1),
+                build(board, x, y + half, level - 1), build(board, x + half, y + half, level - 1));
+}
+
+void HashLife::load(const LifeBoard &board)
+{
+    *this = HashLife();
+    int level = 3;
+    while ((1 << level) < std::max(board.width(), board.height()))
+        ++level;
+    m_root = build(board, 0, 0, level);
+}
+
+uint64_t HashLife::population() const
+{
+    return m_root->population;
+}
+
+void HashLife::advance(uint64_t generations)
+{
+    for (int j = 0; j < 64 && (generations >> j); ++j) {
+        if (!((generations >> j) & 1))
+            continue;
+
+        // The result is the centre half of the root, so the pattern must sit
+        // inside the centre quarter with a margin of at least 2^j cells,
+        // which is as far as anything can travel in 2^j generations.
+        for (;;) {
+            const Node *r = m_root;
+            const bool confined = r->level >= 3
+                    && r->nw->se->se->population + r->ne->sw->sw->population
+                       + r->sw->ne->ne->population + r->se->nw->nw->population == r->population;
+            if (confined && r->level >= j + 3)
+                break;
+            m_originX -= int64_t(1) << (r->level - 1);
+            m_originY -= int64_t(1) << (r->level - 1);
+            m_root = expand(r);
+        }
+
+        const int level = m_root->level;
+        m_root = successor(m_root, j);
+        m_originX += int64_t(1) << (level - 2);
+        m_originY += int64_t(1) << (level - 2);
+        m_generation += uint64_t(1) << j;
+
+        if (m_nodes.size() > NodeLimit)
+            collectGarbage();
+    }
+
+    while (m_root->level > 3 && centre(m_root)->population == m_root->population) {
+        m_originX += int64_t(1) << (m_root->level - 2);
+        m_originY += int64_t(1) << (m_root->level - 2);
+        m_root = centre(m_root);
+    }
+}
+
+const HashLife::Node *HashLife::copyInto(HashLife &target, const Node *node,
+                                         std::unordered_map<const Node *, const Node *> &copies) const
+{
+    if (node->level == 0)
+        return node->population ? target.m_alive : target.m_dead;
+    const auto found = copies.find(node);
+    if (found != copies.end())
+        return found->second;
+
+    const Node *copy = target.join(copyInto(target, node->nw, copies), copyInto(target, node->ne, copies),
+                                   copyInto(target, node->sw, copies), copyInto(target, node->se, copies));
+    copies.emplace(node, copy);
+    return copy;
+}
+
+void HashLife::collectGarbage()
+{
+    HashLife fresh;
+    std::unordered_map<const Node *, const Node *> copies;
+    fresh.m_root = copyInto(fresh, m_root, copies);
+    fresh.m_originX = m_originX;
+    fresh.m_originY = m_originY;
+    fresh.m_generation = m_generation;
+    *this = std::move(fresh);
+}
+
+void HashLife::rasterise(LifeBoard &board, const Node *node, int64_t x, int64_t y) const
+{
+    const int64_t size = int64_t(1) << node->level;
+    if (node->population == 0 || x >= board.width() || y >= board.height()
+        || x + size <= 0 || y + size <= 0)
+        return;
+    if (node->level == 0) {
+        board.setCell(int(x), int(y), true);
+        return;
+    }
+    const int64_t half = size / 2;
+    rasterise(board, node->nw, x, y);
+    rasterise(board, node->ne, x + half, y);
+    rasterise(board, node->sw, x, y + half);
+    rasterise(board, node->se, x + half, y + half);
+}
+
+void HashLife::render(LifeBoard &board) const
+{
+    for (int y = 0; y < board.height(); ++y)
+        std::fill(board.row(y), board.row(y) + board.wordsPerRow(), 0);
+    rasterise(board, m_root, m_originX, m_originY);
+    board.setGeneration(m_generation);
+}
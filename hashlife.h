@@ -0,0 +1,88 @@
+#ifndef HASHLIFE_H
+#define HASHLIFE_H
+
+#include <cstddef>
+#include <cstdint>
+#include <deque>
+#include <unordered_map>
+#include <vector>
+
+class LifeBoard;
+
+// Gosper's HashLife on an unbounded plane: hash-consed quadtree nodes with
+// memoised successors, so periodic or sparse patterns can be advanced by
+// huge power-of-two steps. Loaded boards lose their toroidal wrap.
+class HashLife
+{
+public:
+    HashLife();
+
+    // Places the board with its top-left cell at plane coordinate (0, 0).
+    void load(const LifeBoard &board);
+    void advance(uint64_t generations);
+    // Rasterises the plane window [0, width) x [0, height) into board.
+    void render(LifeBoard &board) const;
+
+    uint64_t generation() const { return m_generation; }
+    uint64_t population() const;
+    size_t nodeCount() const { return m_nodes.size(); }
+
+    // Nodes are only released by rebuilding the store from the live tree;
+    // advance() does that once the store grows past this many nodes.
+    static constexpr size_t NodeLimit = 4 << 20;
+
+private:
+    struct Node
+    {
+        const Node *nw;
+        const Node *ne;
+        const Node *sw;
+        const Node *se;
+        uint64_t population;
+        int level;
+        mutable const Node *next;
+    };
+
+    struct QuadKey
+    {
+        const Node *nw, *ne, *sw, *se;
+        bool operator==(const QuadKey &other) const
+        {
+            return nw == other.nw && ne == other.ne && sw == other.sw && se == other.se;
+        }
+    };
+    struct QuadHash
+    {
+        size_t operator()(const QuadKey &key) const;
+    };
+    struct StepHash
+    {
+        size_t operator()(const std::pair<const Node *, int> &key) const;
+    };
+
+    const Node *join(const Node *nw, const Node *ne, const Node *sw, const Node *se);
+    const Node *empty(int level);
+    const Node *expand(const Node *node);
+    const Node *centre(const Node *node);
+    const Node *lifeFourByFour(const Node *node);
+    const Node *successor(const Node *node, int j);
+    const Node *build(const LifeBoard &board, int x, int y, int level);
+    const Node *copyInto(HashLife &target, const Node *node,
+                         std::unordered_map<const Node *, const Node *> &copies) const;
+    void collectGarbage();
+    void rasterise(LifeBoard &board, const Node *node, int64_t x, int64_t y) const;
+
+    std::deque<Node> m_nodes;
+    std::unordered_map<QuadKey, const Node *, QuadHash> m_index;
+    std::unordered_map<std::pair<const Node *, int>, const Node *, StepHash> m_steps;
+    std::vector<const Node *> m_empty;
+    const Node *m_dead = nullptr;
+    const Node *m_alive = nullptr;
+
+    const Node *m_root = nullptr;
+    int64_t m_originX = 0;
+    int64_t m_originY = 0;
+    uint64_t m_generation = 0;
+};
+
+#endif // HASHLIFE_H
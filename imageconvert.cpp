@@ -0,0 +1,84 @@
+#include "imageconvert.h"
+
+#include "parallel.h"
+#include "tuning.h"
+
+#include <cstring>
+
+namespace ImageConvert {
+
+namespace {
+
+QRgb labelColour(uint32_t label)
+{
+    uint32_t h = label * 0x9e3779b1u;
+    h ^= h >> 15;
+    h *= 0x85ebca77u;
+    return qRgb(64 + int((h >> 0) & 0xbf), 64 + int((h >> 8) & 0xbf), 64 + int((h >> 16) & 0xbf));
+}
+
+} // namespace
+
+Mask toMask(const QImage &image, int threshold)
+{
+    const QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    Mask mask(gray.width(), gray.height());
+    Parallel::forRange(0, size_t(gray.height()), Tuning::current().rowGrain, [&](size_t first, size_t last) {
+        for (size_t y = first; y < last; ++y) {
+            const uchar *in = gray.constScanLine(int(y));
+            uint8_t *out = &mask.at(0, int(y));
+            for (int x = 0; x < mask.width; ++x)
+                out[x] = in[x] < threshold;
+        }
+    });
+    return mask;
+}
+
+Mask toGray(const QImage &image)
+{
+    const QImage gray = image.convertToFormat(QImage::Format_Grayscale8);
+    Mask plane(gray.width(), gray.height());
+    for (int y = 0; y < plane.height; ++y)
+        std::memcpy(&plane.at(0, y), gray.constScanLine(y), size_t(plane.width));
+    return plane;
+}
+
+QImage fromGray(const Mask &gray)
+{
+    QImage image(gray.width, gray.height, QImage::Format_Grayscale8);
+    for (int y = 0; y < gray.height; ++y)
+        std::memcpy(image.scanLine(y), &gray.at(0, y), size_t(gray.width));
+    return image;
+}
+
+QImage fromMask(const Mask &mask)
+{
+    QImage image(mask.width, mask.height, QImage::Format_Indexed8);
+    QVector<QRgb> colours(256);
+    colours[0] = qRgb(24, 24, 24);
+    colours[1] = qRgb(230, 230, 230);
+    for (int value = 2; value < 256; ++value)
+        colours[value] = labelColour(uint32_t(value));
+    image.setColorTable(colours);
+    for (int y = 0; y < mask.height; ++y)
+        std::memcpy(image.scanLine(y), &mask.at(0, y), size_t(mask.width));
+    return image;
+}
+
+QImage fromLabels(const std::vector<uint32_t> &labels, int width, int height)
+{
+    QImage image(width, height, QImage::Format_RGB32);
+    uchar *bits = image.bits();
+    const size_t bytesPerLine = size_t(image.bytesPerLine());
+    Parallel::forRange(0, size_t(height), Tuning::current().rowGrain, [&](size_t first, size_t last) {
+        for (size_t y = first; y < last; ++y) {
+            QRgb *out = reinterpret_cast<QRgb *>(bits + y * bytesPerLine);
+            const uint32_t *in = labels.data() + y * size_t(width);
+            for (int x = 0; x < width; ++x)
+                out[x] = in[x] ? labelColour(in[x]) : qRgb(0, 0, 0);
+        }
+    });
+    return image;
+}
+
+} // namespace ImageConvert
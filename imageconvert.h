@@ -0,0 +1,27 @@
+#ifndef IMAGECONVERT_H
+#define IMAGECONVERT_H
+
+#include "labeling.h"
+
+#include <QImage>
+
+// Conversions between QImage and the plain buffers the image engines use.
+namespace ImageConvert {
+
+// Pixels darker than threshold become foreground (1), the rest background.
+Mask toMask(const QImage &image, int threshold = 128);
+
+// Gray level of every pixel.
+Mask toGray(const QImage &image);
+QImage fromGray(const Mask &gray);
+
+// Indexed8 copy of a mask whose colour table gives each mask value its own
+// colour, so flood fill spans can be painted by writing the index bytes.
+QImage fromMask(const Mask &mask);
+
+// Colours every label with a hash of its value; 0 stays black.
+QImage fromLabels(const std::vector<uint32_t> &labels, int width, int height);
+
+} // namespace ImageConvert
+
+#endif // IMAGECONVERT_H
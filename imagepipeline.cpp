@@ -0,0 +1,820 @@
+#include "imagepipeline.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+#include <mutex>
+
+namespace ImagePipeline {
+
+namespace {
+
+constexpr int RowsPerTraceEntry = 8;
+
+#if defined(__GNUC__)
+#define PIPELINE_ALWAYS_INLINE inline __attribute__((always_inline))
+#define PIPELINE_VECTOR_KERNELS 1
+#else
+#define PIPELINE_ALWAYS_INLINE inline
+#endif
+
+// Integer weights summing to 256, so both passes stay exact: a row pass fits
+// in 16 bits and the 2D sum is the same whichever order it is taken in.
+struct BlurKernel
+{
+    int radius = 0;
+    uint16_t weights[2 * MaxBlurRadius + 1] = {};
+};
+
+BlurKernel makeBlurKernel(int radius)
+{
+    BlurKernel kernel;
+    kernel.radius = std::clamp(radius, 0, MaxBlurRadius);
+    const double sigma = std::max(0.5, kernel.radius / 2.0);
+    double weights[2 * MaxBlurRadius + 1];
+    double total = 0;
+    for (int i = -kernel.radius; i <= kernel.radius; ++i) {
+        weights[i + kernel.radius] = std::exp(-i * i / (2 * sigma * sigma));
+        total += weights[i + kernel.radius];
+    }
+    int sum = 0;
+    for (int i = 0; i <= 2 * kernel.radius; ++i) {
+        kernel.weights[i] = uint16_t(std::lround(weights[i] * 256 / total));
+        sum += kernel.weights[i];
+    }
+    kernel.weights[kernel.radius] = uint16_t(kernel.weights[kernel.radius] + 256 - sum);
+    return kernel;
+}
+
+int stageRadius(Stage stage, const BlurKernel &blur)
+{
+    return stage == Stage::Blur ? blur.radius : stage == Stage::Equalize ? 0 : 1;
+}
+
+// A rectangle of an image held in a buffer of its own; pixel() takes image
+// coordinates, which lets a tile's intermediates be addressed like the image.
+template <typename T>
+struct Window
+{
+    T *data;
+    size_t stride;
+    int x;
+    int y;
+    int width;
+    int height;
+
+    T *pixel(int imageX, int imageY) const
+    {
+        return data + size_t(imageY - y) * stride + size_t(imageX - x);
+    }
+};
+
+using ConstView = Window<const uint8_t>;
+using View = Window<uint8_t>;
+
+ConstView wholeView(const Mask &mask)
+{
+    return { mask.pixels.data(), size_t(mask.width), 0, 0, mask.width, mask.height };
+}
+
+ConstView constView(const View &view)
+{
+    return { view.data, view.stride, view.x, view.y, view.width, view.height };
+}
+
+// Row kernels. Lines are padded by the filter radius on both sides, so none
+// of them needs to know about borders.
+struct Kernels
+{
+    void (*blurRow)(const uint8_t *line, uint16_t *out, int width, const BlurKernel &kernel);
+    void (*blurColumn)(const uint16_t *const *rows, uint8_t *out, int width, const BlurKernel &kernel);
+    void (*sobelRow)(const uint8_t *line, int16_t *diff, int16_t *smooth, int width);
+    void (*sobelColumn)(const int16_t *diffAbove, const int16_t *diff, const int16_t *diffBelow,
+                        const int16_t *smoothAbove, const int16_t *smoothBelow, uint8_t *out, int width);
+    void (*medianRow)(const uint8_t *above, const uint8_t *line, const uint8_t *below,
+                      uint8_t *out, int width, uint8_t *columns);
+};
+
+void blurRowScalar(const uint8_t *line, uint16_t *out, int width, const BlurKernel &kernel)
+{
+    const int taps = 2 * kernel.radius + 1;
+    for (int x = 0; x < width; ++x) {
+        unsigned sum = 0;
+        for (int j = 0; j < taps; ++j)
+            sum += kernel.weights[j] * line[x + j];
+        out[x] = uint16_t(sum);
+    }
+}
+
+void blurColumnScalar(const uint16_t *const *rows, uint8_t *out, int width, const BlurKernel &kernel)
+{
+    const int taps = 2 * kernel.radius + 1;
+    for (int x = 0; x < width; ++x) {
+        uint32_t sum = 0;
+        for (int i = 0; i < taps; ++i)
+            sum += uint32_t(kernel.weights[i]) * rows[i][x];
+        out[x] = uint8_t((sum + 32768) >> 16);
+    }
+}
+
+// Sobel split into [-1 0 1] and [1 2 1] row passes; the column pass finishes
+// gx = [1 2 1]^T * diff and gy = [-1 0 1]^T * smooth, magnitude |gx| + |gy|.
+void sobelRowScalar(const uint8_t *line, int16_t *diff, int16_t *smooth, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        diff[x] = int16_t(line[x + 2] - line[x]);
+        smooth[x] = int16_t(line[x] + 2 * line[x + 1] + line[x + 2]);
+    }
+}
+
+void sobelColumnScalar(const int16_t *diffAbove, const int16_t *diff, const int16_t *diffBelow,
+                       const int16_t *smoothAbove, const int16_t *smoothBelow, uint8_t *out, int width)
+{
+    for (int x = 0; x < width; ++x) {
+        const int gx = diffAbove[x] + 2 * diff[x] + diffBelow[x];
+        const int gy = smoothBelow[x] - smoothAbove[x];
+        out[x] = uint8_t(std::min(255, std::abs(gx) + std::abs(gy)));
+    }
+}
+
+inline uint8_t median3(uint8_t a, uint8_t b, uint8_t c)
+{
+    return std::max(std::min(a, b), std::min(std::max(a, b), c));
+}
+
+// Sorts every column triple once, then takes the median of the largest
+// minimum, the median median and the smallest maximum of three neighbouring
+// columns, which is exactly the median of the 3x3 window. columns holds
+// 3 * (width + 2) bytes.
+void medianRowScalar(const uint8_t *above, const uint8_t *line, const uint8_t *below,
+                     uint8_t *out, int width, uint8_t *columns)
+{
+    uint8_t *lo = columns;
+    uint8_t *mid = lo + width + 2;
+    uint8_t *hi = mid + width + 2;
+    for (int x = 0; x < width + 2; ++x) {
+        lo[x] = std::min(std::min(above[x], line[x]), below[x]);
+        hi[x] = std::max(std::max(above[x], line[x]), below[x]);
+        mid[x] = median3(above[x], line[x], below[x]);
+    }
+    for (int x = 0; x < width; ++x) {
+        const uint8_t maxLo = std::max(std::max(lo[x], lo[x + 1]), lo[x + 2]);
+        const uint8_t minHi = std::min(std::min(hi[x], hi[x + 1]), hi[x + 2]);
+        out[x] = median3(maxLo, median3(mid[x], mid[x + 1], mid[x + 2]), minHi);
+    }
+}
+
+constexpr Kernels ScalarKernels = { blurRowScalar, blurColumnScalar, sobelRowScalar,
+                                    sobelColumnScalar, medianRowScalar };
+
+#ifdef PIPELINE_VECTOR_KERNELS
+typedef uint8_t U8x16 __attribute__((vector_size(16)));
+typedef uint8_t U8x32 __attribute__((vector_size(32)));
+typedef uint16_t U16x16 __attribute__((vector_size(32)));
+typedef int16_t I16x16 __attribute__((vector_size(32)));
+typedef uint32_t U32x16 __attribute__((vector_size(64)));
+
+// Vectors only ever live inside these always-inlined bodies, so each one is
+// compiled twice, once per target, without vector arguments crossing calls.
+template <typename V>
+PIPELINE_ALWAYS_INLINE void load(V &v, const void *p)
+{
+    std::memcpy(&v, p, sizeof v);
+}
+
+template <typename V>
+PIPELINE_ALWAYS_INLINE void sort2(V &a, V &b)
+{
+    const V less = V(a < b);
+    const V low = (a & less) | (b & ~less);
+    b = (b & less) | (a & ~less);
+    a = low;
+}
+
+PIPELINE_ALWAYS_INLINE void blurRowVector(const uint8_t *line, uint16_t *out, int width,
+                                          const BlurKernel &kernel)
+{
+    const int taps = 2 * kernel.radius + 1;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        U16x16 sum = {};
+        for (int j = 0; j < taps; ++j) {
+            U8x16 p;
+            load(p, line + x + j);
+            sum += __builtin_convertvector(p, U16x16) * kernel.weights[j];
+        }
+        std::memcpy(out + x, &sum, sizeof sum);
+    }
+    blurRowScalar(line + x, out + x, width - x, kernel);
+}
+
+PIPELINE_ALWAYS_INLINE void blurColumnVector(const uint16_t *const *rows, uint8_t *out, int width,
+                                             const BlurKernel &kernel)
+{
+    const int taps = 2 * kernel.radius + 1;
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        U32x16 sum = {};
+        for (int i = 0; i < taps; ++i) {
+            U16x16 h;
+            load(h, rows[i] + x);
+            sum += __builtin_convertvector(h, U32x16) * uint32_t(kernel.weights[i]);
+        }
+        const U8x16 result = __builtin_convertvector((sum + 32768) >> 16, U8x16);
+        std::memcpy(out + x, &result, sizeof result);
+    }
+    const uint16_t *tail[2 * MaxBlurRadius + 1];
+    for (int i = 0; i < taps; ++i)
+        tail[i] = rows[i] + x;
+    blurColumnScalar(tail, out + x, width - x, kernel);
+}
+
+PIPELINE_ALWAYS_INLINE void sobelRowVector(const uint8_t *line, int16_t *diff, int16_t *smooth, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        U8x16 a, b, c;
+        load(a, line + x);
+        load(b, line + x + 1);
+        load(c, line + x + 2);
+        const I16x16 left = __builtin_convertvector(a, I16x16);
+        const I16x16 centre = __builtin_convertvector(b, I16x16);
+        const I16x16 right = __builtin_convertvector(c, I16x16);
+        const I16x16 d = right - left;
+        const I16x16 s = left + centre + centre + right;
+        std::memcpy(diff + x, &d, sizeof d);
+        std::memcpy(smooth + x, &s, sizeof s);
+    }
+    sobelRowScalar(line + x, diff + x, smooth + x, width - x);
+}
+
+PIPELINE_ALWAYS_INLINE void sobelColumnVector(const int16_t *diffAbove, const int16_t *diff,
+                                              const int16_t *diffBelow, const int16_t *smoothAbove,
+                                              const int16_t *smoothBelow, uint8_t *out, int width)
+{
+    int x = 0;
+    for (; x + 16 <= width; x += 16) {
+        I16x16 d0, d1, d2, s0, s2;
+        load(d0, diffAbove + x);
+        load(d1, diff + x);
+        load(d2, diffBelow + x);
+        load(s0, smoothAbove + x);
+        load(s2, smoothBelow + x);
+        const I16x16 gx = d0 + d1 + d1 + d2;
+        const I16x16 gy = s2 - s0;
+        const I16x16 sx = gx >> 15;
+        const I16x16 sy = gy >> 15;
+        const I16x16 magnitude = ((gx ^ sx) - sx) + ((gy ^ sy) - sy);
+        const I16x16 over = I16x16(magnitude > 255);
+        const U8x16 result = __builtin_convertvector((magnitude & ~over) | (over & 255), U8x16);
+        std::memcpy(out + x, &result, sizeof result);
+    }
+    sobelColumnScalar(diffAbove + x, diff + x, diffBelow + x, smoothAbove + x, smoothBelow + x,
+                      out + x, width - x);
+}
+
+PIPELINE_ALWAYS_INLINE void medianRowVector(const uint8_t *above, const uint8_t *line, const uint8_t *below,
+                                            uint8_t *out, int width, uint8_t *columns)
+{
+    uint8_t *lo = columns;
+    uint8_t *mid = lo + width + 2;
+    uint8_t *hi = mid + width + 2;
+    int x = 0;
+    for (; x + 32 <= width + 2; x += 32) {
+        U8x32 a, b, c;
+        load(a, above + x);
+        load(b, line + x);
+        load(c, below + x);
+        sort2(a, b);
+        sort2(b, c);
+        sort2(a, b);
+        std::memcpy(lo + x, &a, sizeof a);
+        std::memcpy(mid + x, &b, sizeof b);
+        std::memcpy(hi + x, &c, sizeof c);
+    }
+    for (; x < width + 2; ++x) {
+        lo[x] = std::min(std::min(above[x], line[x]), below[x]);
+        hi[x] = std::max(std::max(above[x], line[x]), below[x]);
+        mid[x] = median3(above[x], line[x], below[x]);
+    }
+
+    for (x = 0; x + 32 <= width; x += 32) {
+        U8x32 l0, l1, l2, m0, m1, m2, h0, h1, h2;
+        load(l0, lo + x);
+        load(l1, lo + x + 1);
+        load(l2, lo + x + 2);
+        load(m0, mid + x);
+        load(m1, mid + x + 1);
+        load(m2, mid + x + 2);
+        load(h0, hi + x);
+        load(h1, hi + x + 1);
+        load(h2, hi + x + 2);
+        sort2(l0, l1);
+        sort2(l1, l2); // l2 = largest minimum
+        sort2(m0, m1);
+        sort2(m1, m2);
+        sort2(m0, m1); // m1 = median of medians
+        sort2(h0, h1);
+        sort2(h0, h2); // h0 = smallest maximum
+        sort2(l2, m1);
+        sort2(m1, h0);
+        sort2(l2, m1);
+        std::memcpy(out + x, &m1, sizeof m1);
+    }
+    for (; x < width; ++x) {
+        const uint8_t maxLo = std::max(std::max(lo[x], lo[x + 1]), lo[x + 2]);
+        const uint8_t minHi = std::min(std::min(hi[x], hi[x + 1]), hi[x + 2]);
+        out[x] = median3(maxLo, median3(mid[x], mid[x + 1], mid[x + 2]), minHi);
+    }
+}
+
+void blurRowDefault(const uint8_t *line, uint16_t *out, int width, const BlurKernel &kernel)
+{
+    blurRowVector(line, out, width, kernel);
+}
+
+void blurColumnDefault(const uint16_t *const *rows, uint8_t *out, int width, const BlurKernel &kernel)
+{
+    blurColumnVector(rows, out, width, kernel);
+}
+
+void sobelRowDefault(const uint8_t *line, int16_t *diff, int16_t *smooth, int width)
+{
+    sobelRowVector(line, diff, smooth, width);
+}
+
+void sobelColumnDefault(const int16_t *diffAbove, const int16_t *diff, const int16_t *diffBelow,
+                        const int16_t *smoothAbove, const int16_t *smoothBelow, uint8_t *out, int width)
+{
+    sobelColumnVector(diffAbove, diff, diffBelow, smoothAbove, smoothBelow, out, width);
+}
+
+void medianRowDefault(const uint8_t *above, const uint8_t *line, const uint8_t *below,
+                      uint8_t *out, int width, uint8_t *columns)
+{
+    medianRowVector(above, line, below, out, width, columns);
+}
+
+constexpr Kernels DefaultVectorKernels = { blurRowDefault, blurColumnDefault, sobelRowDefault,
+                                           sobelColumnDefault, medianRowDefault };
+
+#if defined(__x86_64__)
+#define PIPELINE_AVX2_KERNELS 1
+
+__attribute__((target("avx2")))
+void blurRowAvx2(const uint8_t *line, uint16_t *out, int width, const BlurKernel &kernel)
+{
+    blurRowVector(line, out, width, kernel);
+}
+
+__attribute__((target("avx2")))
+void blurColumnAvx2(const uint16_t *const *rows, uint8_t *out, int width, const BlurKernel &kernel)
+{
+    blurColumnVector(rows, out, width, kernel);
+}
+
+__attribute__((target("avx2")))
+void sobelRowAvx2(const uint8_t *line, int16_t *diff, int16_t *smooth, int width)
+{
+    sobelRowVector(line, diff, smooth, width);
+}
+
+__attribute__((target("avx2")))
+void sobelColumnAvx2(const int16_t *diffAbove, const int16_t *diff, const int16_t *diffBelow,
+                     const int16_t *smoothAbove, const int16_t *smoothBelow, uint8_t *out, int width)
+{
+    sobelColumnVector(diffAbove, diff, diffBelow, smoothAbove, smoothBelow, out, width);
+}
+
+__attribute__((target("avx2")))
+void medianRowAvx2(const uint8_t *above, const uint8_t *line, const uint8_t *below,
+                   uint8_t *out, int width, uint8_t *columns)
+{
+    medianRowVector(above, line, below, out, width, columns);
+}
+
+constexpr Kernels Avx2Kernels = { blurRowAvx2, blurColumnAvx2, sobelRowAvx2,
+                                  sobelColumnAvx2, medianRowAvx2 };
+#endif
+#endif
+
+bool detectAvx2()
+{
+#ifdef PIPELINE_AVX2_KERNELS
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+const Kernels &vectorKernels()
+{
+#ifdef PIPELINE_AVX2_KERNELS
+    if (hasVectorKernel())
+        return Avx2Kernels;
+#endif
+#ifdef PIPELINE_VECTOR_KERNELS
+    return DefaultVectorKernels;
+#else
+    return ScalarKernels;
+#endif
+}
+
+struct Scratch
+{
+    std::vector<uint8_t> lines;
+    std::vector<uint16_t> blurRows;
+    std::vector<int16_t> diff;
+    std::vector<int16_t> smooth;
+};
+
+// Copies columns [x0 - pad, x0 + width + pad) of an image row, repeating the
+// edge pixels where that range leaves the image.
+void loadPadded(const ConstView &in, int imageY, int x0, int width, int pad, int imageWidth, uint8_t *line)
+{
+    const int first = std::max(x0 - pad, 0);
+    const int last = std::min(x0 + width + pad, imageWidth);
+    for (int x = x0 - pad; x < first; ++x)
+        *line++ = *in.pixel(0, imageY);
+    std::memcpy(line, in.pixel(first, imageY), size_t(last - first));
+    line += last - first;
+    for (int x = last; x < x0 + width + pad; ++x)
+        *line++ = *in.pixel(imageWidth - 1, imageY);
+}
+
+// Each filter computes out's rectangle; in must cover every clamped pixel it
+// reads, i.e. out grown by the filter radius and clipped to the image.
+void blurView(const ConstView &in, const View &out, int imageWidth, int imageHeight,
+              const BlurKernel &kernel, const Kernels &kernels, Scratch &scratch)
+{
+    const int r = kernel.radius;
+    const int firstRow = std::max(out.y - r, 0);
+    const int lastRow = std::min(out.y + out.height + r, imageHeight);
+    const size_t width = size_t(out.width);
+    scratch.lines.resize(width + 2 * size_t(r));
+    scratch.blurRows.resize(size_t(lastRow - firstRow) * width);
+    for (int y = firstRow; y < lastRow; ++y) {
+        loadPadded(in, y, out.x, out.width, r, imageWidth, scratch.lines.data());
+        kernels.blurRow(scratch.lines.data(), scratch.blurRows.data() + size_t(y - firstRow) * width,
+                        out.width, kernel);
+    }
+
+    const uint16_t *rows[2 * MaxBlurRadius + 1];
+    for (int y = out.y; y < out.y + out.height; ++y) {
+        for (int i = -r; i <= r; ++i) {
+            const int source = std::clamp(y + i, 0, imageHeight - 1);
+            rows[i + r] = scratch.blurRows.data() + size_t(source - firstRow) * width;
+        }
+        kernels.blurColumn(rows, out.pixel(out.x, y), out.width, kernel);
+    }
+}
+
+void sobelView(const ConstView &in, const View &out, int imageWidth, int imageHeight,
+               const Kernels &kernels, Scratch &scratch)
+{
+    const int firstRow = std::max(out.y - 1, 0);
+    const int lastRow = std::min(out.y + out.height + 1, imageHeight);
+    const size_t width = size_t(out.width);
+    scratch.lines.resize(width + 2);
+    scratch.diff.resize(size_t(lastRow - firstRow) * width);
+    scratch.smooth.resize(scratch.diff.size());
+    for (int y = firstRow; y < lastRow; ++y) {
+        loadPadded(in, y, out.x, out.width, 1, imageWidth, scratch.lines.data());
+        const size_t offset = size_t(y - firstRow) * width;
+        kernels.sobelRow(scratch.lines.data(), scratch.diff.data() + offset,
+                         scratch.smooth.data() + offset, out.width);
+    }
+
+    for (int y = out.y; y < out.y + out.height; ++y) {
+        const size_t above = size_t(std::max(y - 1, 0) - firstRow) * width;
+        const size_t centre = size_t(y - firstRow) * width;
+        const size_t below = size_t(std::min(y + 1, imageHeight - 1) - firstRow) * width;
+        kernels.sobelColumn(scratch.diff.data() + above, scratch.diff.data() + centre,
+                            scratch.diff.data() + below, scratch.smooth.data() + above,
+                            scratch.smooth.data() + below, out.pixel(out.x, y), out.width);
+    }
+}
+
+void medianView(const ConstView &in, const View &out, int imageWidth, int imageHeight,
+                const Kernels &kernels, Scratch &scratch)
+{
+    const size_t padded = size_t(out.width) + 2;
+    scratch.lines.resize(6 * padded);
+    uint8_t *above = scratch.lines.data();
+    uint8_t *line = above + padded;
+    uint8_t *below = line + padded;
+    uint8_t *columns = below + padded;
+    for (int y = out.y; y < out.y + out.height; ++y) {
+        loadPadded(in, std::max(y - 1, 0), out.x, out.width, 1, imageWidth, above);
+        loadPadded(in, y, out.x, out.width, 1, imageWidth, line);
+        loadPadded(in, std::min(y + 1, imageHeight - 1), out.x, out.width, 1, imageWidth, below);
+        kernels.medianRow(above, line, below, out.pixel(out.x, y), out.width, columns);
+    }
+}
+
+void filterView(Stage stage, const ConstView &in, const View &out, int imageWidth, int imageHeight,
+                const BlurKernel &blur, const Kernels &kernels, Scratch &scratch)
+{
+    switch (stage) {
+    case Stage::Blur:
+        blurView(in, out, imageWidth, imageHeight, blur, kernels, scratch);
+        break;
+    case Stage::Sobel:
+        sobelView(in, out, imageWidth, imageHeight, kernels, scratch);
+        break;
+    case Stage::Median:
+        medianView(in, out, imageWidth, imageHeight, kernels, scratch);
+        break;
+    case Stage::Equalize:
+        break;
+    }
+}
+
+// The reference versions: every output pixel visits its whole window.
+void naiveFilter(Stage stage, const Mask &in, Mask &out, const BlurKernel &blur)
+{
+    const int w = in.width;
+    const int h = in.height;
+    auto at = [&](int x, int y) {
+        return in.at(std::clamp(x, 0, w - 1), std::clamp(y, 0, h - 1));
+    };
+    for (int y = 0; y < h; ++y) {
+        for (int x = 0; x < w; ++x) {
+            if (stage == Stage::Blur) {
+                const int r = blur.radius;
+                uint32_t sum = 0;
+                for (int dy = -r; dy <= r; ++dy) {
+                    for (int dx = -r; dx <= r; ++dx)
+                        sum += uint32_t(blur.weights[dy + r]) * blur.weights[dx + r] * at(x + dx, y + dy);
+                }
+                out.at(x, y) = uint8_t((sum + 32768) >> 16);
+            } else if (stage == Stage::Sobel) {
+                static const int kx[3][3] = { { -1, 0, 1 }, { -2, 0, 2 }, { -1, 0, 1 } };
+                static const int ky[3][3] = { { -1, -2, -1 }, { 0, 0, 0 }, { 1, 2, 1 } };
+                int gx = 0;
+                int gy = 0;
+                for (int dy = -1; dy <= 1; ++dy) {
+                    for (int dx = -1; dx <= 1; ++dx) {
+                        gx += kx[dy + 1][dx + 1] * at(x + dx, y + dy);
+                        gy += ky[dy + 1][dx + 1] * at(x + dx, y + dy);
+                    }
+                }
+                out.at(x, y) = uint8_t(std::min(255, std::abs(gx) + std::abs(gy)));
+            } else {
+                uint8_t window[9];
+                for (int i = 0; i < 9; ++i)
+                    window[i] = at(x + i % 3 - 1, y + i / 3 - 1);
+                std::nth_element(window, window + 4, window + 9);
+                out.at(x, y) = window[4];
+            }
+        }
+    }
+}
+
+// Equalization needs the histogram of the whole image before any pixel can
+// be written. The vector variant keeps four interleaved histograms so
+// repeated values do not serialise on one counter.
+void countPixels(const uint8_t *pixels, size_t count, uint64_t *histogram, bool interleaved)
+{
+    if (!interleaved) {
+        for (size_t i = 0; i < count; ++i)
+            ++histogram[pixels[i]];
+        return;
+    }
+    uint32_t partial[4][256] = {};
+    size_t i = 0;
+    for (; i + 4 <= count; i += 4) {
+        ++partial[0][pixels[i]];
+        ++partial[1][pixels[i + 1]];
+        ++partial[2][pixels[i + 2]];
+        ++partial[3][pixels[i + 3]];
+    }
+    for (; i < count; ++i)
+        ++partial[0][pixels[i]];
+    for (int v = 0; v < 256; ++v)
+        histogram[v] += uint64_t(partial[0][v]) + partial[1][v] + partial[2][v] + partial[3][v];
+}
+
+void equalizationTable(const uint64_t *histogram, uint64_t total, uint8_t *table)
+{
+    uint64_t cdf = 0;
+    uint64_t cdfMin = 0;
+    for (int v = 0; v < 256; ++v) {
+        cdf += histogram[v];
+        if (!cdfMin)
+            cdfMin = cdf;
+        table[v] = total == cdfMin ? uint8_t(v)
+                                   : uint8_t(((cdf - cdfMin) * 255 + (total - cdfMin) / 2) / (total - cdfMin));
+    }
+}
+
+class Recorder
+{
+public:
+    explicit Recorder(std::vector<TraceEntry> *trace) : m_trace(trace) {}
+
+    void add(int stage, int x, int y, int width, int height)
+    {
+        if (!m_trace)
+            return;
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_trace->push_back({ stage, x, y, width, height, Parallel::workerIndex() });
+    }
+
+    void addRows(int stage, int firstRow, int lastRow, int width)
+    {
+        for (int y = firstRow; y < lastRow; y += RowsPerTraceEntry)
+            add(stage, 0, y, width, std::min(RowsPerTraceEntry, lastRow - y));
+    }
+
+private:
+    std::vector<TraceEntry> *m_trace;
+    std::mutex m_mutex;
+};
+
+void equalize(const Mask &in, Mask &out, Variant variant, int index, Recorder &recorder)
+{
+    uint64_t histogram[256] = {};
+    uint8_t table[256];
+    const size_t stripPixels = size_t(in.width) * Tuning::current().rowGrain;
+    if (variant != Variant::Tiled) {
+        countPixels(in.pixels.data(), in.pixels.size(), histogram, variant == Variant::Vector);
+        equalizationTable(histogram, in.pixels.size(), table);
+        for (size_t i = 0; i < in.pixels.size(); ++i)
+            out.pixels[i] = table[in.pixels[i]];
+        recorder.addRows(index, 0, in.height, in.width);
+        return;
+    }
+
+    std::mutex merge;
+    Parallel::forRange(0, in.pixels.size(), stripPixels, [&](size_t first, size_t last) {
+        uint64_t local[256] = {};
+        countPixels(in.pixels.data() + first, last - first, local, true);
+        std::lock_guard<std::mutex> lock(merge);
+        for (int v = 0; v < 256; ++v)
+            histogram[v] += local[v];
+    });
+    equalizationTable(histogram, in.pixels.size(), table);
+    Parallel::forRange(0, in.pixels.size(), stripPixels, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            out.pixels[i] = table[in.pixels[i]];
+        const int firstRow = int(first / size_t(in.width));
+        recorder.add(index, 0, firstRow, in.width, int((last - first) / size_t(in.width)));
+    });
+}
+
+// Runs stages [first, first + count) tile by tile. Each stage's output is
+// grown by the radii of the stages after it, so the last one can be computed
+// without reading anything outside the tile's own intermediates.
+void runFused(const Mask &in, Mask &out, const std::vector<Stage> &stages, int first, int count,
+              const BlurKernel &blur, const Options &options, Recorder &recorder)
+{
+    const int width = in.width;
+    const int height = in.height;
+    const int tileWidth = std::max(16, options.tileWidth);
+    const int tileHeight = std::max(1, options.tileHeight);
+    const int columns = (width + tileWidth - 1) / tileWidth;
+    const int rows = (height + tileHeight - 1) / tileHeight;
+
+    std::vector<int> halo(size_t(count), 0);
+    for (int i = count - 2; i >= 0; --i)
+        halo[size_t(i)] = halo[size_t(i) + 1] + stageRadius(stages[size_t(first + i + 1)], blur);
+
+    const Kernels &kernels = vectorKernels();
+    Parallel::forRange(0, size_t(columns) * size_t(rows), 1, [&](size_t begin, size_t end) {
+        thread_local Scratch scratch;
+        thread_local std::vector<uint8_t> planes[2];
+        for (size_t t = begin; t < end; ++t) {
+            const int x = int(t % size_t(columns)) * tileWidth;
+            const int y = int(t / size_t(columns)) * tileHeight;
+            const int w = std::min(tileWidth, width - x);
+            const int h = std::min(tileHeight, height - y);
+
+            ConstView source = wholeView(in);
+            for (int i = 0; i < count; ++i) {
+                View target { out.pixels.data() + size_t(y) * size_t(width) + size_t(x), size_t(width), x, y, w, h };
+                if (i < count - 1) {
+                    const int grow = halo[size_t(i)];
+                    const int left = std::max(x - grow, 0);
+                    const int top = std::max(y - grow, 0);
+                    const int right = std::min(x + w + grow, width);
+                    const int bottom = std::min(y + h + grow, height);
+                    std::vector<uint8_t> &plane = planes[i & 1];
+                    plane.resize(size_t(right - left) * size_t(bottom - top));
+                    target = { plane.data(), size_t(right - left), left, top, right - left, bottom - top };
+                }
+                filterView(stages[size_t(first + i)], source, target, width, height, blur, kernels, scratch);
+                source = constView(target);
+            }
+            recorder.add(first + count - 1, x, y, w, h);
+        }
+    });
+}
+
+} // namespace
+
+Mask run(const Mask &input, const std::vector<Stage> &stages, Variant variant,
+         const Options &options, std::vector<TraceEntry> *trace)
+{
+    if (trace)
+        trace->clear();
+    if (input.pixels.empty() || stages.empty())
+        return input;
+
+    Recorder recorder(trace);
+    const BlurKernel blur = makeBlurKernel(options.blurRadius);
+    Mask buffers[2];
+    const Mask *source = &input;
+    int target = 0;
+    for (size_t i = 0; i < stages.size();) {
+        Mask &out = buffers[target];
+        if (out.pixels.empty())
+            out = Mask(input.width, input.height);
+
+        size_t end = i + 1;
+        if (stages[i] == Stage::Equalize) {
+            equalize(*source, out, variant, int(i), recorder);
+        } else if (variant == Variant::Tiled) {
+            while (end < stages.size() && stages[end] != Stage::Equalize)
+                ++end;
+            runFused(*source, out, stages, int(i), int(end - i), blur, options, recorder);
+        } else if (variant == Variant::Naive) {
+            naiveFilter(stages[i], *source, out, blur);
+            recorder.addRows(int(i), 0, input.height, input.width);
+        } else {
+            Scratch scratch;
+            View whole { out.pixels.data(), size_t(out.width), 0, 0, out.width, out.height };
+            filterView(stages[i], wholeView(*source), whole, input.width, input.height, blur,
+                       variant == Variant::Vector ? vectorKernels() : ScalarKernels, scratch);
+            recorder.addRows(int(i), 0, input.height, input.width);
+        }
+
+        source = &out;
+        target ^= 1;
+        i = end;
+    }
+    return std::move(buffers[target ^ 1]);
+}
+
+const char *stageName(Stage stage)
+{
+    switch (stage) {
+    case Stage::Blur:
+        return "blur";
+    case Stage::Sobel:
+        return "sobel";
+    case Stage::Median:
+        return "median";
+    case Stage::Equalize:
+        return "equalize";
+    }
+    return "";
+}
+
+const char *variantName(Variant variant)
+{
+    switch (variant) {
+    case Variant::Naive:
+        return "naive";
+    case Variant::Separable:
+        return "separable";
+    case Variant::Vector:
+        return "vector";
+    case Variant::Tiled:
+        return "tiled";
+    }
+    return "";
+}
+
+bool stageFromName(const std::string &name, Stage &stage)
+{
+    for (Stage candidate : { Stage::Blur, Stage::Sobel, Stage::Median, Stage::Equalize }) {
+        if (name == stageName(candidate)) {
+            stage = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool variantFromName(const std::string &name, Variant &variant)
+{
+    for (Variant candidate : { Variant::Naive, Variant::Separable, Variant::Vector, Variant::Tiled }) {
+        if (name == variantName(candidate)) {
+            variant = candidate;
+            return true;
+        }
+    }
+    return false;
+}
+
+bool hasVectorKernel()
+{
+    static const bool available = detectAvx2();
+    return available;
+}
+
+} // namespace ImagePipeline
@@ -0,0 +1,58 @@
+#ifndef IMAGEPIPELINE_H
+#define IMAGEPIPELINE_H
+
+#include "labeling.h"
+#include "tuning.h"
+
+#include <string>
+#include <vector>
+
+// Grayscale filters on 8-bit planes, each written four ways so the cost of
+// the same result can be compared:
+//  - Naive: a direct 2D loop per output pixel with clamped reads.
+//  - Separable: row and column passes through a full-size intermediate.
+//  - Vector: the same passes on 32-byte GCC vectors, AVX2 when available.
+//  - Tiled: the vector passes per tile on the Parallel pool, with runs of
+//    consecutive filters fused so their intermediates stay in the tile.
+// Every variant produces bit-identical output; borders repeat the edge pixel.
+namespace ImagePipeline {
+
+enum class Stage { Blur, Sobel, Median, Equalize };
+enum class Variant { Naive, Separable, Vector, Tiled };
+
+constexpr int MaxBlurRadius = 16;
+
+struct Options
+{
+    int blurRadius = 3; // Gaussian with sigma = radius / 2
+    int tileWidth = Tuning::current().tileWidth;
+    int tileHeight = Tuning::current().tileHeight;
+};
+
+// A block of output in the order it was written. Fused tiles report the last
+// stage of their run; worker is the Parallel::workerIndex() that wrote it.
+struct TraceEntry
+{
+    int stage;
+    int x;
+    int y;
+    int width;
+    int height;
+    int worker;
+};
+
+// Applies stages in order. Equalize needs the whole image's histogram
+// first, so it is never fused with its neighbours.
+Mask run(const Mask &input, const std::vector<Stage> &stages, Variant variant,
+         const Options &options = Options(), std::vector<TraceEntry> *trace = nullptr);
+
+const char *stageName(Stage stage);
+const char *variantName(Variant variant);
+// Inverse of the names above; false for unknown names.
+bool stageFromName(const std::string &name, Stage &stage);
+bool variantFromName(const std::string &name, Variant &variant);
+bool hasVectorKernel();
+
+} // namespace ImagePipeline
+
+#endif // IMAGEPIPELINE_H
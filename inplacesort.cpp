@@ -0,0 +1,487 @@
+#include "inplacesort.h"
+
+#include "sorts.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+
+namespace InPlaceSort {
+
+namespace {
+
+// Both sorts start by insertion sorting runs this long.
+constexpr size_t RunLength = 16;
+
+Stepper insertionSort(std::span<int32_t> v, size_t begin, size_t end)
+{
+    for (size_t i = begin + 1; i < end; ++i) {
+        for (size_t j = i; j > begin; --j) {
+            co_yield VisualEvent::compare(j - 1, j);
+            if (!(v[j] < v[j - 1]))
+                break;
+            co_yield VisualEvent::swap(v, j - 1, j);
+        }
+    }
+}
+
+Stepper reverse(std::span<int32_t> v, size_t begin, size_t end)
+{
+    while (begin + 1 < end)
+        co_yield VisualEvent::swap(v, begin++, --end);
+}
+
+// [begin, middle) and [middle, end) trade places, by three reversals.
+Stepper rotate(std::span<int32_t> v, size_t begin, size_t middle, size_t end)
+{
+    if (begin == middle || middle == end)
+        co_return;
+    co_yield VisualEvent::mark(begin, end);
+    co_await reverse(v, begin, middle);
+    co_await reverse(v, middle, end);
+    co_await reverse(v, begin, end);
+}
+
+// The first position in [begin, end) whose value is not less than v[key],
+// or with upper, greater than it.
+Stepper search(std::span<int32_t> v, size_t begin, size_t end, size_t key, bool upper, size_t &result)
+{
+    while (begin < end) {
+        const size_t probe = begin + (end - begin) / 2;
+        co_yield VisualEvent::compare(probe, key);
+        if (upper ? !(v[key] < v[probe]) : v[probe] < v[key])
+            begin = probe + 1;
+        else
+            end = probe;
+    }
+    result = begin;
+}
+
+// Splits the longer run in half, finds where its middle value falls in
+// the other, and rotates so that both halves can be merged separately.
+Stepper mergeByRotation(std::span<int32_t> v, size_t begin, size_t middle, size_t end)
+{
+    while (begin < middle && middle < end) {
+        co_yield VisualEvent::compare(middle - 1, middle);
+        if (!(v[middle] < v[middle - 1]))
+            co_return;
+        if (middle - begin == 1 && end - middle == 1) {
+            co_yield VisualEvent::swap(v, begin, middle);
+            co_return;
+        }
+        size_t cut1 = begin;
+        size_t cut2 = end;
+        if (middle - begin > end - middle) {
+            cut1 = begin + (middle - begin) / 2;
+            co_await search(v, middle, end, cut1, false, cut2);
+        } else {
+            cut2 = middle + (end - middle) / 2;
+            co_await search(v, begin, middle, cut2, true, cut1);
+        }
+        co_await rotate(v, cut1, middle, cut2);
+        const size_t split = cut1 + (cut2 - middle);
+        co_await mergeByRotation(v, begin, cut1, split);
+        begin = split;
+        middle = cut2;
+    }
+}
+
+// For a short run in front of a long one: the short run is rotated forward
+// as a block and drops its first value into place each time, so every
+// value of the long run moves only once.
+Stepper mergeShortFirst(std::span<int32_t> v, size_t begin, size_t middle, size_t end)
+{
+    while (begin < middle && middle < end) {
+        size_t at = middle;
+        co_await search(v, middle, end, begin, false, at);
+        co_await rotate(v, begin, middle, at);
+        begin += at - middle + 1;
+        middle = at;
+    }
+}
+
+Stepper sortByRotation(std::span<int32_t> v, size_t begin, size_t end)
+{
+    for (size_t run = begin; run < end; run += RunLength)
+        co_await insertionSort(v, run, std::min(run + RunLength, end));
+    for (size_t width = RunLength; width < end - begin; width *= 2) {
+        for (size_t first = begin; first + width < end; first += 2 * width) {
+            const size_t last = std::min(first + 2 * width, end);
+            co_yield VisualEvent::mark(first, last);
+            co_await mergeByRotation(v, first, first + width, last);
+        }
+    }
+}
+
+// Moves the first occurrence of up to wanted distinct values to the front,
+// sorted, and leaves the rest in their order behind them. The keys found
+// so far travel along the array as one block.
+Stepper extractKeys(std::span<int32_t> v, size_t wanted, size_t &found)
+{
+    size_t start = 0;
+    found = v.empty() ? 0 : 1;
+    for (size_t i = 1; i < v.size() && found < wanted; ++i) {
+        size_t at = start;
+        co_await search(v, start, start + found, i, false, at);
+        if (at < start + found) {
+            co_yield VisualEvent::compare(i, at);
+            if (!(v[i] < v[at]))
+                continue;
+        }
+        const size_t offset = at - start;
+        co_await rotate(v, start, start + found, i);
+        start = i - found;
+        co_await rotate(v, start + offset, i, i + 1);
+        ++found;
+    }
+    co_await rotate(v, 0, start, start + found);
+}
+
+// Merges [begin, middle) and [middle, end) through the buffer right before
+// them, which must be at least as long as the second run. Each output swaps
+// with a buffer value, so the merged run ends up one buffer length down and
+// the buffer, shuffled, behind it.
+Stepper bufferMerge(std::span<int32_t> v, size_t out, size_t begin, size_t middle, size_t end)
+{
+    size_t left = begin;
+    size_t right = middle;
+    while (left < middle && right < end) {
+        co_yield VisualEvent::compare(left, right);
+        const size_t from = v[right] < v[left] ? right++ : left++;
+        co_yield VisualEvent::swap(v, out++, from);
+    }
+    while (left < middle)
+        co_yield VisualEvent::swap(v, out++, left++);
+    while (right < end)
+        co_yield VisualEvent::swap(v, out++, right++);
+}
+
+// Both runs are whole blocks, with the buffer (one block long) right
+// before them and a key per block at the front of the array, in order.
+// Key i tags block i, so comparing keys tells which run a block came from
+// and, among equal first values, which block was first.
+//
+// The blocks are selection sorted by first value, then a single sweep
+// merges each fragment left over from the one run with the next block of
+// the other, through the buffer, until one of the two runs out. The keys
+// are sorted back afterwards.
+Stepper mergeBlocks(std::span<int32_t> v, size_t blockSize, size_t begin, size_t middle, size_t end)
+{
+    const size_t blocks = (end - begin) / blockSize;
+    const int32_t firstKeyB = v[(middle - begin) / blockSize];
+    for (size_t i = 0; i + 1 < blocks; ++i) {
+        size_t least = i;
+        for (size_t j = i + 1; j < blocks; ++j) {
+            const size_t candidate = begin + j * blockSize;
+            const size_t current = begin + least * blockSize;
+            co_yield VisualEvent::compare(candidate, current);
+            if (v[candidate] < v[current] || (!(v[current] < v[candidate]) && v[j] < v[least]))
+                least = j;
+        }
+        if (least == i)
+            continue;
+        co_yield VisualEvent::mark(begin + i * blockSize, begin + (least + 1) * blockSize);
+        for (size_t k = 0; k < blockSize; ++k)
+            co_yield VisualEvent::swap(v, begin + i * blockSize + k, begin + least * blockSize + k);
+        co_yield VisualEvent::swap(v, i, least);
+    }
+
+    // The buffer is [out, fragment) throughout, and the fragment runs up
+    // to the next block.
+    size_t out = begin - blockSize;
+    size_t fragment = begin;
+    bool fragmentA = v[0] < firstKeyB;
+    for (size_t i = 1; i < blocks; ++i) {
+        const size_t block = begin + i * blockSize;
+        const size_t blockEnd = block + blockSize;
+        const bool blockA = v[i] < firstKeyB;
+        if (blockA == fragmentA) {
+            while (fragment < block)
+                co_yield VisualEvent::swap(v, out++, fragment++);
+            continue;
+        }
+        size_t left = fragment;
+        size_t right = block;
+        while (left < block && right < blockEnd) {
+            co_yield VisualEvent::compare(left, right);
+            const bool takeRight = fragmentA ? v[right] < v[left] : !(v[left] < v[right]);
+            const size_t from = takeRight ? right++ : left++;
+            co_yield VisualEvent::swap(v, out++, from);
+        }
+        if (left == block) {
+            fragment = right;
+            fragmentA = blockA;
+        } else {
+            // The block is used up, so the whole buffer sits where it was;
+            // move the rest of the fragment over it to meet the next block.
+            for (size_t k = block; k-- > left;)
+                co_yield VisualEvent::swap(v, k, k + blockSize);
+            fragment = left + blockSize;
+        }
+    }
+    while (fragment < end)
+        co_yield VisualEvent::swap(v, out++, fragment++);
+    co_await insertionSort(v, 0, blocks);
+}
+
+// Blocks are about sqrt(n) and a power of two, so every merge width past
+// one block is a whole number of them.
+size_t blockSizeFor(size_t size)
+{
+    return std::bit_floor(size_t(std::sqrt(double(size))));
+}
+
+// Plain versions: the same moves as the steppers above, with a
+// Sorts::checkpoint() after every rotation and merge and each block merged.
+
+void insertionSortNative(std::span<int32_t> v, size_t begin, size_t end)
+{
+    for (size_t i = begin + 1; i < end; ++i) {
+        for (size_t j = i; j > begin && v[j] < v[j - 1]; --j)
+            std::swap(v[j - 1], v[j]);
+    }
+}
+
+void rotateNative(std::span<int32_t> v, size_t begin, size_t middle, size_t end)
+{
+    if (begin == middle || middle == end)
+        return;
+    std::reverse(v.begin() + begin, v.begin() + middle);
+    std::reverse(v.begin() + middle, v.begin() + end);
+    std::reverse(v.begin() + begin, v.begin() + end);
+}
+
+void mergeByRotationNative(std::span<int32_t> v, size_t begin, size_t middle, size_t end)
+{
+    while (begin < middle && middle < end) {
+        if (!(v[middle] < v[middle - 1]))
+            return;
+        if (middle - begin == 1 && end - middle == 1) {
+            std::swap(v[begin], v[middle]);
+            return;
+        }
+        size_t cut1 = begin;
+        size_t cut2 = end;
+        if (middle - begin > end - middle) {
+            cut1 = begin + (middle - begin) / 2;
+            cut2 = size_t(std::lower_bound(v.begin() + middle, v.begin() + end, v[cut1]) - v.begin());
+        } else {
+            cut2 = middle + (end - middle) / 2;
+            cut1 = size_t(std::upper_bound(v.begin() + begin, v.begin() + middle, v[cut2]) - v.begin());
+        }
+        rotateNative(v, cut1, middle, cut2);
+        Sorts::checkpoint(v);
+        const size_t split = cut1 + (cut2 - middle);
+        mergeByRotationNative(v, begin, cut1, split);
+        begin = split;
+        middle = cut2;
+    }
+}
+
+void mergeShortFirstNative(std::span<int32_t> v, size_t begin, size_t middle, size_t end)
+{
+    while (begin < middle && middle < end) {
+        const size_t at = size_t(std::lower_bound(v.begin() + middle, v.begin() + end, v[begin]) - v.begin());
+        rotateNative(v, begin, middle, at);
+        begin += at - middle + 1;
+        middle = at;
+    }
+}
+
+void sortByRotationNative(std::span<int32_t> v, size_t begin, size_t end)
+{
+    for (size_t run = begin; run < end; run += RunLength)
+        insertionSortNative(v, run, std::min(run + RunLength, end));
+    for (size_t width = RunLength; width < end - begin; width *= 2) {
+        for (size_t first = begin; first + width < end; first += 2 * width)
+            mergeByRotationNative(v, first, first + width, std::min(first + 2 * width, end));
+    }
+}
+
+size_t extractKeysNative(std::span<int32_t> v, size_t wanted)
+{
+    size_t start = 0;
+    size_t found = v.empty() ? 0 : 1;
+    for (size_t i = 1; i < v.size() && found < wanted; ++i) {
+        const auto keys = v.begin() + start;
+        const auto at = std::lower_bound(keys, keys + found, v[i]);
+        if (at != keys + found && !(v[i] < *at))
+            continue;
+        const size_t offset = size_t(at - keys);
+        rotateNative(v, start, start + found, i);
+        start = i - found;
+        rotateNative(v, start + offset, i, i + 1);
+        ++found;
+    }
+    rotateNative(v, 0, start, start + found);
+    return found;
+}
+
+void bufferMergeNative(std::span<int32_t> v, size_t out, size_t begin, size_t middle, size_t end)
+{
+    size_t left = begin;
+    size_t right = middle;
+    while (left < middle && right < end) {
+        const size_t from = v[right] < v[left] ? right++ : left++;
+        std::swap(v[out++], v[from]);
+    }
+    while (left < middle)
+        std::swap(v[out++], v[left++]);
+    while (right < end)
+        std::swap(v[out++], v[right++]);
+}
+
+void mergeBlocksNative(std::span<int32_t> v, size_t blockSize, size_t begin, size_t middle, size_t end)
+{
+    const size_t blocks = (end - begin) / blockSize;
+    const int32_t firstKeyB = v[(middle - begin) / blockSize];
+    for (size_t i = 0; i + 1 < blocks; ++i) {
+        size_t least = i;
+        for (size_t j = i + 1; j < blocks; ++j) {
+            const int32_t candidate = v[begin + j * blockSize];
+            const int32_t current = v[begin + least * blockSize];
+            if (candidate < current || (!(current < candidate) && v[j] < v[least]))
+                least = j;
+        }
+        if (least == i)
+            continue;
+        std::swap_ranges(v.begin() + begin + i * blockSize, v.begin() + begin + (i + 1) * blockSize,
+                         v.begin() + begin + least * blockSize);
+        std::swap(v[i], v[least]);
+    }
+
+    size_t out = begin - blockSize;
+    size_t fragment = begin;
+    bool fragmentA = v[0] < firstKeyB;
+    for (size_t i = 1; i < blocks; ++i) {
+        const size_t block = begin + i * blockSize;
+        const size_t blockEnd = block + blockSize;
+        const bool blockA = v[i] < firstKeyB;
+        if (blockA == fragmentA) {
+            while (fragment < block)
+                std::swap(v[out++], v[fragment++]);
+            continue;
+        }
+        size_t left = fragment;
+        size_t right = block;
+        while (left < block && right < blockEnd) {
+            const bool takeRight = fragmentA ? v[right] < v[left] : !(v[left] < v[right]);
+            std::swap(v[out++], v[takeRight ? right++ : left++]);
+        }
+        if (left == block) {
+            fragment = right;
+            fragmentA = blockA;
+        } else {
+            for (size_t k = block; k-- > left;)
+                std::swap(v[k], v[k + blockSize]);
+            fragment = left + blockSize;
+        }
+        Sorts::checkpoint(v);
+    }
+    while (fragment < end)
+        std::swap(v[out++], v[fragment++]);
+    insertionSortNative(v, 0, blocks);
+}
+
+} // namespace
+
+Stepper rotateMerge(std::span<int32_t> values)
+{
+    co_await sortByRotation(values, 0, values.size());
+}
+
+void rotateMergeNative(std::span<int32_t> values)
+{
+    sortByRotationNative(values, 0, values.size());
+}
+
+// The array is laid out as [keys][buffer][data] while the data is sorted by
+// bottom-up passes. Each pass carries the buffer from the front of the data
+// to its end, merging the runs it goes past, and then shifts the data back
+// over it. Runs that fit the buffer merge through it directly; longer pairs
+// go block by block, and a short last pair by rotations.
+Stepper blockMerge(std::span<int32_t> values)
+{
+    const size_t size = values.size();
+    if (size <= RunLength) {
+        co_await insertionSort(values, 0, size);
+        co_return;
+    }
+    const size_t blockSize = blockSizeFor(size);
+    const size_t wanted = size / blockSize + 1 + blockSize;
+    size_t found = 0;
+    co_await extractKeys(values, wanted, found);
+    if (found < wanted) {
+        co_await sortByRotation(values, found, size);
+    } else {
+        const size_t data = wanted;
+        for (size_t run = data; run < size; run += RunLength)
+            co_await insertionSort(values, run, std::min(run + RunLength, size));
+        for (size_t width = RunLength; width < size - data; width *= 2) {
+            for (size_t begin = data; begin < size; begin += 2 * width) {
+                const size_t middle = std::min(begin + width, size);
+                const size_t end = std::min(begin + 2 * width, size);
+                co_yield VisualEvent::mark(begin - blockSize, end);
+                if (middle == end || (width > blockSize && end - middle < width)) {
+                    for (size_t k = begin; k < end; ++k)
+                        co_yield VisualEvent::swap(values, k - blockSize, k);
+                    co_await mergeByRotation(values, begin - blockSize, middle - blockSize, end - blockSize);
+                } else if (width <= blockSize) {
+                    co_await bufferMerge(values, begin - blockSize, begin, middle, end);
+                } else {
+                    co_await mergeBlocks(values, blockSize, begin, middle, end);
+                }
+            }
+            for (size_t k = size - blockSize; k-- > data - blockSize;)
+                co_yield VisualEvent::swap(values, k, k + blockSize);
+        }
+    }
+    co_await insertionSort(values, 0, found);
+    co_await mergeShortFirst(values, 0, found, size);
+}
+
+void blockMergeNative(std::span<int32_t> values)
+{
+    const size_t size = values.size();
+    if (size <= RunLength) {
+        insertionSortNative(values, 0, size);
+        return;
+    }
+    const size_t blockSize = blockSizeFor(size);
+    const size_t wanted = size / blockSize + 1 + blockSize;
+    const size_t found = extractKeysNative(values, wanted);
+    if (found < wanted) {
+        sortByRotationNative(values, found, size);
+    } else {
+        const size_t data = wanted;
+        for (size_t run = data; run < size; run += RunLength)
+            insertionSortNative(values, run, std::min(run + RunLength, size));
+        for (size_t width = RunLength; width < size - data; width *= 2) {
+            for (size_t begin = data; begin < size; begin += 2 * width) {
+                const size_t middle = std::min(begin + width, size);
+                const size_t end = std::min(begin + 2 * width, size);
+                if (middle == end || (width > blockSize && end - middle < width)) {
+                    // The ranges overlap whenever the run is longer than a
+                    // block. Going forwards, each swap moves one value down
+                    // a block and pushes a buffer value ahead, so the run
+                    // ends up a block lower with the buffer after it, as in
+                    // the stepping version; swap_ranges promises no order.
+                    for (size_t k = begin; k < end; ++k)
+                        std::swap(values[k - blockSize], values[k]);
+                    mergeByRotationNative(values, begin - blockSize, middle - blockSize, end - blockSize);
+                } else if (width <= blockSize) {
+                    bufferMergeNative(values, begin - blockSize, begin, middle, end);
+                } else {
+                    mergeBlocksNative(values, blockSize, begin, middle, end);
+                }
+                Sorts::checkpoint(values);
+            }
+            for (size_t k = size - blockSize; k-- > data - blockSize;)
+                std::swap(values[k], values[k + blockSize]);
+        }
+    }
+    insertionSortNative(values, 0, found);
+    mergeShortFirstNative(values, 0, found, size);
+}
+
+} // namespace InPlaceSort
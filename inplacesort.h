@@ -0,0 +1,31 @@
+#ifndef INPLACESORT_H
+#define INPLACESORT_H
+
+#include "stepper.h"
+
+#include <cstdint>
+#include <span>
+
+// Stable sorts that use no memory beyond the array and a logarithmic
+// stack, for the catalog in sorts.cpp; each has a stepping and a plain
+// version like the others there.
+//
+//  - rotateMerge merges neighbouring runs by rotating blocks past each
+//    other: O(n log^2 n) moves, nothing else to it.
+//  - blockMerge is a GrailSort-style block merge sort. It first pulls the
+//    first occurrence of about 2 sqrt(n) distinct values to the front: half
+//    serve as a swap buffer to merge through, half as tags that keep equal
+//    blocks in order while whole blocks are selection-sorted. That brings
+//    the moves down to O(n log n). With too few distinct values it falls
+//    back to rotations.
+namespace InPlaceSort {
+
+Stepper rotateMerge(std::span<int32_t> values);
+void rotateMergeNative(std::span<int32_t> values);
+
+Stepper blockMerge(std::span<int32_t> values);
+void blockMergeNative(std::span<int32_t> values);
+
+} // namespace InPlaceSort
+
+#endif // INPLACESORT_H
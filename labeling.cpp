@@ -0,0 +1,188 @@
+#include "labeling.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <memory>
+
+namespace {
+
+// Equivalence table over provisional labels: every entry points to an equal
+// or smaller label, so a component's root is its first label in raster order.
+inline uint32_t findRoot(uint32_t *table, uint32_t label)
+{
+    while (table[label] != label) {
+        table[label] = table[table[label]];
+        label = table[label];
+    }
+    return label;
+}
+
+inline void unite(uint32_t *table, uint32_t a, uint32_t b)
+{
+    a = findRoot(table, a);
+    b = findRoot(table, b);
+    if (a < b)
+        table[b] = a;
+    else if (b < a)
+        table[a] = b;
+}
+
+// Provisional labels a strip can hand out: a checkerboard is the worst case.
+size_t labelCapacity(const Mask &mask, int rows)
+{
+    return size_t(rows) * ((size_t(mask.width) + 1) / 2);
+}
+
+// First pass over rows [firstRow, lastRow): assigns provisional labels from
+// firstLabel upwards and records equivalences between the left and upper
+// neighbours, never looking above firstRow. The union is skipped when the
+// upper-left pixel already joins the two neighbours. Returns the number of
+// labels used.
+uint32_t linkRows(const Mask &mask, uint32_t *labels, uint32_t *table,
+                  int firstRow, int lastRow, uint32_t firstLabel)
+{
+    const size_t width = size_t(mask.width);
+    uint32_t next = firstLabel;
+    for (int y = firstRow; y < lastRow; ++y) {
+        const size_t rowStart = size_t(y) * width;
+        const uint8_t *row = mask.pixels.data() + rowStart;
+        const uint8_t *above = y > firstRow ? row - width : nullptr;
+        uint32_t *out = labels + rowStart;
+        for (size_t x = 0; x < width; ++x) {
+            if (!row[x]) {
+                out[x] = 0;
+                continue;
+            }
+            const bool left = x > 0 && row[x - 1];
+            const bool up = above && above[x];
+            if (left) {
+                out[x] = out[x - 1];
+                if (up && !above[x - 1])
+                    unite(table, out[x - 1], out[x - width]);
+            } else if (up) {
+                out[x] = out[x - width];
+            } else {
+                table[next] = next;
+                out[x] = next++;
+            }
+        }
+    }
+    return next - firstLabel;
+}
+
+// Replaces every table entry in [first, first + count) by its final label.
+// Entries point backwards, so the parent of each one is already final.
+void numberLabels(uint32_t *table, uint32_t first, uint32_t count, uint32_t &components)
+{
+    for (uint32_t label = first; label < first + count; ++label)
+        table[label] = table[label] == label ? ++components : table[table[label]];
+}
+
+} // namespace
+
+ScanlineFill::ScanlineFill(Mask &mask, int x, int y, uint8_t fillValue)
+    : m_mask(mask)
+    , m_target(mask.at(x, y))
+    , m_fill(fillValue)
+{
+    if (m_target != m_fill)
+        m_seeds.emplace_back(x, y);
+}
+
+void ScanlineFill::pushRuns(int y, int left, int right)
+{
+    if (y < 0 || y >= m_mask.height)
+        return;
+    const uint8_t *row = &m_mask.at(0, y);
+    for (int x = left; x <= right; ++x) {
+        if (row[x] != m_target)
+            continue;
+        m_seeds.emplace_back(x, y);
+        while (x <= right && row[x] == m_target)
+            ++x;
+    }
+}
+
+bool ScanlineFill::step(size_t maxSpans, std::vector<Span> *filled)
+{
+    for (size_t spans = 0; spans < maxSpans && !m_seeds.empty();) {
+        const auto [x, y] = m_seeds.back();
+        m_seeds.pop_back();
+
+        uint8_t *row = &m_mask.at(0, y);
+        if (row[x] != m_target)
+            continue;
+
+        int left = x;
+        int right = x;
+        while (left > 0 && row[left - 1] == m_target)
+            --left;
+        while (right + 1 < m_mask.width && row[right + 1] == m_target)
+            ++right;
+        std::fill(row + left, row + right + 1, m_fill);
+        m_filledPixels += size_t(right - left + 1);
+        if (filled)
+            filled->push_back({ y, left, right });
+        ++spans;
+
+        pushRuns(y - 1, left, right);
+        pushRuns(y + 1, left, right);
+    }
+    return !m_seeds.empty();
+}
+
+uint32_t labelTwoPass(const Mask &mask, std::vector<uint32_t> &labels)
+{
+    labels.resize(mask.pixels.size());
+    std::unique_ptr<uint32_t[]> table(new uint32_t[labelCapacity(mask, mask.height) + 1]);
+    table[0] = 0;
+    const uint32_t used = linkRows(mask, labels.data(), table.get(), 0, mask.height, 1);
+
+    uint32_t components = 0;
+    numberLabels(table.get(), 1, used, components);
+    for (uint32_t &label : labels)
+        label = table[label];
+    return components;
+}
+
+uint32_t labelParallel(const Mask &mask, std::vector<uint32_t> &labels, int rowsPerStrip)
+{
+    if (rowsPerStrip <= 0)
+        rowsPerStrip = std::max(16, mask.height / (Parallel::threadCount() * 4));
+    const size_t strips = (size_t(mask.height) + size_t(rowsPerStrip) - 1) / size_t(rowsPerStrip);
+    const size_t capacity = labelCapacity(mask, rowsPerStrip);
+    const size_t width = size_t(mask.width);
+
+    // Each strip owns a disjoint label range; slot 0 stays the background.
+    labels.resize(mask.pixels.size());
+    std::unique_ptr<uint32_t[]> table(new uint32_t[strips * capacity + 1]);
+    table[0] = 0;
+    std::vector<uint32_t> used(strips);
+    Parallel::forRange(0, strips, 1, [&](size_t first, size_t last) {
+        for (size_t s = first; s < last; ++s) {
+            const int firstRow = int(s) * rowsPerStrip;
+            used[s] = linkRows(mask, labels.data(), table.get(), firstRow,
+                               std::min(mask.height, firstRow + rowsPerStrip),
+                               uint32_t(1 + s * capacity));
+        }
+    });
+
+    for (size_t s = 1; s < strips; ++s) {
+        const uint32_t *row = labels.data() + s * size_t(rowsPerStrip) * width;
+        for (size_t x = 0; x < width; ++x) {
+            if (row[x] && row[x - width])
+                unite(table.get(), row[x], row[x - width]);
+        }
+    }
+
+    uint32_t components = 0;
+    for (size_t s = 0; s < strips; ++s)
+        numberLabels(table.get(), uint32_t(1 + s * capacity), used[s], components);
+
+    Parallel::forRange(0, labels.size(), size_t(rowsPerStrip) * width, [&](size_t first, size_t last) {
+        for (size_t i = first; i < last; ++i)
+            labels[i] = table[labels[i]];
+    });
+    return components;
+}
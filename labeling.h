@@ -0,0 +1,64 @@
+#ifndef LABELING_H
+#define LABELING_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// One byte per pixel, row-major without padding. Non-zero is foreground for
+// labeling; flood fill treats every distinct value as its own region. The
+// image pipeline uses the same layout for gray levels.
+struct Mask
+{
+    int width = 0;
+    int height = 0;
+    std::vector<uint8_t> pixels;
+
+    Mask() = default;
+    Mask(int w, int h) : width(w), height(h), pixels(size_t(w) * size_t(h)) {}
+
+    uint8_t &at(int x, int y) { return pixels[size_t(y) * size_t(width) + size_t(x)]; }
+    const uint8_t &at(int x, int y) const { return pixels[size_t(y) * size_t(width) + size_t(x)]; }
+};
+
+// Stack-based scanline flood fill over 4-connected pixels of one value. It
+// runs incrementally so MainWindow can show the fill front advancing.
+class ScanlineFill
+{
+public:
+    struct Span
+    {
+        int y;
+        int left;
+        int right; // inclusive
+    };
+
+    ScanlineFill(Mask &mask, int x, int y, uint8_t fillValue);
+
+    // Fills up to maxSpans spans, appending them to filled when given.
+    // Returns false once the region is complete.
+    bool step(size_t maxSpans, std::vector<Span> *filled = nullptr);
+    bool isFinished() const { return m_seeds.empty(); }
+    size_t filledPixels() const { return m_filledPixels; }
+
+private:
+    void pushRuns(int y, int left, int right);
+
+    Mask &m_mask;
+    uint8_t m_target;
+    uint8_t m_fill;
+    std::vector<std::pair<int, int>> m_seeds;
+    size_t m_filledPixels = 0;
+};
+
+// Connected-component labeling of the 4-connected foreground. labels gets
+// one entry per pixel: 0 for background, 1..N for components in raster order
+// of their first pixel. Both return N.
+uint32_t labelTwoPass(const Mask &mask, std::vector<uint32_t> &labels);
+
+// Labels horizontal strips independently on the Parallel pool, merges the
+// equivalences across strip boundaries, then resolves final labels in
+// parallel. Produces exactly the same labels as labelTwoPass().
+uint32_t labelParallel(const Mask &mask, std::vector<uint32_t> &labels, int rowsPerStrip = 0);
+
+#endif // LABELING_H
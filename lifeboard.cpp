@@ -0,0 +1,260 @@
+#include "lifeboard.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace {
+
+constexpr int RowsPerBand = 64;
+
+#if defined(__GNUC__)
+#define LIFE_ALWAYS_INLINE inline __attribute__((always_inline))
+#else
+#define LIFE_ALWAYS_INLINE inline
+#endif
+
+// Sums the eight neighbour planes with bitwise full adders and applies B3/S23
+// to every lane at once. V is uint64_t or a GCC vector of uint64_t; the
+// function must inline into the AVX2 kernel, which is why it is forced.
+template <typename V>
+LIFE_ALWAYS_INLINE void nextState(const V &nw, const V &n, const V &ne, const V &w, const V &c,
+                                   const V &e, const V &sw, const V &s, const V &se, V &next)
+{
+    const V s1 = nw ^ n ^ ne;
+    const V c1 = (nw & n) | (ne & (nw ^ n));
+    const V s2 = w ^ e ^ sw;
+    const V c2 = (w & e) | (sw & (w ^ e));
+    const V s3 = s ^ se;
+    const V c3 = s & se;
+
+    const V ones = s1 ^ s2 ^ s3;
+    const V c4 = (s1 & s2) | (s3 & (s1 ^ s2));
+
+    const V t = c1 ^ c2 ^ c3;
+    const V fours = (c1 & c2) | (c3 & (c1 ^ c2));
+    const V twos = t ^ c4;
+    const V overflow = fours | (t & c4);
+    next = twos & ~overflow & (ones | c);
+}
+
+inline uint64_t stepWord(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                         int k, int words)
+{
+    const int left = k == 0 ? words - 1 : k - 1;
+    const int right = k == words - 1 ? 0 : k + 1;
+    auto west = [&](const uint64_t *r) { return (r[k] << 1) | (r[left] >> 63); };
+    auto east = [&](const uint64_t *r) { return (r[k] >> 1) | (r[right] << 63); };
+    uint64_t next;
+    nextState<uint64_t>(west(up), up[k], east(up),
+                        west(mid), mid[k], east(mid),
+                        west(down), down[k], east(down), next);
+    return next;
+}
+
+// Words [1, words - 1) never wrap, so they are processed with plain offset
+// loads. Returns the first word the scalar tail still has to handle.
+int stepInteriorScalar(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                       uint64_t *out, int words)
+{
+    for (int k = 1; k < words - 1; ++k) {
+        nextState<uint64_t>((up[k] << 1) | (up[k - 1] >> 63), up[k],
+                            (up[k] >> 1) | (up[k + 1] << 63),
+                            (mid[k] << 1) | (mid[k - 1] >> 63), mid[k],
+                            (mid[k] >> 1) | (mid[k + 1] << 63),
+                            (down[k] << 1) | (down[k - 1] >> 63), down[k],
+                            (down[k] >> 1) | (down[k + 1] << 63), out[k]);
+    }
+    return words - 1;
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define LIFE_VECTOR_KERNEL 1
+
+typedef uint64_t Vec4 __attribute__((vector_size(32)));
+typedef uint64_t UnalignedVec4 __attribute__((vector_size(32), aligned(8), may_alias));
+
+#define LIFE_LOAD4(p) (*reinterpret_cast<const UnalignedVec4 *>(p))
+
+// 256 cells per iteration. The neighbouring words needed for the west/east
+// carries are fetched with unaligned loads one word either side.
+__attribute__((target("avx2")))
+int stepInteriorAvx2(const uint64_t *up, const uint64_t *mid, const uint64_t *down,
+                     uint64_t *out, int words)
+{
+    int k = 1;
+    for (; k + 4 < words; k += 4) {
+        const Vec4 u = LIFE_LOAD4(up + k);
+        const Vec4 m = LIFE_LOAD4(mid + k);
+        const Vec4 d = LIFE_LOAD4(down + k);
+        Vec4 r;
+        nextState<Vec4>((u << 1) | (LIFE_LOAD4(up + k - 1) >> 63), u,
+                        (u >> 1) | (LIFE_LOAD4(up + k + 1) << 63),
+                        (m << 1) | (LIFE_LOAD4(mid + k - 1) >> 63), m,
+                        (m >> 1) | (LIFE_LOAD4(mid + k + 1) << 63),
+                        (d << 1) | (LIFE_LOAD4(down + k - 1) >> 63), d,
+                        (d >> 1) | (LIFE_LOAD4(down + k + 1) << 63), r);
+        std::memcpy(out + k, &r, sizeof r);
+    }
+    return k;
+}
+#endif
+
+bool detectVectorKernel()
+{
+#ifdef LIFE_VECTOR_KERNEL
+    __builtin_cpu_init();
+    return __builtin_cpu_supports("avx2");
+#else
+    return false;
+#endif
+}
+
+uint64_t splitmix64(uint64_t &state)
+{
+    uint64_t z = (state += 0x9e3779b97f4a7c15ULL);
+    z = (z ^ (z >> 30)) * 0xbf58476d1ce4e5b9ULL;
+    z = (z ^ (z >> 27)) * 0x94d049bb133111ebULL;
+    return z ^ (z >> 31);
+}
+
+} // namespace
+
+LifeBoard::LifeBoard(int width, int height)
+    : m_width((std::max(width, 64) + 63) & ~63)
+    , m_height(std::max(height, 1))
+    , m_wordsPerRow(m_width / 64)
+    , m_cells(size_t(m_wordsPerRow) * m_height)
+    , m_next(m_cells.size())
+{
+}
+
+bool LifeBoard::hasVectorKernel()
+{
+    static const bool available = detectVectorKernel();
+    return available;
+}
+
+void LifeBoard::setCell(int x, int y, bool alive)
+{
+    uint64_t &word = row(y)[x >> 6];
+    const uint64_t bit = uint64_t(1) << (x & 63);
+    word = alive ? word | bit : word & ~bit;
+}
+
+void LifeBoard::clear()
+{
+    std::fill(m_cells.begin(), m_cells.end(), 0);
+    m_generation = 0;
+}
+
+void LifeBoard::randomize(uint64_t seed, double density)
+{
+    const uint32_t threshold = uint32_t(std::clamp(density, 0.0, 1.0) * 65536.0);
+    Parallel::forRange(0, size_t(m_height), RowsPerBand, [&](size_t first, size_t last) {
+        for (size_t y = first; y < last; ++y) {
+            uint64_t state = seed ^ (y * 0xd1b54a32d192ed03ULL);
+            uint64_t *cells = row(int(y));
+            for (int k = 0; k < m_wordsPerRow; ++k) {
+                uint64_t word = 0;
+                for (int bit = 0; bit < 64; bit += 4) {
+                    const uint64_t r = splitmix64(state);
+                    for (int j = 0; j < 4; ++j) {
+                        if (((r >> (16 * j)) & 0xffff) < threshold)
+                            word |= uint64_t(1) << (bit + j);
+                    }
+                }
+                cells[k] = word;
+            }
+        }
+    });
+    m_generation = 0;
+}
+
+uint64_t LifeBoard::population() const
+{
+    uint64_t total = 0;
+    for (uint64_t word : m_cells)
+        total += uint64_t(__builtin_popcountll(word));
+    return total;
+}
+
+void LifeBoard::step()
+{
+    Parallel::forRange(0, size_t(m_height), RowsPerBand, [this](size_t first, size_t last) {
+        stepRows(int(first), int(last));
+    });
+    m_cells.swap(m_next);
+    ++m_generation;
+}
+
+void LifeBoard::stepRows(int firstRow, int lastRow)
+{
+    const int words = m_wordsPerRow;
+    const bool vector = hasVectorKernel();
+    for (int y = firstRow; y < lastRow; ++y) {
+        const uint64_t *up = row(y == 0 ? m_height - 1 : y - 1);
+        const uint64_t *mid = row(y);
+        const uint64_t *down = row(y == m_height - 1 ? 0 : y + 1);
+        uint64_t *out = m_next.data() + size_t(y) * words;
+
+        int tail = 1;
+#ifdef LIFE_VECTOR_KERNEL
+        if (vector)
+            tail = stepInteriorAvx2(up, mid, down, out, words);
+#else
+        (void)vector;
+#endif
+        if (tail == 1)
+            tail = stepInteriorScalar(up, mid, down, out, words);
+        for (int k = tail; k < words; ++k)
+            out[k] = stepWord(up, mid, down, k, words);
+        out[0] = stepWord(up, mid, down, 0, words);
+    }
+}
+
+void LifeBoard::renderDensity(int factor, uint8_t *pixels, int bytesPerLine) const
+{
+    int rounded = 1;
+    while (rounded < factor)
+        rounded <<= 1;
+    factor = rounded;
+    const int outWidth = (m_width + factor - 1) / factor;
+    const int outHeight = (m_height + factor - 1) / factor;
+    const uint32_t cellsPerPixel = uint32_t(factor) * uint32_t(factor);
+
+    Parallel::forRange(0, size_t(outHeight), 8, [&](size_t first, size_t last) {
+        std::vector<uint32_t> counts(outWidth);
+        for (size_t oy = first; oy < last; ++oy) {
+            std::fill(counts.begin(), counts.end(), 0);
+            const int yEnd = std::min(m_height, int(oy + 1) * factor);
+            for (int y = int(oy) * factor; y < yEnd; ++y) {
+                const uint64_t *cells = row(y);
+                for (int k = 0; k < m_wordsPerRow; ++k) {
+                    const uint64_t word = cells[k];
+                    if (!word)
+                        continue;
+                    if (factor >= 64) {
+                        counts[size_t(k) * 64 / factor] += uint32_t(__builtin_popcountll(word));
+                        continue;
+                    }
+                    for (int bit = 0; bit < 64; bit += factor) {
+                        const uint64_t group = (word >> bit) & ((uint64_t(1) << factor) - 1);
+                        counts[size_t(k * 64 + bit) / factor] += uint32_t(__builtin_popcountll(group));
+                    }
+                }
+            }
+
+            uint8_t *line = pixels + oy * size_t(bytesPerLine);
+            for (int x = 0; x < outWidth; ++x)
+                line[x] = counts[x] ? uint8_t(64 + 191 * counts[x] / cellsPerPixel) : 0;
+        }
+    });
+}
+
+void LifeBoard::renderBits(uint8_t *pixels, int bytesPerLine) const
+{
+    for (int y = 0; y < m_height; ++y)
+        std::memcpy(pixels + size_t(y) * bytesPerLine, row(y), size_t(m_wordsPerRow) * 8);
+}
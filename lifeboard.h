@@ -0,0 +1,60 @@
+#ifndef LIFEBOARD_H
+#define LIFEBOARD_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// Toroidal Game of Life board stored bit-sliced, 64 cells per word. Bit i of
+// word k in a row is cell x = 64 * k + i, which is also the pixel order of
+// QImage::Format_MonoLSB on little-endian machines, so rows can be copied
+// straight into an image.
+class LifeBoard
+{
+public:
+    LifeBoard() = default;
+    // The width is rounded up to a multiple of 64.
+    LifeBoard(int width, int height);
+
+    int width() const { return m_width; }
+    int height() const { return m_height; }
+    int wordsPerRow() const { return m_wordsPerRow; }
+    uint64_t generation() const { return m_generation; }
+    void setGeneration(uint64_t generation) { m_generation = generation; }
+
+    const uint64_t *row(int y) const { return m_cells.data() + size_t(y) * m_wordsPerRow; }
+    uint64_t *row(int y) { return m_cells.data() + size_t(y) * m_wordsPerRow; }
+
+    bool cell(int x, int y) const { return (row(y)[x >> 6] >> (x & 63)) & 1; }
+    void setCell(int x, int y, bool alive);
+
+    void clear();
+    void randomize(uint64_t seed, double density = 0.25);
+    uint64_t population() const;
+
+    // Advances one generation. Rows are split into bands that run on the
+    // Parallel pool; each band uses the widest vector kernel the CPU has.
+    void step();
+
+    // Writes the number of live cells in each factor x factor block, scaled
+    // to 0..255, into an 8-bit image of ceil(width / factor) columns. The
+    // factor is rounded up to a power of two.
+    void renderDensity(int factor, uint8_t *pixels, int bytesPerLine) const;
+
+    // Copies the board as 1-bit rows, LSB first, for Format_MonoLSB.
+    void renderBits(uint8_t *pixels, int bytesPerLine) const;
+
+    static bool hasVectorKernel();
+
+private:
+    void stepRows(int firstRow, int lastRow);
+
+    int m_width = 0;
+    int m_height = 0;
+    int m_wordsPerRow = 0;
+    uint64_t m_generation = 0;
+    std::vector<uint64_t> m_cells;
+    std::vector<uint64_t> m_next;
+};
+
+#endif // LIFEBOARD_H
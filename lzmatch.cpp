@@ -0,0 +1,172 @@
+#include "lzmatch.h"
+
+#include <algorithm>
+#include <cstring>
+
+namespace LzMatch {
+
+namespace {
+
+constexpr uint32_t None = UINT32_MAX;
+
+inline uint32_t hashAt(const uint8_t *p, int shift)
+{
+    uint32_t v;
+    std::memcpy(&v, p, sizeof v);
+    return (v * 2654435761u) >> shift;
+}
+
+// About one bucket per position: with fewer, chains on incompressible data
+// fill up with collisions and every search walks the full depth through
+// cache misses.
+int hashBitsFor(size_t size)
+{
+    int bits = MinHashBits;
+    while (bits < MaxHashBits && (size_t(1) << bits) < size)
+        ++bits;
+    return bits;
+}
+
+inline uint32_t extend(const uint8_t *a, const uint8_t *b, uint32_t length, uint32_t limit)
+{
+    while (length + 8 <= limit) {
+        uint64_t x;
+        uint64_t y;
+        std::memcpy(&x, a + length, 8);
+        std::memcpy(&y, b + length, 8);
+        if (x != y)
+            return length + uint32_t(__builtin_ctzll(x ^ y) >> 3);
+        length += 8;
+    }
+    while (length < limit && a[length] == b[length])
+        ++length;
+    return length;
+}
+
+} // namespace
+
+HashChain::HashChain(const uint8_t *data, size_t size, int depth)
+    : m_data(data)
+    , m_size(size)
+    , m_depth(std::max(depth, 1))
+    , m_shift(32 - hashBitsFor(size))
+    , m_head(size_t(1) << (32 - m_shift), None)
+    , m_previous(size)
+{
+}
+
+Match HashChain::find(size_t pos, std::vector<Probe> *probes)
+{
+    const uint32_t limit = uint32_t(std::min<size_t>(MaxMatch, m_size - pos));
+    if (limit < MinMatch)
+        return {};
+
+    const uint32_t h = hashAt(m_data + pos, m_shift);
+    uint32_t candidate = m_head[h];
+    m_previous[pos] = candidate;
+    m_head[h] = uint32_t(pos);
+
+    Match best;
+    const uint8_t *current = m_data + pos;
+    for (int depth = m_depth; candidate != None && depth > 0; --depth) {
+        const uint8_t *earlier = m_data + candidate;
+        // A candidate can only win if it also matches the byte that would
+        // make it longer than the best so far.
+        if (earlier[best.length] == current[best.length]) {
+            const uint32_t length = extend(earlier, current, 0, limit);
+            if (probes)
+                probes->push_back({ candidate, length });
+            if (length > best.length) {
+                best = { length, uint32_t(pos - candidate) };
+                if (length == limit)
+                    break;
+            }
+        } else if (probes) {
+            probes->push_back({ candidate, 0 });
+        }
+        candidate = m_previous[candidate];
+    }
+    return best.length >= MinMatch ? best : Match();
+}
+
+void HashChain::skip(size_t pos)
+{
+    if (m_size - pos < MinMatch)
+        return;
+    const uint32_t h = hashAt(m_data + pos, m_shift);
+    m_previous[pos] = m_head[h];
+    m_head[h] = uint32_t(pos);
+}
+
+BinaryTree::BinaryTree(const uint8_t *data, size_t size, int depth)
+    : m_data(data)
+    , m_size(size)
+    , m_depth(std::max(depth, 1))
+    , m_shift(32 - hashBitsFor(size))
+    , m_head(size_t(1) << (32 - m_shift), None)
+    , m_children(size * 2)
+{
+}
+
+Match BinaryTree::find(size_t pos, std::vector<Probe> *probes)
+{
+    const Match best = insert(pos, probes);
+    return best.length >= MinMatch ? best : Match();
+}
+
+// Walks down from the bucket's newest position. Candidates whose suffix
+// sorts below pos's are hung off the "smaller" side of the new node and the
+// rest off the "larger" side, so the new position becomes the root. The
+// shorter of the two bounding prefixes is already known to match, which is
+// where each comparison starts.
+Match BinaryTree::insert(size_t pos, std::vector<Probe> *probes)
+{
+    const uint32_t limit = uint32_t(std::min<size_t>(MaxMatch, m_size - pos));
+    if (limit < MinMatch)
+        return {};
+
+    const uint32_t h = hashAt(m_data + pos, m_shift);
+    uint32_t candidate = m_head[h];
+    m_head[h] = uint32_t(pos);
+
+    uint32_t *smaller = &m_children[pos * 2];
+    uint32_t *larger = &m_children[pos * 2 + 1];
+    uint32_t smallerLength = 0;
+    uint32_t largerLength = 0;
+    const uint8_t *current = m_data + pos;
+    Match best;
+    for (int depth = m_depth;; --depth) {
+        if (candidate == None || depth == 0) {
+            *smaller = None;
+            *larger = None;
+            break;
+        }
+        uint32_t *pair = &m_children[size_t(candidate) * 2];
+        const uint8_t *earlier = m_data + candidate;
+        const uint32_t length = extend(earlier, current, std::min(smallerLength, largerLength), limit);
+        if (probes)
+            probes->push_back({ candidate, length });
+        if (length > best.length)
+            best = { length, uint32_t(pos - candidate) };
+        if (length == limit) {
+            // Identical as far as we can see: pos replaces the candidate.
+            *smaller = pair[0];
+            *larger = pair[1];
+            break;
+        }
+        if (earlier[length] < current[length]) {
+            *smaller = candidate;
+            smaller = &pair[1];
+            candidate = pair[1];
+            smallerLength = length;
+        } else {
+            *larger = candidate;
+            larger = &pair[0];
+            candidate = pair[0];
+            largerLength = length;
+        }
+    }
+    return best;
+}
+
+} // namespace LzMatch
@@ -0,0 +1,76 @@
+#ifndef LZMATCH_H
+#define LZMATCH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <vector>
+
+// LZ77 match finders over one buffer; the window is the whole buffer, so
+// callers keep buffers to a block. Both index positions by a hash of their
+// first MinMatch bytes and must see every position in order, through
+// find() or skip().
+namespace LzMatch {
+
+constexpr int MinMatch = 4;
+constexpr int MaxMatch = 273;
+constexpr int MinHashBits = 10;
+constexpr int MaxHashBits = 20;
+
+struct Match
+{
+    uint32_t length = 0;
+    uint32_t distance = 0;
+};
+
+// A candidate compared during a search and how many bytes it matched.
+struct Probe
+{
+    uint32_t position;
+    uint32_t length;
+};
+
+// zlib-style chains: each position links to the previous one with the same
+// hash, and a search walks the chain newest first, up to depth candidates.
+class HashChain
+{
+public:
+    HashChain(const uint8_t *data, size_t size, int depth = 32);
+
+    Match find(size_t pos, std::vector<Probe> *probes = nullptr);
+    void skip(size_t pos);
+
+private:
+    const uint8_t *m_data;
+    size_t m_size;
+    int m_depth;
+    int m_shift;
+    std::vector<uint32_t> m_head;
+    std::vector<uint32_t> m_previous;
+};
+
+// LZMA-style binary trees: each hash bucket keeps earlier positions in a
+// binary search tree ordered by their suffixes, rebuilt around every new
+// position as it is inserted. A search only visits candidates that share
+// an ever longer prefix, so deep searches stay cheap on repetitive data.
+class BinaryTree
+{
+public:
+    BinaryTree(const uint8_t *data, size_t size, int depth = 32);
+
+    Match find(size_t pos, std::vector<Probe> *probes = nullptr);
+    void skip(size_t pos) { insert(pos, nullptr); }
+
+private:
+    Match insert(size_t pos, std::vector<Probe> *probes);
+
+    const uint8_t *m_data;
+    size_t m_size;
+    int m_depth;
+    int m_shift;
+    std::vector<uint32_t> m_head;
+    std::vector<uint32_t> m_children; // smaller, larger per position
+};
+
+} // namespace LzMatch
+
+#endif // LZMATCH_H
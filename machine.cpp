@@ -0,0 +1,201 @@
+#include "machine.h"
+
+#include <QFile>
+#include <QJsonArray>
+#include <QMap>
+#include <QSysInfo>
+#include <QtGlobal>
+
+#include <algorithm>
+
+#ifdef Q_OS_LINUX
+#include <sched.h>
+#endif
+
+namespace Machine {
+
+namespace {
+
+const QString CpuRoot = QStringLiteral("/sys/devices/system/cpu");
+
+// First line of a small sysfs or procfs file, or an empty string.
+QString readLine(const QString &path)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly))
+        return QString();
+    return QString::fromUtf8(file.readLine()).trimmed();
+}
+
+QString cpuModel()
+{
+    QFile file(QStringLiteral("/proc/cpuinfo"));
+    if (file.open(QIODevice::ReadOnly)) {
+        // x86 says "model name"; some ARM kernels only have "Hardware".
+        QString hardware;
+        while (!file.atEnd()) {
+            const QString line = QString::fromUtf8(file.readLine());
+            const QString key = line.section(QLatin1Char(':'), 0, 0).trimmed();
+            const QString value = line.section(QLatin1Char(':'), 1).trimmed();
+            if (key == QLatin1String("model name") && !value.isEmpty())
+                return value;
+            if (key == QLatin1String("Hardware"))
+                hardware = value;
+        }
+        if (!hardware.isEmpty())
+            return hardware;
+    }
+    return QSysInfo::currentCpuArchitecture();
+}
+
+// "32K", "1024K", "8M" as in the cache size files.
+size_t parseBytes(const QString &text)
+{
+    QString digits = text;
+    size_t scale = 1;
+    if (digits.endsWith(QLatin1Char('K')))
+        scale = 1024;
+    else if (digits.endsWith(QLatin1Char('M')))
+        scale = 1024 * 1024;
+    if (scale > 1)
+        digits.chop(1);
+    return digits.toULongLong() * scale;
+}
+
+std::vector<Cache> caches()
+{
+    std::vector<Cache> caches;
+    for (int index = 0;; ++index) {
+        const QString dir = CpuRoot + QStringLiteral("/cpu0/cache/index%1/").arg(index);
+        const QString level = readLine(dir + QLatin1String("level"));
+        if (level.isEmpty())
+            break;
+        caches.push_back({ level.toInt(), readLine(dir + QLatin1String("type")),
+                           parseBytes(readLine(dir + QLatin1String("size"))) });
+    }
+    return caches;
+}
+
+int boost()
+{
+    const QString boost = readLine(CpuRoot + QLatin1String("/cpufreq/boost"));
+    if (!boost.isEmpty())
+        return boost.toInt() != 0;
+    const QString noTurbo = readLine(CpuRoot + QLatin1String("/intel_pstate/no_turbo"));
+    if (!noTurbo.isEmpty())
+        return noTurbo.toInt() == 0;
+    return -1;
+}
+
+QString cpuList(const std::vector<int> &cpus)
+{
+    QStringList list;
+    for (int cpu : cpus)
+        list << QString::number(cpu);
+    return list.join(QLatin1Char(','));
+}
+
+} // namespace
+
+Info describe(const std::vector<int> &cpus)
+{
+    Info info;
+    info.cpuModel = cpuModel();
+    info.kernel = QSysInfo::kernelType() + QLatin1Char(' ') + QSysInfo::kernelVersion();
+    info.onlineCpus = int(parseCpuList(readLine(CpuRoot + QLatin1String("/online"))).size());
+    info.caches = caches();
+    info.isolated = parseCpuList(readLine(CpuRoot + QLatin1String("/isolated")));
+    for (int cpu : cpus)
+        info.governors << readLine(CpuRoot + QStringLiteral("/cpu%1/cpufreq/scaling_governor").arg(cpu));
+    info.boost = boost();
+    return info;
+}
+
+QJsonObject toJson(const Info &info)
+{
+    QJsonArray caches;
+    for (const Cache &cache : info.caches) {
+        caches.append(QJsonObject {
+            { QStringLiteral("level"), cache.level },
+            { QStringLiteral("type"), cache.type },
+            { QStringLiteral("bytes"), double(cache.bytes) },
+        });
+    }
+    QJsonArray isolated;
+    for (int cpu : info.isolated)
+        isolated.append(cpu);
+    QJsonArray governors;
+    for (const QString &governor : info.governors)
+        governors.append(governor);
+    return QJsonObject {
+        { QStringLiteral("cpuModel"), info.cpuModel },
+        { QStringLiteral("kernel"), info.kernel },
+        { QStringLiteral("onlineCpus"), info.onlineCpus },
+        { QStringLiteral("caches"), caches },
+        { QStringLiteral("isolated"), isolated },
+        { QStringLiteral("governors"), governors },
+        { QStringLiteral("boost"), info.boost },
+    };
+}
+
+QStringList warnings(const Info &info, const std::vector<int> &cpus)
+{
+    QStringList warnings;
+    QMap<QString, std::vector<int>> byGovernor;
+    for (size_t i = 0; i < cpus.size() && i < size_t(info.governors.size()); ++i) {
+        if (!info.governors[int(i)].isEmpty() && info.governors[int(i)] != QLatin1String("performance"))
+            byGovernor[info.governors[int(i)]].push_back(cpus[i]);
+    }
+    for (auto it = byGovernor.constBegin(); it != byGovernor.constEnd(); ++it) {
+        warnings << QStringLiteral("CPU %1 scaled by the %2 governor; the clock will move under load")
+                            .arg(cpuList(it.value()), it.key());
+    }
+    if (info.boost == 1)
+        warnings << QStringLiteral("turbo boost is on; clocks depend on temperature and on what else runs");
+
+    std::vector<int> shared;
+    for (int cpu : cpus) {
+        if (std::find(info.isolated.begin(), info.isolated.end(), cpu) == info.isolated.end())
+            shared.push_back(cpu);
+    }
+    if (!info.isolated.empty() && !shared.empty())
+        warnings << QStringLiteral("CPU %1 not isolated, but %2 are").arg(cpuList(shared), cpuList(info.isolated));
+    return warnings;
+}
+
+std::vector<int> parseCpuList(const QString &list)
+{
+    std::vector<int> cpus;
+    if (list.trimmed().isEmpty())
+        return cpus;
+    for (const QString &range : list.split(QLatin1Char(','))) {
+        const QStringList ends = range.split(QLatin1Char('-'));
+        bool firstOk = false;
+        bool lastOk = false;
+        const int first = ends.first().trimmed().toInt(&firstOk);
+        const int last = ends.last().trimmed().toInt(&lastOk);
+        if (ends.size() > 2 || !firstOk || !lastOk || first < 0 || last < first)
+            return {};
+        for (int cpu = first; cpu <= last; ++cpu)
+            cpus.push_back(cpu);
+    }
+    return cpus;
+}
+
+std::vector<int> allowedCpus()
+{
+    std::vector<int> cpus;
+#ifdef Q_OS_LINUX
+    cpu_set_t set;
+    CPU_ZERO(&set);
+    if (sched_getaffinity(0, sizeof(set), &set) == 0) {
+        for (int cpu = 0; cpu < CPU_SETSIZE; ++cpu) {
+            if (CPU_ISSET(cpu, &set))
+                cpus.push_back(cpu);
+        }
+    }
+#endif
+    return cpus;
+}
+
+} // namespace Machine
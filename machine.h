@@ -0,0 +1,49 @@
+#ifndef MACHINE_H
+#define MACHINE_H
+
+#include <QJsonObject>
+#include <QString>
+#include <QStringList>
+
+#include <cstddef>
+#include <vector>
+
+// What the bench records about the machine it ran on, so that two result
+// files can be told apart by hardware rather than guessed at, and the
+// settings that make timings noisy can be pointed out before they do.
+// Everything comes from /proc and /sys; elsewhere most fields stay empty.
+namespace Machine {
+
+struct Cache
+{
+    int level = 0;
+    QString type; // Data, Instruction or Unified
+    size_t bytes = 0;
+};
+
+struct Info
+{
+    QString cpuModel;
+    QString kernel;
+    int onlineCpus = 0;
+    std::vector<Cache> caches; // as CPU 0 sees them
+    std::vector<int> isolated; // isolcpus= on the kernel command line
+    // Scaling governor of each CPU in the order describe() was given them;
+    // empty where cpufreq is absent.
+    QStringList governors;
+    int boost = -1; // turbo or boost: 1 on, 0 off, -1 unknown
+};
+
+Info describe(const std::vector<int> &cpus);
+QJsonObject toJson(const Info &info);
+// Settings that make timings on cpus vary from run to run.
+QStringList warnings(const Info &info, const std::vector<int> &cpus);
+
+// "0-3,8,10-11" as in sysfs and taskset; empty on a malformed list.
+std::vector<int> parseCpuList(const QString &list);
+// CPUs this process may run on.
+std::vector<int> allowedCpus();
+
+} // namespace Machine
+
+#endif // MACHINE_H
@@ -1,10 +1,20 @@
+#include "distsort.h"
 #include "mainwindow.h"
+#include "sandbox.h"
+#include "tuning.h"
 
 #include <QApplication>
 
+#include <cstring>
+
 int main(int argc, char *argv[])
 {
+    if (argc > 1 && std::strcmp(argv[1], Sandbox::ChildFlag) == 0)
+        return Sandbox::runChild(argc, argv);
+    if (argc > 1 && std::strcmp(argv[1], DistributedSort::NodeFlag) == 0)
+        return DistributedSort::runNode(argc, argv);
     QApplication a(argc, argv);
+    Tuning::loadCurrent();
     MainWindow w;
     w.show();
     return a.exec();
@@ -1,11 +1,158 @@
 #include "mainwindow.h"
 #include "./ui_mainwindow.h"
 
+#include "codec.h"
+#include "distview.h"
+#include "imageconvert.h"
+#include "parallel.h"
+#include "raceview.h"
+
+#include <QCoreApplication>
+#include <QElapsedTimer>
+#include <QFile>
+#include <QFileDialog>
+#include <QFileInfo>
+#include <QImageReader>
+#include <QInputDialog>
+#include <QLineEdit>
+#include <QLocale>
+#include <QMessageBox>
+#include <QRandomGenerator>
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <cstring>
+#include <limits>
+
+namespace {
+
+constexpr int DefaultLifeSize = 8192;
+constexpr uint64_t MaxBitwiseGenerationsPerTick = 64;
+constexpr uint64_t MaxHashLifeGenerationsPerTick = uint64_t(1) << 40;
+constexpr uint64_t MaxRaceEventsPerFrame = uint64_t(1) << 24;
+constexpr size_t InversionTrailFrames = 32;
+
+// Touch counts as dark blue to orange, on a log scale; pages touched in the
+// last few epochs are lightened, so the sort's current working set glows.
+std::vector<QRgb> pageHeatStrip(std::span<const PageTracer::Page> pages, uint32_t epoch)
+{
+    uint32_t most = 1;
+    for (const PageTracer::Page &page : pages)
+        most = std::max(most, page.touches.load(std::memory_order_relaxed));
+    std::vector<QRgb> strip(pages.size());
+    for (size_t i = 0; i < pages.size(); ++i) {
+        const uint32_t touches = pages[i].touches.load(std::memory_order_relaxed);
+        const double heat = std::log1p(touches) / std::log1p(most);
+        const uint32_t age = epoch - pages[i].lastEpoch.load(std::memory_order_relaxed);
+        const double fresh = touches && age < 8 ? 1.0 - age / 8.0 : 0.0;
+        const auto channel = [&](double cold, double hot) { return int(cold + (hot - cold) * heat + (255 - cold) * fresh * 0.6); };
+        strip[i] = qRgb(std::min(channel(30, 250), 255), std::min(channel(30, 140), 255), std::min(channel(70, 40), 255));
+    }
+    return strip;
+}
+
+// Bytes in use over the run in block characters, one per time slice, each
+// the peak of its slice.
+QString heapSparkline(std::span<const MemoryUsage::Profile::Sample> timeline, int width)
+{
+    if (timeline.empty())
+        return QString();
+    const uint64_t duration = std::max<uint64_t>(timeline.back().nanoseconds, 1);
+    std::vector<int64_t> slices(size_t(width), 0);
+    for (const MemoryUsage::Profile::Sample &sample : timeline) {
+        int64_t &slice = slices[std::min(size_t(sample.nanoseconds * width / duration), size_t(width - 1))];
+        slice = std::max(slice, sample.bytes);
+    }
+    const int64_t most = std::max<int64_t>(*std::max_element(slices.begin(), slices.end()), 1);
+    QString line;
+    for (int64_t bytes : slices)
+        line += QChar(0x2581 + int(std::clamp<int64_t>(bytes * 8 / (most + 1), 0, 7)));
+    return line;
+}
+
+// Fractions from 0 to 1 in block characters, one each.
+QString fractionSparkline(std::span<const double> fractions)
+{
+    QString line;
+    for (double fraction : fractions)
+        line += QChar(0x2581 + int(std::clamp(fraction * 8, 0.0, 7.0)));
+    return line;
+}
+
+// Inversions as a fraction of the n(n - 1) / 2 there can be, and the
+// working set as a fraction of its peak, across the whole run.
+std::vector<RaceView::Curve> traceCurves(const TraceAnalysis::Result &stats)
+{
+    RaceView::Curve inversions;
+    inversions.colour = qRgb(120, 200, 255);
+    RaceView::Curve workingSet;
+    workingSet.colour = qRgb(250, 250, 250);
+    const double pairs = std::max(double(stats.size) * double(stats.size - 1) / 2, 1.0);
+    uint32_t peak = 1;
+    for (const TraceAnalysis::Sample &sample : stats.samples)
+        peak = std::max(peak, sample.workingSet);
+    const double events = double(std::max<uint64_t>(stats.events, 1));
+    for (const TraceAnalysis::Sample &sample : stats.samples) {
+        inversions.points.emplace_back(sample.position / events, sample.inversions / pairs);
+        workingSet.points.emplace_back(sample.position / events, double(sample.workingSet) / peak);
+    }
+    inversions.label = MainWindow::tr("inversions, %1 at the start").arg(stats.samples.front().inversions);
+    workingSet.label = MainWindow::tr("working set, up to %1 cache lines").arg(peak);
+    return { inversions, workingSet };
+}
+
+} // namespace
+
 MainWindow::MainWindow(QWidget *parent)
     : QMainWindow(parent)
     , ui(new Ui::MainWindow)
 {
     ui->setupUi(this);
+
+    m_lifeTimer.setInterval(16);
+    connect(&m_lifeTimer, &QTimer::timeout, this, &MainWindow::advanceLife);
+
+    m_fillTimer.setInterval(16);
+    connect(&m_fillTimer, &QTimer::timeout, this, &MainWindow::advanceFloodFill);
+    connect(ui->centralwidget, &CanvasWidget::imageClicked, this, &MainWindow::startFloodFill);
+
+    m_traceTimer.setInterval(16);
+    connect(&m_traceTimer, &QTimer::timeout, this, &MainWindow::advancePipelineTrace);
+
+    m_compressionTimer.setInterval(16);
+    connect(&m_compressionTimer, &QTimer::timeout, this, &MainWindow::advanceCompression);
+
+    m_raceTimer.setInterval(16);
+    connect(&m_raceTimer, &QTimer::timeout, this, &MainWindow::advanceRace);
+
+    m_playerSlider = new QSlider(Qt::Horizontal, this);
+    m_playerSlider->setMinimumWidth(320);
+    m_playerSlider->hide();
+    statusBar()->addPermanentWidget(m_playerSlider);
+    connect(m_playerSlider, &QSlider::sliderMoved, this, &MainWindow::seekPlayer);
+    m_playerTimer.setInterval(16);
+    connect(&m_playerTimer, &QTimer::timeout, this, &MainWindow::advancePlayer);
+    m_player.trackSortedness(ui->actionSortSortedness->isChecked());
+
+    m_analysisTimer.setInterval(100);
+    connect(&m_analysisTimer, &QTimer::timeout, this, &MainWindow::advanceAnalysis);
+
+    m_sandboxTimer.setInterval(16);
+    connect(&m_sandboxTimer, &QTimer::timeout, this, &MainWindow::advanceSandbox);
+
+    m_sampledTimer.setInterval(16);
+    connect(&m_sampledTimer, &QTimer::timeout, this, &MainWindow::advanceSampled);
+
+    m_distributedTimer.setInterval(16);
+    connect(&m_distributedTimer, &QTimer::timeout, this, &MainWindow::advanceDistributed);
+
+    m_searchTimer.setInterval(100);
+    connect(&m_searchTimer, &QTimer::timeout, this, &MainWindow::advanceSearch);
+
+    ui->scalingDock->hide();
+    m_sweepTimer.setInterval(100);
+    connect(&m_sweepTimer, &QTimer::timeout, this, &MainWindow::advanceSweep);
 }
 
 MainWindow::~MainWindow()
@@ -13,3 +160,1044 @@ MainWindow::~MainWindow()
     delete ui;
 }
 
+void MainWindow::on_actionOpen_triggered()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Open Data"), QString(),
+                                                      tr("Arrays (*.txt *.csv);;Edge lists (*.edges *.el);;All files (*)"));
+    if (path.isEmpty())
+        return;
+
+    QElapsedTimer timer;
+    timer.start();
+    QString error;
+    bool fromCache = false;
+    Dataset dataset = m_snapshots.load(path, &error, &fromCache);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+    if (dataset.isEmpty()) {
+        QMessageBox::warning(this, tr("Open Data"), tr("Cannot load %1:\n%2").arg(path, error));
+        return;
+    }
+
+    m_dataset = std::move(dataset);
+    const QString source = fromCache ? tr("mapped from cache") : tr("parsed and cached");
+    if (m_dataset.kind() == Dataset::Kind::Graph) {
+        statusBar()->showMessage(tr("%1 vertices, %2 edges %3 in %4 ms")
+                                 .arg(m_dataset.vertexCount()).arg(m_dataset.edgeCount())
+                                 .arg(source).arg(elapsedMs, 0, 'f', 2));
+    } else {
+        statusBar()->showMessage(tr("%1 values %2 in %3 ms")
+                                 .arg(m_dataset.valueCount()).arg(source).arg(elapsedMs, 0, 'f', 2));
+    }
+}
+
+void MainWindow::on_actionLifeRun_toggled(bool running)
+{
+    if (m_life.width() == 0)
+        on_actionLifeRandomize_triggered();
+    if (running)
+        m_lifeTimer.start();
+    else
+        m_lifeTimer.stop();
+}
+
+void MainWindow::on_actionLifeStep_triggered()
+{
+    if (m_life.width() == 0)
+        on_actionLifeRandomize_triggered();
+    advanceLife();
+}
+
+void MainWindow::on_actionLifeRandomize_triggered()
+{
+    if (m_life.width() == 0)
+        m_life = LifeBoard(DefaultLifeSize, DefaultLifeSize);
+    m_life.randomize(QRandomGenerator::global()->generate64());
+    if (m_useHashLife)
+        m_hashLife.load(m_life);
+    renderLife();
+}
+
+void MainWindow::on_actionLifeBoardSize_triggered()
+{
+    bool ok = false;
+    const int size = QInputDialog::getInt(this, tr("Board Size"), tr("Cells per side:"),
+                                          m_life.width() ? m_life.width() : DefaultLifeSize,
+                                          64, 65536, 64, &ok);
+    if (!ok)
+        return;
+    m_life = LifeBoard(size, size);
+    on_actionLifeRandomize_triggered();
+}
+
+void MainWindow::on_actionLifeFaster_triggered()
+{
+    const uint64_t limit = m_useHashLife ? MaxHashLifeGenerationsPerTick : MaxBitwiseGenerationsPerTick;
+    m_generationsPerTick = std::min(m_generationsPerTick * 2, limit);
+    renderLife();
+}
+
+void MainWindow::on_actionLifeSlower_triggered()
+{
+    m_generationsPerTick = std::max<uint64_t>(m_generationsPerTick / 2, 1);
+    renderLife();
+}
+
+void MainWindow::on_actionLifeHashLife_toggled(bool enabled)
+{
+    m_useHashLife = enabled;
+    if (!enabled)
+        m_generationsPerTick = std::min(m_generationsPerTick, MaxBitwiseGenerationsPerTick);
+    if (m_life.width() == 0)
+        return;
+    if (enabled)
+        m_hashLife.load(m_life);
+    else
+        m_hashLife.render(m_life);
+}
+
+void MainWindow::advanceLife()
+{
+    QElapsedTimer timer;
+    timer.start();
+    if (m_useHashLife) {
+        m_hashLife.advance(m_generationsPerTick);
+        m_hashLife.render(m_life);
+    } else {
+        for (uint64_t i = 0; i < m_generationsPerTick; ++i)
+            m_life.step();
+    }
+    m_lastStepMs = timer.nsecsElapsed() / 1e6;
+    renderLife();
+}
+
+// Boards larger than the canvas are reduced by a power-of-two factor with
+// live-cell density as brightness; at 1:1 the bit rows are copied verbatim.
+void MainWindow::renderLife()
+{
+    if (m_life.width() == 0)
+        return;
+
+    const QSize canvas = ui->centralwidget->size();
+    int factor = 1;
+    while (m_life.width() / factor > canvas.width() * 2 || m_life.height() / factor > canvas.height() * 2)
+        factor *= 2;
+
+    // Render straight into the canvas' image; a second reference to it would
+    // make every frame detach and copy the whole buffer.
+    QImage &image = ui->centralwidget->image();
+    if (factor == 1) {
+        if (image.format() != QImage::Format_MonoLSB || image.size() != QSize(m_life.width(), m_life.height())) {
+            QImage bits(m_life.width(), m_life.height(), QImage::Format_MonoLSB);
+            bits.setColorTable({ qRgb(0, 0, 0), qRgb(120, 230, 120) });
+            ui->centralwidget->setImage(bits);
+        }
+        m_life.renderBits(image.bits(), int(image.bytesPerLine()));
+    } else {
+        const QSize size((m_life.width() + factor - 1) / factor, (m_life.height() + factor - 1) / factor);
+        if (image.format() != QImage::Format_Grayscale8 || image.size() != size)
+            ui->centralwidget->setImage(QImage(size, QImage::Format_Grayscale8));
+        m_life.renderDensity(factor, image.bits(), int(image.bytesPerLine()));
+    }
+    ui->centralwidget->update();
+
+    const uint64_t generation = m_useHashLife ? m_hashLife.generation() : m_life.generation();
+    const uint64_t population = m_useHashLife ? m_hashLife.population() : m_life.population();
+    statusBar()->showMessage(tr("Generation %1, population %2, %3 gen/tick, %4 ms/tick%5")
+                             .arg(generation).arg(population).arg(m_generationsPerTick)
+                             .arg(m_lastStepMs, 0, 'f', 2)
+                             .arg(m_useHashLife ? tr(", HashLife (%1 nodes)").arg(m_hashLife.nodeCount()) : QString()));
+}
+
+void MainWindow::on_actionOpenImage_triggered()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Open Image"), QString(),
+                                                      tr("Images (*.png *.jpg *.jpeg *.bmp *.pbm *.pgm *.tif *.tiff);;All files (*)"));
+    if (path.isEmpty())
+        return;
+
+    QImageReader reader(path);
+#if QT_VERSION >= QT_VERSION_CHECK(6, 0, 0)
+    reader.setAllocationLimit(0);
+#endif
+    const QImage image = reader.read();
+    if (image.isNull()) {
+        QMessageBox::warning(this, tr("Open Image"), tr("Cannot read %1:\n%2").arg(path, reader.errorString()));
+        return;
+    }
+
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    m_gray = ImageConvert::toGray(image);
+    m_mask = ImageConvert::toMask(image);
+    m_nextFillValue = 2;
+    ui->centralwidget->setImage(ImageConvert::fromMask(m_mask));
+    statusBar()->showMessage(tr("%1 x %2, dark pixels are foreground").arg(m_mask.width).arg(m_mask.height));
+}
+
+void MainWindow::on_actionLabelTwoPass_triggered()
+{
+    showLabels(false);
+}
+
+void MainWindow::on_actionLabelParallel_triggered()
+{
+    showLabels(true);
+}
+
+void MainWindow::showLabels(bool parallel)
+{
+    if (m_mask.pixels.empty())
+        return;
+    stopAnimations();
+
+    std::vector<uint32_t> labels;
+    QElapsedTimer timer;
+    timer.start();
+    const uint32_t components = parallel ? labelParallel(m_mask, labels) : labelTwoPass(m_mask, labels);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+
+    ui->centralwidget->setImage(ImageConvert::fromLabels(labels, m_mask.width, m_mask.height));
+    statusBar()->showMessage(tr("%1 components in %2 ms (%3)")
+                             .arg(components).arg(elapsedMs, 0, 'f', 1)
+                             .arg(parallel ? tr("parallel, %1 threads").arg(Parallel::threadCount()) : tr("two-pass")));
+}
+
+void MainWindow::startFloodFill(const QPoint &pixel)
+{
+    if (!ui->actionFloodFill->isChecked() || m_mask.pixels.empty()
+        || pixel.x() >= m_mask.width || pixel.y() >= m_mask.height)
+        return;
+
+    m_traceTimer.stop();
+    m_fill = std::make_unique<ScanlineFill>(m_mask, pixel.x(), pixel.y(), m_nextFillValue);
+    m_nextFillValue = m_nextFillValue == 255 ? 2 : m_nextFillValue + 1;
+    ui->centralwidget->setImage(ImageConvert::fromMask(m_mask));
+    m_fillTimer.start();
+}
+
+// Enough spans per frame that a full-screen region completes in a couple of
+// seconds, while small regions are still visibly swept.
+void MainWindow::advanceFloodFill()
+{
+    if (!m_fill) {
+        m_fillTimer.stop();
+        return;
+    }
+
+    const size_t spansPerFrame = std::max<size_t>(64, size_t(m_mask.height) / 16);
+    m_filledSpans.clear();
+    const bool more = m_fill->step(spansPerFrame, &m_filledSpans);
+    QImage &image = ui->centralwidget->image();
+    for (const ScanlineFill::Span &span : m_filledSpans) {
+        std::memcpy(image.scanLine(span.y) + span.left, &m_mask.at(span.left, span.y),
+                    size_t(span.right - span.left + 1));
+    }
+    ui->centralwidget->update();
+    statusBar()->showMessage(tr("Flood fill: %1 pixels").arg(m_fill->filledPixels()));
+
+    if (!more) {
+        m_fillTimer.stop();
+        m_fill.reset();
+    }
+}
+
+void MainWindow::stopAnimations()
+{
+    m_fillTimer.stop();
+    m_fill.reset();
+    m_traceTimer.stop();
+    m_compressionTimer.stop();
+    m_raceTimer.stop();
+    m_playerTimer.stop();
+    m_playerSlider->hide();
+    m_inversionTrail.clear();
+    m_analysisTimer.stop();
+    m_analysis.cancel();
+    m_traceStats = {};
+    m_sandboxTimer.stop();
+    m_sandbox.stop();
+    m_sampledTimer.stop();
+    m_sampled.cancel();
+    m_distributedTimer.stop();
+    m_distributed.stop();
+}
+
+void MainWindow::on_actionPipeline_triggered()
+{
+    if (m_gray.pixels.empty()) {
+        on_actionOpenImage_triggered();
+        if (m_gray.pixels.empty())
+            return;
+    }
+
+    bool ok = false;
+    const QStringList variants = { tr("naive"), tr("separable"), tr("vector"), tr("tiled") };
+    const int variant = variants.indexOf(QInputDialog::getItem(this, tr("Image Pipeline"), tr("Implementation:"),
+                                                               variants, 3, false, &ok));
+    if (!ok || variant < 0)
+        return;
+    const QString names = QInputDialog::getText(this, tr("Image Pipeline"),
+                                                tr("Stages (blur, sobel, median, equalize):"),
+                                                QLineEdit::Normal, QStringLiteral("blur, sobel, median"), &ok);
+    if (!ok)
+        return;
+    std::vector<ImagePipeline::Stage> stages;
+    for (const QString &name : names.split(QLatin1Char(','), Qt::SkipEmptyParts)) {
+        ImagePipeline::Stage stage;
+        if (!ImagePipeline::stageFromName(name.trimmed().toLower().toStdString(), stage)) {
+            QMessageBox::warning(this, tr("Image Pipeline"), tr("Unknown stage \"%1\".").arg(name.trimmed()));
+            return;
+        }
+        stages.push_back(stage);
+    }
+    if (stages.empty())
+        return;
+
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    QElapsedTimer timer;
+    timer.start();
+    m_pipelineResult = ImagePipeline::run(m_gray, stages, ImagePipeline::Variant(variant),
+                                          ImagePipeline::Options(), &m_pipelineTrace);
+    const double elapsedMs = timer.nsecsElapsed() / 1e6;
+    m_pipelineStages = int(stages.size());
+    m_pipelineSummary = tr("%1 pipeline, %2 stages in %3 ms, %4 blocks, %5 threads")
+                        .arg(variants[variant]).arg(stages.size()).arg(elapsedMs, 0, 'f', 1)
+                        .arg(m_pipelineTrace.size()).arg(Parallel::threadCount());
+
+    // Replay the recorded write order over a dimmed copy of the input.
+    QImage canvas = ImageConvert::fromGray(m_gray).convertToFormat(QImage::Format_RGB32);
+    for (int y = 0; y < canvas.height(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(canvas.scanLine(y));
+        for (int x = 0; x < canvas.width(); ++x) {
+            const int level = qGray(line[x]) / 4;
+            line[x] = qRgb(level, level, level);
+        }
+    }
+    ui->centralwidget->setImage(canvas);
+    m_traceShown = 0;
+    m_traceTimer.start();
+}
+
+// Each frame paints the next few recorded blocks: the result's gray level,
+// brighter for later stages, tinted with the colour of the worker thread
+// that wrote the block. The clean result replaces it once replay ends.
+void MainWindow::advancePipelineTrace()
+{
+    const size_t blocksPerFrame = std::max<size_t>(1, m_pipelineTrace.size() / 150);
+    const size_t last = std::min(m_pipelineTrace.size(), m_traceShown + blocksPerFrame);
+    QImage &image = ui->centralwidget->image();
+    for (; m_traceShown < last; ++m_traceShown) {
+        const ImagePipeline::TraceEntry &entry = m_pipelineTrace[m_traceShown];
+        const QColor tint = QColor::fromHsv((entry.worker * 67) % 360, 200, 255);
+        const int weight = 64 + 192 * (entry.stage + 1) / m_pipelineStages;
+        for (int y = entry.y; y < entry.y + entry.height; ++y) {
+            QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y));
+            const uint8_t *gray = &m_pipelineResult.at(0, y);
+            for (int x = entry.x; x < entry.x + entry.width; ++x) {
+                const int level = gray[x] * weight / 256;
+                line[x] = qRgb((level * 3 + tint.red()) / 4, (level * 3 + tint.green()) / 4,
+                               (level * 3 + tint.blue()) / 4);
+            }
+        }
+    }
+    statusBar()->showMessage(tr("%1 (replaying %2 of %3)").arg(m_pipelineSummary)
+                             .arg(m_traceShown).arg(m_pipelineTrace.size()));
+
+    if (m_traceShown == m_pipelineTrace.size()) {
+        m_traceTimer.stop();
+        ui->centralwidget->setImage(ImageConvert::fromGray(m_pipelineResult));
+        statusBar()->showMessage(m_pipelineSummary);
+    }
+    ui->centralwidget->update();
+}
+
+void MainWindow::on_actionCompressionOpen_triggered()
+{
+    const QString path = QFileDialog::getOpenFileName(this, tr("Open File to Compress"));
+    if (path.isEmpty())
+        return;
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        QMessageBox::warning(this, tr("Open File"), tr("Cannot read %1:\n%2").arg(path, file.errorString()));
+        return;
+    }
+    const QByteArray bytes = file.readAll();
+    m_compressionInput.assign(bytes.begin(), bytes.end());
+    m_compressionName = QFileInfo(path).fileName();
+    statusBar()->showMessage(tr("%1: %2 bytes").arg(m_compressionName).arg(m_compressionInput.size()));
+}
+
+void MainWindow::on_actionCompressHashChain_triggered()
+{
+    startCompression(CompressionView::Mode::HashChain);
+}
+
+void MainWindow::on_actionCompressBinaryTree_triggered()
+{
+    startCompression(CompressionView::Mode::BinaryTree);
+}
+
+void MainWindow::on_actionCompressHuffman_triggered()
+{
+    startCompression(CompressionView::Mode::Huffman);
+}
+
+void MainWindow::on_actionCompressRans_triggered()
+{
+    startCompression(CompressionView::Mode::Rans);
+}
+
+// The animation only covers the first few KB, so the throughput shown next
+// to it is measured once on the whole file with the engine being animated:
+// the codec with that match finder, or the entropy coder on its own.
+void MainWindow::startCompression(CompressionView::Mode mode)
+{
+    if (m_compressionInput.empty()) {
+        on_actionCompressionOpen_triggered();
+        if (m_compressionInput.empty())
+            return;
+    }
+
+    const uint8_t *data = m_compressionInput.data();
+    const size_t size = m_compressionInput.size();
+    std::vector<uint8_t> compressed;
+    std::vector<uint8_t> restored;
+    bool ok = false;
+    QElapsedTimer timer;
+    timer.start();
+    switch (mode) {
+    case CompressionView::Mode::HashChain:
+    case CompressionView::Mode::BinaryTree: {
+        Codec::Options options;
+        options.finder = mode == CompressionView::Mode::HashChain ? Codec::Finder::HashChain
+                                                                  : Codec::Finder::BinaryTree;
+        compressed = Codec::compress(data, size, options);
+        break;
+    }
+    case CompressionView::Mode::Huffman:
+        Huffman::encode(data, size, compressed);
+        break;
+    case CompressionView::Mode::Rans:
+        Rans::encode(data, size, compressed);
+        break;
+    }
+    const double encodeSeconds = timer.nsecsElapsed() / 1e9;
+    timer.restart();
+    switch (mode) {
+    case CompressionView::Mode::HashChain:
+    case CompressionView::Mode::BinaryTree:
+        ok = Codec::decompress(compressed.data(), compressed.size(), restored);
+        break;
+    case CompressionView::Mode::Huffman:
+        restored.resize(size);
+        ok = Huffman::decode(compressed.data(), compressed.size(), size, restored.data());
+        break;
+    case CompressionView::Mode::Rans:
+        restored.resize(size);
+        ok = Rans::decode(compressed.data(), compressed.size(), size, restored.data());
+        break;
+    }
+    const double decodeSeconds = timer.nsecsElapsed() / 1e9;
+    const double megabytes = size / 1e6;
+    m_compressionSummary = tr("%1: %2 -> %3 bytes (%4%), encode %5 MB/s, decode %6 MB/s%7")
+                           .arg(m_compressionName).arg(size).arg(compressed.size())
+                           .arg(100.0 * compressed.size() / size, 0, 'f', 1)
+                           .arg(megabytes / std::max(encodeSeconds, 1e-9), 0, 'f', 1)
+                           .arg(megabytes / std::max(decodeSeconds, 1e-9), 0, 'f', 1)
+                           .arg(ok && restored == m_compressionInput ? QString() : tr(", ROUND TRIP FAILED"));
+
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    m_compression.start(data, size, mode);
+    m_compression.render(ui->centralwidget->image());
+    ui->centralwidget->update();
+    m_compressionTimer.start();
+}
+
+void MainWindow::advanceCompression()
+{
+    if (!m_compression.advance())
+        m_compressionTimer.stop();
+    m_compression.render(ui->centralwidget->image());
+    ui->centralwidget->update();
+    statusBar()->showMessage(tr("%1 | %2").arg(m_compression.progress(), m_compressionSummary));
+}
+
+void MainWindow::on_actionSortRace_triggered()
+{
+    m_race.start(SortRace::allPairs(), m_raceSize, QRandomGenerator::global()->generate());
+    startRace();
+}
+
+// Sorts the loaded array in one large panel, or a random one when no array
+// is loaded. The dataset itself is left alone; the lane works on a copy.
+void MainWindow::on_actionSortDataset_triggered()
+{
+    QStringList names;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms())
+        names << QString::fromLatin1(algorithm.name);
+    bool ok = false;
+    const QString name = QInputDialog::getItem(this, tr("Sort"), tr("Algorithm:"), names,
+                                               names.indexOf(QStringLiteral("quick")), false, &ok);
+    if (!ok)
+        return;
+
+    std::vector<int32_t> values;
+    std::string input;
+    pickSortInput(values, input);
+    m_race.start(Sorts::findAlgorithm(name.toStdString()), std::move(values), input);
+    startRace();
+}
+
+void MainWindow::pickSortInput(std::vector<int32_t> &values, std::string &input) const
+{
+    if (m_dataset.kind() == Dataset::Kind::Array) {
+        values.assign(m_dataset.values(), m_dataset.values() + m_dataset.valueCount());
+        input = "dataset";
+    } else {
+        values = Sorts::makeInput(Sorts::Shape::Random, std::max<size_t>(m_raceSize, 1024),
+                                  QRandomGenerator::global()->generate());
+        input = "random";
+    }
+}
+
+void MainWindow::on_actionSortSize_triggered()
+{
+    bool ok = false;
+    const int size = QInputDialog::getInt(this, tr("Array Size"), tr("Elements per race lane:"),
+                                          int(m_raceSize), 2, 1 << 20, 1, &ok);
+    if (ok)
+        m_raceSize = size_t(size);
+}
+
+void MainWindow::on_actionSortFaster_triggered()
+{
+    m_raceEventsPerFrame = std::min(m_raceEventsPerFrame * 2, MaxRaceEventsPerFrame);
+}
+
+void MainWindow::on_actionSortSlower_triggered()
+{
+    m_raceEventsPerFrame = std::max<uint64_t>(m_raceEventsPerFrame / 2, 1);
+}
+
+void MainWindow::startRace()
+{
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    RaceView::render(m_race, ui->centralwidget->image(), ui->centralwidget->pixelSize(),
+                     ui->centralwidget->devicePixelRatioF());
+    ui->centralwidget->update();
+    m_raceTimer.start();
+}
+
+// The sorts run on this thread as coroutines: each frame gives every lane
+// the same number of events, but stops early rather than miss the frame.
+void MainWindow::advanceRace()
+{
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    if (!m_race.advance(m_raceEventsPerFrame, deadline))
+        m_raceTimer.stop();
+    RaceView::render(m_race, ui->centralwidget->image(), ui->centralwidget->pixelSize(),
+                     ui->centralwidget->devicePixelRatioF());
+    ui->centralwidget->update();
+
+    const std::vector<SortRace::Lane> &lanes = m_race.lanes();
+    if (lanes.size() == 1) {
+        const SortRace::Lane &lane = lanes.front();
+        statusBar()->showMessage(tr("%1 on %2 elements: %3 compares, %4 swaps, %5 writes, %6 events/frame%7")
+                                 .arg(QLatin1String(lane.algorithm->name)).arg(lane.values.size())
+                                 .arg(lane.compares).arg(lane.swaps).arg(lane.writes).arg(m_raceEventsPerFrame)
+                                 .arg(lane.finishedPlace ? tr(", done") : QString()));
+    } else {
+        statusBar()->showMessage(tr("%1 lanes of %2 elements, %3 still running, %4 events/frame")
+                                 .arg(lanes.size()).arg(m_raceSize).arg(m_race.running()).arg(m_raceEventsPerFrame));
+    }
+}
+
+// Like Sort Dataset, but through a TracePlayer, so the run can be paused,
+// stepped and scrubbed in both directions. Unbounded sorts are offered too;
+// the player only ever holds a window of their events.
+void MainWindow::on_actionSortPlay_triggered()
+{
+    QStringList names;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms())
+        names << QString::fromLatin1(algorithm.name);
+    bool ok = false;
+    const QString name = QInputDialog::getItem(this, tr("Play Sort"), tr("Algorithm:"), names,
+                                               names.indexOf(QStringLiteral("quick")), false, &ok);
+    if (ok)
+        playSort(Sorts::findAlgorithm(name.toStdString()));
+}
+
+void MainWindow::playSort(const Sorts::Algorithm *algorithm)
+{
+    std::vector<int32_t> values;
+    std::string input;
+    pickSortInput(values, input);
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    m_player.start(algorithm, std::move(values), TracePlayer::Options());
+    m_playerInput = QString::fromStdString(input);
+    m_playerTarget = 0;
+    ui->actionSortPause->setChecked(false);
+    m_playerSlider->setRange(0, 0);
+    m_playerSlider->show();
+    m_playerTimer.start();
+}
+
+void MainWindow::on_actionSortPause_toggled(bool paused)
+{
+    if (!paused && m_player.algorithm() && !m_playerTimer.isActive())
+        m_playerTimer.start();
+}
+
+void MainWindow::on_actionSortStepBack_triggered()
+{
+    stepPlayer(-1);
+}
+
+void MainWindow::on_actionSortStepForward_triggered()
+{
+    stepPlayer(1);
+}
+
+void MainWindow::stepPlayer(int64_t delta)
+{
+    if (!m_player.algorithm())
+        return;
+    ui->actionSortPause->setChecked(true);
+    m_playerTarget = delta < 0 ? m_player.position() - std::min<uint64_t>(m_player.position(), uint64_t(-delta))
+                               : m_player.position() + uint64_t(delta);
+    if (!m_playerTimer.isActive())
+        m_playerTimer.start();
+}
+
+void MainWindow::seekPlayer(int position)
+{
+    ui->actionSortPause->setChecked(true);
+    m_playerTarget = uint64_t(position);
+    if (!m_playerTimer.isActive())
+        m_playerTimer.start();
+}
+
+// Seeking gets 10 ms a frame. A long jump back shows the nearest checkpoint
+// at once and catches up over the following frames.
+void MainWindow::advancePlayer()
+{
+    const bool paused = ui->actionSortPause->isChecked();
+    if (!paused)
+        m_playerTarget = m_player.position() + m_raceEventsPerFrame;
+    const auto deadline = std::chrono::steady_clock::now() + std::chrono::milliseconds(10);
+    const bool arrived = m_player.seek(m_playerTarget, deadline);
+    const bool atEnd = m_player.finished() && m_player.position() == m_player.generated();
+    if (arrived && (paused || atEnd))
+        m_playerTimer.stop();
+
+    RaceView::Panel panel;
+    panel.values = m_player.values();
+    panel.active = m_player.lastEvent(panel.last) && !atEnd;
+    panel.range = m_player.range();
+    panel.finished = atEnd;
+    panel.title = QStringLiteral("%1 / %2").arg(QLatin1String(m_player.algorithm()->name), m_playerInput);
+    panel.status = QString::number(m_player.position());
+    if (!m_traceStats.samples.empty()) {
+        panel.heat = TraceAnalysis::heat(m_traceStats, m_heat);
+        panel.curves = traceCurves(m_traceStats);
+        panel.cursor = double(m_player.position()) / double(std::max<uint64_t>(m_traceStats.events, 1));
+    }
+    RaceView::render({ panel }, ui->centralwidget->image(), ui->centralwidget->pixelSize(),
+                     ui->centralwidget->devicePixelRatioF());
+    ui->centralwidget->update();
+
+    const int maximum = int(std::min<uint64_t>(m_player.generated(), uint64_t(std::numeric_limits<int>::max())));
+    m_playerSlider->setRange(0, maximum);
+    if (!m_playerSlider->isSliderDown())
+        m_playerSlider->setValue(int(std::min<uint64_t>(m_player.position(), uint64_t(maximum))));
+
+    QString message = tr("%1: event %2 of %3%4 | %5 checkpoints %6 events apart | %7 KB")
+                      .arg(QLatin1String(m_player.algorithm()->name)).arg(m_player.position())
+                      .arg(m_player.generated()).arg(m_player.finished() ? QString() : tr("+"))
+                      .arg(m_player.checkpointCount()).arg(m_player.checkpointInterval())
+                      .arg(m_player.memoryBytes() / 1024);
+    if (m_player.rederiving())
+        message += tr(" | re-deriving %1%").arg(int(m_player.rederiveProgress() * 100));
+    if (const Sortedness *sortedness = m_player.sortedness()) {
+        const double fraction = double(sortedness->inversions())
+                              / double(std::max<uint64_t>(sortedness->mostInversions(), 1));
+        m_inversionTrail.push_back(fraction);
+        if (m_inversionTrail.size() > InversionTrailFrames)
+            m_inversionTrail.erase(m_inversionTrail.begin());
+        message += tr(" | %1 inversions (%2%) %3, %4 runs, displaced up to %5")
+                       .arg(sortedness->inversions()).arg(fraction * 100, 0, 'f', 2)
+                       .arg(fractionSparkline(m_inversionTrail)).arg(sortedness->runs())
+                       .arg(sortedness->maxDisplacement());
+    }
+    if (m_analysis.running())
+        message += tr(" | analyzing, %1 events").arg(m_analysis.events());
+    else if (!m_traceStats.samples.empty())
+        message += tr(" | %1 heat, analysis took %2 KB").arg(QLatin1String(TraceAnalysis::heatName(m_heat)))
+                       .arg(m_traceStats.memoryBytes / 1024);
+    statusBar()->showMessage(message);
+}
+
+// Goes over the whole run being played once more, on a worker, however
+// long it is, then lays the chosen heatmap and the inversion and working
+// set curves over the player.
+void MainWindow::on_actionSortAnalyze_triggered()
+{
+    if (!m_player.algorithm()) {
+        statusBar()->showMessage(tr("Play a sort first; the analysis covers the run being played"));
+        return;
+    }
+    QStringList heats;
+    for (TraceAnalysis::Heat heat : { TraceAnalysis::Heat::Accesses, TraceAnalysis::Heat::Writes,
+                                      TraceAnalysis::Heat::SwapDistance })
+        heats << QLatin1String(TraceAnalysis::heatName(heat));
+    bool ok = false;
+    const QString heat = QInputDialog::getItem(this, tr("Analyze Trace"), tr("Heatmap:"), heats, int(m_heat), false, &ok);
+    if (!ok)
+        return;
+    m_heat = TraceAnalysis::Heat(heats.indexOf(heat));
+    const std::span<const int32_t> input = m_player.input();
+    m_traceStats = {};
+    m_analysis.start(m_player.algorithm(), std::vector<int32_t>(input.begin(), input.end()));
+    m_analysisTimer.start();
+}
+
+// Redraws a paused or finished player, which has no timer of its own
+// running, to show the progress and then the overlay.
+void MainWindow::advanceAnalysis()
+{
+    if (!m_analysis.running()) {
+        m_analysisTimer.stop();
+        m_traceStats = m_analysis.result();
+    }
+    if (!m_playerTimer.isActive())
+        advancePlayer();
+}
+
+// Metrics follow the player from the next frame; turning them on part way
+// through a run counts the array as it stands.
+void MainWindow::on_actionSortSortedness_toggled(bool checked)
+{
+    m_player.trackSortedness(checked);
+    m_inversionTrail.clear();
+    if (m_player.algorithm() && !m_playerTimer.isActive())
+        advancePlayer();
+}
+
+// Runs a catalog sort, or a plugin library, in a child process that sorts a
+// shared copy of the input. Whatever the child does, this window only ever
+// reads the array, and the watchdog in Sandbox::poll() ends runaways.
+void MainWindow::on_actionSortSandbox_triggered()
+{
+    QStringList names;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms())
+        names << QString::fromLatin1(algorithm.name);
+    const QString pluginItem = tr("Plugin library...");
+    names << pluginItem;
+    bool ok = false;
+    QString name = QInputDialog::getItem(this, tr("Run Sandboxed"), tr("Algorithm:"), names,
+                                         names.indexOf(QStringLiteral("quick")), false, &ok);
+    if (!ok)
+        return;
+    Sandbox::Options options;
+    options.tracePages = ui->actionSortTracePages->isChecked();
+    if (name == pluginItem) {
+        name = QFileDialog::getOpenFileName(this, tr("Open Sort Plugin"), QString(),
+                                            tr("Shared libraries (*.so *.dylib);;All files (*)"));
+        if (name.isEmpty())
+            return;
+        // Plugins report no progress, so only a time limit can catch them.
+        options.timeLimit = std::chrono::seconds(60);
+    }
+
+    std::vector<int32_t> values;
+    std::string input;
+    pickSortInput(values, input);
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    QString error;
+    if (!m_sandbox.start(QCoreApplication::applicationFilePath(), name, values, options, &error)) {
+        QMessageBox::warning(this, tr("Run Sandboxed"), error);
+        return;
+    }
+    m_sandboxName = QFileInfo(name).fileName();
+    m_sandboxAllowance = 0;
+    m_sandboxTimer.start();
+}
+
+void MainWindow::advanceSandbox()
+{
+    m_sandboxAllowance += m_raceEventsPerFrame;
+    m_sandbox.allowEvents(m_sandboxAllowance);
+    const Sandbox::State state = m_sandbox.poll();
+    if (state != Sandbox::State::Running)
+        m_sandboxTimer.stop();
+
+    RaceView::Panel panel;
+    panel.values = m_sandbox.values();
+    panel.last = m_sandbox.lastEvent();
+    panel.range = m_sandbox.range();
+    panel.active = state == Sandbox::State::Running;
+    panel.finished = state == Sandbox::State::Finished;
+    panel.title = tr("%1 (sandboxed)").arg(m_sandboxName);
+    panel.status = QString::number(m_sandbox.events());
+    panel.strip = pageHeatStrip(m_sandbox.pages(), m_sandbox.traceEpoch());
+    RaceView::render({ panel }, ui->centralwidget->image(), ui->centralwidget->pixelSize(),
+                     ui->centralwidget->devicePixelRatioF());
+    ui->centralwidget->update();
+    QString message = tr("%1 in process %2: %3 events, %4")
+                      .arg(m_sandboxName).arg(m_sandbox.pid() > 0 ? QString::number(m_sandbox.pid()) : tr("-"))
+                      .arg(m_sandbox.events()).arg(m_sandbox.describe());
+    if (!m_sandbox.pages().empty())
+        message += tr(" | %1 page faults over %2 epochs").arg(m_sandbox.traceFaults()).arg(m_sandbox.traceEpoch());
+    statusBar()->showMessage(message);
+}
+
+// For arrays far too big to step through: the sort runs on a worker thread
+// at native speed and each frame draws a strided snapshot of it, or, for
+// algorithms without a plain version, every Nth of its events with a
+// snapshot at each. A native sort cannot be stopped, so a new run waits
+// for the last one to finish.
+void MainWindow::on_actionSortSampled_triggered()
+{
+    if (m_sampled.busy()) {
+        statusBar()->showMessage(tr("%1 is still sorting natively; start another once it is done")
+                                         .arg(QLatin1String(m_sampled.algorithm()->name)));
+        return;
+    }
+    QStringList names;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (!algorithm.unbounded)
+            names << QString::fromLatin1(algorithm.name);
+    }
+    bool ok = false;
+    const QString name = QInputDialog::getItem(this, tr("Sort at Full Speed"), tr("Algorithm:"), names,
+                                               names.indexOf(QStringLiteral("quick")), false, &ok);
+    if (!ok)
+        return;
+    const Sorts::Algorithm *algorithm = Sorts::findAlgorithm(name.toStdString());
+    SampledSort::Mode mode = SampledSort::Mode::EveryNth;
+    if (algorithm->native) {
+        const QStringList modes = { tr("Snapshots of a native run"), tr("Every 65536th event") };
+        const QString picked = QInputDialog::getItem(this, tr("Sort at Full Speed"), tr("Sampling:"), modes, 0, false, &ok);
+        if (!ok)
+            return;
+        mode = picked == modes.front() ? SampledSort::Mode::Native : SampledSort::Mode::EveryNth;
+    }
+
+    std::vector<int32_t> values;
+    if (m_dataset.kind() == Dataset::Kind::Array) {
+        values.assign(m_dataset.values(), m_dataset.values() + m_dataset.valueCount());
+    } else {
+        const int count = QInputDialog::getInt(this, tr("Sort at Full Speed"), tr("Random elements:"),
+                                               10000000, 2, std::numeric_limits<int>::max(), 1, &ok);
+        if (!ok)
+            return;
+        values = Sorts::makeInput(Sorts::Shape::Random, size_t(count), QRandomGenerator::global()->generate());
+    }
+
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    // Sampling one event in 2^16 keeps the stepper near its own full speed.
+    m_sampled.start(algorithm, std::move(values), mode, uint64_t(1) << 16);
+    m_sampledTimer.start();
+}
+
+void MainWindow::advanceSampled()
+{
+    const bool finished = m_sampled.finished();
+    if (finished)
+        m_sampledTimer.stop();
+    QImage &image = ui->centralwidget->image();
+    const size_t stride = m_sampled.snapshot(size_t(std::max(image.width(), 1280)), m_sampledSnapshot);
+
+    // Event indices are into the full array; the panel shows every stride-th.
+    const auto scaled = [stride](VisualEvent event) {
+        event.a = uint32_t(event.a / stride);
+        event.b = uint32_t(event.b / stride);
+        return event;
+    };
+    RaceView::Panel panel;
+    panel.values = m_sampledSnapshot;
+    panel.last = scaled(m_sampled.lastSample());
+    panel.range = scaled(m_sampled.range());
+    panel.active = !finished && m_sampled.mode() == SampledSort::Mode::EveryNth;
+    panel.finished = finished;
+    panel.title = tr("%1 / %2 elements, 1 in %3 shown").arg(QLatin1String(m_sampled.algorithm()->name))
+                  .arg(m_sampled.size()).arg(stride);
+    panel.status = tr("%1 s").arg(m_sampled.seconds(), 0, 'f', 2);
+    RaceView::render({ panel }, image, ui->centralwidget->pixelSize(), ui->centralwidget->devicePixelRatioF());
+    ui->centralwidget->update();
+
+    const QString how = m_sampled.mode() == SampledSort::Mode::Native
+            ? tr("native, snapshots only")
+            : tr("%1 events, 1 in 65536 sampled").arg(m_sampled.events());
+    const MemoryUsage::Profile *profile = m_sampled.profile();
+    QString heap = tr("heap peak %1 in %2 allocations").arg(QLocale().formattedDataSize(profile->peakBytes()))
+                   .arg(profile->allocations());
+    if (finished)
+        heap += QStringLiteral(" ") + heapSparkline(profile->timeline(), 24);
+    statusBar()->showMessage(tr("%1 on %2 elements: %3 s, %4, %5%6").arg(QLatin1String(m_sampled.algorithm()->name))
+                             .arg(m_sampled.size()).arg(m_sampled.seconds(), 0, 'f', 2).arg(how, heap)
+                             .arg(finished ? tr(", done") : QString()));
+}
+
+// Sample sort over local node processes, slowed down so that each round
+// can be followed: the exchange is stretched to a few seconds and the
+// nodes rest briefly between phases.
+void MainWindow::on_actionSortDistributed_triggered()
+{
+    bool ok = false;
+    const int nodes = QInputDialog::getInt(this, tr("Distributed Sort"), tr("Nodes:"), 4, 2,
+                                           DistributedSort::MaxNodes, 1, &ok);
+    if (!ok)
+        return;
+    std::vector<int32_t> values;
+    std::string input;
+    pickSortInput(values, input);
+
+    ui->actionLifeRun->setChecked(false);
+    stopAnimations();
+    DistributedSort::Options options;
+    options.nodes = nodes;
+    options.exchangeDuration = std::chrono::seconds(4);
+    options.phasePause = std::chrono::milliseconds(400);
+    options.chunkValues = std::max<size_t>(values.size() / size_t(nodes * 64), 1);
+    QString error;
+    if (!m_distributed.start(QCoreApplication::applicationFilePath(), values, options, &error)) {
+        QMessageBox::warning(this, tr("Distributed Sort"), error);
+        return;
+    }
+    m_distributedTimer.start();
+}
+
+void MainWindow::advanceDistributed()
+{
+    if (!m_distributed.poll())
+        m_distributedTimer.stop();
+    DistView::render(m_distributed, ui->centralwidget->image());
+    ui->centralwidget->update();
+
+    uint64_t total = 0;
+    for (int i = 0; i < m_distributed.nodes(); ++i)
+        total += m_distributed.local(i).size();
+    const QString state = m_distributed.failed() ? tr("failed") : m_distributed.done() ? tr("done") : tr("running");
+    statusBar()->showMessage(tr("%1 nodes, %2 values: %3 after %4 s | %5 values over sockets (%6%) | skew %7")
+                             .arg(m_distributed.nodes()).arg(total).arg(state)
+                             .arg(m_distributed.seconds(), 0, 'f', 2).arg(m_distributed.networkValues())
+                             .arg(total ? 100.0 * double(m_distributed.networkValues()) / double(total) : 0.0, 0, 'f', 1)
+                             .arg(m_distributed.skew(), 0, 'f', 2));
+}
+
+// Runs beside whatever is animating, which costs the sweep some accuracy
+// but keeps the two comparable: a hidden quadratic shows either way.
+void MainWindow::on_actionSortScaling_triggered()
+{
+    QStringList names;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (!algorithm.unbounded)
+            names << QString::fromLatin1(algorithm.name);
+    }
+    bool ok = false;
+    const QString name = QInputDialog::getItem(this, tr("Scaling Sweep"), tr("Algorithm:"), names,
+                                               names.indexOf(QStringLiteral("quick")), false, &ok);
+    if (!ok)
+        return;
+    QStringList shapes;
+    for (int i = 0; i < Sorts::ShapeCount; ++i)
+        shapes << QString::fromLatin1(Sorts::shapeName(Sorts::Shape(i)));
+    const QString shapeName = QInputDialog::getItem(this, tr("Scaling Sweep"), tr("Input:"), shapes, 0, false, &ok);
+    if (!ok)
+        return;
+    const int largest = QInputDialog::getInt(this, tr("Scaling Sweep"), tr("Largest n:"), 1 << 20, 512,
+                                             std::numeric_limits<int>::max(), 1, &ok);
+    if (!ok)
+        return;
+
+    Sorts::Shape shape = Sorts::Shape::Random;
+    Sorts::shapeFromName(shapeName.toStdString(), shape);
+    // A size that takes over two seconds ends the sweep; the next would
+    // take four or more.
+    m_sweep.start(Sorts::findAlgorithm(name.toStdString()), shape, 256, size_t(largest), 2000);
+    ui->scalingDock->setWindowTitle(tr("Scaling: %1 on %2").arg(name, shapeName));
+    ui->scalingView->setMeasurements({});
+    ui->scalingDock->show();
+    m_sweepTimer.start();
+}
+
+void MainWindow::advanceSweep()
+{
+    std::vector<Complexity::Measurement> measurements = m_sweep.measurements();
+    const bool running = m_sweep.running();
+    if (!running)
+        m_sweepTimer.stop();
+    if (!measurements.empty()) {
+        statusBar()->showMessage(tr("Scaling sweep %1: n = %2 took %3 ms")
+                                 .arg(running ? tr("running") : tr("done"))
+                                 .arg(measurements.back().n)
+                                 .arg(measurements.back().ms, 0, 'f', 2));
+    }
+    ui->scalingView->setMeasurements(std::move(measurements));
+}
+
+void MainWindow::on_actionSortWorstCase_triggered()
+{
+    QStringList names;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (!algorithm.unbounded)
+            names << QString::fromLatin1(algorithm.name);
+    }
+    bool ok = false;
+    const QString name = QInputDialog::getItem(this, tr("Find Worst Case"), tr("Algorithm:"), names,
+                                               names.indexOf(QStringLiteral("quick")), false, &ok);
+    if (!ok)
+        return;
+    const QStringList methods = { tr("McIlroy's adversary (comparison sorts)"), tr("Genetic search") };
+    const QString method = QInputDialog::getItem(this, tr("Find Worst Case"), tr("Method:"), methods, 0, false, &ok);
+    if (!ok)
+        return;
+    const bool adversary = method == methods.front();
+    // The adversary is quadratic, so it gets fewer elements.
+    const int size = QInputDialog::getInt(this, tr("Find Worst Case"), tr("Elements:"), 2048, 2,
+                                          adversary ? 1 << 14 : 1 << 16, 1, &ok);
+    if (!ok)
+        return;
+
+    Adversary::SearchOptions options;
+    options.size = size_t(size);
+    options.seed = QRandomGenerator::global()->generate();
+    m_search.start(Sorts::findAlgorithm(name.toStdString()),
+                   adversary ? Adversary::BackgroundSearch::Method::AntiSort
+                             : Adversary::BackgroundSearch::Method::Genetic,
+                   options);
+    m_searchTimer.start();
+}
+
+void MainWindow::advanceSearch()
+{
+    const bool adversary = m_search.method() == Adversary::BackgroundSearch::Method::AntiSort;
+    if (m_search.running()) {
+        const QString name = QString::fromLatin1(m_search.algorithm()->name);
+        statusBar()->showMessage(adversary ? tr("Running McIlroy's adversary against %1").arg(name)
+                                           : tr("Searching for a worst case of %1: generation %2, %3 operations")
+                                                 .arg(name).arg(m_search.generation()).arg(m_search.best(), 0, 'f', 0));
+        return;
+    }
+    m_searchTimer.stop();
+    showWorstCase(m_search.algorithm(), m_search.result(), adversary ? tr("adversary") : tr("genetic search"));
+}
+
+// The input becomes the dataset, so every sort action uses it from here
+// on, and is played straight away on the algorithm it was found for.
+void MainWindow::showWorstCase(const Sorts::Algorithm *algorithm, Adversary::SearchResult result, const QString &method)
+{
+    if (result.input.empty())
+        return;
+    m_dataset = Dataset::fromValues(std::move(result.input));
+    playSort(algorithm);
+    m_playerInput = tr("%1 worst case, %2x random").arg(method)
+                        .arg(result.typical > 0 ? result.score / result.typical : 0.0, 0, 'f', 1);
+}
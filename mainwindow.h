@@ -1,7 +1,27 @@
 #ifndef MAINWINDOW_H
 #define MAINWINDOW_H
 
+#include "adversary.h"
+#include "complexity.h"
+#include "compressionview.h"
+#include "dataset.h"
+#include "distsort.h"
+#include "hashlife.h"
+#include "imagepipeline.h"
+#include "labeling.h"
+#include "lifeboard.h"
+#include "sampledsort.h"
+#include "sandbox.h"
+#include "snapshotcache.h"
+#include "sortrace.h"
+#include "traceanalysis.h"
+#include "traceplayer.h"
+
 #include <QMainWindow>
+#include <QSlider>
+#include <QTimer>
+
+#include <memory>
 
 QT_BEGIN_NAMESPACE
 namespace Ui { class MainWindow; }
@@ -15,7 +35,142 @@ public:
     MainWindow(QWidget *parent = nullptr);
     ~MainWindow();
 
+private slots:
+    void on_actionOpen_triggered();
+
+    void on_actionLifeRun_toggled(bool running);
+    void on_actionLifeStep_triggered();
+    void on_actionLifeRandomize_triggered();
+    void on_actionLifeBoardSize_triggered();
+    void on_actionLifeFaster_triggered();
+    void on_actionLifeSlower_triggered();
+    void on_actionLifeHashLife_toggled(bool enabled);
+
+    void advanceLife();
+
+    void on_actionOpenImage_triggered();
+    void on_actionLabelTwoPass_triggered();
+    void on_actionLabelParallel_triggered();
+    void startFloodFill(const QPoint &pixel);
+    void advanceFloodFill();
+
+    void on_actionPipeline_triggered();
+    void advancePipelineTrace();
+
+    void on_actionCompressionOpen_triggered();
+    void on_actionCompressHashChain_triggered();
+    void on_actionCompressBinaryTree_triggered();
+    void on_actionCompressHuffman_triggered();
+    void on_actionCompressRans_triggered();
+    void advanceCompression();
+
+    void on_actionSortRace_triggered();
+    void on_actionSortDataset_triggered();
+    void on_actionSortSize_triggered();
+    void on_actionSortFaster_triggered();
+    void on_actionSortSlower_triggered();
+    void advanceRace();
+
+    void on_actionSortPlay_triggered();
+    void on_actionSortPause_toggled(bool paused);
+    void on_actionSortStepBack_triggered();
+    void on_actionSortStepForward_triggered();
+    void seekPlayer(int position);
+    void advancePlayer();
+    void on_actionSortAnalyze_triggered();
+    void advanceAnalysis();
+    void on_actionSortSortedness_toggled(bool checked);
+
+    void on_actionSortSandbox_triggered();
+    void advanceSandbox();
+
+    void on_actionSortSampled_triggered();
+    void advanceSampled();
+
+    void on_actionSortDistributed_triggered();
+    void advanceDistributed();
+
+    void on_actionSortScaling_triggered();
+    void advanceSweep();
+
+    void on_actionSortWorstCase_triggered();
+    void advanceSearch();
+
 private:
+    void renderLife();
+    void showLabels(bool parallel);
+    void stopAnimations();
+    void startCompression(CompressionView::Mode mode);
+    void startRace();
+    void pickSortInput(std::vector<int32_t> &values, std::string &input) const;
+    void stepPlayer(int64_t delta);
+    void playSort(const Sorts::Algorithm *algorithm);
+    void showWorstCase(const Sorts::Algorithm *algorithm, Adversary::SearchResult result, const QString &method);
+
     Ui::MainWindow *ui;
+    SnapshotCache m_snapshots;
+    Dataset m_dataset;
+
+    LifeBoard m_life;
+    HashLife m_hashLife;
+    bool m_useHashLife = false;
+    uint64_t m_generationsPerTick = 1;
+    double m_lastStepMs = 0;
+    QTimer m_lifeTimer;
+
+    Mask m_mask;
+    std::unique_ptr<ScanlineFill> m_fill;
+    std::vector<ScanlineFill::Span> m_filledSpans;
+    uint8_t m_nextFillValue = 2;
+    QTimer m_fillTimer;
+
+    Mask m_gray;
+    Mask m_pipelineResult;
+    std::vector<ImagePipeline::TraceEntry> m_pipelineTrace;
+    size_t m_traceShown = 0;
+    int m_pipelineStages = 0;
+    QString m_pipelineSummary;
+    QTimer m_traceTimer;
+
+    std::vector<uint8_t> m_compressionInput;
+    QString m_compressionName;
+    QString m_compressionSummary;
+    CompressionView m_compression;
+    QTimer m_compressionTimer;
+
+    SortRace m_race;
+    size_t m_raceSize = 256;
+    uint64_t m_raceEventsPerFrame = 16;
+    QTimer m_raceTimer;
+
+    TracePlayer m_player;
+    uint64_t m_playerTarget = 0;
+    QString m_playerInput;
+    QSlider *m_playerSlider = nullptr;
+    QTimer m_playerTimer;
+    std::vector<double> m_inversionTrail; // fraction of the most, per frame
+
+    TraceAnalysis::BackgroundAnalysis m_analysis;
+    TraceAnalysis::Result m_traceStats;
+    TraceAnalysis::Heat m_heat = TraceAnalysis::Heat::Accesses;
+    QTimer m_analysisTimer;
+
+    Sandbox m_sandbox;
+    QString m_sandboxName;
+    uint64_t m_sandboxAllowance = 0;
+    QTimer m_sandboxTimer;
+
+    SampledSort m_sampled;
+    std::vector<int32_t> m_sampledSnapshot;
+    QTimer m_sampledTimer;
+
+    DistributedSort m_distributed;
+    QTimer m_distributedTimer;
+
+    Complexity::Sweep m_sweep;
+    QTimer m_sweepTimer;
+
+    Adversary::BackgroundSearch m_search;
+    QTimer m_searchTimer;
 };
 #endif // MAINWINDOW_H
@@ -0,0 +1,170 @@
+#include "memoryusage.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cstdlib>
+#include <new>
+
+namespace {
+
+std::atomic<size_t> g_current { 0 };
+std::atomic<size_t> g_peak { 0 };
+
+// The block size is kept in front of every block, padded so that what
+// follows keeps operator new's alignment.
+constexpr size_t HeaderBytes = __STDCPP_DEFAULT_NEW_ALIGNMENT__;
+
+thread_local MemoryUsage::Profile *t_profile = nullptr;
+
+uint64_t nowNs()
+{
+    return uint64_t(std::chrono::duration_cast<std::chrono::nanoseconds>(
+                            std::chrono::steady_clock::now().time_since_epoch()).count());
+}
+
+} // namespace
+
+namespace MemoryUsage {
+
+size_t current()
+{
+    return g_current.load(std::memory_order_relaxed);
+}
+
+size_t peak()
+{
+    return g_peak.load(std::memory_order_relaxed);
+}
+
+void resetPeak()
+{
+    g_peak.store(current(), std::memory_order_relaxed);
+}
+
+// The samples are reserved up front: record() runs inside operator new and
+// must not allocate itself.
+Profile::Profile(size_t maxSamples)
+    : m_maxSamples(std::max<size_t>(maxSamples, 2))
+{
+    m_samples.reserve(m_maxSamples);
+}
+
+Profile::~Profile()
+{
+    detach();
+}
+
+void Profile::attach()
+{
+    detach();
+    m_bytes.store(0, std::memory_order_relaxed);
+    m_peak.store(0, std::memory_order_relaxed);
+    m_allocations.store(0, std::memory_order_relaxed);
+    m_frees.store(0, std::memory_order_relaxed);
+    m_allocatedBytes.store(0, std::memory_order_relaxed);
+    m_samples.clear();
+    m_stride = 1;
+    m_windowEvents = 0;
+    m_windowPeak = std::numeric_limits<int64_t>::min();
+    m_startNs = nowNs();
+    t_profile = this;
+}
+
+void Profile::detach()
+{
+    if (t_profile != this)
+        return;
+    t_profile = nullptr;
+    if (m_windowEvents > 0)
+        addSample();
+}
+
+Profile *Profile::active()
+{
+    return t_profile;
+}
+
+void Profile::record(int64_t delta)
+{
+    while (m_recording.test_and_set(std::memory_order_acquire)) {
+    }
+    const int64_t now = m_bytes.load(std::memory_order_relaxed) + delta;
+    m_bytes.store(now, std::memory_order_relaxed);
+    if (delta > 0) {
+        m_allocations.store(m_allocations.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+        m_allocatedBytes.store(m_allocatedBytes.load(std::memory_order_relaxed) + uint64_t(delta),
+                               std::memory_order_relaxed);
+        if (now > m_peak.load(std::memory_order_relaxed))
+            m_peak.store(now, std::memory_order_relaxed);
+    } else {
+        m_frees.store(m_frees.load(std::memory_order_relaxed) + 1, std::memory_order_relaxed);
+    }
+    m_windowPeak = std::max(m_windowPeak, now);
+    if (++m_windowEvents == m_stride)
+        addSample();
+    m_recording.clear(std::memory_order_release);
+}
+
+void Profile::addSample()
+{
+    if (m_samples.size() == m_maxSamples) {
+        for (size_t i = 0; i < m_samples.size() / 2; ++i) {
+            const Sample &first = m_samples[2 * i];
+            const Sample &second = m_samples[2 * i + 1];
+            m_samples[i] = { second.nanoseconds, std::max(first.bytes, second.bytes) };
+        }
+        if (m_samples.size() % 2)
+            m_samples[m_samples.size() / 2] = m_samples.back();
+        m_samples.resize((m_samples.size() + 1) / 2);
+        m_stride *= 2;
+    }
+    m_samples.push_back({ nowNs() - m_startNs, m_windowPeak });
+    m_windowEvents = 0;
+    m_windowPeak = std::numeric_limits<int64_t>::min();
+}
+
+ProfileScope::ProfileScope(Profile *profile)
+    : m_previous(t_profile)
+{
+    t_profile = profile;
+}
+
+ProfileScope::~ProfileScope()
+{
+    t_profile = m_previous;
+}
+
+} // namespace MemoryUsage
+
+// The array forms and the nothrow and sized variants all end up here.
+void *operator new(std::size_t bytes)
+{
+    char *block = static_cast<char *>(std::malloc(bytes + HeaderBytes));
+    if (!block)
+        throw std::bad_alloc();
+    *reinterpret_cast<size_t *>(block) = bytes;
+    const size_t now = g_current.fetch_add(bytes, std::memory_order_relaxed) + bytes;
+    size_t highest = g_peak.load(std::memory_order_relaxed);
+    while (now > highest && !g_peak.compare_exchange_weak(highest, now, std::memory_order_relaxed)) {
+    }
+    if (MemoryUsage::Profile *profile = t_profile)
+        profile->record(int64_t(bytes));
+    return block + HeaderBytes;
+}
+
+void operator delete(void *pointer) noexcept
+{
+    if (!pointer)
+        return;
+    char *block = static_cast<char *>(pointer) - HeaderBytes;
+    const size_t bytes = *reinterpret_cast<size_t *>(block);
+    g_current.fetch_sub(bytes, std::memory_order_relaxed);
+    if (MemoryUsage::Profile *profile = t_profile)
+        profile->record(-int64_t(bytes));
+    std::free(block);
+}
+
+void operator delete(void *pointer, std::size_t) noexcept
+{
+    operator delete(pointer);
+}
@@ -0,0 +1,99 @@
+#ifndef MEMORYUSAGE_H
+#define MEMORYUSAGE_H
+
+#include <atomic>
+#include <cstddef>
+#include <cstdint>
+#include <limits>
+#include <span>
+#include <vector>
+
+// Heap use as seen by a replacement global operator new, which records the
+// size of every block so delete can give it back. malloc() and Qt's own
+// containers go around it; the algorithms allocate through std::vector and
+// coroutine frames, which do not.
+namespace MemoryUsage {
+
+// Bytes allocated with operator new and not yet freed.
+size_t current();
+// The highest current() has been since the last resetPeak().
+size_t peak();
+void resetPeak();
+
+// What one thread allocates and frees while the profile is attached to it,
+// with a timeline of the bytes it had in use. Parallel::forRange carries the
+// profile over to the pool workers that run the thread's tasks, so a sort
+// that allocates on the pool is counted whole. The counters can be read
+// from any thread as it goes, the timeline once it has detached. A block
+// freed on a thread the profile is not on is not seen as freed.
+class Profile
+{
+public:
+    struct Sample
+    {
+        uint64_t nanoseconds; // since attach()
+        int64_t bytes; // the most in use since the previous sample
+    };
+
+    // Past maxSamples, neighbouring samples are merged pairwise and only
+    // every other event is sampled from then on, so the timeline covers
+    // the whole run at a falling resolution.
+    explicit Profile(size_t maxSamples = 1024);
+    Profile(const Profile &) = delete;
+    Profile &operator=(const Profile &) = delete;
+    ~Profile();
+
+    // Both on the thread being profiled. attach() starts over.
+    void attach();
+    void detach();
+    // The profile attached to the calling thread, or carried over to it.
+    static Profile *active();
+
+    // Negative if the thread frees more than it allocates.
+    int64_t bytes() const { return m_bytes.load(std::memory_order_relaxed); }
+    int64_t peakBytes() const { return m_peak.load(std::memory_order_relaxed); }
+    uint64_t allocations() const { return m_allocations.load(std::memory_order_relaxed); }
+    uint64_t frees() const { return m_frees.load(std::memory_order_relaxed); }
+    uint64_t allocatedBytes() const { return m_allocatedBytes.load(std::memory_order_relaxed); }
+    std::span<const Sample> timeline() const { return m_samples; }
+
+    // For operator new and delete: bytes allocated (> 0) or freed (< 0).
+    // Threads sharing the profile take turns.
+    void record(int64_t delta);
+
+private:
+    void addSample();
+
+    std::atomic_flag m_recording;
+
+    std::atomic<int64_t> m_bytes { 0 };
+    std::atomic<int64_t> m_peak { 0 };
+    std::atomic<uint64_t> m_allocations { 0 };
+    std::atomic<uint64_t> m_frees { 0 };
+    std::atomic<uint64_t> m_allocatedBytes { 0 };
+
+    size_t m_maxSamples;
+    std::vector<Sample> m_samples;
+    uint64_t m_startNs = 0;
+    uint64_t m_stride = 1;
+    uint64_t m_windowEvents = 0;
+    int64_t m_windowPeak = std::numeric_limits<int64_t>::min();
+};
+
+// Counts the calling thread's allocations into profile, which may be null,
+// for as long as it lives, without starting the profile over.
+class ProfileScope
+{
+public:
+    explicit ProfileScope(Profile *profile);
+    ProfileScope(const ProfileScope &) = delete;
+    ProfileScope &operator=(const ProfileScope &) = delete;
+    ~ProfileScope();
+
+private:
+    Profile *m_previous;
+};
+
+} // namespace MemoryUsage
+
+#endif // MEMORYUSAGE_H
@@ -0,0 +1,119 @@
+#include "mergepath.h"
+
+#include "parallel.h"
+#include "sorts.h"
+#include "tuning.h"
+
+#include <algorithm>
+#include <vector>
+
+namespace MergePath {
+
+namespace {
+
+// Enough pieces per thread to even out the ones that get descheduled.
+constexpr size_t PiecesPerThread = 4;
+
+// Below the tuned piece size, work is not worth handing to another thread.
+size_t minPiece()
+{
+    return Tuning::current().mergePiece;
+}
+
+size_t pieceCount(size_t size)
+{
+    return std::clamp<size_t>(size / minPiece(), 1, size_t(Parallel::threadCount()) * PiecesPerThread);
+}
+
+} // namespace
+
+// a[i] is among the first diagonal outputs if it is not greater than the b
+// value it would otherwise have to follow, b[diagonal - i - 1].
+size_t split(std::span<const int32_t> a, std::span<const int32_t> b, size_t diagonal)
+{
+    size_t low = diagonal > b.size() ? diagonal - b.size() : 0;
+    size_t high = std::min(diagonal, a.size());
+    while (low < high) {
+        const size_t middle = low + (high - low) / 2;
+        if (b[diagonal - middle - 1] < a[middle])
+            high = middle;
+        else
+            low = middle + 1;
+    }
+    return low;
+}
+
+void mergeRange(std::span<const int32_t> a, std::span<const int32_t> b, size_t begin, size_t end,
+                std::span<int32_t> out)
+{
+    const size_t aBegin = split(a, b, begin);
+    const size_t aEnd = split(a, b, end);
+    std::merge(a.begin() + aBegin, a.begin() + aEnd, b.begin() + (begin - aBegin), b.begin() + (end - aEnd),
+               out.begin());
+}
+
+void merge(std::span<const int32_t> a, std::span<const int32_t> b, std::span<int32_t> out)
+{
+    const size_t size = a.size() + b.size();
+    const size_t pieces = pieceCount(size);
+    Parallel::forRange(0, pieces, 1, [&](size_t first, size_t last) {
+        for (size_t piece = first; piece < last; ++piece) {
+            const size_t begin = size * piece / pieces;
+            const size_t end = size * (piece + 1) / pieces;
+            mergeRange(a, b, begin, end, out.subspan(begin, end - begin));
+        }
+    });
+}
+
+// A pass merges neighbouring runs of width values from one buffer into the
+// other. Its output is cut into pieces without regard to where runs start
+// and end, so a piece may finish one merge and begin the next; the many
+// small merges of the early passes and the single big one of the last
+// spread over the threads alike.
+void sort(std::span<int32_t> values)
+{
+    const size_t size = values.size();
+    if (size < 2)
+        return;
+    const size_t blocks = std::min<size_t>(Parallel::threadCount(), (size + minPiece() - 1) / minPiece());
+    const size_t blockSize = (size + blocks - 1) / blocks;
+    Parallel::forRange(0, blocks, 1, [&](size_t first, size_t last) {
+        for (size_t block = first; block < last; ++block) {
+            const auto begin = values.begin() + std::min(size, block * blockSize);
+            std::stable_sort(begin, values.begin() + std::min(size, (block + 1) * blockSize));
+        }
+    });
+    if (blocks == 1)
+        return;
+    Sorts::checkpoint(values);
+
+    std::vector<int32_t> scratch(size);
+    std::span<int32_t> from = values;
+    std::span<int32_t> to = scratch;
+    const size_t pieces = pieceCount(size);
+    for (size_t width = blockSize; width < size; width *= 2) {
+        Parallel::forRange(0, pieces, 1, [&](size_t first, size_t last) {
+            for (size_t piece = first; piece < last; ++piece) {
+                const size_t end = size * (piece + 1) / pieces;
+                for (size_t out = size * piece / pieces; out < end;) {
+                    const size_t runBegin = out / (2 * width) * (2 * width);
+                    const size_t middle = std::min(runBegin + width, size);
+                    const size_t runEnd = std::min(runBegin + 2 * width, size);
+                    const size_t stop = std::min(end, runEnd);
+                    mergeRange(from.subspan(runBegin, middle - runBegin), from.subspan(middle, runEnd - middle),
+                               out - runBegin, stop - runBegin, to.subspan(out, stop - out));
+                    out = stop;
+                }
+            }
+        });
+        std::swap(from, to);
+        Sorts::checkpoint(from);
+    }
+    if (from.data() != values.data()) {
+        Parallel::forRange(0, size, minPiece(), [&](size_t begin, size_t end) {
+            std::copy(from.begin() + begin, from.begin() + end, values.begin() + begin);
+        });
+    }
+}
+
+} // namespace MergePath
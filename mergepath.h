@@ -0,0 +1,34 @@
+#ifndef MERGEPATH_H
+#define MERGEPATH_H
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+
+// Merge path partitioning: output position d of merging a and b is reached
+// after taking some i elements of a and d - i of b, and i can be found by a
+// binary search along that diagonal without merging anything. Cutting the
+// output into equal pieces this way gives every thread the same amount of
+// merging, however the values are distributed, so the last passes of a
+// merge sort use all cores instead of one.
+//
+// Merges are stable: on equal values, a comes first.
+namespace MergePath {
+
+// How many of the first diagonal merged outputs come from a.
+size_t split(std::span<const int32_t> a, std::span<const int32_t> b, size_t diagonal);
+// Writes outputs [begin, end) of the merge of a and b to out, which must
+// hold end - begin values.
+void mergeRange(std::span<const int32_t> a, std::span<const int32_t> b, size_t begin, size_t end,
+                std::span<int32_t> out);
+// out holds a.size() + b.size() values and overlaps neither input.
+void merge(std::span<const int32_t> a, std::span<const int32_t> b, std::span<int32_t> out);
+
+// Stable merge sort on the Parallel pool: blocks sorted one per thread,
+// then bottom-up passes, each cut into equal-work pieces across all the
+// runs being merged.
+void sort(std::span<int32_t> values);
+
+} // namespace MergePath
+
+#endif // MERGEPATH_H
@@ -0,0 +1,147 @@
+#include "pagetracer.h"
+
+#include <QtGlobal>
+
+#ifdef Q_OS_UNIX
+#include <signal.h>
+#include <sys/mman.h>
+#include <unistd.h>
+#endif
+
+#ifdef Q_OS_UNIX
+
+// The process-wide side: one tracer at a time, and the handlers it
+// displaced, which get every fault outside the traced region.
+struct PageTracer::Handler
+{
+    static inline std::atomic<PageTracer *> active { nullptr };
+    static inline struct sigaction previousSegv;
+    static inline struct sigaction previousBus;
+
+    static void onFault(int signal, siginfo_t *info, void *context)
+    {
+        PageTracer *tracer = active.load(std::memory_order_acquire);
+        if (tracer && tracer->handle(info->si_addr))
+            return;
+        const struct sigaction &previous = signal == SIGBUS ? previousBus : previousSegv;
+        if ((previous.sa_flags & SA_SIGINFO) && previous.sa_sigaction) {
+            previous.sa_sigaction(signal, info, context);
+        } else if (previous.sa_handler != SIG_DFL && previous.sa_handler != SIG_IGN) {
+            previous.sa_handler(signal);
+        } else {
+            // Returning retries the access, which now gets the default action.
+            struct sigaction fallback = {};
+            fallback.sa_handler = SIG_DFL;
+            sigaction(signal, &fallback, nullptr);
+        }
+    }
+};
+
+size_t PageTracer::pageSize()
+{
+    return size_t(sysconf(_SC_PAGESIZE));
+}
+
+bool PageTracer::start(void *region, size_t bytes, std::span<Page> pages, Counters *counters,
+                       std::chrono::microseconds interval)
+{
+    stop();
+    m_pageSize = pageSize();
+    if (reinterpret_cast<uintptr_t>(region) % m_pageSize || bytes == 0
+        || pages.size() < (bytes + m_pageSize - 1) / m_pageSize) {
+        return false;
+    }
+    PageTracer *expected = nullptr;
+    if (!Handler::active.compare_exchange_strong(expected, this))
+        return false;
+
+    m_region = static_cast<char *>(region);
+    m_bytes = bytes;
+    m_pages = pages;
+    m_counters = counters;
+    m_interval = interval;
+
+    struct sigaction action = {};
+    action.sa_sigaction = Handler::onFault;
+    action.sa_flags = SA_SIGINFO | SA_RESTART;
+    sigemptyset(&action.sa_mask);
+    sigaction(SIGSEGV, &action, &Handler::previousSegv);
+    sigaction(SIGBUS, &action, &Handler::previousBus);
+
+    m_stopping = false;
+    m_counters->epoch.store(1, std::memory_order_relaxed);
+    mprotect(m_region, m_bytes, PROT_NONE);
+    m_rearm = std::thread(&PageTracer::rearmLoop, this);
+    return true;
+}
+
+void PageTracer::stop()
+{
+    if (!m_region)
+        return;
+    {
+        std::lock_guard<std::mutex> lock(m_mutex);
+        m_stopping = true;
+    }
+    m_wake.notify_all();
+    m_rearm.join();
+    mprotect(m_region, m_bytes, PROT_READ | PROT_WRITE);
+    sigaction(SIGSEGV, &Handler::previousSegv, nullptr);
+    sigaction(SIGBUS, &Handler::previousBus, nullptr);
+    Handler::active.store(nullptr, std::memory_order_release);
+    m_region = nullptr;
+}
+
+// Runs in the signal handler: atomics and mprotect() only.
+bool PageTracer::handle(const void *address)
+{
+    const char *byte = static_cast<const char *>(address);
+    if (byte < m_region || byte >= m_region + m_bytes)
+        return false;
+    const size_t page = size_t(byte - m_region) / m_pageSize;
+    m_pages[page].touches.fetch_add(1, std::memory_order_relaxed);
+    m_pages[page].lastEpoch.store(m_counters->epoch.load(std::memory_order_relaxed), std::memory_order_relaxed);
+    m_counters->faults.fetch_add(1, std::memory_order_relaxed);
+    return mprotect(m_region + page * m_pageSize, m_pageSize, PROT_READ | PROT_WRITE) == 0;
+}
+
+void PageTracer::rearmLoop()
+{
+    std::unique_lock<std::mutex> lock(m_mutex);
+    while (!m_wake.wait_for(lock, m_interval, [this] { return m_stopping; })) {
+        m_counters->epoch.fetch_add(1, std::memory_order_relaxed);
+        mprotect(m_region, m_bytes, PROT_NONE);
+    }
+}
+
+#else
+
+size_t PageTracer::pageSize()
+{
+    return 4096;
+}
+
+bool PageTracer::start(void *, size_t, std::span<Page>, Counters *, std::chrono::microseconds)
+{
+    return false;
+}
+
+void PageTracer::stop()
+{
+}
+
+bool PageTracer::handle(const void *)
+{
+    return false;
+}
+
+void PageTracer::rearmLoop()
+{
+}
+
+#endif
+
+PageTracer::~PageTracer()
+{
+    stop();
+}
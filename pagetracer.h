@@ -0,0 +1,74 @@
+#ifndef PAGETRACER_H
+#define PAGETRACER_H
+
+#include <atomic>
+#include <chrono>
+#include <condition_variable>
+#include <cstddef>
+#include <cstdint>
+#include <mutex>
+#include <span>
+#include <thread>
+
+// Records which pages of a memory region code touches, without the code's
+// cooperation: the region is protected with PROT_NONE, and the first access
+// to each page faults into a handler that counts it and opens the page up.
+// A background thread closes the whole region again every interval, which
+// starts a new epoch, so every page costs at most one fault per epoch and
+// the overhead stays bounded however hard the code hammers the array.
+//
+// A page's touch count is then roughly how many intervals the code spent
+// on it, and the epoch it was last touched in orders the pages by recency.
+// Accesses made by the kernel, say a read() into the region, are not seen:
+// they fail with EFAULT rather than fault, so keep I/O out of traced code.
+//
+// The region must be page aligned and normally readable and writable. Only
+// one tracer can be active per process. POSIX only; start() fails elsewhere.
+class PageTracer
+{
+public:
+    struct Page
+    {
+        std::atomic<uint32_t> touches;
+        std::atomic<uint32_t> lastEpoch;
+    };
+
+    struct Counters
+    {
+        std::atomic<uint32_t> epoch;
+        std::atomic<uint64_t> faults;
+    };
+
+    static size_t pageSize();
+
+    PageTracer() = default;
+    PageTracer(const PageTracer &) = delete;
+    PageTracer &operator=(const PageTracer &) = delete;
+    ~PageTracer();
+
+    // pages needs one entry per page of the region. Both it and counters
+    // may live in shared memory, for another process to read as they fill.
+    bool start(void *region, size_t bytes, std::span<Page> pages, Counters *counters,
+               std::chrono::microseconds interval);
+    void stop();
+
+private:
+    struct Handler;
+
+    bool handle(const void *address);
+    void rearmLoop();
+
+    char *m_region = nullptr;
+    size_t m_bytes = 0;
+    size_t m_pageSize = 0;
+    std::span<Page> m_pages;
+    Counters *m_counters = nullptr;
+    std::chrono::microseconds m_interval { 0 };
+
+    std::thread m_rearm;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    bool m_stopping = false;
+};
+
+#endif // PAGETRACER_H
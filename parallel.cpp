@@ -0,0 +1,198 @@
+#include "parallel.h"
+
+#include "memoryusage.h"
+
+#include <algorithm>
+#include <atomic>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#ifdef __linux__
+#include <pthread.h>
+#include <sched.h>
+#endif
+
+namespace {
+
+thread_local bool t_insidePool = false;
+thread_local int t_workerIndex = 0;
+
+class Pool
+{
+public:
+    static Pool &instance()
+    {
+        static Pool pool;
+        return pool;
+    }
+
+    int hardwareThreads() const { return int(m_workers.size()) + 1; }
+
+    bool pin(const std::vector<int> &cpus)
+    {
+#ifdef __linux__
+        if (cpus.empty() || std::any_of(cpus.begin(), cpus.end(), [](int cpu) { return cpu < 0 || cpu >= CPU_SETSIZE; }))
+            return false;
+        const auto bind = [&](pthread_t thread, size_t index) {
+            cpu_set_t set;
+            CPU_ZERO(&set);
+            CPU_SET(cpus[index % cpus.size()], &set);
+            return pthread_setaffinity_np(thread, sizeof(set), &set) == 0;
+        };
+        bool ok = bind(pthread_self(), 0);
+        for (size_t i = 0; i < m_workers.size(); ++i)
+            ok = bind(m_workers[i].native_handle(), i + 1) && ok;
+        return ok;
+#else
+        (void)cpus;
+        return false;
+#endif
+    }
+
+    int limit() const { return m_limit.load(std::memory_order_relaxed); }
+    void setLimit(int count) { m_limit.store(std::clamp(count, 1, hardwareThreads())); }
+
+    void run(size_t begin, size_t end, size_t grain,
+             const std::function<void(size_t, size_t)> &body)
+    {
+        const int threads = std::min<size_t>(limit(), (end - begin + grain - 1) / grain);
+        std::unique_lock<std::mutex> submit(m_submit, std::defer_lock);
+        if (t_insidePool || threads <= 1 || !submit.try_lock()) {
+            for (size_t chunk = begin; chunk < end; chunk += grain)
+                body(chunk, std::min(chunk + grain, end));
+            return;
+        }
+
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_body = &body;
+            m_profile = MemoryUsage::Profile::active();
+            m_end = end;
+            m_grain = grain;
+            m_next.store(begin, std::memory_order_relaxed);
+            m_participants = threads - 1;
+            m_active = threads - 1;
+            ++m_generation;
+        }
+        m_wake.notify_all();
+
+        t_insidePool = true;
+        work();
+        t_insidePool = false;
+
+        std::unique_lock<std::mutex> lock(m_mutex);
+        m_done.wait(lock, [this] { return m_active == 0; });
+        m_body = nullptr;
+    }
+
+private:
+    Pool()
+    {
+        const int workers = std::max(1u, std::thread::hardware_concurrency()) - 1;
+        m_limit = workers + 1;
+        for (int i = 0; i < workers; ++i)
+            m_workers.emplace_back([this, i] { workerLoop(i); });
+    }
+
+    ~Pool()
+    {
+        {
+            std::lock_guard<std::mutex> lock(m_mutex);
+            m_stop = true;
+        }
+        m_wake.notify_all();
+        for (std::thread &worker : m_workers)
+            worker.join();
+    }
+
+    void work()
+    {
+        for (;;) {
+            const size_t chunk = m_next.fetch_add(m_grain, std::memory_order_relaxed);
+            if (chunk >= m_end)
+                return;
+            (*m_body)(chunk, std::min(chunk + m_grain, m_end));
+        }
+    }
+
+    void workerLoop(int index)
+    {
+        t_insidePool = true;
+        t_workerIndex = index + 1;
+        uint64_t seen = 0;
+        std::unique_lock<std::mutex> lock(m_mutex);
+        for (;;) {
+            m_wake.wait(lock, [&] { return m_stop || m_generation != seen; });
+            if (m_stop)
+                return;
+            seen = m_generation;
+            if (index >= m_participants)
+                continue;
+
+            MemoryUsage::Profile *profile = m_profile;
+            lock.unlock();
+            {
+                const MemoryUsage::ProfileScope scope(profile);
+                work();
+            }
+            lock.lock();
+            if (--m_active == 0)
+                m_done.notify_one();
+        }
+    }
+
+    std::vector<std::thread> m_workers;
+    std::atomic<int> m_limit { 1 };
+
+    std::mutex m_submit;
+    std::mutex m_mutex;
+    std::condition_variable m_wake;
+    std::condition_variable m_done;
+    uint64_t m_generation = 0;
+    int m_participants = 0;
+    int m_active = 0;
+    bool m_stop = false;
+
+    const std::function<void(size_t, size_t)> *m_body = nullptr;
+    // The caller's, for the workers to count their allocations into.
+    MemoryUsage::Profile *m_profile = nullptr;
+    size_t m_end = 0;
+    size_t m_grain = 1;
+    std::atomic<size_t> m_next { 0 };
+};
+
+} // namespace
+
+namespace Parallel {
+
+int threadCount()
+{
+    return Pool::instance().limit();
+}
+
+void setThreadCount(int count)
+{
+    Pool::instance().setLimit(count);
+}
+
+int workerIndex()
+{
+    return t_workerIndex;
+}
+
+bool pinThreads(const std::vector<int> &cpus)
+{
+    return Pool::instance().pin(cpus);
+}
+
+void forRange(size_t begin, size_t end, size_t grain,
+              const std::function<void(size_t, size_t)> &body)
+{
+    if (begin >= end)
+        return;
+    Pool::instance().run(begin, end, std::max<size_t>(grain, 1), body);
+}
+
+} // namespace Parallel
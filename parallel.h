@@ -0,0 +1,33 @@
+#ifndef PARALLEL_H
+#define PARALLEL_H
+
+#include <cstddef>
+#include <functional>
+#include <vector>
+
+// Minimal fork-join helper shared by the simulation and image kernels. A
+// fixed pool of workers is started on first use; the calling thread takes
+// part in the work, and nested calls from inside a worker run serially.
+namespace Parallel {
+
+int threadCount();
+// Caps the number of threads used by subsequent calls (1 = serial). Values
+// above the hardware concurrency are clamped.
+void setThreadCount(int count);
+// 0 on the calling thread, 1..threadCount() - 1 on pool workers. Lets
+// kernels tag work with the thread that did it.
+int workerIndex();
+// Binds the calling thread to cpus[0] and pool worker i to cpus[i % size],
+// so that threads stop migrating mid-measurement; the bench does this
+// before timing anything. Linux only; elsewhere, and on an empty list or
+// an offline CPU, it returns false.
+bool pinThreads(const std::vector<int> &cpus);
+
+// Calls body(chunkBegin, chunkEnd) over [begin, end) in chunks of at most
+// grain elements, distributed dynamically across the pool.
+void forRange(size_t begin, size_t end, size_t grain,
+              const std::function<void(size_t, size_t)> &body);
+
+} // namespace Parallel
+
+#endif // PARALLEL_H
@@ -0,0 +1,214 @@
+#include "raceview.h"
+
+#include <QPainter>
+
+#include <algorithm>
+#include <cmath>
+
+namespace RaceView {
+
+namespace {
+
+constexpr int LabelHeight = 16;
+constexpr int StripHeight = 10;
+
+QRgb highlight(const VisualEvent &event)
+{
+    switch (event.kind) {
+    case VisualEvent::Compare:
+        return qRgb(240, 210, 60);
+    case VisualEvent::Swap:
+        return qRgb(240, 80, 70);
+    case VisualEvent::Write:
+        return qRgb(90, 230, 120);
+    case VisualEvent::Mark:
+        break;
+    }
+    return qRgb(200, 200, 200);
+}
+
+// Dark to red to yellow.
+QRgb heatColour(float heat)
+{
+    const float t = std::clamp(heat, 0.0f, 1.0f);
+    if (t < 0.5f)
+        return qRgb(28 + int(t * 2 * 172), 28 + int(t * 2 * 22), 34 - int(t * 2 * 14));
+    return qRgb(200 + int((t - 0.5f) * 2 * 40), 50 + int((t - 0.5f) * 2 * 160), 20 + int((t - 0.5f) * 2 * 30));
+}
+
+// Where the elements of each column start: column x shows the elements
+// [x * n / width, (x + 1) * n / width), drawn as the first of them, so
+// arrays wider than the panel are subsampled and narrower ones get wide
+// bars. Kept for the last size and width, which every panel of a race
+// shares, so a frame does no divisions per column.
+const std::vector<size_t> &columnStarts(size_t n, int width)
+{
+    static std::vector<size_t> starts;
+    static size_t startsFor = 0;
+    if (startsFor != n || starts.size() != size_t(width) + 1) {
+        starts.resize(size_t(width) + 1);
+        for (int x = 0; x <= width; ++x)
+            starts[size_t(x)] = size_t(x) * n / size_t(width);
+        startsFor = n;
+    }
+    return starts;
+}
+
+// Each column's bar top and colours first, then the image a scanline at a
+// time, left to right, rather than down each column: at 4K a column step
+// is a cache miss per pixel.
+void drawBars(const Panel &panel, QImage &image, const QRect &area)
+{
+    const size_t n = panel.values.size();
+    const int width = area.width();
+    if (n == 0 || width <= 0 || area.height() <= 0)
+        return;
+    const auto [lowest, highest] = std::minmax_element(panel.values.begin(), panel.values.end());
+    const double scale = area.height() / double(std::max<int64_t>(int64_t(*highest) - *lowest, 1));
+    const QRgb background = qRgb(28, 28, 34);
+    const QRgb range = qRgb(44, 44, 58);
+    const QRgb bar = panel.finished ? qRgb(90, 170, 110) : qRgb(120, 140, 180);
+
+    const std::vector<size_t> &starts = columnStarts(n, width);
+    const size_t columns = size_t(width);
+    std::vector<int> tops(columns);
+    std::vector<QRgb> colours(columns, bar);
+    std::vector<QRgb> empties(columns, background);
+    for (size_t x = 0; x < columns; ++x) {
+        const size_t first = starts[x];
+        const size_t last = std::max(first + 1, starts[x + 1]);
+        const auto covers = [&](uint32_t index) { return index >= first && index < last; };
+
+        if (panel.active && panel.last.kind != VisualEvent::Mark && (covers(panel.last.a) || covers(panel.last.b)))
+            colours[x] = highlight(panel.last);
+        const bool inRange = panel.active && panel.range.b > panel.range.a && first < panel.range.b && last > panel.range.a;
+        if (!panel.heat.empty())
+            empties[x] = heatColour(panel.heat[x * panel.heat.size() / columns]);
+        else if (inRange)
+            empties[x] = range;
+        const int height = 1 + int((int64_t(panel.values[first]) - *lowest) * scale);
+        tops[x] = area.bottom() + 1 - std::min(height, area.height());
+    }
+    for (int y = area.top(); y <= area.bottom(); ++y) {
+        QRgb *line = reinterpret_cast<QRgb *>(image.scanLine(y)) + area.left();
+        for (size_t x = 0; x < columns; ++x)
+            line[x] = y >= tops[x] ? colours[x] : empties[x];
+    }
+}
+
+void drawStrip(const std::vector<QRgb> &strip, QImage &image, const QRect &area)
+{
+    std::vector<QRgb> colours(size_t(std::max(area.width(), 0)));
+    for (size_t x = 0; x < colours.size(); ++x)
+        colours[x] = strip[x * strip.size() / colours.size()];
+    for (int y = area.top(); y <= area.bottom(); ++y)
+        std::copy(colours.begin(), colours.end(), reinterpret_cast<QRgb *>(image.scanLine(y)) + area.left());
+}
+
+void drawCurves(const Panel &panel, QPainter &painter, const QRect &area, qreal ratio)
+{
+    const auto map = [&](const QPointF &point) {
+        return QPointF(area.left() + point.x() * area.width(), area.bottom() + 1 - point.y() * area.height());
+    };
+    painter.setRenderHint(QPainter::Antialiasing);
+    for (size_t i = 0; i < panel.curves.size(); ++i) {
+        const Curve &curve = panel.curves[i];
+        painter.setPen(QPen(QColor::fromRgb(curve.colour), 1.5 * ratio));
+        for (size_t p = 1; p < curve.points.size(); ++p)
+            painter.drawLine(map(curve.points[p - 1]), map(curve.points[p]));
+        const int labelHeight = qRound(LabelHeight * ratio);
+        painter.drawText(QRect(area.left() + qRound(4 * ratio), area.top() + qRound(2 * ratio) + int(i) * labelHeight,
+                               area.width() - qRound(8 * ratio), labelHeight),
+                         Qt::AlignLeft | Qt::AlignVCenter, curve.label);
+    }
+    if (panel.cursor >= 0) {
+        painter.setPen(QColor(230, 230, 230));
+        const double x = area.left() + std::min(panel.cursor, 1.0) * area.width();
+        painter.drawLine(QPointF(x, area.top()), QPointF(x, area.bottom() + 1));
+    }
+    painter.setRenderHint(QPainter::Antialiasing, false);
+}
+
+QRect barArea(const Panel &panel, const QRect &area, qreal ratio)
+{
+    return panel.strip.empty() ? area : area.adjusted(0, 0, 0, -qRound((StripHeight + 2) * ratio));
+}
+
+} // namespace
+
+// Laid out in device pixels throughout, the bars written straight into the
+// image and the text painted at a scaled size, so the ratio is only set on
+// the image at the end for the widget to draw it at.
+void render(const std::vector<Panel> &panels, QImage &image, const QSize &size, qreal ratio)
+{
+    const int columns = std::max(1, int(std::ceil(std::sqrt(double(panels.size())))));
+    const int rows = std::max(1, (int(panels.size()) + columns - 1) / columns);
+    QSize pixels = size;
+    if (pixels.isEmpty()) {
+        pixels = panels.size() <= 1 ? QSize(1280, 720) : QSize(columns * 200, rows * 120);
+        ratio = 1;
+    }
+    if (image.size() != pixels || image.format() != QImage::Format_RGB32)
+        image = QImage(pixels, QImage::Format_RGB32);
+    image.setDevicePixelRatio(1);
+    image.fill(qRgb(16, 16, 20));
+
+    const int panelWidth = pixels.width() / columns;
+    const int panelHeight = pixels.height() / rows;
+    const int labelHeight = qRound(LabelHeight * ratio);
+    const int margin = qRound(2 * ratio);
+    const auto cellOf = [&](size_t i) {
+        return QRect(int(i) % columns * panelWidth, int(i) / columns * panelHeight, panelWidth, panelHeight);
+    };
+    const auto areaOf = [&](size_t i) { return cellOf(i).adjusted(margin, labelHeight, -margin, -margin); };
+    for (size_t i = 0; i < panels.size(); ++i) {
+        const QRect area = areaOf(i);
+        drawBars(panels[i], image, barArea(panels[i], area, ratio));
+        if (!panels[i].strip.empty()) {
+            // A canvas squeezed shorter than label and strip leaves no
+            // room; the strip is cut to the panel rather than run above it.
+            const int stripHeight = qRound(StripHeight * ratio);
+            const QRect strip = QRect(area.left(), area.bottom() + 1 - stripHeight, area.width(), stripHeight).intersected(area);
+            if (!strip.isEmpty())
+                drawStrip(panels[i].strip, image, strip);
+        }
+    }
+
+    QPainter painter(&image);
+    QFont font = painter.font();
+    font.setPixelSize(qRound(11 * ratio));
+    painter.setFont(font);
+    for (size_t i = 0; i < panels.size(); ++i) {
+        const Panel &panel = panels[i];
+        const QRect cell = cellOf(i);
+        const QRect label(cell.left() + qRound(3 * ratio), cell.top(), panelWidth - qRound(6 * ratio), labelHeight);
+        painter.setPen(QColor(220, 220, 220));
+        painter.drawText(label, Qt::AlignLeft | Qt::AlignVCenter, panel.title);
+        painter.setPen(panel.finished ? QColor(120, 230, 140) : QColor(160, 160, 170));
+        painter.drawText(label, Qt::AlignRight | Qt::AlignVCenter, panel.status);
+        drawCurves(panel, painter, barArea(panel, areaOf(i), ratio), ratio);
+    }
+    painter.end();
+    image.setDevicePixelRatio(ratio);
+}
+
+void render(const SortRace &race, QImage &image, const QSize &size, qreal ratio)
+{
+    std::vector<Panel> panels;
+    panels.reserve(race.lanes().size());
+    for (const SortRace::Lane &lane : race.lanes()) {
+        Panel panel;
+        panel.values = lane.values;
+        panel.last = lane.last;
+        panel.range = lane.range;
+        panel.active = lane.events > 0 && !lane.finishedPlace;
+        panel.finished = lane.finishedPlace;
+        panel.title = QStringLiteral("%1 / %2").arg(QLatin1String(lane.algorithm->name), QString::fromStdString(lane.input));
+        panel.status = lane.finishedPlace ? QStringLiteral("#%1  %2").arg(lane.finishedPlace).arg(lane.events)
+                                          : QString::number(lane.events);
+        panels.push_back(std::move(panel));
+    }
+    render(panels, image, size, ratio);
+}
+
+} // namespace RaceView
@@ -0,0 +1,55 @@
+#ifndef RACEVIEW_H
+#define RACEVIEW_H
+
+#include "sortrace.h"
+
+#include <QImage>
+#include <QPointF>
+#include <QString>
+
+#include <span>
+#include <vector>
+
+// Draws sorting runs as a grid of bar charts, one panel per run, with the
+// latest event and working range highlighted.
+namespace RaceView {
+
+struct Curve
+{
+    QString label;
+    QRgb colour = 0;
+    std::vector<QPointF> points; // x and y from 0 to 1
+};
+
+struct Panel
+{
+    std::span<const int32_t> values;
+    VisualEvent last;
+    VisualEvent range;
+    // Highlights are drawn only while active.
+    bool active = false;
+    bool finished = false;
+    QString title;
+    QString status;
+    // Optional colour band under the bars, its entries spread evenly over
+    // the width; the sandbox draws page heat in it.
+    std::vector<QRgb> strip;
+    // Optional heat from 0 to 1, spread over the width like the strip, that
+    // tints the background above the bars.
+    std::vector<float> heat;
+    // Optional lines drawn over the bars, with a marker at cursor (0 to 1
+    // across) unless that is negative.
+    std::vector<Curve> curves;
+    double cursor = -1;
+};
+
+// Renders at size in device pixels with the given device pixel ratio, so
+// a widget of that size shows the image unscaled and sharp on any screen;
+// labels and margins grow with the ratio. Without a size, a single panel
+// gets a 1280x720 image to itself and more panels 200x120 each.
+void render(const std::vector<Panel> &panels, QImage &image, const QSize &size = QSize(), qreal ratio = 1);
+void render(const SortRace &race, QImage &image, const QSize &size = QSize(), qreal ratio = 1);
+
+} // namespace RaceView
+
+#endif // RACEVIEW_H
@@ -0,0 +1,197 @@
+#include "roofline.h"
+
+#include "parallel.h"
+
+#include <algorithm>
+#include <chrono>
+#include <cmath>
+#include <vector>
+
+#ifdef __linux__
+#include <linux/perf_event.h>
+#include <sys/ioctl.h>
+#include <sys/syscall.h>
+#include <unistd.h>
+#endif
+
+namespace Roofline {
+
+namespace {
+
+typedef int32_t I32x8 __attribute__((vector_size(32)));
+
+template <typename Function>
+double bestSeconds(int repeat, Function &&function)
+{
+    double best = HUGE_VAL;
+    for (int i = 0; i < std::max(repeat, 1); ++i) {
+        const auto started = std::chrono::steady_clock::now();
+        function();
+        best = std::min(best, std::chrono::duration<double>(std::chrono::steady_clock::now() - started).count());
+    }
+    return best;
+}
+
+// Enough chunks per thread that a slow core does not hold the rest up.
+size_t grainFor(size_t count)
+{
+    return std::max<size_t>(count / (size_t(Parallel::threadCount()) * 4), 4096);
+}
+
+constexpr int Accumulators = 8;
+constexpr int Lanes = sizeof(I32x8) / sizeof(int32_t);
+constexpr int OpsPerUpdate = 3;
+
+// Eight independent accumulators keep the vector units busy although each
+// update waits for the previous one to the same accumulator. Like the
+// pipeline's kernels, the vectors stay inside this always-inlined body so
+// it can be compiled once per target.
+__attribute__((always_inline)) inline int32_t spin(size_t iterations, int32_t seed)
+{
+    I32x8 acc[Accumulators];
+    for (int k = 0; k < Accumulators; ++k)
+        acc[k] = I32x8 {} + (seed + k);
+    const I32x8 pivot = I32x8 {} + 1000;
+    const I32x8 up = I32x8 {} + 3;
+    const I32x8 down = I32x8 {} - 5;
+    for (size_t i = 0; i < iterations; ++i) {
+        for (int k = 0; k < Accumulators; ++k)
+            acc[k] += acc[k] < pivot ? up : down;
+    }
+    I32x8 sum = acc[0];
+    for (int k = 1; k < Accumulators; ++k)
+        sum += acc[k];
+    int32_t total = 0;
+    for (int lane = 0; lane < Lanes; ++lane)
+        total += sum[lane];
+    return total;
+}
+
+int32_t spinDefault(size_t iterations, int32_t seed)
+{
+    return spin(iterations, seed);
+}
+
+#if defined(__GNUC__) && defined(__x86_64__)
+#define ROOFLINE_AVX2_KERNEL 1
+
+__attribute__((target("avx2")))
+int32_t spinAvx2(size_t iterations, int32_t seed)
+{
+    return spin(iterations, seed);
+}
+#endif
+
+} // namespace
+
+Bandwidth measureBandwidth(size_t arrayBytes, int repeat)
+{
+    const size_t count = std::max<size_t>(arrayBytes / sizeof(double), 1);
+    std::vector<double> a(count);
+    std::vector<double> b(count);
+    std::vector<double> c(count);
+    const size_t grain = grainFor(count);
+    // First touch on the threads that will use each chunk, for NUMA.
+    Parallel::forRange(0, count, grain, [&](size_t first, size_t last) {
+        std::fill(a.begin() + first, a.begin() + last, 1.0);
+        std::fill(b.begin() + first, b.begin() + last, 2.0);
+        std::fill(c.begin() + first, c.begin() + last, 0.0);
+    });
+
+    Bandwidth bandwidth;
+    const double copy = bestSeconds(repeat, [&] {
+        Parallel::forRange(0, count, grain, [&](size_t first, size_t last) {
+            std::copy(a.begin() + first, a.begin() + last, c.begin() + first);
+        });
+    });
+    bandwidth.copy = 2.0 * sizeof(double) * count / copy / 1e9;
+    const double scalar = 3.0;
+    const double triad = bestSeconds(repeat, [&] {
+        Parallel::forRange(0, count, grain, [&](size_t first, size_t last) {
+            for (size_t i = first; i < last; ++i)
+                a[i] = b[i] + scalar * c[i];
+        });
+    });
+    bandwidth.triad = 3.0 * sizeof(double) * count / triad / 1e9;
+    return bandwidth;
+}
+
+double measurePeakOps(int repeat)
+{
+    constexpr size_t Iterations = size_t(1) << 22;
+    int32_t (*kernel)(size_t, int32_t) = spinDefault;
+#ifdef ROOFLINE_AVX2_KERNEL
+    __builtin_cpu_init();
+    if (__builtin_cpu_supports("avx2"))
+        kernel = spinAvx2;
+#endif
+    const int threads = Parallel::threadCount();
+    std::vector<int32_t> sinks(threads);
+    const double seconds = bestSeconds(repeat, [&] {
+        Parallel::forRange(0, size_t(threads), 1, [&](size_t first, size_t last) {
+            for (size_t thread = first; thread < last; ++thread)
+                sinks[thread] = kernel(Iterations, int32_t(thread));
+        });
+    });
+    return double(threads) * Iterations * Accumulators * Lanes * OpsPerUpdate / seconds / 1e9;
+}
+
+MissCounter::MissCounter()
+{
+#ifdef __linux__
+    perf_event_attr attr {};
+    attr.type = PERF_TYPE_HARDWARE;
+    attr.size = sizeof(attr);
+    attr.config = PERF_COUNT_HW_CACHE_MISSES;
+    attr.disabled = 1;
+    attr.exclude_kernel = 1;
+    attr.exclude_hv = 1;
+    m_fd = int(syscall(SYS_perf_event_open, &attr, 0, -1, -1, 0));
+#endif
+}
+
+MissCounter::~MissCounter()
+{
+#ifdef __linux__
+    if (m_fd >= 0)
+        close(m_fd);
+#endif
+}
+
+void MissCounter::start()
+{
+#ifdef __linux__
+    if (m_fd < 0)
+        return;
+    ioctl(m_fd, PERF_EVENT_IOC_RESET, 0);
+    ioctl(m_fd, PERF_EVENT_IOC_ENABLE, 0);
+#endif
+}
+
+uint64_t MissCounter::stop()
+{
+#ifdef __linux__
+    if (m_fd < 0)
+        return 0;
+    ioctl(m_fd, PERF_EVENT_IOC_DISABLE, 0);
+    uint64_t misses = 0;
+    if (read(m_fd, &misses, sizeof(misses)) != sizeof(misses))
+        return 0;
+    return misses * LineBytes;
+#else
+    return 0;
+#endif
+}
+
+Placement place(double ops, double bytes, double seconds, double peakOps, double bandwidth)
+{
+    Placement placement;
+    placement.intensity = bytes > 0 ? ops / bytes : HUGE_VAL;
+    placement.achieved = seconds > 0 ? ops / seconds / 1e9 : 0;
+    const double memoryRoof = placement.intensity * bandwidth;
+    placement.memoryBound = memoryRoof < peakOps;
+    placement.roof = std::min(memoryRoof, peakOps);
+    return placement;
+}
+
+} // namespace Roofline
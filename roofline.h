@@ -0,0 +1,65 @@
+#ifndef ROOFLINE_H
+#define ROOFLINE_H
+
+#include <cstddef>
+#include <cstdint>
+
+// The two ceilings of a roofline model and where a run sits under them.
+// A run doing ops operations on bytes of memory traffic cannot beat
+// min(peak ops/s, ops/bytes * bandwidth): left of the ridge point it is
+// memory bound and faster memory access is what helps, right of it only
+// doing less work does.
+//
+// Sorts do integer compares and moves, not floating point, so the compute
+// ceiling is measured in 32-bit integer vector operations rather than flops.
+namespace Roofline {
+
+struct Bandwidth
+{
+    double copy = 0;  // GB/s
+    double triad = 0;
+};
+
+// STREAM's copy (c = a) and triad (a = b + s * c) on arrays of doubles of
+// the given size each, on the Parallel pool; bytes are those the kernel
+// names, as STREAM counts them, so write-allocate traffic is not included.
+Bandwidth measureBandwidth(size_t arrayBytes, int repeat);
+// Billions of int32 lane operations per second (compare, select, add) on
+// register-resident vectors, one independent stream per pool thread.
+double measurePeakOps(int repeat);
+
+// Memory traffic of the calling thread from the last-level cache miss
+// counter, a line per miss. Only on Linux, and only where perf events are
+// allowed (perf_event_paranoid, container seccomp); available() says.
+class MissCounter
+{
+public:
+    static constexpr int LineBytes = 64;
+
+    MissCounter();
+    MissCounter(const MissCounter &) = delete;
+    MissCounter &operator=(const MissCounter &) = delete;
+    ~MissCounter();
+
+    bool available() const { return m_fd >= 0; }
+    void start();
+    // Bytes since start(), or 0 if unavailable.
+    uint64_t stop();
+
+private:
+    int m_fd = -1;
+};
+
+struct Placement
+{
+    double intensity = 0; // ops per byte
+    double achieved = 0;  // Gop/s
+    double roof = 0;      // the ceiling at this intensity, Gop/s
+    bool memoryBound = false;
+};
+
+Placement place(double ops, double bytes, double seconds, double peakOps, double bandwidth);
+
+} // namespace Roofline
+
+#endif // ROOFLINE_H
@@ -0,0 +1,205 @@
+#include "sampledsort.h"
+
+#include <algorithm>
+#include <mutex>
+#include <span>
+
+// Owned jointly by the object and its worker, so a detached worker can
+// outlive the object it was started from.
+struct SampledSort::Shared : Sorts::Watcher
+{
+    std::vector<int32_t> values;
+    bool native = false;
+    std::chrono::steady_clock::time_point started;
+    std::atomic<int64_t> elapsedNs { -1 }; // set once finished
+    std::atomic<bool> cancelled { false };
+    std::atomic<uint64_t> events { 0 };
+    std::atomic<uint32_t> lastKind { VisualEvent::Mark };
+    std::atomic<uint32_t> lastA { 0 };
+    std::atomic<uint32_t> lastB { 0 };
+    std::atomic<uint32_t> rangeA { 0 };
+    std::atomic<uint32_t> rangeB { 0 };
+    MemoryUsage::Profile profile;
+
+    // The worker's copy of values for snapshot() while it runs, at the size
+    // snapshot() last asked for. A native sort only takes one at a
+    // checkpoint after snapshot() has asked again.
+    std::mutex snapshotMutex;
+    std::vector<int32_t> snapshot;
+    size_t snapshotStride = 1;
+    std::atomic<size_t> snapshotValues { 4096 };
+    std::atomic<bool> snapshotWanted { false };
+
+    void publishSnapshot(std::span<const int32_t> from);
+    void checkpoint(std::span<const int32_t> from) override;
+};
+
+namespace {
+
+void publish(std::atomic<uint32_t> &a, std::atomic<uint32_t> &b, const VisualEvent &event)
+{
+    a.store(event.a, std::memory_order_relaxed);
+    b.store(event.b, std::memory_order_relaxed);
+}
+
+size_t copyStrided(std::span<const int32_t> values, size_t maxValues, std::vector<int32_t> &out)
+{
+    out.clear();
+    if (values.empty() || maxValues == 0)
+        return 1;
+    const size_t stride = (values.size() + maxValues - 1) / maxValues;
+    out.reserve(values.size() / stride + 1);
+    for (size_t i = 0; i < values.size(); i += stride)
+        out.push_back(values[i]);
+    return stride;
+}
+
+} // namespace
+
+void SampledSort::Shared::publishSnapshot(std::span<const int32_t> from)
+{
+    std::lock_guard lock(snapshotMutex);
+    snapshotStride = copyStrided(from, snapshotValues.load(std::memory_order_relaxed), snapshot);
+}
+
+void SampledSort::Shared::checkpoint(std::span<const int32_t> from)
+{
+    if (!snapshotWanted.load(std::memory_order_relaxed))
+        return;
+    snapshotWanted.store(false, std::memory_order_relaxed);
+    publishSnapshot(from);
+}
+
+SampledSort::~SampledSort()
+{
+    cancel();
+    if (m_worker.joinable())
+        m_worker.detach();
+}
+
+bool SampledSort::start(const Sorts::Algorithm *algorithm, std::vector<int32_t> values, Mode mode, uint64_t every)
+{
+    if (busy())
+        return false;
+    cancel();
+    if (m_worker.joinable())
+        m_worker.join();
+    m_algorithm = algorithm;
+    m_mode = algorithm->native ? mode : Mode::EveryNth;
+    m_shared = std::make_shared<Shared>();
+    m_shared->values = std::move(values);
+    m_shared->native = m_mode == Mode::Native;
+    m_shared->publishSnapshot(m_shared->values);
+    m_workerShared = m_shared;
+    m_shared->started = std::chrono::steady_clock::now();
+    every = std::max<uint64_t>(every, 1);
+
+    m_worker = std::thread([shared = m_shared, algorithm, mode = m_mode, every] {
+        shared->profile.attach();
+        if (mode == Mode::Native) {
+            Sorts::WatchScope watch(shared.get());
+            algorithm->native(shared->values);
+        } else {
+            Stepper stepper = algorithm->run(shared->values);
+            uint64_t events = 0;
+            while (stepper.next()) {
+                if (++events % every)
+                    continue;
+                const VisualEvent &event = stepper.event();
+                if (event.kind == VisualEvent::Mark)
+                    publish(shared->rangeA, shared->rangeB, event);
+                shared->lastKind.store(event.kind, std::memory_order_relaxed);
+                publish(shared->lastA, shared->lastB, event);
+                shared->events.store(events, std::memory_order_relaxed);
+                shared->publishSnapshot(shared->values);
+                if (shared->cancelled.load(std::memory_order_relaxed))
+                    break;
+            }
+            shared->events.store(events, std::memory_order_relaxed);
+        }
+        shared->profile.detach();
+        const auto elapsed = std::chrono::steady_clock::now() - shared->started;
+        shared->elapsedNs.store(std::chrono::duration_cast<std::chrono::nanoseconds>(elapsed).count(),
+                                std::memory_order_release);
+    });
+    return true;
+}
+
+void SampledSort::cancel()
+{
+    if (m_shared)
+        m_shared->cancelled.store(true, std::memory_order_relaxed);
+    m_shared.reset();
+}
+
+size_t SampledSort::size() const
+{
+    return m_shared ? m_shared->values.size() : 0;
+}
+
+bool SampledSort::busy() const
+{
+    return m_workerShared && m_workerShared->native
+           && m_workerShared->elapsedNs.load(std::memory_order_acquire) < 0;
+}
+
+bool SampledSort::finished() const
+{
+    return m_shared && m_shared->elapsedNs.load(std::memory_order_acquire) >= 0;
+}
+
+double SampledSort::seconds() const
+{
+    if (!m_shared)
+        return 0;
+    const int64_t elapsed = m_shared->elapsedNs.load(std::memory_order_acquire);
+    if (elapsed >= 0)
+        return elapsed / 1e9;
+    return std::chrono::duration<double>(std::chrono::steady_clock::now() - m_shared->started).count();
+}
+
+uint64_t SampledSort::events() const
+{
+    return m_shared ? m_shared->events.load(std::memory_order_relaxed) : 0;
+}
+
+VisualEvent SampledSort::lastSample() const
+{
+    if (!m_shared)
+        return VisualEvent();
+    VisualEvent event;
+    event.kind = VisualEvent::Kind(m_shared->lastKind.load(std::memory_order_relaxed));
+    event.a = m_shared->lastA.load(std::memory_order_relaxed);
+    event.b = m_shared->lastB.load(std::memory_order_relaxed);
+    return event;
+}
+
+VisualEvent SampledSort::range() const
+{
+    if (!m_shared)
+        return VisualEvent();
+    return VisualEvent::mark(m_shared->rangeA.load(std::memory_order_relaxed),
+                             m_shared->rangeB.load(std::memory_order_relaxed));
+}
+
+const MemoryUsage::Profile *SampledSort::profile() const
+{
+    return m_shared ? &m_shared->profile : nullptr;
+}
+
+// Once the worker is done, values holds still and can be read directly;
+// until then only the worker reads it, into the copy taken here.
+size_t SampledSort::snapshot(size_t maxValues, std::vector<int32_t> &out) const
+{
+    if (!m_shared) {
+        out.clear();
+        return 1;
+    }
+    if (finished())
+        return copyStrided(m_shared->values, maxValues, out);
+    m_shared->snapshotValues.store(maxValues, std::memory_order_relaxed);
+    m_shared->snapshotWanted.store(true, std::memory_order_relaxed);
+    std::lock_guard lock(m_shared->snapshotMutex);
+    out = m_shared->snapshot;
+    return m_shared->snapshotStride;
+}
@@ -0,0 +1,80 @@
+#ifndef SAMPLEDSORT_H
+#define SAMPLEDSORT_H
+
+#include "memoryusage.h"
+#include "sorts.h"
+#include "stepper.h"
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <memory>
+#include <thread>
+#include <vector>
+
+// Runs one sort on a worker thread at (nearly) full speed and lets another
+// thread watch it statistically instead of through every event:
+//
+//  - Native runs the algorithm's plain version. No events are recorded;
+//    at the sort's checkpoints (see Sorts::Watcher) the worker copies the
+//    array for the watcher, but only the first time after each
+//    snapshot() call, so a frame costs the sort one strided copy.
+//  - EveryNth drains the stepper and publishes one event in every N, for
+//    algorithms without a native version or when the events are wanted,
+//    along with a strided copy of the array as it stands then.
+//
+// A copy is a few thousand reads and a checkpoint with no copy wanted one
+// load, so a native sort keeps nearly all of its speed while being drawn;
+// the stepper's own overhead is what slows EveryNth. The worker's heap use
+// is profiled along the way.
+class SampledSort
+{
+public:
+    enum class Mode { Native, EveryNth };
+
+    SampledSort() = default;
+    SampledSort(const SampledSort &) = delete;
+    SampledSort &operator=(const SampledSort &) = delete;
+    // Does not wait for a native sort, which cannot be interrupted; the
+    // worker finishes on its own and frees what it used.
+    ~SampledSort();
+
+    // Falls back to EveryNth if the algorithm has no native version. Only
+    // one worker sorts at a time: a previous EveryNth run is cancelled and
+    // waited for, which takes until its next sample, but a native one
+    // cannot be stopped, so while it is busy() start() returns false and
+    // changes nothing.
+    bool start(const Sorts::Algorithm *algorithm, std::vector<int32_t> values, Mode mode, uint64_t every);
+    void cancel();
+    // A native run, cancelled or not, is still sorting.
+    bool busy() const;
+
+    const Sorts::Algorithm *algorithm() const { return m_algorithm; }
+    Mode mode() const { return m_mode; }
+    size_t size() const;
+    bool finished() const;
+    double seconds() const;
+    // EveryNth only: events so far, and the latest sampled ones.
+    uint64_t events() const;
+    VisualEvent lastSample() const;
+    VisualEvent range() const;
+    // What the worker allocated; the timeline only once finished.
+    const MemoryUsage::Profile *profile() const;
+
+    // Copies at most maxValues elements, evenly spaced; returns the spacing.
+    // While a run is going, the copy is the worker's latest, at the size
+    // asked for the time before.
+    size_t snapshot(size_t maxValues, std::vector<int32_t> &out) const;
+
+private:
+    struct Shared;
+
+    const Sorts::Algorithm *m_algorithm = nullptr;
+    Mode m_mode = Mode::Native;
+    std::shared_ptr<Shared> m_shared;
+    // m_worker's state, kept after cancel() resets m_shared.
+    std::shared_ptr<const Shared> m_workerShared;
+    std::thread m_worker;
+};
+
+#endif // SAMPLEDSORT_H
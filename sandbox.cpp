@@ -0,0 +1,431 @@
+#include "sandbox.h"
+
+#include "pagetracer.h"
+#include "sorts.h"
+
+#include <QByteArray>
+#include <QtGlobal>
+
+#include <algorithm>
+#include <cerrno>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <new>
+#include <string>
+#include <thread>
+
+#ifdef Q_OS_UNIX
+#include <dlfcn.h>
+#include <fcntl.h>
+#include <signal.h>
+#include <sys/mman.h>
+#include <sys/resource.h>
+#include <sys/stat.h>
+#include <sys/wait.h>
+#include <unistd.h>
+#endif
+#ifdef Q_OS_LINUX
+#include <sys/prctl.h>
+#endif
+
+// The first page of the shared file. The parent maps it writable, to raise
+// the allowance; the array follows on the next page boundary.
+struct Sandbox::Control
+{
+    static constexpr uint32_t Magic = 0x53424f58; // "SBOX"
+
+    uint32_t magic;
+    uint32_t plugin;
+    uint64_t count;
+    std::atomic<uint64_t> allowance;
+    std::atomic<uint64_t> events;
+    std::atomic<uint32_t> done;
+    std::atomic<uint32_t> lastKind;
+    std::atomic<uint32_t> lastA;
+    std::atomic<uint32_t> lastB;
+    std::atomic<uint32_t> rangeA;
+    std::atomic<uint32_t> rangeB;
+
+    // With tracing on, the page records follow the array.
+    uint32_t tracePages;
+    uint32_t traceInterval; // microseconds
+    uint64_t pageCount;
+    PageTracer::Counters trace;
+};
+
+namespace {
+
+// Where the child finds the shared file, whatever descriptor it had here.
+constexpr int ChildFd = 3;
+
+// Exit codes of the child, besides 0.
+enum ChildExit { BadArguments = 2, BadSharedMemory = 3, UnknownAlgorithm = 4, BadPlugin = 5 };
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+#ifdef Q_OS_UNIX
+size_t roundToPages(size_t bytes)
+{
+    const size_t page = PageTracer::pageSize();
+    return std::max<size_t>((bytes + page - 1) / page * page, page);
+}
+#endif
+
+QString systemError(const char *what)
+{
+    return QStringLiteral("%1: %2").arg(QLatin1String(what), QString::fromLocal8Bit(std::strerror(errno)));
+}
+
+} // namespace
+
+#ifdef Q_OS_UNIX
+
+size_t Sandbox::controlBytes()
+{
+    return roundToPages(sizeof(Control));
+}
+
+int Sandbox::runChild(int argc, char **argv)
+{
+    if (argc != 3) {
+        std::fprintf(stderr, "usage: %s %s <algorithm or plugin>\n", argv[0], ChildFlag);
+        return BadArguments;
+    }
+#ifdef Q_OS_LINUX
+    // Never outlive the window that is showing us.
+    prctl(PR_SET_PDEATHSIG, SIGKILL);
+#endif
+    const rlimit noCore = { 0, 0 };
+    setrlimit(RLIMIT_CORE, &noCore);
+
+    struct stat info;
+    const size_t header = controlBytes();
+    if (fstat(ChildFd, &info) != 0 || size_t(info.st_size) < header)
+        return BadSharedMemory;
+    void *mapped = mmap(nullptr, size_t(info.st_size), PROT_READ | PROT_WRITE, MAP_SHARED, ChildFd, 0);
+    close(ChildFd);
+    if (mapped == MAP_FAILED)
+        return BadSharedMemory;
+    Control *control = static_cast<Control *>(mapped);
+    const size_t valueBytes = roundToPages(size_t(control->count) * sizeof(int32_t));
+    if (control->magic != Control::Magic
+        || header + valueBytes + control->pageCount * sizeof(PageTracer::Page) > size_t(info.st_size)) {
+        return BadSharedMemory;
+    }
+    char *region = static_cast<char *>(mapped) + header;
+    const std::span<int32_t> values(reinterpret_cast<int32_t *>(region), size_t(control->count));
+
+    // Traces whatever runs below, plugin or not, until the child returns.
+    PageTracer tracer;
+    if (control->tracePages) {
+        const std::span<PageTracer::Page> pages(reinterpret_cast<PageTracer::Page *>(region + valueBytes),
+                                                size_t(control->pageCount));
+        if (!tracer.start(region, valueBytes, pages, &control->trace,
+                          std::chrono::microseconds(control->traceInterval))) {
+            return BadSharedMemory;
+        }
+    }
+
+    if (control->plugin) {
+        void *library = dlopen(argv[2], RTLD_NOW | RTLD_LOCAL);
+        using SortValues = void (*)(int32_t *, size_t);
+        SortValues sortValues = library ? reinterpret_cast<SortValues>(dlsym(library, "sort_values")) : nullptr;
+        if (!sortValues) {
+            std::fprintf(stderr, "%s: %s\n", argv[2], dlerror());
+            return BadPlugin;
+        }
+        sortValues(values.data(), values.size());
+        control->done.store(1, std::memory_order_release);
+        return 0;
+    }
+
+    const Sorts::Algorithm *algorithm = Sorts::findAlgorithm(argv[2]);
+    if (!algorithm)
+        return UnknownAlgorithm;
+    Stepper stepper = algorithm->run(values);
+    for (uint64_t events = 0;; ++events) {
+        while (events >= control->allowance.load(std::memory_order_acquire))
+            std::this_thread::sleep_for(std::chrono::milliseconds(1));
+        if (!stepper.next())
+            break;
+        const VisualEvent &event = stepper.event();
+        if (event.kind == VisualEvent::Mark) {
+            control->rangeA.store(event.a, std::memory_order_relaxed);
+            control->rangeB.store(event.b, std::memory_order_relaxed);
+        }
+        control->lastKind.store(event.kind, std::memory_order_relaxed);
+        control->lastA.store(event.a, std::memory_order_relaxed);
+        control->lastB.store(event.b, std::memory_order_relaxed);
+        control->events.store(events + 1, std::memory_order_release);
+    }
+    control->done.store(1, std::memory_order_release);
+    return 0;
+}
+
+bool Sandbox::start(const QString &program, const QString &algorithm, std::span<const int32_t> values,
+                    const Options &options, QString *error)
+{
+    stop();
+    unmap();
+    m_options = options;
+    m_plugin = !Sorts::findAlgorithm(algorithm.toStdString());
+    m_exitDetail = 0;
+
+    // An unlinked shared memory object: it goes away with the last mapping.
+    const std::string name = "/animated_algorithms-" + std::to_string(getpid()) + "-"
+            + std::to_string(std::chrono::steady_clock::now().time_since_epoch().count());
+    const int fd = shm_open(name.c_str(), O_RDWR | O_CREAT | O_EXCL, 0600);
+    if (fd < 0) {
+        setError(error, systemError("Cannot create shared memory"));
+        return false;
+    }
+    shm_unlink(name.c_str());
+
+    m_controlBytes = controlBytes();
+    m_count = values.size();
+    m_valueBytes = roundToPages(m_count * sizeof(int32_t));
+    m_pageCount = options.tracePages ? m_valueBytes / PageTracer::pageSize() : 0;
+    m_sharedBytes = m_valueBytes + m_pageCount * sizeof(PageTracer::Page);
+    if (ftruncate(fd, off_t(m_controlBytes + m_sharedBytes)) != 0) {
+        setError(error, systemError("Cannot size shared memory"));
+        close(fd);
+        return false;
+    }
+
+    // Fill the array through a temporary writable mapping, then keep only a
+    // read-only one of it and the page records.
+    void *control = mmap(nullptr, m_controlBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, 0);
+    void *writable = mmap(nullptr, m_valueBytes, PROT_READ | PROT_WRITE, MAP_SHARED, fd, off_t(m_controlBytes));
+    if (control == MAP_FAILED || writable == MAP_FAILED) {
+        setError(error, systemError("Cannot map shared memory"));
+        if (control != MAP_FAILED)
+            munmap(control, m_controlBytes);
+        if (writable != MAP_FAILED)
+            munmap(writable, m_valueBytes);
+        close(fd);
+        return false;
+    }
+    std::memcpy(writable, values.data(), values.size_bytes());
+    munmap(writable, m_valueBytes);
+    const void *readable = mmap(nullptr, m_sharedBytes, PROT_READ, MAP_SHARED, fd, off_t(m_controlBytes));
+    if (readable == MAP_FAILED) {
+        setError(error, systemError("Cannot map shared memory"));
+        munmap(control, m_controlBytes);
+        close(fd);
+        return false;
+    }
+    m_control = new (control) Control();
+    m_control->magic = Control::Magic;
+    m_control->plugin = m_plugin;
+    m_control->count = m_count;
+    m_control->lastKind.store(VisualEvent::Mark, std::memory_order_relaxed);
+    m_control->tracePages = options.tracePages;
+    m_control->traceInterval = uint32_t(options.traceInterval.count());
+    m_control->pageCount = m_pageCount;
+    m_values = static_cast<const int32_t *>(readable);
+    m_pages = reinterpret_cast<const PageTracer::Page *>(static_cast<const char *>(readable) + m_valueBytes);
+
+    // Everything the child needs is prepared before fork(); after it, only
+    // async-signal-safe calls until exec.
+    const QByteArray programPath = program.toLocal8Bit();
+    const QByteArray algorithmArgument = algorithm.toLocal8Bit();
+    char *argv[] = { const_cast<char *>(programPath.constData()), const_cast<char *>(ChildFlag),
+                     const_cast<char *>(algorithmArgument.constData()), nullptr };
+    const pid_t pid = fork();
+    if (pid == 0) {
+        if (fd == ChildFd)
+            fcntl(fd, F_SETFD, 0);
+        else if (dup2(fd, ChildFd) < 0)
+            _exit(BadSharedMemory);
+        execv(argv[0], argv);
+        _exit(127);
+    }
+    close(fd);
+    if (pid < 0) {
+        setError(error, systemError("Cannot start child process"));
+        unmap();
+        return false;
+    }
+
+    m_pid = pid;
+    m_state = State::Running;
+    m_started = m_lastProgress = std::chrono::steady_clock::now();
+    m_lastEvents = 0;
+    return true;
+}
+
+void Sandbox::allowEvents(uint64_t total)
+{
+    if (m_control)
+        m_control->allowance.store(total, std::memory_order_release);
+}
+
+Sandbox::State Sandbox::poll()
+{
+    if (m_state != State::Running)
+        return m_state;
+
+    int status = 0;
+    if (waitpid(m_pid, &status, WNOHANG) == m_pid) {
+        m_pid = -1;
+        if (WIFSIGNALED(status)) {
+            m_state = State::Crashed;
+            m_exitDetail = WTERMSIG(status);
+        } else if (WEXITSTATUS(status) != 0 || !m_control->done.load(std::memory_order_acquire)) {
+            m_state = State::Failed;
+            m_exitDetail = WEXITSTATUS(status);
+        } else {
+            m_state = State::Finished;
+        }
+        return m_state;
+    }
+
+    const auto now = std::chrono::steady_clock::now();
+    const uint64_t events = this->events();
+    if (events != m_lastEvents || events >= m_control->allowance.load(std::memory_order_relaxed)) {
+        m_lastEvents = events;
+        m_lastProgress = now;
+    }
+    State verdict = State::Running;
+    if (!m_plugin && now - m_lastProgress > m_options.stallTimeout)
+        verdict = State::Stalled;
+    else if (m_options.timeLimit.count() > 0 && now - m_started > m_options.timeLimit)
+        verdict = State::TimedOut;
+    if (verdict != State::Running) {
+        stop();
+        m_state = verdict;
+    }
+    return m_state;
+}
+
+void Sandbox::stop()
+{
+    if (m_pid > 0) {
+        kill(m_pid, SIGKILL);
+        waitpid(m_pid, nullptr, 0);
+        m_pid = -1;
+        m_state = State::Stopped;
+    }
+}
+
+void Sandbox::unmap()
+{
+    if (m_control)
+        munmap(m_control, m_controlBytes);
+    if (m_values)
+        munmap(const_cast<int32_t *>(m_values), m_sharedBytes);
+    m_control = nullptr;
+    m_values = nullptr;
+    m_count = 0;
+    m_pages = nullptr;
+    m_pageCount = 0;
+}
+
+#else
+
+size_t Sandbox::controlBytes()
+{
+    return 0;
+}
+
+int Sandbox::runChild(int, char **)
+{
+    return BadArguments;
+}
+
+bool Sandbox::start(const QString &, const QString &, std::span<const int32_t>, const Options &, QString *error)
+{
+    setError(error, QStringLiteral("Sandboxed sorting needs a POSIX system"));
+    return false;
+}
+
+void Sandbox::allowEvents(uint64_t)
+{
+}
+
+Sandbox::State Sandbox::poll()
+{
+    return m_state;
+}
+
+void Sandbox::stop()
+{
+}
+
+void Sandbox::unmap()
+{
+}
+
+#endif
+
+Sandbox::~Sandbox()
+{
+    stop();
+    unmap();
+}
+
+QString Sandbox::describe() const
+{
+    switch (m_state) {
+    case State::Idle:
+        return QStringLiteral("idle");
+    case State::Running:
+        return QStringLiteral("running");
+    case State::Finished:
+        return QStringLiteral("finished");
+    case State::Failed:
+        return QStringLiteral("failed with exit code %1").arg(m_exitDetail);
+    case State::Crashed:
+#ifdef Q_OS_UNIX
+        return QStringLiteral("crashed: %1").arg(QString::fromLocal8Bit(strsignal(m_exitDetail)));
+#else
+        return QStringLiteral("crashed");
+#endif
+    case State::Stalled:
+        return QStringLiteral("killed by the watchdog after %1 ms without progress").arg(m_options.stallTimeout.count());
+    case State::TimedOut:
+        return QStringLiteral("killed by the watchdog after %1 ms").arg(m_options.timeLimit.count());
+    case State::Stopped:
+        return QStringLiteral("stopped");
+    }
+    return QString();
+}
+
+uint64_t Sandbox::events() const
+{
+    return m_control ? m_control->events.load(std::memory_order_acquire) : 0;
+}
+
+VisualEvent Sandbox::lastEvent() const
+{
+    if (!m_control)
+        return VisualEvent();
+    VisualEvent event;
+    event.kind = VisualEvent::Kind(m_control->lastKind.load(std::memory_order_relaxed));
+    event.a = m_control->lastA.load(std::memory_order_relaxed);
+    event.b = m_control->lastB.load(std::memory_order_relaxed);
+    return event;
+}
+
+VisualEvent Sandbox::range() const
+{
+    if (!m_control)
+        return VisualEvent();
+    return VisualEvent::mark(m_control->rangeA.load(std::memory_order_relaxed),
+                             m_control->rangeB.load(std::memory_order_relaxed));
+}
+
+uint32_t Sandbox::traceEpoch() const
+{
+    return m_control ? m_control->trace.epoch.load(std::memory_order_relaxed) : 0;
+}
+
+uint64_t Sandbox::traceFaults() const
+{
+    return m_control ? m_control->trace.faults.load(std::memory_order_relaxed) : 0;
+}
@@ -0,0 +1,109 @@
+#ifndef SANDBOX_H
+#define SANDBOX_H
+
+#include "pagetracer.h"
+#include "stepper.h"
+
+#include <QString>
+
+#include <atomic>
+#include <chrono>
+#include <cstdint>
+#include <span>
+
+// Runs one sort in a child process, so a crashing or runaway algorithm
+// takes down only the child. The array lives in shared memory: the child
+// sorts it in place, and this side maps it read-only and can draw it at
+// any moment without copying anything across.
+//
+// The child is this same executable started again with ChildFlag, which
+// main() hands to runChild() before any Qt setup. It runs either a catalog
+// algorithm, paced by an event allowance the parent raises each frame, or a
+// plugin: a shared library exporting
+//
+//     extern "C" void sort_values(int32_t *values, size_t count);
+//
+// which runs unpaced and reports no events. Either kind can run under a
+// PageTracer, whose page records also live in the shared memory.
+//
+// POSIX only; start() fails elsewhere.
+class Sandbox
+{
+public:
+    enum class State { Idle, Running, Finished, Failed, Crashed, Stalled, TimedOut, Stopped };
+
+    struct Options
+    {
+        // A catalog algorithm that has events to spare but makes no progress
+        // for this long is killed. Plugins report no progress and are not
+        // watched this way.
+        std::chrono::milliseconds stallTimeout { 2000 };
+        // Wall-clock limit for the whole run; zero for none.
+        std::chrono::milliseconds timeLimit { 0 };
+        bool tracePages = false;
+        std::chrono::microseconds traceInterval { 2000 };
+    };
+
+    static constexpr const char *ChildFlag = "--sandbox-child";
+    // The entry point of the child process; returns its exit code.
+    static int runChild(int argc, char **argv);
+
+    Sandbox() = default;
+    Sandbox(const Sandbox &) = delete;
+    Sandbox &operator=(const Sandbox &) = delete;
+    ~Sandbox();
+
+    // algorithm is a catalog name, or a path to a plugin library.
+    bool start(const QString &program, const QString &algorithm, std::span<const int32_t> values,
+               const Options &options, QString *error = nullptr);
+    // Lets a catalog algorithm run up to this many events in total.
+    void allowEvents(uint64_t total);
+    // Reaps the child if it has exited and enforces the watchdog. Call it
+    // regularly; the state only changes in here and in stop().
+    State poll();
+    void stop();
+
+    State state() const { return m_state; }
+    bool running() const { return m_state == State::Running; }
+    int pid() const { return m_pid; }
+    // The exit code for Failed, the signal for Crashed.
+    int exitDetail() const { return m_exitDetail; }
+    QString describe() const;
+
+    // Live views into the child's memory; contents may change while read.
+    std::span<const int32_t> values() const { return { m_values, m_count }; }
+    uint64_t events() const;
+    VisualEvent lastEvent() const;
+    VisualEvent range() const;
+    // Empty unless tracing; one record per page of values().
+    std::span<const PageTracer::Page> pages() const { return { m_pages, m_pageCount }; }
+    uint32_t traceEpoch() const;
+    uint64_t traceFaults() const;
+
+private:
+    struct Control;
+
+    static size_t controlBytes();
+    void unmap();
+
+    Options m_options;
+    State m_state = State::Idle;
+    int m_pid = -1;
+    int m_exitDetail = 0;
+    bool m_plugin = false;
+
+    Control *m_control = nullptr;
+    size_t m_controlBytes = 0;
+    const int32_t *m_values = nullptr;
+    size_t m_count = 0;
+    size_t m_valueBytes = 0;
+    const PageTracer::Page *m_pages = nullptr;
+    size_t m_pageCount = 0;
+    size_t m_sharedBytes = 0; // the array and the page records
+
+    std::chrono::steady_clock::time_point m_started;
+    std::chrono::steady_clock::time_point m_lastProgress;
+    uint64_t m_lastEvents = 0;
+};
+
+#endif // SANDBOX_H
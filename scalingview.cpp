@@ -0,0 +1,139 @@
+#include "scalingview.h"
+
+#include <QPainter>
+#include <QPainterPath>
+
+#include <algorithm>
+#include <cmath>
+
+namespace {
+
+struct Series
+{
+    const char *name;
+    QColor colour;
+    double (*value)(const Complexity::Measurement &measurement);
+};
+
+const Series SeriesList[] = {
+    { "time", QColor(255, 160, 40), [](const Complexity::Measurement &m) { return m.ms; } },
+    { "compares", QColor(120, 180, 255), [](const Complexity::Measurement &m) { return double(m.compares); } },
+    { "moves", QColor(110, 210, 120), [](const Complexity::Measurement &m) { return double(m.moves); } },
+};
+
+constexpr int Margin = 36;
+
+} // namespace
+
+ScalingView::ScalingView(QWidget *parent)
+    : QWidget(parent)
+{
+    setAttribute(Qt::WA_OpaquePaintEvent);
+}
+
+void ScalingView::setMeasurements(std::vector<Complexity::Measurement> measurements)
+{
+    m_measurements = std::move(measurements);
+    update();
+}
+
+QSize ScalingView::sizeHint() const
+{
+    return QSize(360, 280);
+}
+
+void ScalingView::paintEvent(QPaintEvent *)
+{
+    QPainter painter(this);
+    painter.fillRect(rect(), QColor(24, 24, 28));
+    painter.setRenderHint(QPainter::Antialiasing);
+    if (m_measurements.empty()) {
+        painter.setPen(QColor(150, 150, 160));
+        painter.drawText(rect(), Qt::AlignCenter, tr("Sort > Scaling Sweep to measure"));
+        return;
+    }
+
+    // Both axes count doublings from the first measurement.
+    const double n0 = double(m_measurements.front().n);
+    const double spanX = std::max(std::log2(double(m_measurements.back().n) / n0), 1.0);
+    double spanY = spanX;
+    for (const Series &series : SeriesList) {
+        const double first = series.value(m_measurements.front());
+        if (first <= 0)
+            continue;
+        for (const Complexity::Measurement &measurement : m_measurements)
+            spanY = std::max(spanY, std::log2(std::max(series.value(measurement), first) / first));
+    }
+    const QRectF plot = QRectF(rect()).adjusted(Margin, Margin / 2, -Margin / 2, -Margin);
+    const auto at = [&](double n, double ratio) {
+        return QPointF(plot.left() + std::log2(n / n0) / spanX * plot.width(),
+                       plot.bottom() - std::log2(ratio) / spanY * plot.height());
+    };
+
+    painter.setPen(QColor(90, 90, 100));
+    painter.drawRect(plot);
+    painter.drawText(QRectF(plot.left(), plot.bottom(), plot.width(), Margin), Qt::AlignCenter,
+                     tr("n = %1 .. %2 (log)").arg(m_measurements.front().n).arg(m_measurements.back().n));
+    painter.save();
+    painter.translate(plot.left() - 6, plot.center().y());
+    painter.rotate(-90);
+    painter.drawText(QRectF(-plot.height() / 2, -Margin + 6, plot.height(), Margin - 6), Qt::AlignCenter,
+                     tr("growth over smallest n (log)"));
+    painter.restore();
+
+    painter.setClipRect(plot);
+    const Complexity::Model *guides[] = { &Complexity::models()[2], &Complexity::models()[3],
+                                          &Complexity::models()[4] };
+    for (const Complexity::Model *guide : guides) {
+        QPainterPath path;
+        const int steps = 64;
+        for (int i = 0; i <= steps; ++i) {
+            const double n = n0 * std::exp2(spanX * i / steps);
+            const QPointF point = at(n, guide->f(n) / guide->f(n0));
+            if (i == 0)
+                path.moveTo(point);
+            else
+                path.lineTo(point);
+        }
+        painter.setPen(QPen(QColor(80, 80, 92), 1, Qt::DashLine));
+        painter.drawPath(path);
+        painter.setPen(QColor(110, 110, 120));
+        const QPointF end = path.currentPosition();
+        painter.drawText(QPointF(std::min(end.x(), plot.right() - 60), std::max(end.y(), plot.top()) + 14),
+                         QString::fromLatin1(guide->name));
+    }
+
+    int legendRow = 0;
+    for (const Series &series : SeriesList) {
+        const double first = series.value(m_measurements.front());
+        if (first <= 0)
+            continue;
+        QPainterPath path;
+        std::vector<Complexity::Point> points;
+        for (const Complexity::Measurement &measurement : m_measurements) {
+            const double value = series.value(measurement);
+            points.push_back({ double(measurement.n), value });
+            const QPointF point = at(double(measurement.n), std::max(value, first) / first);
+            if (points.size() == 1)
+                path.moveTo(point);
+            else
+                path.lineTo(point);
+            painter.setPen(Qt::NoPen);
+            painter.setBrush(series.colour);
+            painter.drawEllipse(point, 2.5, 2.5);
+        }
+        painter.setBrush(Qt::NoBrush);
+        painter.setPen(QPen(series.colour, 1.5));
+        painter.drawPath(path);
+
+        const Complexity::Fit fit = Complexity::fit(points);
+        QString label = QString::fromLatin1(series.name);
+        if (fit.model) {
+            label += tr(" ~ n^%1, closest %2 (±%3%)")
+                             .arg(fit.exponent, 0, 'f', 2)
+                             .arg(QString::fromLatin1(fit.model->name))
+                             .arg(fit.modelError * 100, 0, 'f', 0);
+        }
+        painter.drawText(QPointF(plot.left() + 8, plot.top() + 16 + 16 * legendRow++), label);
+    }
+}
@@ -0,0 +1,32 @@
+#ifndef SCALINGVIEW_H
+#define SCALINGVIEW_H
+
+#include "complexity.h"
+
+#include <QWidget>
+
+#include <vector>
+
+// Log-log plot of a Complexity sweep for the scaling dock: time, compares
+// and moves, each relative to its value at the smallest n, over faint n,
+// n log n and n^2 guides from the same corner. A curve that climbs with
+// the n^2 guide is quadratic however quick the small sizes were.
+class ScalingView : public QWidget
+{
+    Q_OBJECT
+
+public:
+    explicit ScalingView(QWidget *parent = nullptr);
+
+    void setMeasurements(std::vector<Complexity::Measurement> measurements);
+
+    QSize sizeHint() const override;
+
+protected:
+    void paintEvent(QPaintEvent *event) override;
+
+private:
+    std::vector<Complexity::Measurement> m_measurements;
+};
+
+#endif // SCALINGVIEW_H
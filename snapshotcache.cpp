@@ -0,0 +1,305 @@
+#include "snapshotcache.h"
+
+#include <QCryptographicHash>
+#include <QDateTime>
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QSaveFile>
+#include <QStandardPaths>
+
+#include <cstring>
+
+namespace {
+
+constexpr char Magic[8] = { 'A', 'A', 'S', 'N', 'A', 'P', '\0', '\1' };
+constexpr uint32_t FormatVersion = 1;
+constexpr uint32_t ByteOrderMark = 0x01020304;
+constexpr uint64_t SectionAlignment = 64;
+
+enum SectionId : uint32_t {
+    ValuesSection = 1,
+    OffsetsSection = 2,
+    TargetsSection = 3,
+};
+
+struct FileHeader
+{
+    char magic[8];
+    uint32_t version;
+    uint32_t byteOrder;
+    uint32_t kind;
+    uint32_t sectionCount;
+    uint64_t sourceSize;
+    int64_t sourceModified;
+    uint64_t tableChecksum;
+    uint64_t headerChecksum;
+    uint64_t reserved;
+};
+static_assert(sizeof(FileHeader) == 64, "snapshot header must stay 64 bytes");
+
+struct SectionEntry
+{
+    uint32_t id;
+    uint32_t elementSize;
+    uint64_t offset;
+    uint64_t count;
+    uint64_t checksum;
+};
+static_assert(sizeof(SectionEntry) == 32, "section entries must stay 32 bytes");
+
+struct SectionSource
+{
+    SectionId id;
+    uint32_t elementSize;
+    const void *data;
+    uint64_t count;
+};
+
+uint64_t mix(uint64_t h)
+{
+    h ^= h >> 33;
+    h *= 0xff51afd7ed558ccdULL;
+    h ^= h >> 33;
+    h *= 0xc4ceb9fe1a85ec53ULL;
+    return h ^ (h >> 33);
+}
+
+// Four independent multiply-xor lanes so the hash runs at memory speed
+// rather than being bound by one long multiply dependency chain.
+uint64_t checksum64(const void *data, uint64_t size)
+{
+    const auto *bytes = static_cast<const unsigned char *>(data);
+    uint64_t lanes[4] = { 0x9e3779b97f4a7c15ULL, 0xbf58476d1ce4e5b9ULL,
+                          0x94d049bb133111ebULL, size };
+    uint64_t i = 0;
+    for (; i + 32 <= size; i += 32) {
+        for (int lane = 0; lane < 4; ++lane) {
+            uint64_t word;
+            std::memcpy(&word, bytes + i + lane * 8, 8);
+            lanes[lane] = (lanes[lane] ^ word) * 0x100000001b3ULL;
+            lanes[lane] ^= lanes[lane] >> 29;
+        }
+    }
+    uint64_t h = mix(lanes[0]) ^ mix(lanes[1] + 1) ^ mix(lanes[2] + 2) ^ mix(lanes[3] + 3);
+    for (; i < size; ++i)
+        h = (h ^ bytes[i]) * 0x100000001b3ULL;
+    return mix(h);
+}
+
+uint64_t alignUp(uint64_t value)
+{
+    return (value + SectionAlignment - 1) & ~(SectionAlignment - 1);
+}
+
+std::vector<SectionSource> sectionsOf(const Dataset &dataset)
+{
+    switch (dataset.kind()) {
+    case Dataset::Kind::Array:
+        return { { ValuesSection, sizeof(int32_t), dataset.values(), dataset.valueCount() } };
+    case Dataset::Kind::Graph:
+        return { { OffsetsSection, sizeof(uint32_t), dataset.offsets(), dataset.vertexCount() + 1 },
+                 { TargetsSection, sizeof(uint32_t), dataset.targets(), dataset.edgeCount() } };
+    case Dataset::Kind::Empty:
+        break;
+    }
+    return {};
+}
+
+// Traversals index with the offsets and targets, so a damaged graph must
+// not get through even without verifyData: offsets run from 0 to the edge
+// count without going down, and every target is a vertex.
+bool validGraph(const Dataset &dataset)
+{
+    const uint32_t *offsets = dataset.offsets();
+    const uint32_t *targets = dataset.targets();
+    const size_t vertices = dataset.vertexCount();
+    if (offsets[0] != 0 || offsets[vertices] != dataset.edgeCount())
+        return false;
+    for (size_t v = 0; v < vertices; ++v) {
+        if (offsets[v + 1] < offsets[v])
+            return false;
+    }
+    for (size_t e = 0; e < dataset.edgeCount(); ++e) {
+        if (targets[e] >= vertices)
+            return false;
+    }
+    return true;
+}
+
+} // namespace
+
+SnapshotCache::SnapshotCache(const QString &directory)
+    : m_directory(directory)
+{
+}
+
+QString SnapshotCache::defaultDirectory()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::CacheLocation)
+            + QLatin1String("/snapshots");
+}
+
+QString SnapshotCache::snapshotPath(const QFileInfo &source) const
+{
+    const QByteArray key = QCryptographicHash::hash(source.absoluteFilePath().toUtf8(),
+                                                    QCryptographicHash::Sha1).toHex();
+    return m_directory + QLatin1Char('/') + QString::fromLatin1(key) + QLatin1String(".snap");
+}
+
+Dataset SnapshotCache::open(const QFileInfo &source, bool verifyData) const
+{
+    auto file = std::make_shared<QFile>(snapshotPath(source));
+    if (!file->open(QIODevice::ReadOnly) || file->size() < qint64(sizeof(FileHeader)))
+        return {};
+
+    const uint64_t fileSize = uint64_t(file->size());
+    const uchar *base = file->map(0, file->size());
+    if (!base)
+        return {};
+
+    FileHeader header;
+    std::memcpy(&header, base, sizeof header);
+    const uint64_t storedHeaderChecksum = header.headerChecksum;
+    header.headerChecksum = 0;
+    if (std::memcmp(header.magic, Magic, sizeof Magic) != 0
+        || header.version != FormatVersion
+        || header.byteOrder != ByteOrderMark
+        || storedHeaderChecksum != checksum64(&header, sizeof header)
+        || header.sourceSize != uint64_t(source.size())
+        || header.sourceModified != source.lastModified().toMSecsSinceEpoch()
+        || sizeof(FileHeader) + uint64_t(header.sectionCount) * sizeof(SectionEntry) > fileSize) {
+        return {};
+    }
+
+    const uchar *table = base + sizeof(FileHeader);
+    const uint64_t tableSize = uint64_t(header.sectionCount) * sizeof(SectionEntry);
+    if (checksum64(table, tableSize) != header.tableChecksum)
+        return {};
+
+    Dataset dataset;
+    for (uint32_t i = 0; i < header.sectionCount; ++i) {
+        SectionEntry entry;
+        std::memcpy(&entry, table + i * sizeof(SectionEntry), sizeof entry);
+        if (entry.elementSize != 4 || entry.offset % SectionAlignment != 0 || entry.offset > fileSize
+            || entry.count > (fileSize - entry.offset) / 4)
+            return {};
+        const uint64_t bytes = entry.count * 4;
+        const uchar *data = base + entry.offset;
+        if (verifyData && checksum64(data, bytes) != entry.checksum)
+            return {};
+
+        switch (entry.id) {
+        case ValuesSection:
+            dataset.m_values = reinterpret_cast<const int32_t *>(data);
+            dataset.m_valueCount = entry.count;
+            break;
+        case OffsetsSection:
+            if (entry.count == 0)
+                return {};
+            dataset.m_offsets = reinterpret_cast<const uint32_t *>(data);
+            dataset.m_vertexCount = entry.count - 1;
+            break;
+        case TargetsSection:
+            dataset.m_targets = reinterpret_cast<const uint32_t *>(data);
+            dataset.m_edgeCount = entry.count;
+            break;
+        default:
+            break;
+        }
+    }
+
+    dataset.m_kind = Dataset::Kind(header.kind);
+    if ((dataset.m_kind == Dataset::Kind::Array && !dataset.m_values)
+        || (dataset.m_kind == Dataset::Kind::Graph && (!dataset.m_offsets || !dataset.m_targets))
+        || dataset.m_kind == Dataset::Kind::Empty || header.kind > uint32_t(Dataset::Kind::Graph))
+        return {};
+    if (dataset.m_kind == Dataset::Kind::Graph && !validGraph(dataset))
+        return {};
+
+    // The mapping stays valid after close() and is released with the QFile.
+    file->close();
+    dataset.m_mapping = std::move(file);
+    return dataset;
+}
+
+bool SnapshotCache::store(const QFileInfo &source, const Dataset &dataset, QString *error) const
+{
+    const std::vector<SectionSource> sections = sectionsOf(dataset);
+    if (sections.empty()) {
+        if (error)
+            *error = QStringLiteral("Nothing to store");
+        return false;
+    }
+
+    std::vector<SectionEntry> table(sections.size());
+    uint64_t offset = alignUp(sizeof(FileHeader) + sections.size() * sizeof(SectionEntry));
+    for (size_t i = 0; i < sections.size(); ++i) {
+        const uint64_t bytes = sections[i].count * sections[i].elementSize;
+        table[i] = { sections[i].id, sections[i].elementSize, offset, sections[i].count,
+                     checksum64(sections[i].data, bytes) };
+        offset = alignUp(offset + bytes);
+    }
+
+    FileHeader header = {};
+    std::memcpy(header.magic, Magic, sizeof Magic);
+    header.version = FormatVersion;
+    header.byteOrder = ByteOrderMark;
+    header.kind = uint32_t(dataset.kind());
+    header.sectionCount = uint32_t(sections.size());
+    header.sourceSize = uint64_t(source.size());
+    header.sourceModified = source.lastModified().toMSecsSinceEpoch();
+    header.tableChecksum = checksum64(table.data(), table.size() * sizeof(SectionEntry));
+    header.headerChecksum = checksum64(&header, sizeof header);
+
+    if (!QDir().mkpath(m_directory)) {
+        if (error)
+            *error = QStringLiteral("Cannot create %1").arg(m_directory);
+        return false;
+    }
+
+    QSaveFile file(snapshotPath(source));
+    if (!file.open(QIODevice::WriteOnly)) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+
+    static const char padding[SectionAlignment] = {};
+    auto pad = [&file]() {
+        const qint64 gap = qint64(alignUp(uint64_t(file.pos()))) - file.pos();
+        if (gap > 0)
+            file.write(padding, gap);
+    };
+
+    file.write(reinterpret_cast<const char *>(&header), sizeof header);
+    file.write(reinterpret_cast<const char *>(table.data()),
+               qint64(table.size() * sizeof(SectionEntry)));
+    for (const SectionSource &section : sections) {
+        pad();
+        file.write(static_cast<const char *>(section.data),
+                   qint64(section.count * section.elementSize));
+    }
+
+    if (!file.commit()) {
+        if (error)
+            *error = file.errorString();
+        return false;
+    }
+    return true;
+}
+
+Dataset SnapshotCache::load(const QString &path, QString *error, bool *fromCache) const
+{
+    const QFileInfo source(path);
+    Dataset dataset = open(source);
+    if (fromCache)
+        *fromCache = !dataset.isEmpty();
+    if (!dataset.isEmpty())
+        return dataset;
+
+    dataset = Dataset::importText(path, error);
+    if (!dataset.isEmpty())
+        store(source, dataset);
+    return dataset;
+}
@@ -0,0 +1,37 @@
+#ifndef SNAPSHOTCACHE_H
+#define SNAPSHOTCACHE_H
+
+#include "dataset.h"
+
+#include <QString>
+
+class QFileInfo;
+
+// Native binary snapshots of imported datasets. A snapshot is a 64-byte
+// header, a section table and 64-byte aligned raw sections; it is keyed by
+// the source file's path and validated against its size and mtime, so a
+// later open of the same file maps the snapshot instead of reparsing it.
+class SnapshotCache
+{
+public:
+    explicit SnapshotCache(const QString &directory = defaultDirectory());
+
+    static QString defaultDirectory();
+
+    QString snapshotPath(const QFileInfo &source) const;
+
+    // Maps the snapshot for source if one exists and is current. Header and
+    // section table checksums are always checked, and so is a graph's
+    // structure, which traversals rely on; the section payloads are only
+    // hashed when verifyData is set since that touches every page.
+    Dataset open(const QFileInfo &source, bool verifyData = false) const;
+    bool store(const QFileInfo &source, const Dataset &dataset, QString *error = nullptr) const;
+
+    // open() falling back to Dataset::importText() followed by store().
+    Dataset load(const QString &path, QString *error = nullptr, bool *fromCache = nullptr) const;
+
+private:
+    QString m_directory;
+};
+
+#endif // SNAPSHOTCACHE_H
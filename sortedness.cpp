@@ -0,0 +1,359 @@
+#include "sortedness.h"
+
+#include <algorithm>
+#include <bit>
+#include <cmath>
+#include <limits>
+
+namespace {
+
+constexpr int64_t Unbounded = std::numeric_limits<int64_t>::max();
+
+size_t lowestBit(size_t k)
+{
+    return k & (~k + 1);
+}
+
+// From index to the nearest of the places [first, end) a value takes in
+// the sorted input, or to first if the input does not have it.
+uint32_t sortedDistance(size_t index, size_t first, size_t end)
+{
+    const size_t last = std::max(end, first + 1) - 1;
+    return uint32_t(index < first ? first - index : index > last ? index - last : 0);
+}
+
+} // namespace
+
+// Blocks and buckets of about sqrt(n) keep the grid at about n counters
+// and the scans at a few sqrt(n) elements.
+void Sortedness::start(std::span<const int32_t> input)
+{
+    const size_t n = input.size();
+    m_ranks.assign(input.begin(), input.end());
+    std::sort(m_ranks.begin(), m_ranks.end());
+    m_blockSize = std::max<size_t>(std::bit_ceil(size_t(std::sqrt(double(n)))), 64);
+    m_blocks = (n + m_blockSize - 1) / m_blockSize;
+
+    // Whole values to a bucket, up to m_blockSize elements unless one value
+    // alone has more.
+    m_bucketMins.clear();
+    m_mixed.clear();
+    size_t filled = 0;
+    for (size_t r = 0; r < n;) {
+        const size_t end = size_t(std::upper_bound(m_ranks.begin() + r, m_ranks.end(), m_ranks[r]) - m_ranks.begin());
+        if (m_bucketMins.empty() || filled + (end - r) > m_blockSize) {
+            m_bucketMins.push_back(m_ranks[r]);
+            m_mixed.push_back(false);
+            filled = 0;
+        } else {
+            m_mixed.back() = true;
+        }
+        filled += end - r;
+        r = end;
+    }
+    reset(input);
+}
+
+void Sortedness::reset(std::span<const int32_t> values)
+{
+    const size_t n = values.size();
+    const size_t buckets = m_bucketMins.size();
+    const size_t row = buckets + 1;
+    m_values.assign(values.begin(), values.end());
+
+    // One walk over the values in order, beside the sorted input and the
+    // buckets, finds where each value sorts; a binary search per element
+    // is several times slower at a million.
+    std::vector<std::pair<int32_t, uint32_t>> order(n);
+    for (size_t i = 0; i < n; ++i)
+        order[i] = { m_values[i], uint32_t(i) };
+    std::sort(order.begin(), order.end());
+    std::vector<uint32_t> notAbove(n); // input values not above each element's
+    m_grid.assign((m_blocks + 1) * row, 0);
+    m_members.assign(buckets, {});
+    m_slots.assign(n, 0);
+    m_displacement.assign(2 * n, 0);
+    size_t first = 0;
+    size_t end = 0;
+    size_t b = 0;
+    for (const auto &[value, index] : order) {
+        while (first < n && m_ranks[first] < value)
+            ++first;
+        end = std::max(end, first);
+        while (end < n && m_ranks[end] <= value)
+            ++end;
+        while (b + 1 < buckets && m_bucketMins[b + 1] <= value)
+            ++b;
+        notAbove[index] = uint32_t(end);
+        m_displacement[n + index] = sortedDistance(index, first, end);
+        ++m_grid[(index / m_blockSize + 1) * row + b + 1];
+        addMember(b, index, value);
+    }
+
+    // Counts per cell first, then each cell takes in the ones its Fenwick
+    // range covers, along rows and then down columns.
+    for (size_t x = 1; x <= m_blocks; ++x) {
+        for (size_t y = 1; y <= buckets; ++y) {
+            if (y + lowestBit(y) <= buckets)
+                m_grid[x * row + y + lowestBit(y)] += m_grid[x * row + y];
+        }
+    }
+    for (size_t x = 1; x <= m_blocks; ++x) {
+        if (x + lowestBit(x) > m_blocks)
+            continue;
+        for (size_t y = 1; y <= buckets; ++y)
+            m_grid[(x + lowestBit(x)) * row + y] += m_grid[x * row + y];
+    }
+
+    // Each element is out of order with the larger ones seen before it.
+    std::vector<uint32_t> seen(n + 1, 0);
+    m_inversions = 0;
+    for (size_t i = 0; i < n; ++i) {
+        uint64_t notLarger = 0;
+        for (size_t k = notAbove[i]; k > 0; k &= k - 1)
+            notLarger += seen[k];
+        m_inversions += i - notLarger;
+        for (size_t k = notAbove[i]; k <= n; k += lowestBit(k))
+            ++seen[k];
+    }
+
+    m_descents = 0;
+    for (size_t i = 0; i + 1 < n; ++i)
+        m_descents += descent(i);
+
+    for (size_t node = n; node-- > 1;)
+        m_displacement[node] = std::max(m_displacement[2 * node], m_displacement[2 * node + 1]);
+}
+
+void Sortedness::apply(const VisualEvent &event)
+{
+    if (event.kind == VisualEvent::Swap)
+        swap(event.a, event.b);
+    else if (event.kind == VisualEvent::Write)
+        set(event.a, event.value);
+}
+
+void Sortedness::undo(const VisualEvent &event)
+{
+    if (event.kind == VisualEvent::Swap)
+        swap(event.a, event.b);
+    else if (event.kind == VisualEvent::Write)
+        set(event.a, event.previous);
+}
+
+uint64_t Sortedness::mostInversions() const
+{
+    const uint64_t n = m_values.size();
+    return n ? n * (n - 1) / 2 : 0;
+}
+
+size_t Sortedness::memoryBytes() const
+{
+    size_t bytes = (m_values.capacity() + m_ranks.capacity() + m_bucketMins.capacity()) * sizeof(int32_t)
+                 + (m_grid.capacity() + m_slots.capacity() + m_displacement.capacity()) * sizeof(uint32_t)
+                 + m_members.capacity() * sizeof(m_members[0]) + m_mixed.capacity() / 8;
+    for (const auto &members : m_members)
+        bytes += members.capacity() * sizeof(members[0]);
+    return bytes;
+}
+
+// Pairs with the elements before it are out of order when those are
+// larger, and with the elements after it when those are smaller.
+void Sortedness::set(size_t index, int32_t value)
+{
+    const int32_t old = m_values[index];
+    if (value == old)
+        return;
+    const size_t n = m_values.size();
+    if (value > old) {
+        m_inversions += count(index + 1, n, old, value);
+        m_inversions -= count(0, index, int64_t(old) + 1, int64_t(value) + 1);
+    } else {
+        m_inversions += count(0, index, int64_t(value) + 1, int64_t(old) + 1);
+        m_inversions -= count(index + 1, n, value, old);
+    }
+
+    m_descents -= (index > 0 && descent(index - 1)) + descent(index);
+    m_values[index] = value;
+    m_descents += (index > 0 && descent(index - 1)) + descent(index);
+
+    const size_t from = bucket(old);
+    const size_t to = bucket(value);
+    if (from != to) {
+        addToGrid(index, from, -1);
+        addToGrid(index, to, 1);
+        removeMember(from, index);
+        addMember(to, index, value);
+    } else if (m_mixed[to]) {
+        m_members[to][m_slots[index]].second = value;
+    }
+    displace(index);
+}
+
+// Swapping x and y flips their own pair and, for every element between
+// them with a value between theirs, its pairs with both; an element equal
+// to one of them only has a pair with the other.
+void Sortedness::swap(size_t i, size_t j)
+{
+    if (i > j)
+        std::swap(i, j);
+    const int32_t x = m_values[i];
+    const int32_t y = m_values[j];
+    if (x == y)
+        return;
+    const int64_t low = std::min(x, y);
+    const int64_t high = std::max(x, y);
+    const uint64_t flipped = 1 + count(i + 1, j, low, high + 1) + count(i + 1, j, low + 1, high);
+    if (x < y)
+        m_inversions += flipped;
+    else
+        m_inversions -= flipped;
+
+    const size_t neighbours[] = { i - 1, i, j - 1, j };
+    const auto descents = [&] {
+        size_t total = 0;
+        for (size_t k = 0; k < 4; ++k) {
+            const size_t at = neighbours[k];
+            if (at < m_values.size() && (k != 2 || at != i))
+                total += descent(at);
+        }
+        return total;
+    };
+    m_descents -= descents();
+    std::swap(m_values[i], m_values[j]);
+    m_descents += descents();
+
+    const size_t bx = bucket(x);
+    const size_t by = bucket(y);
+    if (bx != by && i / m_blockSize != j / m_blockSize) {
+        addToGrid(i, bx, -1);
+        addToGrid(j, bx, 1);
+        addToGrid(j, by, -1);
+        addToGrid(i, by, 1);
+    }
+    const uint32_t slotX = m_slots[i];
+    const uint32_t slotY = m_slots[j];
+    if (m_mixed[bx]) {
+        m_members[bx][slotX].first = uint32_t(j);
+        m_slots[j] = slotX;
+    }
+    if (m_mixed[by]) {
+        m_members[by][slotY].first = uint32_t(i);
+        m_slots[i] = slotY;
+    }
+    displace(i);
+    displace(j);
+}
+
+uint64_t Sortedness::count(size_t begin, size_t end, int64_t low, int64_t high) const
+{
+    low = snap(low);
+    high = snap(high);
+    if (begin >= end || low >= high)
+        return 0;
+    return prefix(end, low, high) - prefix(begin, low, high);
+}
+
+// Whole blocks and buckets come from the grid. What is left is the part
+// block at the end, and the buckets low and high fall inside, if they do;
+// both being input values, those are buckets of several values.
+uint64_t Sortedness::prefix(size_t end, int64_t low, int64_t high) const
+{
+    const size_t blocks = end / m_blockSize;
+    const size_t edge = blocks * m_blockSize;
+    uint64_t total = 0;
+    for (size_t i = edge; i < end; ++i)
+        total += m_values[i] >= low && m_values[i] < high;
+    if (blocks == 0)
+        return total;
+
+    const size_t lowBucket = bucket(low);
+    const size_t highBucket = high == Unbounded ? m_bucketMins.size() : bucket(high);
+    const bool lowInside = m_bucketMins[lowBucket] != low;
+    const bool highInside = highBucket < m_bucketMins.size() && m_bucketMins[highBucket] != high;
+    const size_t first = lowBucket + lowInside;
+    if (first < highBucket)
+        total += gridPrefix(blocks, highBucket) - gridPrefix(blocks, first);
+
+    const auto scan = [&](size_t b) {
+        for (const auto &[index, value] : m_members[b])
+            total += index < edge && value >= low && value < high;
+    };
+    if (lowBucket == highBucket) {
+        if (lowInside || highInside)
+            scan(lowBucket);
+    } else {
+        if (lowInside)
+            scan(lowBucket);
+        if (highInside)
+            scan(highBucket);
+    }
+    return total;
+}
+
+int64_t Sortedness::snap(int64_t value) const
+{
+    const auto at = std::lower_bound(m_ranks.begin(), m_ranks.end(), value);
+    return at == m_ranks.end() ? Unbounded : *at;
+}
+
+size_t Sortedness::bucket(int64_t value) const
+{
+    const auto at = std::upper_bound(m_bucketMins.begin(), m_bucketMins.end(), value);
+    return at == m_bucketMins.begin() ? 0 : size_t(at - m_bucketMins.begin()) - 1;
+}
+
+uint64_t Sortedness::gridPrefix(size_t blocks, size_t buckets) const
+{
+    const size_t row = m_bucketMins.size() + 1;
+    uint64_t total = 0;
+    for (size_t x = blocks; x > 0; x &= x - 1) {
+        for (size_t y = buckets; y > 0; y &= y - 1)
+            total += m_grid[x * row + y];
+    }
+    return total;
+}
+
+void Sortedness::addToGrid(size_t index, size_t bucket, int32_t amount)
+{
+    const size_t row = m_bucketMins.size() + 1;
+    for (size_t x = index / m_blockSize + 1; x <= m_blocks; x += lowestBit(x)) {
+        for (size_t y = bucket + 1; y < row; y += lowestBit(y))
+            m_grid[x * row + y] += uint32_t(amount);
+    }
+}
+
+void Sortedness::addMember(size_t bucket, size_t index, int32_t value)
+{
+    if (!m_mixed[bucket])
+        return;
+    m_slots[index] = uint32_t(m_members[bucket].size());
+    m_members[bucket].emplace_back(uint32_t(index), value);
+}
+
+void Sortedness::removeMember(size_t bucket, size_t index)
+{
+    if (!m_mixed[bucket])
+        return;
+    auto &members = m_members[bucket];
+    const uint32_t slot = m_slots[index];
+    members[slot] = members.back();
+    m_slots[members[slot].first] = slot;
+    members.pop_back();
+}
+
+uint32_t Sortedness::displacement(size_t index) const
+{
+    const int32_t value = m_values[index];
+    const auto first = std::lower_bound(m_ranks.begin(), m_ranks.end(), value);
+    const auto end = std::upper_bound(first, m_ranks.end(), value);
+    return sortedDistance(index, size_t(first - m_ranks.begin()), size_t(end - m_ranks.begin()));
+}
+
+void Sortedness::displace(size_t index)
+{
+    size_t node = m_values.size() + index;
+    m_displacement[node] = displacement(index);
+    for (node /= 2; node >= 1; node /= 2)
+        m_displacement[node] = std::max(m_displacement[2 * node], m_displacement[2 * node + 1]);
+}
@@ -0,0 +1,97 @@
+#ifndef SORTEDNESS_H
+#define SORTEDNESS_H
+
+#include "stepper.h"
+
+#include <cstddef>
+#include <cstdint>
+#include <span>
+#include <utility>
+#include <vector>
+
+// How sorted an array is, kept up to date as a player applies or undoes
+// events one at a time:
+//
+//  - inversions, the pairs out of order. reset() counts them with a
+//    Fenwick tree over value ranks, O(n log n). After that a changed
+//    element only alters the pairs it is in: a swap moves the count by the
+//    elements between the two places with values between the two values,
+//    a write by those on either side with values between the old and the
+//    new one. Those are counted with a two-dimensional Fenwick tree over
+//    blocks of positions and buckets of values, both about sqrt(n) wide:
+//    O(log^2 n) for the whole blocks and buckets, plus a scan of the block
+//    and the buckets the range ends inside. A value with too many copies
+//    for one bucket gets a bucket to itself, and a range never ends inside
+//    those, so the scans stay short for any input.
+//  - runs, the maximal non-descending stretches, from the neighbours of
+//    the changed elements in O(1).
+//  - the largest displacement, how far any element is from the nearest
+//    place its value would have sorted, from a max tree in O(log n).
+//
+// The counts assume every value in the array is one of the input's, as
+// holds for the catalog sorts, which only move values around; any other
+// value counts as the next larger one the input has.
+class Sortedness
+{
+public:
+    void start(std::span<const int32_t> input);
+    // Another state of the same run, as when a player jumps to a checkpoint.
+    void reset(std::span<const int32_t> values);
+
+    void apply(const VisualEvent &event);
+    void undo(const VisualEvent &event);
+
+    size_t size() const { return m_values.size(); }
+    uint64_t inversions() const { return m_inversions; }
+    // n (n - 1) / 2, for a reversed array of distinct values.
+    uint64_t mostInversions() const;
+    size_t runs() const { return m_values.empty() ? 0 : m_descents + 1; }
+    size_t maxDisplacement() const { return m_displacement.size() > 1 ? m_displacement[1] : 0; }
+    size_t memoryBytes() const;
+
+private:
+    void set(size_t index, int32_t value);
+    void swap(size_t i, size_t j);
+
+    // Elements in [begin, end) with low <= value < high.
+    uint64_t count(size_t begin, size_t end, int64_t low, int64_t high) const;
+    // The same in [0, end), with low and high snapped.
+    uint64_t prefix(size_t end, int64_t low, int64_t high) const;
+    // The smallest input value not below value, or Unbounded.
+    int64_t snap(int64_t value) const;
+    size_t bucket(int64_t value) const;
+    uint64_t gridPrefix(size_t blocks, size_t buckets) const;
+    void addToGrid(size_t index, size_t bucket, int32_t amount);
+    void addMember(size_t bucket, size_t index, int32_t value);
+    void removeMember(size_t bucket, size_t index);
+
+    bool descent(size_t index) const { return index + 1 < m_values.size() && m_values[index] > m_values[index + 1]; }
+    uint32_t displacement(size_t index) const;
+    void displace(size_t index);
+
+    std::vector<int32_t> m_values;
+    std::vector<int32_t> m_ranks; // the input, sorted
+
+    size_t m_blockSize = 1;
+    size_t m_blocks = 0;
+    // The smallest input value in each bucket; a bucket takes every value
+    // up to the next one's.
+    std::vector<int32_t> m_bucketMins;
+    // Elements per block and bucket, one-based both ways, with a row of
+    // m_bucketMins.size() + 1 per block.
+    std::vector<uint32_t> m_grid;
+    // Buckets of more than one input value are the only ones a range can
+    // end inside; for those, the elements in them as (index, value), and
+    // where each index sits in its bucket's list.
+    std::vector<std::vector<std::pair<uint32_t, int32_t>>> m_members;
+    std::vector<bool> m_mixed;
+    std::vector<uint32_t> m_slots;
+
+    // Leaves at [n, 2n) hold each element's displacement, node i the
+    // largest of nodes 2i and 2i + 1.
+    std::vector<uint32_t> m_displacement;
+    uint64_t m_inversions = 0;
+    size_t m_descents = 0;
+};
+
+#endif // SORTEDNESS_H
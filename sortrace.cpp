@@ -0,0 +1,85 @@
+#include "sortrace.h"
+
+#include <algorithm>
+
+void SortRace::start(const std::vector<Entry> &entries, size_t size, uint32_t seed)
+{
+    std::vector<int32_t> inputs[Sorts::ShapeCount];
+    m_lanes.clear();
+    m_lanes.resize(entries.size());
+    for (size_t i = 0; i < entries.size(); ++i) {
+        Lane &lane = m_lanes[i];
+        std::vector<int32_t> &input = inputs[int(entries[i].shape)];
+        if (input.empty())
+            input = Sorts::makeInput(entries[i].shape, size, seed);
+        lane.algorithm = entries[i].algorithm;
+        lane.input = Sorts::shapeName(entries[i].shape);
+        lane.values = input;
+        // The coroutine keeps a span of values, so the lane must not move
+        // after this; m_lanes is not resized again until the next start().
+        lane.stepper = lane.algorithm->run(lane.values);
+    }
+    m_finished = 0;
+}
+
+void SortRace::start(const Sorts::Algorithm *algorithm, std::vector<int32_t> values, const std::string &input)
+{
+    m_lanes.clear();
+    m_lanes.resize(1);
+    Lane &lane = m_lanes.front();
+    lane.algorithm = algorithm;
+    lane.input = input;
+    lane.values = std::move(values);
+    lane.stepper = algorithm->run(lane.values);
+    m_finished = 0;
+}
+
+std::vector<SortRace::Entry> SortRace::allPairs()
+{
+    std::vector<Entry> entries;
+    for (const Sorts::Algorithm &algorithm : Sorts::algorithms()) {
+        if (algorithm.unbounded)
+            continue;
+        for (int shape = 0; shape < Sorts::ShapeCount; ++shape)
+            entries.push_back({ &algorithm, Sorts::Shape(shape) });
+    }
+    return entries;
+}
+
+bool SortRace::advance(uint64_t eventsPerLane, std::chrono::steady_clock::time_point deadline)
+{
+    constexpr uint64_t RoundSize = 256;
+    for (uint64_t remaining = eventsPerLane; remaining > 0 && m_finished < int(m_lanes.size());) {
+        const uint64_t round = std::min(remaining, RoundSize);
+        for (Lane &lane : m_lanes) {
+            if (lane.finishedPlace)
+                continue;
+            for (uint64_t i = 0; i < round; ++i) {
+                if (!lane.stepper.next()) {
+                    lane.finishedPlace = ++m_finished;
+                    break;
+                }
+                lane.last = lane.stepper.event();
+                ++lane.events;
+                switch (lane.last.kind) {
+                case VisualEvent::Compare:
+                    ++lane.compares;
+                    break;
+                case VisualEvent::Swap:
+                    ++lane.swaps;
+                    break;
+                case VisualEvent::Write:
+                    ++lane.writes;
+                    break;
+                case VisualEvent::Mark:
+                    lane.range = lane.last;
+                    break;
+                }
+            }
+        }
+        remaining -= round;
+        if (std::chrono::steady_clock::now() >= deadline)
+            break;
+    }
+    return m_finished < int(m_lanes.size());
+}
@@ -0,0 +1,59 @@
+#ifndef SORTRACE_H
+#define SORTRACE_H
+
+#include "sorts.h"
+#include "stepper.h"
+
+#include <chrono>
+#include <cstdint>
+#include <string>
+#include <vector>
+
+// Runs many sorts side by side on the calling thread. Every lane gets the
+// same number of events per round, so lanes finish in the order of how much
+// work their algorithm needs on their input, independent of frame rate.
+class SortRace
+{
+public:
+    struct Entry
+    {
+        const Sorts::Algorithm *algorithm;
+        Sorts::Shape shape;
+    };
+
+    struct Lane
+    {
+        const Sorts::Algorithm *algorithm = nullptr;
+        std::string input; // shape name, or what the values came from
+        std::vector<int32_t> values;
+        Stepper stepper;
+        VisualEvent last; // most recent event, for highlighting
+        VisualEvent range; // most recent Mark: the part being worked on
+        uint64_t events = 0;
+        uint64_t compares = 0;
+        uint64_t swaps = 0;
+        uint64_t writes = 0;
+        int finishedPlace = 0; // 1 for the first lane to finish, 0 while running
+    };
+
+    // All lanes with the same shape start from the same array.
+    void start(const std::vector<Entry> &entries, size_t size, uint32_t seed);
+    // A single lane sorting the given values.
+    void start(const Sorts::Algorithm *algorithm, std::vector<int32_t> values, const std::string &input);
+    // Every bounded algorithm on every shape, algorithm-major.
+    static std::vector<Entry> allPairs();
+
+    // Gives every running lane up to eventsPerLane more events, in rounds
+    // of a few hundred so a passed deadline can cut the frame short without
+    // favouring the first lanes. Returns false once all lanes are done.
+    bool advance(uint64_t eventsPerLane, std::chrono::steady_clock::time_point deadline);
+
+    const std::vector<Lane> &lanes() const { return m_lanes; }
+    int running() const { return int(m_lanes.size()) - m_finished; }
+
+private:
+    std::vector<Lane> m_lanes;
+    int m_finished = 0;
+};
+
+#endif // SORTRACE_H
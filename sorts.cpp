@@ -0,0 +1,538 @@
+#include "sorts.h"
+
+#include "inplacesort.h"
+#include "mergepath.h"
+#include "tuning.h"
+
+#include <algorithm>
+#include <array>
+#include <numeric>
+#include <random>
+
+namespace Sorts {
+
+namespace {
+
+thread_local Watcher *t_watcher = nullptr;
+
+Stepper bubbleSort(std::span<int32_t> v)
+{
+    for (size_t end = v.size(); end > 1;) {
+        size_t lastSwap = 0;
+        for (size_t i = 1; i < end; ++i) {
+            co_yield VisualEvent::compare(i - 1, i);
+            if (v[i] < v[i - 1]) {
+                co_yield VisualEvent::swap(v, i - 1, i);
+                lastSwap = i;
+            }
+        }
+        end = lastSwap;
+    }
+}
+
+Stepper insertionSort(std::span<int32_t> v)
+{
+    for (size_t i = 1; i < v.size(); ++i) {
+        for (size_t j = i; j > 0; --j) {
+            co_yield VisualEvent::compare(j - 1, j);
+            if (!(v[j] < v[j - 1]))
+                break;
+            co_yield VisualEvent::swap(v, j - 1, j);
+        }
+    }
+}
+
+Stepper selectionSort(std::span<int32_t> v)
+{
+    for (size_t i = 0; i + 1 < v.size(); ++i) {
+        size_t smallest = i;
+        for (size_t j = i + 1; j < v.size(); ++j) {
+            co_yield VisualEvent::compare(smallest, j);
+            if (v[j] < v[smallest])
+                smallest = j;
+        }
+        if (smallest != i)
+            co_yield VisualEvent::swap(v, i, smallest);
+    }
+}
+
+// Ciura's gaps, extended by a factor of 2.25 for large arrays.
+Stepper shellSort(std::span<int32_t> v)
+{
+    std::vector<size_t> gaps = { 1, 4, 10, 23, 57, 132, 301, 701 };
+    while (gaps.back() * 2 < v.size())
+        gaps.push_back(gaps.back() * 9 / 4);
+    for (auto gap = gaps.rbegin(); gap != gaps.rend(); ++gap) {
+        if (*gap >= v.size())
+            continue;
+        co_yield VisualEvent::mark(0, v.size(), int32_t(*gap));
+        for (size_t i = *gap; i < v.size(); ++i) {
+            for (size_t j = i; j >= *gap; j -= *gap) {
+                co_yield VisualEvent::compare(j - *gap, j);
+                if (!(v[j] < v[j - *gap]))
+                    break;
+                co_yield VisualEvent::swap(v, j - *gap, j);
+            }
+        }
+    }
+}
+
+// Top-down, merging through one scratch buffer. Comparisons are reported
+// at the positions the two candidates came from.
+Stepper mergeSortRange(std::span<int32_t> v, std::span<int32_t> scratch, size_t begin, size_t end)
+{
+    if (end - begin < 2)
+        co_return;
+    const size_t middle = begin + (end - begin) / 2;
+    co_await mergeSortRange(v, scratch, begin, middle);
+    co_await mergeSortRange(v, scratch, middle, end);
+
+    co_yield VisualEvent::mark(begin, end);
+    std::copy(v.begin() + begin, v.begin() + end, scratch.begin() + begin);
+    size_t left = begin;
+    size_t right = middle;
+    for (size_t out = begin; out < end; ++out) {
+        bool takeRight = left == middle;
+        if (left < middle && right < end) {
+            co_yield VisualEvent::compare(left, right);
+            takeRight = scratch[right] < scratch[left];
+        }
+        co_yield VisualEvent::write(v, out, takeRight ? scratch[right++] : scratch[left++]);
+    }
+}
+
+Stepper mergeSort(std::span<int32_t> v)
+{
+    std::vector<int32_t> scratch(v.size());
+    co_await mergeSortRange(v, scratch, 0, v.size());
+}
+
+// Bottom-up, with every pass cut into Lanes equal pieces of output, each
+// starting where MergePath::split puts it and merging from there; the
+// lanes run one after another here. Its native version, MergePath::sort,
+// only shares the splitting: it stable sorts a block per pool thread first
+// and cuts each pass into as many pieces as the pool wants.
+Stepper mergePathSort(std::span<int32_t> v)
+{
+    constexpr size_t Lanes = 8;
+    const size_t size = v.size();
+    std::vector<int32_t> scratch(size);
+    for (size_t width = 1; width < size; width *= 2) {
+        std::copy(v.begin(), v.end(), scratch.begin());
+        const std::span<const int32_t> from = scratch;
+        for (size_t lane = 0; lane < Lanes; ++lane) {
+            const size_t end = size * (lane + 1) / Lanes;
+            size_t out = size * lane / Lanes;
+            if (out < end)
+                co_yield VisualEvent::mark(out, end, int32_t(lane));
+            while (out < end) {
+                const size_t runBegin = out / (2 * width) * (2 * width);
+                const size_t middle = std::min(runBegin + width, size);
+                const size_t runEnd = std::min(runBegin + 2 * width, size);
+                const size_t diagonal = out - runBegin;
+                const size_t taken = MergePath::split(from.subspan(runBegin, middle - runBegin),
+                                                      from.subspan(middle, runEnd - middle), diagonal);
+
+                size_t left = runBegin + taken;
+                size_t right = middle + diagonal - taken;
+                for (const size_t stop = std::min(end, runEnd); out < stop; ++out) {
+                    bool takeRight = left == middle;
+                    if (left < middle && right < runEnd) {
+                        co_yield VisualEvent::compare(left, right);
+                        takeRight = scratch[right] < scratch[left];
+                    }
+                    co_yield VisualEvent::write(v, out, takeRight ? scratch[right++] : scratch[left++]);
+                }
+            }
+        }
+    }
+}
+
+// Hoare partitioning around a median of three. The smaller side recurses,
+// the larger one loops, so the recursion stays logarithmic.
+Stepper quickSortRange(std::span<int32_t> v, size_t begin, size_t end)
+{
+    while (end - begin > 1) {
+        co_yield VisualEvent::mark(begin, end);
+        const size_t last = end - 1;
+        size_t pivot = begin + (last - begin) / 2;
+        co_yield VisualEvent::compare(begin, pivot);
+        if (v[pivot] < v[begin])
+            co_yield VisualEvent::swap(v, begin, pivot);
+        co_yield VisualEvent::compare(pivot, last);
+        if (v[last] < v[pivot]) {
+            co_yield VisualEvent::swap(v, pivot, last);
+            co_yield VisualEvent::compare(begin, pivot);
+            if (v[pivot] < v[begin])
+                co_yield VisualEvent::swap(v, begin, pivot);
+        }
+
+        // The pivot value moves when it is swapped; track where it is so
+        // the comparisons point at it.
+        ptrdiff_t i = ptrdiff_t(begin) - 1;
+        ptrdiff_t j = ptrdiff_t(end);
+        for (;;) {
+            do {
+                ++i;
+                co_yield VisualEvent::compare(size_t(i), pivot);
+            } while (v[size_t(i)] < v[pivot]);
+            do {
+                --j;
+                co_yield VisualEvent::compare(size_t(j), pivot);
+            } while (v[pivot] < v[size_t(j)]);
+            if (i >= j)
+                break;
+            co_yield VisualEvent::swap(v, size_t(i), size_t(j));
+            if (pivot == size_t(i))
+                pivot = size_t(j);
+            else if (pivot == size_t(j))
+                pivot = size_t(i);
+        }
+
+        const size_t split = size_t(j) + 1;
+        if (split - begin < end - split) {
+            co_await quickSortRange(v, begin, split);
+            begin = split;
+        } else {
+            co_await quickSortRange(v, split, end);
+            end = split;
+        }
+    }
+}
+
+Stepper quickSort(std::span<int32_t> v)
+{
+    return quickSortRange(v, 0, v.size());
+}
+
+Stepper heapSort(std::span<int32_t> v)
+{
+    const auto siftDown = [](std::span<int32_t> v, size_t root, size_t end) -> Stepper {
+        for (size_t child; (child = root * 2 + 1) < end; root = child) {
+            if (child + 1 < end) {
+                co_yield VisualEvent::compare(child, child + 1);
+                if (v[child] < v[child + 1])
+                    ++child;
+            }
+            co_yield VisualEvent::compare(root, child);
+            if (!(v[root] < v[child]))
+                break;
+            co_yield VisualEvent::swap(v, root, child);
+        }
+    };
+    for (size_t root = v.size() / 2; root-- > 0;)
+        co_await siftDown(v, root, v.size());
+    for (size_t end = v.size(); end > 1;) {
+        co_yield VisualEvent::swap(v, 0, --end);
+        co_await siftDown(v, 0, end);
+    }
+}
+
+// LSD radix sort on bytes, with the sign bit flipped so negative values
+// order first. Passes where every value has the same digit are skipped.
+Stepper radixSort(std::span<int32_t> v)
+{
+    std::vector<int32_t> scratch(v.size());
+    for (int shift = 0; shift < 32; shift += 8) {
+        const auto digit = [shift](int32_t value) { return (uint32_t(value) ^ 0x80000000u) >> shift & 255; };
+        std::array<size_t, 256> counts {};
+        for (int32_t value : v)
+            ++counts[digit(value)];
+        if (std::find(counts.begin(), counts.end(), v.size()) != counts.end())
+            continue;
+        co_yield VisualEvent::mark(0, v.size(), shift);
+        std::exclusive_scan(counts.begin(), counts.end(), counts.begin(), size_t(0));
+        std::copy(v.begin(), v.end(), scratch.begin());
+        for (int32_t value : scratch)
+            co_yield VisualEvent::write(v, counts[digit(value)]++, value);
+    }
+}
+
+// Plain versions of the sorts that matter at sizes where stepping costs too
+// much. Each makes the same moves as its coroutine above, minus the events,
+// except where the machine's Tuning profile says otherwise: merge and quick
+// sort hand short ranges to insertion sort, and radix digits change width.
+// Keep the two in step when changing either. Merge-path's native version is
+// MergePath::sort, which works differently; see mergePathSort. They call
+// checkpoint() after every merge, partition or pass, and every 2^16 rounds
+// of the loops that have none of those.
+
+void insertionSortNative(std::span<int32_t> v, size_t begin, size_t end)
+{
+    for (size_t i = begin + 1; i < end; ++i) {
+        for (size_t j = i; j > begin && v[j] < v[j - 1]; --j)
+            std::swap(v[j - 1], v[j]);
+    }
+}
+
+void shellSortNative(std::span<int32_t> v)
+{
+    std::vector<size_t> gaps = { 1, 4, 10, 23, 57, 132, 301, 701 };
+    while (gaps.back() * 2 < v.size())
+        gaps.push_back(gaps.back() * 9 / 4);
+    for (auto gap = gaps.rbegin(); gap != gaps.rend(); ++gap) {
+        for (size_t i = *gap; i < v.size(); ++i) {
+            for (size_t j = i; j >= *gap && v[j] < v[j - *gap]; j -= *gap)
+                std::swap(v[j - *gap], v[j]);
+            if (i % 65536 == 0)
+                checkpoint(v);
+        }
+    }
+}
+
+void mergeSortNativeRange(std::span<int32_t> v, std::span<int32_t> scratch, size_t begin, size_t end)
+{
+    if (end - begin <= Tuning::current().insertionCutoff) {
+        insertionSortNative(v, begin, end);
+        return;
+    }
+    const size_t middle = begin + (end - begin) / 2;
+    mergeSortNativeRange(v, scratch, begin, middle);
+    mergeSortNativeRange(v, scratch, middle, end);
+    std::copy(v.begin() + begin, v.begin() + end, scratch.begin() + begin);
+    size_t left = begin;
+    size_t right = middle;
+    for (size_t out = begin; out < end; ++out) {
+        const bool takeRight = left == middle || (right < end && scratch[right] < scratch[left]);
+        v[out] = takeRight ? scratch[right++] : scratch[left++];
+    }
+    checkpoint(v);
+}
+
+void mergeSortNative(std::span<int32_t> v)
+{
+    std::vector<int32_t> scratch(v.size());
+    mergeSortNativeRange(v, scratch, 0, v.size());
+}
+
+void quickSortNativeRange(std::span<int32_t> v, size_t begin, size_t end)
+{
+    const size_t cutoff = std::max<size_t>(Tuning::current().insertionCutoff, 1);
+    while (end - begin > cutoff) {
+        const size_t last = end - 1;
+        size_t pivot = begin + (last - begin) / 2;
+        if (v[pivot] < v[begin])
+            std::swap(v[begin], v[pivot]);
+        if (v[last] < v[pivot]) {
+            std::swap(v[pivot], v[last]);
+            if (v[pivot] < v[begin])
+                std::swap(v[begin], v[pivot]);
+        }
+
+        ptrdiff_t i = ptrdiff_t(begin) - 1;
+        ptrdiff_t j = ptrdiff_t(end);
+        for (;;) {
+            do {
+                ++i;
+            } while (v[size_t(i)] < v[pivot]);
+            do {
+                --j;
+            } while (v[pivot] < v[size_t(j)]);
+            if (i >= j)
+                break;
+            std::swap(v[size_t(i)], v[size_t(j)]);
+            if (pivot == size_t(i))
+                pivot = size_t(j);
+            else if (pivot == size_t(j))
+                pivot = size_t(i);
+        }
+        checkpoint(v);
+
+        const size_t split = size_t(j) + 1;
+        if (split - begin < end - split) {
+            quickSortNativeRange(v, begin, split);
+            begin = split;
+        } else {
+            quickSortNativeRange(v, split, end);
+            end = split;
+        }
+    }
+    insertionSortNative(v, begin, end);
+}
+
+void quickSortNative(std::span<int32_t> v)
+{
+    quickSortNativeRange(v, 0, v.size());
+}
+
+void heapSortNative(std::span<int32_t> v)
+{
+    const auto siftDown = [v](size_t root, size_t end) {
+        for (size_t child; (child = root * 2 + 1) < end; root = child) {
+            if (child + 1 < end && v[child] < v[child + 1])
+                ++child;
+            if (!(v[root] < v[child]))
+                break;
+            std::swap(v[root], v[child]);
+        }
+    };
+    for (size_t root = v.size() / 2; root-- > 0;) {
+        siftDown(root, v.size());
+        if (root % 65536 == 0)
+            checkpoint(v);
+    }
+    for (size_t end = v.size(); end > 1;) {
+        std::swap(v[0], v[--end]);
+        siftDown(0, end);
+        if (end % 65536 == 0)
+            checkpoint(v);
+    }
+}
+
+void radixSortNative(std::span<int32_t> v)
+{
+    const int bits = Tuning::current().radixBits;
+    const uint32_t mask = (1u << bits) - 1;
+    std::vector<int32_t> scratch(v.size());
+    std::vector<size_t> counts(size_t(mask) + 1);
+    for (int shift = 0; shift < 32; shift += bits) {
+        const auto digit = [shift, mask](int32_t value) { return (uint32_t(value) ^ 0x80000000u) >> shift & mask; };
+        std::fill(counts.begin(), counts.end(), 0);
+        for (int32_t value : v)
+            ++counts[digit(value)];
+        if (std::find(counts.begin(), counts.end(), v.size()) != counts.end())
+            continue;
+        std::exclusive_scan(counts.begin(), counts.end(), counts.begin(), size_t(0));
+        std::copy(v.begin(), v.end(), scratch.begin());
+        for (int32_t value : scratch)
+            v[counts[digit(value)]++] = value;
+        checkpoint(v);
+    }
+}
+
+// Shuffles until sorted, from a fixed seed so that runs repeat exactly.
+Stepper bogoSort(std::span<int32_t> v)
+{
+    uint32_t state = 2463534242u;
+    for (;;) {
+        bool sorted = true;
+        for (size_t i = 1; i < v.size() && sorted; ++i) {
+            co_yield VisualEvent::compare(i - 1, i);
+            sorted = !(v[i] < v[i - 1]);
+        }
+        if (sorted)
+            co_return;
+        for (size_t i = v.size(); i > 1; --i) {
+            state ^= state << 13;
+            state ^= state >> 17;
+            state ^= state << 5;
+            co_yield VisualEvent::swap(v, i - 1, state % i);
+        }
+    }
+}
+
+constexpr Algorithm Catalog[] = {
+    { "bubble", bubbleSort, nullptr, false, true },
+    { "insertion", insertionSort, nullptr, false, true },
+    { "selection", selectionSort },
+    { "shell", shellSort, shellSortNative },
+    { "merge", mergeSort, mergeSortNative, false, true },
+    { "merge-path", mergePathSort, MergePath::sort, false, true },
+    { "rotate-merge", InPlaceSort::rotateMerge, InPlaceSort::rotateMergeNative, false, true },
+    { "block-merge", InPlaceSort::blockMerge, InPlaceSort::blockMergeNative, false, true },
+    { "quick", quickSort, quickSortNative },
+    { "heap", heapSort, heapSortNative },
+    { "radix", radixSort, radixSortNative, false, true },
+    { "bogo", bogoSort, nullptr, true },
+};
+
+constexpr const char *ShapeNames[ShapeCount] = {
+    "random", "sorted", "reversed", "nearly-sorted", "few-unique", "sawtooth", "organ-pipe", "rotated",
+};
+
+} // namespace
+
+std::span<const Algorithm> algorithms()
+{
+    return Catalog;
+}
+
+const Algorithm *findAlgorithm(std::string_view name)
+{
+    for (const Algorithm &algorithm : Catalog) {
+        if (name == algorithm.name)
+            return &algorithm;
+    }
+    return nullptr;
+}
+
+const char *shapeName(Shape shape)
+{
+    return ShapeNames[int(shape)];
+}
+
+bool shapeFromName(std::string_view name, Shape &shape)
+{
+    for (int i = 0; i < ShapeCount; ++i) {
+        if (name == ShapeNames[i]) {
+            shape = Shape(i);
+            return true;
+        }
+    }
+    return false;
+}
+
+std::vector<int32_t> makeInput(Shape shape, size_t size, uint32_t seed)
+{
+    std::vector<int32_t> values(size);
+    std::iota(values.begin(), values.end(), 1);
+    std::mt19937 random(seed);
+    switch (shape) {
+    case Shape::Random:
+        std::shuffle(values.begin(), values.end(), random);
+        break;
+    case Shape::Sorted:
+        break;
+    case Shape::Reversed:
+        std::reverse(values.begin(), values.end());
+        break;
+    case Shape::NearlySorted:
+        for (size_t i = 0; i < size / 32 && size > 1; ++i)
+            std::swap(values[random() % size], values[random() % size]);
+        break;
+    case Shape::FewUnique:
+        for (int32_t &value : values)
+            value = int32_t((random() % 8 + 1) * std::max<size_t>(size / 8, 1));
+        break;
+    case Shape::Sawtooth: {
+        // Value k goes to run k % 4, so each of the four runs ascends.
+        std::vector<int32_t> sorted = values;
+        size_t out = 0;
+        for (size_t run = 0; run < 4; ++run) {
+            for (size_t k = run; k < size; k += 4)
+                values[out++] = sorted[k];
+        }
+        break;
+    }
+    case Shape::OrganPipe: {
+        std::vector<int32_t> sorted = values;
+        for (size_t k = 0; k < size; ++k)
+            values[k % 2 ? size - 1 - k / 2 : k / 2] = sorted[k];
+        break;
+    }
+    case Shape::Rotated:
+        if (size > 1)
+            std::rotate(values.begin(), values.begin() + 1, values.end());
+        break;
+    }
+    return values;
+}
+
+WatchScope::WatchScope(Watcher *watcher)
+    : m_previous(t_watcher)
+{
+    t_watcher = watcher;
+}
+
+WatchScope::~WatchScope()
+{
+    t_watcher = m_previous;
+}
+
+void checkpoint(std::span<const int32_t> values)
+{
+    if (t_watcher)
+        t_watcher->checkpoint(values);
+}
+
+} // namespace Sorts
@@ -0,0 +1,74 @@
+#ifndef SORTS_H
+#define SORTS_H
+
+#include "stepper.h"
+
+#include <cstdint>
+#include <span>
+#include <string_view>
+#include <vector>
+
+// The sorting algorithms MainWindow animates, each a Stepper coroutine that
+// sorts the span in place, plus the input shapes they are raced on. Every
+// algorithm is deterministic, randomised ones included, so a run can be
+// re-derived from its input.
+namespace Sorts {
+
+struct Algorithm
+{
+    const char *name;
+    Stepper (*run)(std::span<int32_t> values);
+    // The same sort without events, for full-speed runs; nullptr for the
+    // ones nobody runs at sizes where the stepping overhead matters.
+    void (*native)(std::span<int32_t> values) = nullptr;
+    // May not finish in any useful time; races and benchmarks leave it out.
+    bool unbounded = false;
+    // Equal values keep their order, which bench fuzz checks from the trace.
+    bool stable = false;
+};
+
+std::span<const Algorithm> algorithms();
+// nullptr if there is no algorithm of that name.
+const Algorithm *findAlgorithm(std::string_view name);
+
+enum class Shape { Random, Sorted, Reversed, NearlySorted, FewUnique, Sawtooth, OrganPipe, Rotated };
+constexpr int ShapeCount = 8;
+
+const char *shapeName(Shape shape);
+bool shapeFromName(std::string_view name, Shape &shape);
+// Values 1..size (fewer distinct ones for FewUnique), arranged as the shape
+// says; the seed only matters for the shapes with randomness in them.
+std::vector<int32_t> makeInput(Shape shape, size_t size, uint32_t seed);
+
+// The native sorts call checkpoint() at pass and partition boundaries with
+// the whole array as it then stands (or, for the ones that sort through a
+// scratch copy, that copy). A watcher installed on the sorting thread is
+// handed it there, the one place the array can be read without racing the
+// sort; with none installed a checkpoint is a thread-local load.
+class Watcher
+{
+public:
+    virtual void checkpoint(std::span<const int32_t> values) = 0;
+
+protected:
+    ~Watcher() = default;
+};
+
+// Installs watcher on the current thread for the scope's lifetime.
+class WatchScope
+{
+public:
+    explicit WatchScope(Watcher *watcher);
+    WatchScope(const WatchScope &) = delete;
+    WatchScope &operator=(const WatchScope &) = delete;
+    ~WatchScope();
+
+private:
+    Watcher *m_previous;
+};
+
+void checkpoint(std::span<const int32_t> values);
+
+} // namespace Sorts
+
+#endif // SORTS_H
@@ -0,0 +1,65 @@
+#include "statistics.h"
+
+#include <algorithm>
+#include <cmath>
+#include <numeric>
+
+namespace Statistics {
+
+double median(std::vector<double> values)
+{
+    if (values.empty())
+        return NAN;
+    const size_t middle = values.size() / 2;
+    std::nth_element(values.begin(), values.begin() + middle, values.end());
+    if (values.size() % 2)
+        return values[middle];
+    const double upper = values[middle];
+    return (*std::max_element(values.begin(), values.begin() + middle) + upper) / 2;
+}
+
+// Ranks the pooled values, tied ones sharing the mean of their ranks, and
+// compares the first sample's rank sum with what chance would give.
+RankTest mannWhitney(std::span<const double> a, std::span<const double> b)
+{
+    RankTest test;
+    const double n1 = double(a.size());
+    const double n2 = double(b.size());
+    const size_t total = a.size() + b.size();
+    if (a.empty() || b.empty())
+        return test;
+
+    std::vector<size_t> order(total);
+    std::iota(order.begin(), order.end(), size_t(0));
+    const auto value = [&](size_t i) { return i < a.size() ? a[i] : b[i - a.size()]; };
+    std::sort(order.begin(), order.end(), [&](size_t i, size_t j) { return value(i) < value(j); });
+
+    double rankSumA = 0;
+    double tieTerm = 0;
+    for (size_t first = 0; first < total;) {
+        size_t last = first + 1;
+        while (last < total && value(order[last]) == value(order[first]))
+            ++last;
+        const double rank = (first + 1 + last) / 2.0;
+        for (size_t k = first; k < last; ++k) {
+            if (order[k] < a.size())
+                rankSumA += rank;
+        }
+        const double ties = double(last - first);
+        tieTerm += ties * ties * ties - ties;
+        first = last;
+    }
+
+    test.u = rankSumA - n1 * (n1 + 1) / 2;
+    const double n = double(total);
+    const double variance = n1 * n2 / 12 * ((n + 1) - tieTerm / (n * (n - 1)));
+    if (variance <= 0)
+        return test;
+    const double offset = test.u - n1 * n2 / 2;
+    const double corrected = std::max(std::abs(offset) - 0.5, 0.0);
+    test.z = std::copysign(corrected / std::sqrt(variance), offset);
+    test.p = std::erfc(std::abs(test.z) / std::sqrt(2.0));
+    return test;
+}
+
+} // namespace Statistics
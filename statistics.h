@@ -0,0 +1,28 @@
+#ifndef STATISTICS_H
+#define STATISTICS_H
+
+#include <span>
+#include <vector>
+
+// Small-sample statistics for benchmark timings, which are skewed (a run
+// can only be slowed down, never sped up, by noise) and often tied at the
+// timer's resolution, so the tests here make no normality assumption.
+namespace Statistics {
+
+double median(std::vector<double> values);
+
+struct RankTest
+{
+    double u = 0; // Mann-Whitney U of the first sample
+    double z = 0; // > 0 when the first sample tends to be larger
+    double p = 1; // two-sided
+};
+
+// Mann-Whitney U test by the normal approximation with tie and continuity
+// corrections; good from about eight values per sample. p is 1 when
+// either sample is empty or every value is the same.
+RankTest mannWhitney(std::span<const double> a, std::span<const double> b);
+
+} // namespace Statistics
+
+#endif // STATISTICS_H
@@ -0,0 +1,163 @@
+#ifndef STEPPER_H
+#define STEPPER_H
+
+#include <coroutine>
+#include <cstddef>
+#include <cstdint>
+#include <exception>
+#include <span>
+#include <utility>
+
+// What an algorithm did to its array, one operation at a time. Writes carry
+// the value they replaced so a player can also run events backwards.
+struct VisualEvent
+{
+    enum Kind : uint8_t { Compare, Swap, Write, Mark };
+
+    Kind kind = Mark;
+    uint32_t a = 0; // first index; the written index for Write
+    uint32_t b = 0; // second index; end of the range for Mark
+    int32_t value = 0; // Write: new value. Mark: a tag the algorithm chooses
+    int32_t previous = 0; // Write: old value
+
+    static VisualEvent compare(size_t i, size_t j) { return { Compare, uint32_t(i), uint32_t(j), 0, 0 }; }
+    static VisualEvent mark(size_t begin, size_t end, int32_t tag = 0)
+    {
+        return { Mark, uint32_t(begin), uint32_t(end), tag, 0 };
+    }
+    // These two also carry out the operation they describe.
+    static VisualEvent swap(std::span<int32_t> values, size_t i, size_t j)
+    {
+        std::swap(values[i], values[j]);
+        return { Swap, uint32_t(i), uint32_t(j), 0, 0 };
+    }
+    static VisualEvent write(std::span<int32_t> values, size_t i, int32_t value)
+    {
+        const VisualEvent event { Write, uint32_t(i), uint32_t(i), value, values[i] };
+        values[i] = value;
+        return event;
+    }
+
+    // Replays the event on another copy of the array, or takes it back.
+    void apply(std::span<int32_t> values) const
+    {
+        if (kind == Swap)
+            std::swap(values[a], values[b]);
+        else if (kind == Write)
+            values[a] = value;
+    }
+    void undo(std::span<int32_t> values) const
+    {
+        if (kind == Swap)
+            std::swap(values[a], values[b]);
+        else if (kind == Write)
+            values[a] = previous;
+    }
+};
+
+// An algorithm written as a coroutine that co_yields VisualEvents. Nothing
+// runs until next() is called, and each call runs up to the following
+// event, so a caller decides how much work happens per frame and several
+// algorithms can be interleaved on one thread.
+//
+// Recursive algorithms call themselves with co_await: the callee's events
+// come out of the outermost Stepper, and resuming jumps straight to the
+// innermost active frame instead of through every level of recursion.
+class Stepper
+{
+public:
+    struct promise_type;
+    using Handle = std::coroutine_handle<promise_type>;
+
+    struct promise_type
+    {
+        VisualEvent event; // only the root's is used
+        promise_type *root = this;
+        Handle leaf; // root only: the frame to resume
+        Handle parent;
+
+        Stepper get_return_object() { return Stepper(Handle::from_promise(*this)); }
+        std::suspend_always initial_suspend() noexcept { return {}; }
+
+        struct FinalAwaiter
+        {
+            bool await_ready() noexcept { return false; }
+            std::coroutine_handle<> await_suspend(Handle finished) noexcept
+            {
+                promise_type &promise = finished.promise();
+                if (!promise.parent)
+                    return std::noop_coroutine();
+                promise.root->leaf = promise.parent;
+                return promise.parent;
+            }
+            void await_resume() noexcept {}
+        };
+        FinalAwaiter final_suspend() noexcept { return {}; }
+
+        std::suspend_always yield_value(const VisualEvent &value)
+        {
+            root->event = value;
+            return {};
+        }
+
+        struct CallAwaiter
+        {
+            Handle child;
+
+            bool await_ready() noexcept { return !child || child.done(); }
+            Handle await_suspend(Handle caller) noexcept
+            {
+                promise_type &promise = child.promise();
+                promise.parent = caller;
+                promise.root = caller.promise().root;
+                promise.root->leaf = child;
+                return child;
+            }
+            void await_resume() {}
+        };
+        // The child frame is owned by the temporary Stepper in the co_await
+        // expression and lives until the call has finished.
+        CallAwaiter await_transform(Stepper &&child) { return { child.m_handle }; }
+
+        void return_void() {}
+        void unhandled_exception() { std::terminate(); }
+    };
+
+    Stepper() = default;
+    Stepper(Stepper &&other) noexcept : m_handle(std::exchange(other.m_handle, {})) {}
+    Stepper &operator=(Stepper &&other) noexcept
+    {
+        if (this != &other) {
+            if (m_handle)
+                m_handle.destroy();
+            m_handle = std::exchange(other.m_handle, {});
+        }
+        return *this;
+    }
+    Stepper(const Stepper &) = delete;
+    Stepper &operator=(const Stepper &) = delete;
+    ~Stepper()
+    {
+        if (m_handle)
+            m_handle.destroy();
+    }
+
+    // Runs to the next event; false once the algorithm has returned.
+    bool next()
+    {
+        if (!m_handle || m_handle.done())
+            return false;
+        promise_type &promise = m_handle.promise();
+        (promise.leaf ? promise.leaf : m_handle).resume();
+        return !m_handle.done();
+    }
+    const VisualEvent &event() const { return m_handle.promise().event; }
+    bool done() const { return !m_handle || m_handle.done(); }
+
+private:
+    explicit Stepper(Handle handle) : m_handle(handle) {}
+
+    Handle m_handle;
+};
+
+#endif // STEPPER_H
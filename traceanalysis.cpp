@@ -0,0 +1,241 @@
+#include "traceanalysis.h"
+
+#include <algorithm>
+#include <atomic>
+#include <bit>
+#include <cmath>
+#include <mutex>
+#include <thread>
+
+namespace TraceAnalysis {
+
+namespace {
+
+constexpr size_t LineElements = 64 / sizeof(int32_t);
+
+// Bottom-up merge sort of a copy: an element taken from the right run
+// jumps every element left in the left run.
+uint64_t countInversions(std::span<const int32_t> values, std::vector<int32_t> &from, std::vector<int32_t> &to)
+{
+    const size_t n = values.size();
+    from.assign(values.begin(), values.end());
+    to.resize(n);
+    uint64_t inversions = 0;
+    for (size_t width = 1; width < n; width *= 2) {
+        for (size_t begin = 0; begin < n; begin += 2 * width) {
+            const size_t middle = std::min(begin + width, n);
+            const size_t end = std::min(begin + 2 * width, n);
+            size_t i = begin;
+            size_t j = middle;
+            size_t out = begin;
+            while (i < middle && j < end) {
+                if (from[j] < from[i]) {
+                    inversions += middle - i;
+                    to[out++] = from[j++];
+                } else {
+                    to[out++] = from[i++];
+                }
+            }
+            out = size_t(std::copy(from.begin() + i, from.begin() + middle, to.begin() + out) - to.begin());
+            std::copy(from.begin() + j, from.begin() + end, to.begin() + out);
+        }
+        std::swap(from, to);
+    }
+    return inversions;
+}
+
+} // namespace
+
+Result analyze(const Sorts::Algorithm &algorithm, std::vector<int32_t> input, const Options &options,
+               const std::function<bool(uint64_t events)> &progress)
+{
+    Result result;
+    const size_t size = input.size();
+    const size_t regions = std::max<size_t>(std::min(options.regions, size), 1);
+    const uint64_t window = std::max<uint64_t>(options.window, 1);
+    const size_t maxSamples = std::max<size_t>(options.maxSamples, 2);
+    result.size = size;
+    result.compares.assign(regions, 0);
+    result.swaps.assign(regions, 0);
+    result.writes.assign(regions, 0);
+    result.swapDistance.assign(regions, 0);
+    result.interval = window * std::max<uint64_t>((size + window - 1) / window, 1);
+
+    // A line was touched in the current window when its stamp is the
+    // window's number plus one, so nothing needs clearing between windows.
+    std::vector<uint64_t> lineStamps((size + LineElements - 1) / LineElements, 0);
+    uint64_t stamp = 1;
+    uint32_t touched = 0;
+    std::vector<int32_t> from;
+    std::vector<int32_t> to;
+
+    const auto count = [&](std::vector<uint64_t> &counts, const VisualEvent &event, uint64_t amount) {
+        const size_t first = size_t(uint64_t(event.a) * regions / size);
+        const size_t second = size_t(uint64_t(event.b) * regions / size);
+        counts[first] += amount;
+        if (second != first)
+            counts[second] += amount;
+    };
+    const auto touch = [&](uint32_t index) {
+        uint64_t &line = lineStamps[index / LineElements];
+        if (line != stamp) {
+            line = stamp;
+            ++touched;
+        }
+    };
+    const auto sample = [&](uint64_t position) {
+        result.samples.push_back({ position, countInversions(input, from, to), touched });
+    };
+
+    sample(0);
+    Stepper stepper = algorithm.run(input);
+    uint64_t events = 0;
+    bool stopped = false;
+    while (stepper.next()) {
+        const VisualEvent &event = stepper.event();
+        switch (event.kind) {
+        case VisualEvent::Compare:
+            count(result.compares, event, 1);
+            break;
+        case VisualEvent::Swap: {
+            const uint32_t distance = event.a > event.b ? event.a - event.b : event.b - event.a;
+            count(result.swaps, event, 1);
+            count(result.swapDistance, event, distance);
+            ++result.distances[std::max<int>(std::bit_width(distance), 1) - 1];
+            break;
+        }
+        case VisualEvent::Write:
+            count(result.writes, event, 1);
+            break;
+        case VisualEvent::Mark:
+            break;
+        }
+        if (event.kind != VisualEvent::Mark) {
+            touch(event.a);
+            touch(event.b);
+        }
+
+        if (++events % window)
+            continue;
+        if (events % result.interval == 0) {
+            sample(events);
+            if (result.samples.size() > maxSamples) {
+                result.interval *= 2;
+                std::erase_if(result.samples, [&](const Sample &kept) { return kept.position % result.interval; });
+            }
+            if (progress && !progress(events)) {
+                stopped = true;
+                break;
+            }
+        }
+        ++stamp;
+        touched = 0;
+    }
+    if (result.samples.back().position != events)
+        sample(events);
+
+    result.events = events;
+    result.complete = !stopped;
+    result.memoryBytes = 4 * regions * sizeof(uint64_t) + lineStamps.size() * sizeof(uint64_t)
+                       + (input.capacity() + from.capacity() + to.capacity()) * sizeof(int32_t)
+                       + result.samples.capacity() * sizeof(Sample);
+    return result;
+}
+
+const char *heatName(Heat heat)
+{
+    switch (heat) {
+    case Heat::Accesses:
+        return "accesses";
+    case Heat::Writes:
+        return "writes";
+    case Heat::SwapDistance:
+        return "swap distance";
+    }
+    return "";
+}
+
+std::vector<float> heat(const Result &result, Heat heat)
+{
+    std::vector<double> values(result.compares.size(), 0);
+    for (size_t r = 0; r < values.size(); ++r) {
+        switch (heat) {
+        case Heat::Accesses:
+            values[r] = double(result.compares[r] + result.swaps[r] + result.writes[r]);
+            break;
+        case Heat::Writes:
+            values[r] = double(result.swaps[r] + result.writes[r]);
+            break;
+        case Heat::SwapDistance:
+            values[r] = result.swaps[r] ? double(result.swapDistance[r]) / double(result.swaps[r]) : 0;
+            break;
+        }
+    }
+    const double most = values.empty() ? 0 : *std::max_element(values.begin(), values.end());
+    std::vector<float> heats(values.size(), 0);
+    if (most > 0) {
+        for (size_t r = 0; r < values.size(); ++r)
+            heats[r] = float(std::log1p(values[r]) / std::log1p(most));
+    }
+    return heats;
+}
+
+struct BackgroundAnalysis::Shared
+{
+    std::mutex mutex;
+    Result result;
+    std::atomic<uint64_t> events { 0 };
+    std::atomic<bool> cancelled { false };
+    std::atomic<bool> done { false };
+};
+
+BackgroundAnalysis::~BackgroundAnalysis()
+{
+    cancel();
+}
+
+void BackgroundAnalysis::start(const Sorts::Algorithm *algorithm, std::vector<int32_t> input, const Options &options)
+{
+    cancel();
+    m_algorithm = algorithm;
+    m_shared = std::make_shared<Shared>();
+    std::thread([shared = m_shared, algorithm, input = std::move(input), options]() mutable {
+        Result result = analyze(*algorithm, std::move(input), options, [&](uint64_t events) {
+            shared->events.store(events, std::memory_order_relaxed);
+            return !shared->cancelled.load(std::memory_order_relaxed);
+        });
+        shared->events.store(result.events, std::memory_order_relaxed);
+        {
+            std::lock_guard<std::mutex> lock(shared->mutex);
+            shared->result = std::move(result);
+        }
+        shared->done.store(true, std::memory_order_release);
+    }).detach();
+}
+
+void BackgroundAnalysis::cancel()
+{
+    if (m_shared)
+        m_shared->cancelled.store(true, std::memory_order_relaxed);
+    m_shared.reset();
+}
+
+bool BackgroundAnalysis::running() const
+{
+    return m_shared && !m_shared->done.load(std::memory_order_acquire);
+}
+
+uint64_t BackgroundAnalysis::events() const
+{
+    return m_shared ? m_shared->events.load(std::memory_order_relaxed) : 0;
+}
+
+Result BackgroundAnalysis::result() const
+{
+    if (!m_shared || !m_shared->done.load(std::memory_order_acquire))
+        return {};
+    std::lock_guard<std::mutex> lock(m_shared->mutex);
+    return m_shared->result;
+}
+
+} // namespace TraceAnalysis
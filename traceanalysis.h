@@ -0,0 +1,102 @@
+#ifndef TRACEANALYSIS_H
+#define TRACEANALYSIS_H
+
+#include "sorts.h"
+
+#include <array>
+#include <cstdint>
+#include <functional>
+#include <memory>
+#include <span>
+#include <vector>
+
+// Statistics over a sort's whole trace, gathered in one pass while the
+// events are generated and dropped, like the player does. A trace of
+// billions of events takes time, but memory stays at a few counters per
+// region, a stamp per cache line and three copies of the array:
+//
+//  - compares, swaps and writes per region of the array, and how far the
+//    swaps reach, for heatmaps over the bars;
+//  - a histogram of swap distances;
+//  - the inversion count and the working set (cache lines touched in a
+//    window of events) at evenly spaced points of the run. The points
+//    are thinned to every other one, at twice the spacing, whenever there
+//    are too many, so they always cover the run so far. The spacing is
+//    never below the array size, which keeps the O(n log n) inversion
+//    counts at O(log n) per event.
+namespace TraceAnalysis {
+
+struct Options
+{
+    size_t regions = 1024; // fewer for smaller arrays
+    uint64_t window = 4096; // events per working set measurement
+    size_t maxSamples = 256;
+};
+
+struct Sample
+{
+    uint64_t position = 0; // events before it
+    uint64_t inversions = 0;
+    uint32_t workingSet = 0; // 64-byte lines touched in the window ending here
+};
+
+// Bucket k counts swaps across a distance in [2^k, 2^(k+1)).
+constexpr int DistanceBuckets = 32;
+
+struct Result
+{
+    size_t size = 0;
+    uint64_t events = 0;
+    bool complete = false; // false when stopped early
+    // Region r covers the elements [r * size / regions, (r + 1) * size / regions).
+    // Each counts the events with an end in the region.
+    std::vector<uint64_t> compares;
+    std::vector<uint64_t> swaps;
+    std::vector<uint64_t> writes;
+    std::vector<uint64_t> swapDistance; // summed over the swaps counted
+    std::array<uint64_t, DistanceBuckets> distances {};
+    std::vector<Sample> samples;
+    uint64_t interval = 0; // events between samples, bar the last
+    size_t memoryBytes = 0; // held by the pass
+};
+
+// progress sees the events so far at every sample and returns false to
+// stop, leaving an incomplete result.
+Result analyze(const Sorts::Algorithm &algorithm, std::vector<int32_t> input, const Options &options = Options(),
+               const std::function<bool(uint64_t events)> &progress = {});
+
+enum class Heat { Accesses, Writes, SwapDistance };
+const char *heatName(Heat heat);
+// One value per region from 0 to 1, on a log scale so that a few hot spots
+// do not wash out the rest.
+std::vector<float> heat(const Result &result, Heat heat);
+
+// analyze() on a worker thread for the GUI to poll; like SampledSort, the
+// worker may outlive the object.
+class BackgroundAnalysis
+{
+public:
+    BackgroundAnalysis() = default;
+    BackgroundAnalysis(const BackgroundAnalysis &) = delete;
+    BackgroundAnalysis &operator=(const BackgroundAnalysis &) = delete;
+    ~BackgroundAnalysis();
+
+    void start(const Sorts::Algorithm *algorithm, std::vector<int32_t> input, const Options &options = Options());
+    void cancel();
+
+    const Sorts::Algorithm *algorithm() const { return m_algorithm; }
+    bool running() const;
+    uint64_t events() const;
+    // Empty until finished.
+    Result result() const;
+
+private:
+    struct Shared;
+
+    const Sorts::Algorithm *m_algorithm = nullptr;
+    std::shared_ptr<Shared> m_shared;
+};
+
+} // namespace TraceAnalysis
+
+#endif // TRACEANALYSIS_H
@@ -0,0 +1,208 @@
+#include "traceplayer.h"
+
+#include <algorithm>
+
+namespace {
+
+// How often the generating loops look at the clock.
+constexpr uint64_t DeadlineCheckInterval = 4096;
+// Events cost microseconds each with Sortedness metrics on.
+constexpr uint64_t TrackedDeadlineCheckInterval = 64;
+
+} // namespace
+
+void TracePlayer::start(const Sorts::Algorithm *algorithm, std::vector<int32_t> input, const Options &options)
+{
+    m_algorithm = algorithm;
+    m_options = options;
+    // Large arrays get fewer checkpoints rather than more memory.
+    const size_t arrayBytes = std::max<size_t>(input.size() * sizeof(int32_t), 1);
+    m_options.maxCheckpoints = std::clamp<size_t>(options.checkpointBytes / arrayBytes, 2, options.maxCheckpoints);
+    m_input = std::move(input);
+    m_values = m_input;
+    if (m_trackSortedness)
+        m_sortedness.start(m_input);
+    m_cursor = 0;
+    m_range = VisualEvent();
+    m_ring.assign(std::max<size_t>(m_options.history + m_options.lookahead, 1), VisualEvent());
+    m_checkpoints.clear();
+    m_checkpoints.push_back({ 0, m_input });
+    m_interval = std::max<uint64_t>(m_options.checkpointInterval, 1);
+    m_rederiveTarget = 0;
+    m_generatorValues = m_input;
+    m_stepper = m_algorithm->run(m_generatorValues);
+    m_generated = 0;
+    m_ringStart = 0;
+    m_finished = false;
+}
+
+bool TracePlayer::seek(uint64_t target, std::chrono::steady_clock::time_point deadline)
+{
+    const uint64_t checkEvery = m_trackSortedness ? TrackedDeadlineCheckInterval : DeadlineCheckInterval;
+    for (;;) {
+        if (rederiving()) {
+            if (!generate(deadline))
+                return false;
+        } else if (target < m_cursor) {
+            if (target < m_ringStart) {
+                restoreCheckpoint(target);
+                continue;
+            }
+            while (m_cursor > target) {
+                backward();
+                if (m_cursor % checkEvery == 0 && std::chrono::steady_clock::now() >= deadline)
+                    return false;
+            }
+        } else if (target > m_cursor) {
+            if (m_cursor == m_generated) {
+                if (m_finished)
+                    break;
+                if (!generate(deadline))
+                    return false;
+                continue;
+            }
+            const uint64_t end = std::min(target, m_generated);
+            while (m_cursor < end) {
+                forward();
+                if (m_cursor % checkEvery == 0 && std::chrono::steady_clock::now() >= deadline)
+                    return false;
+            }
+        } else {
+            break;
+        }
+    }
+
+    while (!m_finished && m_generated - m_cursor < m_options.lookahead
+           && std::chrono::steady_clock::now() < deadline) {
+        generate(deadline);
+    }
+    return true;
+}
+
+double TracePlayer::rederiveProgress() const
+{
+    return m_rederiveTarget ? double(m_generated) / double(m_rederiveTarget) : 1.0;
+}
+
+void TracePlayer::trackSortedness(bool track)
+{
+    m_trackSortedness = track;
+    if (!track) {
+        m_sortedness = Sortedness();
+        return;
+    }
+    m_sortedness.start(m_input);
+    m_sortedness.reset(m_values);
+}
+
+bool TracePlayer::lastEvent(VisualEvent &event) const
+{
+    if (m_cursor == 0 || m_cursor <= m_ringStart)
+        return false;
+    event = buffered(m_cursor - 1);
+    return true;
+}
+
+size_t TracePlayer::memoryBytes() const
+{
+    size_t bytes = m_ring.capacity() * sizeof(VisualEvent);
+    bytes += (m_input.capacity() + m_values.capacity() + m_generatorValues.capacity()) * sizeof(int32_t);
+    bytes += m_sortedness.memoryBytes();
+    for (const Checkpoint &checkpoint : m_checkpoints)
+        bytes += sizeof(Checkpoint) + checkpoint.values.capacity() * sizeof(int32_t);
+    return bytes;
+}
+
+// Runs the generator until the lookahead is full, or, while re-deriving,
+// until it reaches the checkpoint, throwing those events away. Returns
+// false if the deadline cut it short.
+bool TracePlayer::generate(std::chrono::steady_clock::time_point deadline)
+{
+    const bool skipping = rederiving();
+    const uint64_t limit = skipping ? m_rederiveTarget : m_cursor + m_options.lookahead;
+    uint64_t count = 0;
+    bool cutShort = false;
+    while (m_generated < limit) {
+        if (!m_stepper.next()) {
+            m_finished = true;
+            break;
+        }
+        if (!skipping) {
+            m_ring[m_generated % m_ring.size()] = m_stepper.event();
+            if (m_generated - m_ringStart == m_ring.size())
+                ++m_ringStart;
+        }
+        ++m_generated;
+        if (++count % DeadlineCheckInterval == 0 && std::chrono::steady_clock::now() >= deadline) {
+            cutShort = true;
+            break;
+        }
+    }
+    // However the loop ended, a skip that got to the checkpoint, or to the
+    // end of a run, leaves the ring empty from there.
+    if (skipping && (m_finished || m_generated >= limit)) {
+        // Finishing early would mean the run did not repeat; stop waiting.
+        m_rederiveTarget = m_generated;
+        m_ringStart = m_generated;
+    }
+    return !cutShort || m_generated >= limit;
+}
+
+void TracePlayer::forward()
+{
+    const VisualEvent &event = buffered(m_cursor);
+    event.apply(m_values);
+    if (m_trackSortedness)
+        m_sortedness.apply(event);
+    if (event.kind == VisualEvent::Mark)
+        m_range = event;
+    ++m_cursor;
+    if (m_cursor >= m_checkpoints.back().position + m_interval)
+        addCheckpoint();
+}
+
+void TracePlayer::backward()
+{
+    const VisualEvent &event = buffered(--m_cursor);
+    event.undo(m_values);
+    if (m_trackSortedness)
+        m_sortedness.undo(event);
+}
+
+void TracePlayer::restoreCheckpoint(uint64_t target)
+{
+    const auto after = std::upper_bound(m_checkpoints.begin(), m_checkpoints.end(), target,
+                                        [](uint64_t position, const Checkpoint &checkpoint) {
+                                            return position < checkpoint.position;
+                                        });
+    const Checkpoint &checkpoint = *(after - 1);
+    m_values = checkpoint.values;
+    if (m_trackSortedness)
+        m_sortedness.reset(m_values);
+    m_cursor = checkpoint.position;
+    m_range = VisualEvent();
+
+    // A generator that has not got past the checkpoint yet can carry on;
+    // otherwise start over from the input.
+    if (m_generated > checkpoint.position) {
+        m_generatorValues = m_input;
+        m_stepper = m_algorithm->run(m_generatorValues);
+        m_generated = 0;
+        m_finished = false;
+    }
+    m_rederiveTarget = checkpoint.position;
+    m_ringStart = m_generated;
+}
+
+void TracePlayer::addCheckpoint()
+{
+    m_checkpoints.push_back({ m_cursor, m_values });
+    if (m_checkpoints.size() <= m_options.maxCheckpoints)
+        return;
+    // Keep the even ones, which always includes the input at position 0.
+    size_t kept = 1;
+    for (size_t i = 2; i < m_checkpoints.size(); i += 2)
+        m_checkpoints[kept++] = std::move(m_checkpoints[i]);
+    m_checkpoints.resize(kept);
+    m_interval *= 2;
+}
@@ -0,0 +1,109 @@
+#ifndef TRACEPLAYER_H
+#define TRACEPLAYER_H
+
+#include "sortedness.h"
+#include "sorts.h"
+#include "stepper.h"
+
+#include <chrono>
+#include <cstdint>
+#include <span>
+#include <vector>
+
+// Plays one algorithm's events with a seekable cursor, generating them only
+// just ahead of it. Memory stays flat however long the run is: a ring of
+// recent and upcoming events, plus a bounded set of array checkpoints.
+//
+// Seeking back within the ring undoes events. Further back, the array is
+// restored from the nearest earlier checkpoint, and a fresh run of the
+// algorithm is fast-forwarded to that point without keeping its events.
+// This works because every algorithm is deterministic. Checkpoints are
+// thinned to every other one whenever there are too many, so they stay
+// spread over the whole run at a growing interval.
+class TracePlayer
+{
+public:
+    struct Options
+    {
+        size_t lookahead = size_t(1) << 16;
+        size_t history = size_t(1) << 18;
+        size_t maxCheckpoints = 32;
+        // Lowers maxCheckpoints for arrays big enough to need it.
+        size_t checkpointBytes = size_t(64) << 20;
+        uint64_t checkpointInterval = uint64_t(1) << 16;
+    };
+
+    void start(const Sorts::Algorithm *algorithm, std::vector<int32_t> input, const Options &options);
+
+    // Works towards putting the cursor on target until it gets there or the
+    // deadline passes, then tops up the lookahead with whatever time is
+    // left. Returns true once the cursor is on target, or on the end of a
+    // run that finished before target.
+    bool seek(uint64_t target, std::chrono::steady_clock::time_point deadline);
+
+    uint64_t position() const { return m_cursor; }
+    // Events generated so far, which is the length of the run once finished().
+    uint64_t generated() const { return m_generated; }
+    bool finished() const { return m_finished; }
+    // True while a seek back is fast-forwarding a fresh run.
+    bool rederiving() const { return m_rederiveTarget > m_generated; }
+    double rederiveProgress() const;
+
+    const Sorts::Algorithm *algorithm() const { return m_algorithm; }
+    std::span<const int32_t> input() const { return m_input; }
+    std::span<const int32_t> values() const { return m_values; }
+    // The event that brought the array to the cursor, if it is still known.
+    bool lastEvent(VisualEvent &event) const;
+    const VisualEvent &range() const { return m_range; }
+
+    // Keeps Sortedness metrics of the array shown, across runs until turned
+    // off. Events then take microseconds each on large arrays, so seek()
+    // looks at its deadline more often.
+    void trackSortedness(bool track);
+    const Sortedness *sortedness() const { return m_trackSortedness ? &m_sortedness : nullptr; }
+
+    size_t checkpointCount() const { return m_checkpoints.size(); }
+    uint64_t checkpointInterval() const { return m_interval; }
+    size_t memoryBytes() const;
+
+private:
+    struct Checkpoint
+    {
+        uint64_t position;
+        std::vector<int32_t> values;
+    };
+
+    const VisualEvent &buffered(uint64_t position) const { return m_ring[position % m_ring.size()]; }
+    bool generate(std::chrono::steady_clock::time_point deadline);
+    void forward();
+    void backward();
+    void restoreCheckpoint(uint64_t target);
+    void addCheckpoint();
+
+    const Sorts::Algorithm *m_algorithm = nullptr;
+    Options m_options;
+    std::vector<int32_t> m_input;
+
+    // The generator and the array it sorts sit at m_generated.
+    std::vector<int32_t> m_generatorValues;
+    Stepper m_stepper;
+    uint64_t m_generated = 0;
+    uint64_t m_rederiveTarget = 0;
+    bool m_finished = false;
+
+    // Events [m_ringStart, m_generated) are in the ring.
+    std::vector<VisualEvent> m_ring;
+    uint64_t m_ringStart = 0;
+
+    // The array shown, at m_cursor.
+    std::vector<int32_t> m_values;
+    uint64_t m_cursor = 0;
+    VisualEvent m_range;
+    Sortedness m_sortedness;
+    bool m_trackSortedness = false;
+
+    std::vector<Checkpoint> m_checkpoints;
+    uint64_t m_interval = 0;
+};
+
+#endif // TRACEPLAYER_H
@@ -0,0 +1,102 @@
+#include "tuning.h"
+
+#include <QDir>
+#include <QFile>
+#include <QFileInfo>
+#include <QJsonDocument>
+#include <QJsonObject>
+#include <QStandardPaths>
+
+#include <algorithm>
+
+namespace Tuning {
+
+namespace {
+
+Profile g_current;
+
+void setError(QString *error, const QString &message)
+{
+    if (error)
+        *error = message;
+}
+
+} // namespace
+
+const Profile &current()
+{
+    return g_current;
+}
+
+void setCurrent(const Profile &profile)
+{
+    g_current = profile;
+}
+
+// Shared by the GUI and the bench, so not under either's application name.
+QString profilePath()
+{
+    return QStandardPaths::writableLocation(QStandardPaths::GenericConfigLocation)
+            + QLatin1String("/animated_algorithms/tuning.json");
+}
+
+bool load(const QString &path, Profile &profile, QString *error)
+{
+    QFile file(path);
+    if (!file.open(QIODevice::ReadOnly)) {
+        setError(error, QStringLiteral("Cannot read %1: %2").arg(path, file.errorString()));
+        return false;
+    }
+    QJsonParseError parseError;
+    const QJsonDocument document = QJsonDocument::fromJson(file.readAll(), &parseError);
+    if (!document.isObject()) {
+        setError(error, QStringLiteral("%1 is not a tuning profile: %2").arg(path, parseError.errorString()));
+        return false;
+    }
+    const QJsonObject object = document.object();
+    const auto read = [&](const char *key, auto value, auto low, auto high) {
+        const double read = object.value(QLatin1String(key)).toDouble(double(value));
+        return decltype(value)(std::clamp<qint64>(qint64(read), qint64(low), qint64(high)));
+    };
+    profile = Profile();
+    profile.insertionCutoff = read("insertionCutoff", profile.insertionCutoff, 1, 1024);
+    profile.radixBits = read("radixBits", profile.radixBits, 1, 16);
+    profile.mergePiece = read("mergePiece", profile.mergePiece, 256, 1 << 24);
+    profile.tileWidth = read("tileWidth", profile.tileWidth, 16, 1 << 16);
+    profile.tileHeight = read("tileHeight", profile.tileHeight, 1, 1 << 16);
+    profile.rowGrain = read("rowGrain", profile.rowGrain, 1, 1 << 16);
+    return true;
+}
+
+bool save(const QString &path, const Profile &profile, QString *error)
+{
+    const QJsonObject object {
+        { QStringLiteral("insertionCutoff"), qint64(profile.insertionCutoff) },
+        { QStringLiteral("radixBits"), profile.radixBits },
+        { QStringLiteral("mergePiece"), qint64(profile.mergePiece) },
+        { QStringLiteral("tileWidth"), profile.tileWidth },
+        { QStringLiteral("tileHeight"), profile.tileHeight },
+        { QStringLiteral("rowGrain"), qint64(profile.rowGrain) },
+    };
+    QDir().mkpath(QFileInfo(path).absolutePath());
+    QFile file(path);
+    if (!file.open(QIODevice::WriteOnly | QIODevice::Truncate)
+        || file.write(QJsonDocument(object).toJson()) < 0 || !file.flush()) {
+        setError(error, QStringLiteral("Cannot write %1: %2").arg(path, file.errorString()));
+        return false;
+    }
+    return true;
+}
+
+bool loadCurrent(const QString &path, QString *error)
+{
+    if (!QFileInfo::exists(path))
+        return true;
+    Profile profile;
+    if (!load(path, profile, error))
+        return false;
+    setCurrent(profile);
+    return true;
+}
+
+} // namespace Tuning
@@ -0,0 +1,45 @@
+#ifndef TUNING_H
+#define TUNING_H
+
+#include <QString>
+
+#include <cstddef>
+
+// Thresholds whose best value depends on the machine: cache sizes, core
+// count, how much a mispredicted branch costs. The defaults are fair
+// anywhere; `animated_algorithms_bench tune` measures better ones and
+// writes them to profilePath(), which both programs load at startup.
+namespace Tuning {
+
+struct Profile
+{
+    // Native merge and quick sort finish ranges this short by insertion;
+    // 1 leaves them making the same moves as their steppers.
+    size_t insertionCutoff = 1;
+    // Digit width of the native radix sort.
+    int radixBits = 8;
+    // Smallest piece of a parallel merge handed to one thread.
+    size_t mergePiece = size_t(1) << 14;
+    // Tile size of the fused image pipeline.
+    int tileWidth = 512;
+    int tileHeight = 64;
+    // Rows per chunk in the row-parallel image loops.
+    size_t rowGrain = 64;
+};
+
+// Read by the engines on every call; change it only while nothing runs.
+const Profile &current();
+void setCurrent(const Profile &profile);
+
+QString profilePath();
+// Keys missing from the file keep their defaults, out-of-range values are
+// clamped, and unknown keys are ignored.
+bool load(const QString &path, Profile &profile, QString *error = nullptr);
+bool save(const QString &path, const Profile &profile, QString *error = nullptr);
+// Makes the profile at path current if there is one. No file is not an
+// error; a broken one is, and leaves current() alone.
+bool loadCurrent(const QString &path = profilePath(), QString *error = nullptr);
+
+} // namespace Tuning
+
+#endif // TUNING_H